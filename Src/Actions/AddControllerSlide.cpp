@@ -18,6 +18,7 @@
 #include "Actions/EditAction.h"
 //#include "Editors/ControllerEditor.h"
 //#include "GUI/GraphicalTrack.h"
+#include "MemoryUsage.h"
 #include "Midi/ControllerEvent.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
@@ -43,6 +44,14 @@ AddControllerSlide::~AddControllerSlide()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+long long AddControllerSlide::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(removedControlEvents) +
+           MemoryUsage::getVectorBytes(relocator.events);
+}
+
 void AddControllerSlide::undo()
 {
     ControllerEvent* current_event;
@@ -48,6 +48,7 @@ namespace AriaMaestosa
             
             
             virtual ~AddControllerSlide();
+            virtual long long getMemoryUsage() const;
         };
         
     }
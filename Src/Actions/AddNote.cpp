@@ -89,7 +89,7 @@ void AddNote::perform()
         {
             // select last added note
             m_track->selectNote(ALL_NOTES, false, true /* ignoreModifiers */);
-            tmp_note->setSelected(true);
+            m_track->setNoteSelected(tmp_note, true);
         }
     }
     else
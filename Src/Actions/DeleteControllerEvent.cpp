@@ -17,6 +17,7 @@
 #include "AriaCore.h"
 #include "Actions/DeleteControllerEvent.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
 #include "Midi/Note.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
@@ -51,6 +52,13 @@ DeleteControllerEvent::~DeleteControllerEvent()
 
 // ----------------------------------------------------------------------------------------------------------
 
+long long DeleteControllerEvent::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(removedControlEvents);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void DeleteControllerEvent::undo()
 {
     const int controlAmount = removedControlEvents.size();
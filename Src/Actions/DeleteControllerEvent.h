@@ -47,6 +47,7 @@ namespace AriaMaestosa
             void perform();
             void undo();
             virtual ~DeleteControllerEvent();
+            virtual long long getMemoryUsage() const;
         };
         
         
@@ -17,6 +17,7 @@
 #include "AriaCore.h"
 #include "Actions/DeleteSelected.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
 #include "Midi/Note.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
@@ -27,8 +28,10 @@
 
 #include "UnitTest.h"
 #include <cmath>
+#include <iostream>
 
 #include <wx/intl.h>
+#include <wx/stopwatch.h>
 
 using namespace AriaMaestosa;
 using namespace AriaMaestosa::Action;
@@ -51,6 +54,14 @@ DeleteSelected::~DeleteSelected()
 
 // ----------------------------------------------------------------------------------------------------------
 
+long long DeleteSelected::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(removedNotes) +
+           MemoryUsage::getVectorBytes(removedControlEvents);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void DeleteSelected::undo()
 {
     const int noteAmount    = removedNotes.size();
@@ -161,29 +172,19 @@ void DeleteSelected::perform()
     }
     else
     {
-        ptr_vector<Note>& notes        = m_visitor->getNotesVector();
-        ptr_vector<Note, REF>& noteOff = m_visitor->getNoteOffVector();
+        ptr_vector<Note>& notes = m_visitor->getNotesVector();
+
+        std::vector<int> selection;
+        m_track->getSelectedNoteIDs(selection);
 
-        for (int n=0; n<notes.size(); n++)
+        // the note off events are removed along with the notes; the notes are kept for undo
+        const int selectedAmount = selection.size();
+        for (int i=0; i<selectedAmount; i++)
         {
-            if (not notes[n].isSelected()) continue;
-            
-            // also delete corresponding note off event
-            for (int i=0; i<noteOff.size(); i++)
-            {
-                if (noteOff.get(i) == notes.get(n))
-                {
-                    noteOff.remove(i);
-                    break;
-                }
-            }
-            
-            //notes.erase(n);
-            removedNotes.push_back( notes.get(n) );
-            notes.remove(n);
-            
-            n--;
+            removedNotes.push_back( notes.get(selection[i]) );
+            m_track->markNoteToBeRemoved(selection[i]);
         }//next
+        m_track->removeMarkedNotes();
         
     }
     
@@ -358,5 +359,115 @@ namespace DeleteSelectedTest
         provider.verifyUndo();      
     }
     
+    UNIT_TEST(TestDeleteMovesMemoryToUndoStack)
+    {
+        TestSeqProvider provider;
+        Track* t = provider.m_seq->getTrack(0);
+        
+        MemoryUsage before;
+        provider.m_seq->getMemoryUsage(before);
+        require_e(before.getObjects(MemoryUsage::NOTES), ==, 4, "all notes are accounted for");
+        require_e(before.getBytes(MemoryUsage::UNDO_STACK), ==, 0, "nothing can be undone yet");
+        
+        t->selectNote(1, true);
+        t->selectNote(2, true);
+        t->action(new DeleteSelected(NULL));
+        
+        MemoryUsage after;
+        provider.m_seq->getMemoryUsage(after);
+        require_e(after.getObjects(MemoryUsage::NOTES), ==, 2, "deleted notes are no more in the track");
+        require_e(after.getBytes(MemoryUsage::NOTES), <, before.getBytes(MemoryUsage::NOTES),
+                  "deleted notes don't count as notes anymore");
+        require_e(after.getBytes(MemoryUsage::UNDO_STACK), >=, (long long)(2*sizeof(Note)),
+                  "deleted notes are kept by the undo stack");
+        require_e(after.getObjects(MemoryUsage::UNDO_STACK), ==, 1, "one action can be undone");
+        
+        provider.m_seq->undo();
+        
+        MemoryUsage undone;
+        provider.m_seq->getMemoryUsage(undone);
+        require_e(undone.getBytes(MemoryUsage::NOTES), ==, before.getBytes(MemoryUsage::NOTES),
+                  "undo gives the notes back");
+        require_e(undone.getBytes(MemoryUsage::UNDO_STACK), ==, 0, "the undone action was freed");
+    }
+    
+    UNIT_TEST(TestSelectionFollowsEdits)
+    {
+        TestSeqProvider provider;
+        Track* t = provider.m_seq->getTrack(0);
+        
+        t->selectNote(1, true);
+        t->selectNote(3, true);
+        require_e(t->getSelectedNoteAmount(), ==, 2, "the track knows which notes are selected");
+        require_e(t->getFirstSelectedNote(), ==, 1, "the first selected note is found");
+        require_e(t->getFirstNoteTick(true), ==, 101, "the first selected note is found");
+        
+        t->action(new DeleteSelected(NULL));
+        require_e(t->getSelectedNoteAmount(), ==, 0, "deleted notes left the selection");
+        require_e(t->getFirstSelectedNote(), ==, -1, "deleted notes left the selection");
+        
+        provider.m_seq->undo();
+        std::vector<int> selection;
+        t->getSelectedNoteIDs(selection);
+        require_e(selection.size(), ==, 2u, "notes given back by undo are selected again");
+        require(selection[0] == 1 and selection[1] == 3, "notes given back by undo are selected again");
+        
+        t->selectNote(ALL_NOTES, true, true);
+        require_e(t->getSelectedNoteAmount(), ==, 4, "all notes can be selected at once");
+        
+        t->selectNote(ALL_NOTES, false, true);
+        require_e(t->getSelectedNoteAmount(), ==, 0, "all notes can be deselected at once");
+        require(not t->isNoteSelected(1) and not t->isNoteSelected(3), "deselected notes know it");
+    }
+    
+    UNIT_TEST(TestSmallSelectionOnLargeTrack)
+    {
+        const int NOTE_AMOUNT      = 1000000;
+        const int SELECTION_AMOUNT = 10;
+        
+        TestSeqProvider provider;
+        Sequence* seq = provider.m_seq;
+        Track* t = seq->getTrack(0);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=4; n<NOTE_AMOUNT; n++)
+            {
+                t->addNote_import(20 + n % 90 /* pitch */, n*100, n*100 + 50, 80, -1);
+            }
+        }
+        t->reorderNoteOffVector();
+        
+        for (int n=0; n<SELECTION_AMOUNT; n++)
+        {
+            t->selectNote((NOTE_AMOUNT/SELECTION_AMOUNT)*n + 7, true, true);
+        }
+        
+        // what every selection-scoped operation used to do first
+        wxStopWatch scanTime;
+        int found = 0;
+        for (int n=0; n<t->getNoteAmount(); n++)
+        {
+            if (t->isNoteSelected(n)) found++;
+        }
+        const long scanMs = scanTime.Time();
+        require_e(found, ==, SELECTION_AMOUNT, "sanity check");
+        
+        wxStopWatch firstTime;
+        const int first = t->getFirstSelectedNote();
+        const long firstMs = firstTime.Time();
+        require_e(first, ==, 7, "the first selected note is found");
+        
+        wxStopWatch deleteTime;
+        t->action(new DeleteSelected(NULL));
+        const long deleteMs = deleteTime.Time();
+        require_e(t->getNoteAmount(), ==, NOTE_AMOUNT - SELECTION_AMOUNT, "the selected notes were deleted");
+        require_e(t->getNoteOffVector().size(), ==, NOTE_AMOUNT - SELECTION_AMOUNT,
+                  "their note off events were deleted");
+        
+        std::cout << "[DeleteSelected] " << SELECTION_AMOUNT << " notes selected among " << NOTE_AMOUNT
+                  << " : scanning the track for them takes " << scanMs << " ms; finding the first one, "
+                  << firstMs << " ms; deleting them, " << deleteMs << " ms" << std::endl;
+    }
+    
 }
 #endif
@@ -48,6 +48,7 @@ namespace AriaMaestosa
             void perform();
             void undo();
             virtual ~DeleteSelected();
+            virtual long long getMemoryUsage() const;
         };
         
         
@@ -16,6 +16,7 @@
 
 #include "Actions/DeleteTrack.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
 #include "Midi/Track.h"
 #include "Midi/Sequence.h"
 #include "AriaCore.h"
@@ -45,6 +46,18 @@ DeleteTrack::~DeleteTrack()
 
 // --------------------------------------------------------------------------------------------------------
 
+long long DeleteTrack::getMemoryUsage() const
+{
+    // once performed, the removed track is only kept by this action
+    if (m_removed_track == NULL) return EditAction::getMemoryUsage();
+    
+    MemoryUsage track;
+    m_removed_track->getMemoryUsage(track);
+    return EditAction::getMemoryUsage() + track.getTotalBytes();
+}
+
+// --------------------------------------------------------------------------------------------------------
+
 void DeleteTrack::undo()
 {
     ASSERT(m_removed_track != NULL)
@@ -41,6 +41,7 @@ namespace AriaMaestosa
         public:
             DeleteTrack(Sequence* whichSequence);
             virtual ~DeleteTrack();
+            virtual long long getMemoryUsage() const;
 
             void perform();
             void undo();
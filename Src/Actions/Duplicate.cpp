@@ -89,25 +89,20 @@ void Duplicate::perform()
     //GraphicalTrack* gtrack = m_track->getGraphics();
     //MeasureData* md = m_track->getSequence()->getMeasureData();
     
-    ptr_vector<Note>& notes = m_visitor->getNotesVector();
-    const int count = notes.size();
-    
     std::vector<Note*> to_add;
+    m_track->getSelectedNotes(to_add);
     
-    for (int n=0; n<count; n++)
+    for (unsigned int n=0; n<to_add.size(); n++)
     {
-        if (notes[n].isSelected())
-        {
-            Note* tmp = new Note( notes[n] );
-            to_add.push_back(tmp);
-            notes[n].setSelected(false);
-        }
+        to_add[n] = new Note( *to_add[n] );
     }
+    
+    // the originals are deselected, the copies (that are selected too) join the selection when added
+    m_track->selectNote(ALL_NOTES, false, true /* ignoreModifiers */);
     for (unsigned int n=0; n<to_add.size(); n++)
     {
         m_track->addNote( to_add[n], false );
         relocator.rememberNote( to_add[n] );
-        to_add[n]->setSelected(true);
     }
 
 }
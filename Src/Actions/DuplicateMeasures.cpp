@@ -23,13 +23,41 @@
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
+#include "Parallel.h"
 #include "UnitTest.h"
 
-#include <map>
-
 using namespace AriaMaestosa;
 using namespace AriaMaestosa::Action;
 
+namespace AriaMaestosa
+{
+    /**
+      * Moves the notes and control events of each track that are after a given tick, and adds copies
+      * of those that were in the duplicated range
+      */
+    class DuplicateInTrackTask : public IParallelTask
+    {
+        ptr_vector<Track::TrackVisitor>& m_visitors;
+        Sequence* m_sequence;
+        int m_after_tick;
+        int m_stop_duplicating_at_tick;
+        int m_amount_in_ticks;
+        
+    public:
+        
+        DuplicateInTrackTask(ptr_vector<Track::TrackVisitor>& visitors, Sequence* sequence, const int afterTick,
+                             const int stopDuplicatingAtTick, const int amountInTicks) : m_visitors(visitors)
+        {
+            m_sequence                 = sequence;
+            m_after_tick               = afterTick;
+            m_stop_duplicating_at_tick = stopDuplicatingAtTick;
+            m_amount_in_ticks          = amountInTicks;
+        }
+        
+        virtual void run(const int id);
+    };
+}
+
 // --------------------------------------------------------------------------------------------------------
 
 DuplicateMeasures::DuplicateMeasures(int fromMeasure, int toMeasure) :
@@ -57,6 +85,75 @@ void DuplicateMeasures::undo()
 
 // --------------------------------------------------------------------------------------------------------
 
+void DuplicateInTrackTask::run(const int id)
+{
+    Track* track = m_sequence->getTrack(id);
+    
+    std::vector<Note> notesToDuplicate;
+    std::vector<ControllerEvent> controllerEventsToDuplicate;
+    
+    // ----------------- note events -----------------
+    ptr_vector<Note>& notes = m_visitors[id].getNotesVector();
+    const int noteAmount = notes.size();
+    for (int n=0; n<noteAmount; n++)
+    {
+        Note* note = notes.get(n);
+        if (note->getTick() > m_after_tick)
+        {
+            if (note->getTick() < m_stop_duplicating_at_tick)
+            {
+                // duplicate
+                notesToDuplicate.push_back(Note(track, note->getPitchID(), note->getTick(),
+                                                note->getEndTick(), note->getVolume(),
+                                                note->getString()));
+            }
+            
+            note->setTick(note->getTick() + m_amount_in_ticks);
+            note->setEndTick(note->getEndTick() + m_amount_in_ticks);
+        }
+    }
+    
+    // ----------------- control events -----------------
+    ptr_vector<ControllerEvent>& ctrl = m_visitors[id].getControlEventVector();
+    const int controlAmount = ctrl.size();
+    for (int n=0; n<controlAmount; n++)
+    {
+        if (ctrl[n].getTick() > m_after_tick)
+        {
+            if (ctrl[n].getTick() < m_stop_duplicating_at_tick)
+            {
+                controllerEventsToDuplicate.push_back(ControllerEvent(ctrl[n].getController(),
+                                                                      ctrl[n].getTick(),
+                                                                      ctrl[n].getValue()));
+            }
+            
+            ctrl[n].setTick( ctrl[n].getTick() + m_amount_in_ticks );
+        }
+    }
+    
+    // ----------------- add the copies -----------------
+    for (size_t n = 0; n < notesToDuplicate.size(); n++)
+    {
+        track->addNote_import(notesToDuplicate[n].getPitchID(),
+                              notesToDuplicate[n].getTick(),
+                              notesToDuplicate[n].getEndTick(), 
+                              notesToDuplicate[n].getVolume(),
+                              notesToDuplicate[n].getString());
+    }
+    
+    for (size_t n = 0; n < controllerEventsToDuplicate.size(); n++)
+    {
+        ControllerEvent& evt = controllerEventsToDuplicate[n];
+        track->addControlEvent_import(evt.getTick(), evt.getValue(), evt.getController());
+    }
+    
+    track->reorderNoteVector();
+    track->reorderNoteOffVector();
+    track->reorderControlVector();
+}
+
+// --------------------------------------------------------------------------------------------------------
+
 void DuplicateMeasures::perform()
 {
     ASSERT(m_sequence != NULL);
@@ -79,58 +176,19 @@ void DuplicateMeasures::perform()
         
         tr->setMeasureAmount( md->getMeasureAmount() + amount );
     
-        std::vector<Note> notesToDuplicate;
-        std::map<Track*, std::vector<ControllerEvent> > controllerEventsToDuplicate;
         std::vector<ControllerEvent> tempoEventsToDuplicate;
         
-        // move all notes that are after given start tick by the necessary amount
+        // move all notes that are after given start tick by the necessary amount, one track per thread
         const int trackAmount = m_sequence->getTrackAmount();
+        ptr_vector<Track::TrackVisitor> visitors;
         for (int t=0; t<trackAmount; t++)
         {
-            Track* track = m_sequence->getTrack(t);
-            
-            // ----------------- note events -----------------
-            const int noteAmount = track->getNoteAmount();
-            for (int n=0; n<noteAmount; n++)
-            {
-                Note* note = track->getNote(n);
-                if (note->getTick() > afterTick)
-                {
-                    if (note->getTick() < stopDuplicatingAtTick)
-                    {
-                        // duplicate
-                        notesToDuplicate.push_back(Note(track, note->getPitchID(), note->getTick(),
-                                                        note->getEndTick(), note->getVolume(),
-                                                        note->getString()));
-                    }
-                    
-                    note->setTick(note->getTick() + amountInTicks);
-                    note->setEndTick(note->getEndTick() + amountInTicks);
-                    
-                }
-            }
-            
-            // ----------------- control events -----------------
-            OwnerPtr<Track::TrackVisitor> tvisitor(m_visitor->getNewTrackVisitor(t));
-            ptr_vector<ControllerEvent>& ctrl = tvisitor->getControlEventVector();
-            
-            const int controlAmount = ctrl.size();
-            for (int n=0; n<controlAmount; n++)
-            {
-                if (ctrl[n].getTick() > afterTick)
-                {
-                    if (ctrl[n].getTick() < stopDuplicatingAtTick)
-                    {
-                        controllerEventsToDuplicate[track].push_back(ControllerEvent(ctrl[n].getController(),
-                                                                                     ctrl[n].getTick(),
-                                                                                     ctrl[n].getValue()));
-                    }
-                    
-                    ctrl[n].setTick( ctrl[n].getTick() + amountInTicks );
-                }
-            }
+            visitors.push_back(m_visitor->getNewTrackVisitor(t));
         }
         
+        DuplicateInTrackTask task(visitors, m_sequence, afterTick, stopDuplicatingAtTick, amountInTicks);
+        Parallel::forEach(trackAmount, &task);
+        
         // ----------------- move tempo events -----------------
         const int tempo_event_amount = m_sequence->getTempoEventAmount();
         if (tempo_event_amount>0)
@@ -173,26 +231,6 @@ void DuplicateMeasures::perform()
             }//next
         }//endif
         
-        for (size_t n = 0; n < notesToDuplicate.size(); n++)
-        {
-            notesToDuplicate[n].getParent()->addNote_import(notesToDuplicate[n].getPitchID(),
-                                                            notesToDuplicate[n].getTick(),
-                                                            notesToDuplicate[n].getEndTick(), 
-                                                            notesToDuplicate[n].getVolume(),
-                                                            notesToDuplicate[n].getString());
-        }
-        
-        for (std::map<Track*, std::vector<ControllerEvent> >::iterator it = controllerEventsToDuplicate.begin();
-             it != controllerEventsToDuplicate.end();
-             it++)
-        {
-            for (size_t n = 0; n < it->second.size(); n++)
-            {
-                ControllerEvent& evt = it->second[n];
-                it->first->addControlEvent_import(evt.getTick(), evt.getValue(), evt.getController());
-            }
-        }
-        
         for (size_t n = 0; n < tempoEventsToDuplicate.size(); n++)
         {
             wxFloat64 previousEventValue;
@@ -202,15 +240,6 @@ void DuplicateMeasures::perform()
                                       &previousEventValue);
         }
     } // end transaction
-    
-    for (int n = 0; n < m_sequence->getTrackAmount(); n++)
-    {
-        m_sequence->getTrack(n)->reorderNoteVector();
-        m_sequence->getTrack(n)->reorderNoteOffVector();
-        m_sequence->getTrack(n)->reorderControlVector();
-    }
-    
-    
 }
 
 
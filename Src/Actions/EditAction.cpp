@@ -15,6 +15,7 @@
  */
 
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
 #include "Midi/Track.h"
 #include "Midi/ControllerEvent.h"
 
@@ -31,6 +32,13 @@ EditAction::EditAction(wxString name) : m_name(name)
     
 }
 
+// ----------------------------------------------------------------------------------------------------
+
+long long EditAction::getMemoryUsage() const
+{
+    return sizeof(EditAction) + MemoryUsage::getStringBytes(m_name);
+}
+
 
 // ----------------------------------------------------------------------------------------------------
 
@@ -114,7 +114,7 @@ namespace AriaMaestosa
             wxString m_name;
 
         public:
-            LEAK_CHECK();
+            LEAK_CHECK(EditAction);
             
             EditAction(wxString name);
             virtual void perform() = 0;
@@ -123,6 +123,12 @@ namespace AriaMaestosa
             /** Some actions may not be undoable at any time */
             virtual bool canUndoNow() { return true; }
             
+            /**
+              * @return an estimate of the bytes this action keeps to be able to undo itself (see
+              *         MemoryUsage); actions that keep data for each note or event they change add it
+              */
+            virtual long long getMemoryUsage() const;
+            
             virtual ~EditAction() {}
             
             wxString getName() const { return m_name; }
@@ -146,6 +152,9 @@ namespace AriaMaestosa
             virtual void undo() = 0;
             
             void setParentTrack(Track* parent, Track::TrackVisitor* visitor);
+            
+            /** @return the track this action was performed on */
+            Track* getParentTrack() { return m_track; }
         };
         
         /**
@@ -21,13 +21,64 @@
 #include "Actions/InsertEmptyMeasures.h"
 #include "Actions/RemoveMeasures.h"
 #include "Midi/MeasureData.h"
+#include "Midi/NoteKernels.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
+#include "Parallel.h"
 #include "UnitTest.h"
 
 using namespace AriaMaestosa;
 using namespace AriaMaestosa::Action;
 
+namespace AriaMaestosa
+{
+    /** Moves the notes and control events of each track that are after a given tick */
+    class InsertInTrackTask : public IParallelTask
+    {
+        Sequence* m_sequence;
+        ptr_vector<Track::TrackVisitor>& m_visitors;
+        int m_after_tick;
+        int m_amount_in_ticks;
+        
+    public:
+        
+        InsertInTrackTask(Sequence* sequence, ptr_vector<Track::TrackVisitor>& visitors, const int afterTick,
+                          const int amountInTicks) : m_visitors(visitors)
+        {
+            m_sequence        = sequence;
+            m_after_tick      = afterTick;
+            m_amount_in_ticks = amountInTicks;
+        }
+        
+        virtual void run(const int id)
+        {
+            Track* track = m_sequence->getTrack(id);
+            
+            // ----------------- move note events -----------------
+            NoteBatch batch;
+            batch.gather(m_visitors[id].getNotesVector(), false /* all notes */,
+                         NoteBatch::TICKS | NoteBatch::END_TICKS);
+            NoteKernels::shiftAfter(NoteBatch::data(batch.m_ticks), NoteBatch::data(batch.m_end_ticks),
+                                    batch.size(), m_after_tick, m_amount_in_ticks);
+            batch.scatter(NoteBatch::TICKS | NoteBatch::END_TICKS);
+            
+            // ----------------- move control events -----------------
+            ptr_vector<ControllerEvent>& ctrl = m_visitors[id].getControlEventVector();
+            const int controlAmount = ctrl.size();
+            for (int n=0; n<controlAmount; n++)
+            {
+                if (ctrl[n].getTick() > m_after_tick)
+                {
+                    ctrl[n].setTick( ctrl[n].getTick() + m_amount_in_ticks );
+                }
+            }
+            
+            track->reorderNoteVector();
+            track->reorderNoteOffVector();
+        }
+    };
+}
+
 // --------------------------------------------------------------------------------------------------------
 
 InsertEmptyMeasures::InsertEmptyMeasures(int measureID, int amount) :
@@ -71,41 +122,17 @@ void InsertEmptyMeasures::perform()
         
         tr->setMeasureAmount( md->getMeasureAmount() + m_amount );
     
-        // move all notes that are after given start tick by the necessary amount
+        // move all notes that are after given start tick by the necessary amount, one track per thread
         const int trackAmount = m_sequence->getTrackAmount();
+        ptr_vector<Track::TrackVisitor> visitors;
         for (int t=0; t<trackAmount; t++)
         {
-            Track* track = m_sequence->getTrack(t);
-            
-            // ----------------- move note events -----------------
-            const int noteAmount = track->getNoteAmount();
-            for (int n=0; n<noteAmount; n++)
-            {
-                Note* note = track->getNote(n);
-                if (note->getTick() > afterTick)
-                {
-                    note->setTick(note->getTick() + amountInTicks);
-                    note->setEndTick(note->getEndTick() + amountInTicks);
-                }
-            }
-            // ----------------- move control events -----------------
-            
-            OwnerPtr<Track::TrackVisitor> tvisitor(m_visitor->getNewTrackVisitor(t));
-            ptr_vector<ControllerEvent>& ctrl = tvisitor->getControlEventVector();
-            
-            const int controlAmount = ctrl.size();
-            for (int n=0; n<controlAmount; n++)
-            {
-                if (ctrl[n].getTick() > afterTick)
-                {
-                    ctrl[n].setTick( ctrl[n].getTick() + amountInTicks );
-                }
-            }
-            
-            track->reorderNoteVector();
-            track->reorderNoteOffVector();
+            visitors.push_back(m_visitor->getNewTrackVisitor(t));
         }
         
+        InsertInTrackTask task(m_sequence, visitors, afterTick, amountInTicks);
+        Parallel::forEach(trackAmount, &task);
+        
         // ----------------- move tempo events -----------------
         const int tempo_event_amount = m_sequence->getTempoEventAmount();
         if (tempo_event_amount>0)
@@ -175,40 +202,44 @@ namespace InsertMeasuresTest
     public:
         Sequence* m_seq;
         
-        TestSeqProvider()
+        /** @param trackAmount  number of tracks, each with the same notes and events */
+        TestSeqProvider(const int trackAmount = 1)
         {
             m_seq = new Sequence(NULL, NULL, NULL, NULL, false);
             AriaMaestosa::setCurrentSequenceProvider(this);
             
-            Track* t = new Track(m_seq);
-            
             const int beatLen = m_seq->ticksPerQuarterNote();
             
-            // make a factory sequence to work from
+            for (int track=0; track<trackAmount; track++)
             {
-                OwnerPtr<Sequence::Import> import(m_seq->startImport());
-                for (int n=0; n<16; n++)
-                {
-                    t->addNote_import(100 + n           /* pitch  */,
-                                      n*beatLen         /* start  */,
-                                      (n+1)*beatLen - 1 /* end    */,
-                                      127               /* volume */, -1);
-                }
-                for (int n=0; n<32; n++)
-                {
-                    t->addControlEvent_import((n*beatLen)/2 /* tick */, 64+n*2 /* value */,  0 /* controller */);
-                }
-                for (int n=0; n<32; n++)
+                Track* t = new Track(m_seq);
+                
+                // make a factory sequence to work from
                 {
-                    t->addControlEvent_import((n*beatLen)/2 /* tick */, 64-n*2 /* value */,  1 /* controller */);
+                    OwnerPtr<Sequence::Import> import(m_seq->startImport());
+                    for (int n=0; n<16; n++)
+                    {
+                        t->addNote_import(100 + n           /* pitch  */,
+                                          n*beatLen         /* start  */,
+                                          (n+1)*beatLen - 1 /* end    */,
+                                          127               /* volume */, -1);
+                    }
+                    for (int n=0; n<32; n++)
+                    {
+                        t->addControlEvent_import((n*beatLen)/2 /* tick */, 64+n*2 /* value */,  0 /* controller */);
+                    }
+                    for (int n=0; n<32; n++)
+                    {
+                        t->addControlEvent_import((n*beatLen)/2 /* tick */, 64-n*2 /* value */,  1 /* controller */);
+                    }
                 }
-            }
-            
-            require_e(t->getNoteAmount(), ==, 16, "sanity check"); // sanity check on the way...
-            require_e(t->getControllerEventAmount(0), ==, 32, "Controller events OK");
-            require_e(t->getControllerEventAmount(1), ==, 32, "Controller events OK");
+                
+                require_e(t->getNoteAmount(), ==, 16, "sanity check"); // sanity check on the way...
+                require_e(t->getControllerEventAmount(0), ==, 32, "Controller events OK");
+                require_e(t->getControllerEventAmount(1), ==, 32, "Controller events OK");
 
-            m_seq->addTrack(t);            
+                m_seq->addTrack(t);
+            }
         }
         
         ~TestSeqProvider()
@@ -228,8 +259,14 @@ namespace InsertMeasuresTest
         
         void verifyUndo()
         {
-            Track* t = m_seq->getTrack(0);
-            
+            for (int track=0; track<m_seq->getTrackAmount(); track++)
+            {
+                verifyUndo(m_seq->getTrack(track));
+            }
+        }
+        
+        void verifyUndo(Track* t)
+        {
             const int beatLen = m_seq->ticksPerQuarterNote();
             
             require(t->getNoteAmount() == 16, "the number of events is fine on undo");
@@ -270,7 +307,6 @@ namespace InsertMeasuresTest
         // test the action
         provider.m_seq->action(new InsertEmptyMeasures(2 /* insert at */, 2 /* amount of measures to insert */));
         
-        // TODO: test this action on multiple tracks, not only one
         // TODO: test this action on tempo events too
         
         // verify the data is OK        
@@ -334,5 +370,37 @@ namespace InsertMeasuresTest
         provider.m_seq->undo();
         provider.verifyUndo();
     }
+    
+    // ----------------------------------------------------------------------------------------------------------
+    
+    UNIT_TEST(TestInsertOnManyTracks)
+    {
+        // tracks are processed in parallel (see Parallel::forEach), each must be modified as if it were alone
+        TestSeqProvider provider(64);
+        provider.m_seq->action(new InsertEmptyMeasures(2 /* insert at */, 2 /* amount of measures to insert */));
+        
+        const int beatLen = provider.m_seq->ticksPerQuarterNote();
+        const int insertedShift = 2*(beatLen*4); // two measures of 4 beats were inserted
+        
+        for (int track=0; track<provider.m_seq->getTrackAmount(); track++)
+        {
+            Track* t = provider.m_seq->getTrack(track);
+            require(t->getNoteAmount() == 16, "the number of events is fine");
+            require(t->getNoteOffVector().size() == 16, "Note off vector is fine");
+            
+            for (int n=0; n<16; n++)
+            {
+                const int shift = (n < 8 ? 0 : insertedShift);
+                require_e(t->getNote(n)->getTick(), ==, shift + n*beatLen, "events were properly modified by action");
+                require_e(t->getNoteOffVector()[n].getEndTick(), ==, shift + (n + 1)*beatLen - 1,
+                          "Note off vector was properly modified by action");
+            }
+            require_e(t->getControllerEvent(31, 0 /* controller */)->getTick(), ==, insertedShift + (31*beatLen)/2,
+                      "control events were properly modified");
+        }
+        
+        provider.m_seq->undo();
+        provider.verifyUndo();
+    }
 }
 #endif
@@ -23,6 +23,7 @@
 #include "Editors/Editor.h"
 #include "GUI/GraphicalTrack.h"
 
+#include "MemoryUsage.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
@@ -52,6 +53,15 @@ MoveNotes::~MoveNotes()
 
 // ----------------------------------------------------------------------------------------------------------
 
+long long MoveNotes::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(relocator.notes) +
+           MemoryUsage::getVectorBytes(undo_pitch) + MemoryUsage::getVectorBytes(undo_fret) +
+           MemoryUsage::getVectorBytes(undo_string);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void MoveNotes::undo()
 {
     Note* current_note;
@@ -107,10 +117,13 @@ void MoveNotes::perform()
 
         bool played = false;
         
-        const int noteAmount = notes.size();
-        for (int n=0; n<noteAmount; n++)
+        std::vector<int> selection;
+        m_track->getSelectedNoteIDs(selection);
+        
+        const int selectedAmount = selection.size();
+        for (int i=0; i<selectedAmount; i++)
         {
-            if (not notes[n].isSelected()) continue;
+            const int n = selection[i];
 
             doMoveOneNote(n);
             
@@ -69,6 +69,7 @@ namespace AriaMaestosa
             void doMoveOneNote(const int noteid);
             
             virtual ~MoveNotes();
+            virtual long long getMemoryUsage() const;
         };
     }
 }
@@ -51,25 +51,16 @@ void NumberPressed::undo()
 
 void NumberPressed::perform()
 {
-    bool played = false;
-    
     ptr_vector<Note>& notes = m_visitor->getNotesVector();
-    const int noteAmount = notes.size();
     
-    for (int n=0; n<noteAmount; n++)
-    {
-        if (not notes[n].isSelected()) continue;
-
-        m_previous_number = notes[n].getFret();
-        notes[n].setFret(m_number);
-        relocator.rememberNote( notes[n] );
-        if (not played)
-        {
-            notes[n].play(true);
-            played = true;
-        }
-        return;
-    }//next
+    // only the first selected note is concerned
+    const int n = m_track->getFirstSelectedNote();
+    if (n == -1) return;
+    
+    m_previous_number = notes[n].getFret();
+    notes[n].setFret(m_number);
+    relocator.rememberNote( notes[n] );
+    notes[n].play(true);
 }
 
 
@@ -144,9 +144,7 @@ void Paste::perform()
     if (not m_at_mouse) beginning=0;
 
     // unselected previously selected track->m_notes
-    ptr_vector<Note>& notes = m_visitor->getNotesVector();
-    const int count = notes.size();
-    for (int n=0; n<count; n++) notes[n].setSelected(false);
+    m_track->selectNote(ALL_NOTES, false, true /* ignoreModifiers */);
 
     // find where track->m_notes begin if necessary
     if (m_at_mouse)
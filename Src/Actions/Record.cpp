@@ -17,6 +17,7 @@
 #include "Actions/Record.h"
 
 #include "AriaCore.h"
+#include "MemoryUsage.h"
 #include "Midi/Track.h"
 #include "Midi/Sequence.h"
 #include "Midi/Players/PlatformMidiManager.h"
@@ -41,6 +42,20 @@ Record::~Record()
 
 // ----------------------------------------------------------------------------------------------------------
 
+long long Record::getMemoryUsage() const
+{
+    long long bytes = EditAction::getMemoryUsage();
+    
+    const int actionAmount = m_actions.size();
+    for (int n=0; n<actionAmount; n++)
+    {
+        bytes += m_actions.getConst(n)->getMemoryUsage();
+    }
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void Record::undo()
 {
     for (int n=m_actions.size() - 1; n >= 0; n--)
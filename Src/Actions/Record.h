@@ -47,6 +47,7 @@ namespace AriaMaestosa
             virtual bool canUndoNow();
             
             virtual ~Record();
+            virtual long long getMemoryUsage() const;
         };
         
     }
@@ -18,19 +18,60 @@
 #include "Actions/InsertEmptyMeasures.h"
 #include "Actions/EditAction.h"
 #include "IO/IOUtils.h"
+#include "MemoryUsage.h"
 #include "Midi/Track.h"
 #include "Midi/Sequence.h"
 #include "Midi/TimeSigChange.h"
 #include "Midi/MeasureData.h"
 #include "AriaCore.h"
+#include "Parallel.h"
 
 #include <iostream>
 #include <map>
 
 #include <wx/intl.h>
 
+using namespace AriaMaestosa;
 using namespace AriaMaestosa::Action;
 
+namespace AriaMaestosa
+{
+    /** Removes the notes and control events of each track in the given range, and moves back those after it */
+    class RemoveFromTrackTask : public IParallelTask
+    {
+        ptr_vector<Track::TrackVisitor>& m_visitors;
+        ptr_vector<RemoveMeasures::RemovedTrackPart>& m_parts;
+        int m_from_tick;
+        int m_to_tick;
+        
+    public:
+        
+        RemoveFromTrackTask(ptr_vector<Track::TrackVisitor>& visitors,
+                            ptr_vector<RemoveMeasures::RemovedTrackPart>& parts,
+                            const int fromTick, const int toTick) : m_visitors(visitors), m_parts(parts)
+        {
+            m_from_tick = fromTick;
+            m_to_tick   = toTick;
+        }
+        
+        virtual void run(const int id);
+    };
+    
+    /** Adds back the notes and control events removed from each track */
+    class RestoreTrackTask : public IParallelTask
+    {
+        ptr_vector<RemoveMeasures::RemovedTrackPart>& m_parts;
+        
+    public:
+        
+        RestoreTrackTask(ptr_vector<RemoveMeasures::RemovedTrackPart>& parts) : m_parts(parts)
+        {
+        }
+        
+        virtual void run(const int id);
+    };
+}
+
 // ----------------------------------------------------------------------------------------------------------
 
 RemoveMeasures::RemoveMeasures(int from_measure, int to_measure) :
@@ -49,41 +90,63 @@ RemoveMeasures::~RemoveMeasures()
 
 // ----------------------------------------------------------------------------------------------------------
 
+long long RemoveMeasures::getMemoryUsage() const
+{
+    long long bytes = EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(removedTempoEvents) +
+                      MemoryUsage::getVectorBytes(removedTextEvents) +
+                      MemoryUsage::getVectorBytes(timeSigChangesBackup);
+    
+    const int partAmount = removedTrackParts.size();
+    for (int n=0; n<partAmount; n++)
+    {
+        const RemovedTrackPart* part = removedTrackParts.getConst(n);
+        bytes += sizeof(RemovedTrackPart) + MemoryUsage::getVectorBytes(part->removedNotes) +
+                 MemoryUsage::getVectorBytes(part->removedControlEvents);
+    }
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 RemoveMeasures::RemovedTrackPart::~RemovedTrackPart()
 {
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
+void RestoreTrackTask::run(const int id)
+{
+    RemoveMeasures::RemovedTrackPart* removedBits = m_parts.get(id);
+    
+    // add removed notes again
+    const int n_amount = removedBits->removedNotes.size();
+    for (int n=0; n<n_amount; n++)
+    {
+        removedBits->track->addNote( removedBits->removedNotes.get(n) );
+    }
+    // we are using the notes again, so make sure it won't delete them
+    removedBits->removedNotes.clearWithoutDeleting();
+    
+    // add removed control events again
+    const int c_amount = removedBits->removedControlEvents.size();
+    for (int n=0; n<c_amount; n++)
+    {
+        removedBits->track->addControlEvent( removedBits->removedControlEvents.get(n) );
+    }
+    // we are using the events again, so make sure it won't delete them
+    removedBits->removedControlEvents.clearWithoutDeleting();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void RemoveMeasures::undo()
 {
     Action::InsertEmptyMeasures opposite_action(m_from_measure, (m_to_measure - m_from_measure));
     opposite_action.setParentSequence( m_sequence, m_visitor->clone() );
     opposite_action.perform();
     
-    const int rmtrackamount = removedTrackParts.size();
-    for (int rm=0; rm<rmtrackamount; rm++)
-    {
-        RemovedTrackPart* removedBits = removedTrackParts.get(rm);
-        
-        // add removed notes again
-        const int n_amount = removedBits->removedNotes.size();
-        for (int n=0; n<n_amount; n++)
-        {
-            removedBits->track->addNote( removedBits->removedNotes.get(n) );
-        }
-        // we are using the notes again, so make sure it won't delete them
-        removedBits->removedNotes.clearWithoutDeleting();
-        
-        // add removed control events again
-        const int c_amount = removedBits->removedControlEvents.size();
-        for (int n=0; n<c_amount; n++)
-        {
-            removedBits->track->addControlEvent( removedBits->removedControlEvents.get(n) );
-        }
-        // we are using the events again, so make sure it won't delete them
-        removedBits->removedControlEvents.clearWithoutDeleting();
-    }
+    RestoreTrackTask task(removedTrackParts);
+    Parallel::forEach(removedTrackParts.size(), &task);
     
     // add removed tempo events again
     const int s_amount = removedTempoEvents.size();
@@ -124,6 +187,81 @@ void RemoveMeasures::undo()
 
 // ----------------------------------------------------------------------------------------------------------
 
+void RemoveFromTrackTask::run(const int id)
+{
+    RemoveMeasures::RemovedTrackPart* removedBits = m_parts.get(id);
+    Track* track = removedBits->track;
+    
+    const int fromTick = m_from_tick;
+    const int toTick   = m_to_tick;
+    const int amountInTicks = toTick - fromTick - 1;
+    
+    ptr_vector<Note>& notes = m_visitors[id].getNotesVector();
+    
+    // ------------------------ erase/move notes ------------------------
+    const int amount_n = notes.size();
+    for (int n=0; n<amount_n; n++)
+    {
+        Note* note = notes.get(n);
+        
+        // note is an area that is removed. remove it.
+        if (note->getTick() > fromTick and note->getTick() < toTick)
+        {
+            removedBits->removedNotes.push_back(note);
+            track->markNoteToBeRemoved(n);
+        }
+        // note is in after the removed area. move it back by necessary amound
+        else if (notes[n].getTick() >= toTick)
+        {
+            note->setTick( note->getTick() - amountInTicks);
+            note->setEndTick( note->getEndTick() - amountInTicks);
+        }
+    }
+    track->removeMarkedNotes();
+    
+    // ------------------------ erase/move control events ------------------------
+    
+    ptr_vector<ControllerEvent>& ctrl = m_visitors[id].getControlEventVector();
+    
+    std::map<int, wxFloat64> latest_value_by_controller;
+    
+    const int c_amount = ctrl.size();
+    for (int n=0; n<c_amount; n++)
+    {
+        // delete all controller events located in the area to be deleted
+        if (ctrl[n].getTick() > fromTick and ctrl[n].getTick() < toTick)
+        {
+            latest_value_by_controller[ctrl[n].getController()] = ctrl[n].getValue();
+            removedBits->removedControlEvents.push_back( ctrl.get(n) );
+            ctrl.markToBeRemoved(n);
+        }
+        // move all controller events that are after given start tick by the necessary amount
+        else if (ctrl[n].getTick() >= toTick)
+        {
+            ctrl[n].setTick(ctrl[n].getTick() - amountInTicks);
+        }
+    }
+    ctrl.removeMarked();
+    
+    // if needed, insert a new event at the end of the deleted section with the latest value
+    // the controller had. This part is not undoable since the additional event doesn't hurt.
+    for (std::map<int, wxFloat64>::iterator it = latest_value_by_controller.begin();
+         it != latest_value_by_controller.end(); it++)
+    {
+         if (track->getControllerEventAt(toTick - amountInTicks, it->first) == NULL)
+         {
+             wxFloat64 previousVal;
+             track->addControlEvent(new ControllerEvent(it->first, toTick - amountInTicks, it->second),
+                                    &previousVal);
+         }
+    }
+    
+    track->reorderNoteVector();
+    track->reorderNoteOffVector();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void RemoveMeasures::perform()
 {
     
@@ -139,80 +277,21 @@ void RemoveMeasures::perform()
     // after the area that is removed.
     const int amountInTicks = toTick - fromTick - 1;
     
+    // parts are created in track order, so that undo data doesn't depend on how tracks were scheduled
     const int trackAmount = m_sequence->getTrackAmount();
+    ptr_vector<Track::TrackVisitor> visitors;
     for (int t=0; t<trackAmount; t++)
     {
         RemovedTrackPart* removedBits = new RemovedTrackPart();
+        removedBits->track = m_sequence->getTrack(t);
         removedTrackParts.push_back( removedBits );
         
-        Track* track = m_sequence->getTrack(t);
-        removedBits->track = track;
-        
-        OwnerPtr<Track::TrackVisitor> tvisitor(m_visitor->getNewTrackVisitor(t));
-        ptr_vector<Note>& notes = tvisitor->getNotesVector();
-        
-        // ------------------------ erase/move notes ------------------------
-        const int amount_n = notes.size();
-        for (int n=0; n<amount_n; n++)
-        {
-            Note* note = notes.get(n);
-            
-            // note is an area that is removed. remove it.
-            if (note->getTick() > fromTick and note->getTick() < toTick)
-            {
-                removedBits->removedNotes.push_back(note);
-                track->markNoteToBeRemoved(n);
-            }
-            // note is in after the removed area. move it back by necessary amound
-            else if (notes[n].getTick() >= toTick)
-            {
-                note->setTick( note->getTick() - amountInTicks);
-                note->setEndTick( note->getEndTick() - amountInTicks);
-            }
-        }
-        track->removeMarkedNotes();
-        
-        // ------------------------ erase/move control events ------------------------
-        
-        ptr_vector<ControllerEvent>& ctrl = tvisitor->getControlEventVector();
-        
-        std::map<int, wxFloat64> latest_value_by_controller;
-        
-        const int c_amount = ctrl.size();
-        for (int n=0; n<c_amount; n++)
-        {
-            // delete all controller events located in the area to be deleted
-            if (ctrl[n].getTick() > fromTick and ctrl[n].getTick() < toTick)
-            {
-                latest_value_by_controller[ctrl[n].getController()] = ctrl[n].getValue();
-                removedBits->removedControlEvents.push_back( ctrl.get(n) );
-                ctrl.markToBeRemoved(n);
-            }
-            // move all controller events that are after given start tick by the necessary amount
-            else if (ctrl[n].getTick() >= toTick)
-            {
-                ctrl[n].setTick(ctrl[n].getTick() - amountInTicks);
-            }
-        }
-        ctrl.removeMarked();
-        
-        // if needed, insert a new event at the end of the deleted section with the latest value
-        // the controller had. This part is not undoable since the additional event doesn't hurt.
-        for (std::map<int, wxFloat64>::iterator it = latest_value_by_controller.begin();
-             it != latest_value_by_controller.end(); it++)
-        {
-             if (track->getControllerEventAt(toTick - amountInTicks, it->first) == NULL)
-             {
-                 wxFloat64 previousVal;
-                 track->addControlEvent(new ControllerEvent(it->first, toTick - amountInTicks, it->second),
-                                        &previousVal);
-             }
-        }
-        
-        track->reorderNoteVector();
-        track->reorderNoteOffVector();
+        visitors.push_back(m_visitor->getNewTrackVisitor(t));
     }
     
+    RemoveFromTrackTask task(visitors, removedTrackParts, fromTick, toTick);
+    Parallel::forEach(trackAmount, &task);
+    
     
     // ------------------------ erase/move tempo events ------------------------
     const int s_amount = m_sequence->getTempoEventAmount();
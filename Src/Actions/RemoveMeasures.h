@@ -23,6 +23,8 @@ namespace AriaMaestosa
 {
     class Track;
     class TimeSigChange;
+    class RemoveFromTrackTask;
+    class RestoreTrackTask;
     
     namespace Action
     {
@@ -44,6 +46,8 @@ namespace AriaMaestosa
             };
             
             friend class AriaMaestosa::Track;
+            friend class AriaMaestosa::RemoveFromTrackTask;
+            friend class AriaMaestosa::RestoreTrackTask;
             int m_from_measure, m_to_measure;
             
             ptr_vector<RemovedTrackPart> removedTrackParts;
@@ -55,6 +59,7 @@ namespace AriaMaestosa
             void perform();
             void undo();
             virtual ~RemoveMeasures();
+            virtual long long getMemoryUsage() const;
         };
         
         
@@ -16,12 +16,12 @@
 
 #include "Actions/RemoveOverlapping.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
 #include "Midi/Track.h"
 #include "Midi/Note.h"
 #include "AriaCore.h"
 
 #include <wx/intl.h>
-#include <wx/utils.h>
 
 using namespace AriaMaestosa::Action;
 
@@ -36,6 +36,13 @@ RemoveOverlapping::~RemoveOverlapping()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+long long RemoveOverlapping::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(removedNotes);
+}
+
 void RemoveOverlapping::undo()
 {
     const int noteAmount = removedNotes.size();
@@ -50,7 +57,6 @@ void RemoveOverlapping::undo()
 void RemoveOverlapping::perform()
 {
     ASSERT(m_track != NULL);
-    wxBeginBusyCursor();
     
     ptr_vector<Note>& notes = m_visitor->getNotesVector();
     const int noteAmount = notes.size();
@@ -91,7 +97,6 @@ void RemoveOverlapping::perform()
     }//next n1
     
     m_track->removeMarkedNotes();
-    wxEndBusyCursor();
     
     Display::render();
     
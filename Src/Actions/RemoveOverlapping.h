@@ -41,6 +41,7 @@ namespace AriaMaestosa
             void perform();
             void undo();
             virtual ~RemoveOverlapping();
+            virtual long long getMemoryUsage() const;
         };
         
     }
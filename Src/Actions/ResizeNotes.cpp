@@ -71,9 +71,14 @@ void ResizeNotes::perform()
     if (m_note_ID == SELECTED_NOTES)
     {        
         bool played = false;
-        for (int n=0; n<notes.size(); n++)
+        
+        std::vector<int> selection;
+        m_track->getSelectedNoteIDs(selection);
+        
+        const int selectedAmount = selection.size();
+        for (int i=0; i<selectedAmount; i++)
         {
-            if (not notes[n].isSelected()) continue;
+            const int n = selection[i];
             
             notes[n].resize(m_relative_width);
             relocator.rememberNote(notes[n]);
@@ -17,13 +17,45 @@
 #include "Actions/ScaleTrack.h"
 #include "Actions/ScaleSong.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
+#include "Midi/MeasureData.h"
 #include "Midi/Track.h"
 #include "Midi/Sequence.h"
+#include "Parallel.h"
 
+#include <algorithm>
 #include <wx/intl.h>
 
+using namespace AriaMaestosa;
 using namespace AriaMaestosa::Action;
 
+namespace AriaMaestosa
+{
+    /** Scales or unscales the notes of each track, see ScaleSong */
+    class ScaleTrackTask : public IParallelTask
+    {
+        ptr_vector<ScaleTrack>& m_actions;
+        bool m_undo;
+        
+    public:
+        
+        /** end tick of the last note scaled in each track */
+        std::vector<int> m_last_ticks;
+        
+        ScaleTrackTask(ptr_vector<ScaleTrack>& actions, const bool undo) : m_actions(actions)
+        {
+            m_undo = undo;
+            m_last_ticks.resize(actions.size(), -1);
+        }
+        
+        virtual void run(const int id)
+        {
+            if (m_undo) m_actions[id].undo();
+            else        m_last_ticks[id] = m_actions[id].scaleNotes();
+        }
+    };
+}
+
 
 ScaleSong::ScaleSong(float factor, int relative_to) :
     //I18N: (undoable) action name
@@ -37,25 +69,52 @@ ScaleSong::~ScaleSong()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+long long ScaleSong::getMemoryUsage() const
+{
+    long long bytes = EditAction::getMemoryUsage();
+    
+    const int actionAmount = actions.size();
+    for (int n=0; n<actionAmount; n++)
+    {
+        bytes += actions.getConst(n)->getMemoryUsage();
+    }
+    return bytes;
+}
+
 void ScaleSong::perform()
 {
+    // actions are created in track order, so that undo data doesn't depend on how tracks were scheduled
     const int trackAmount = m_sequence->getTrackAmount();
     for (int t=0; t<trackAmount; t++)
     {
         Action::ScaleTrack* action = new Action::ScaleTrack(m_factor, m_relative_to, false);
         
         action->setParentTrack(m_sequence->getTrack(t), m_visitor->getNewTrackVisitor(t));
-        action->perform();
         actions.push_back(action);
     }
+    
+    ScaleTrackTask task(actions, false);
+    Parallel::forEach(trackAmount, &task);
+    
+    // the measures are shared by all tracks, extend them once all tracks were scaled
+    int last_tick = -1;
+    for (int t=0; t<trackAmount; t++)
+    {
+        last_tick = std::max(last_tick, task.m_last_ticks[t]);
+    }
+    
+    MeasureData* md = m_sequence->getMeasureData();
+    if (last_tick > md->getTotalTickAmount())
+    {
+        md->extendToTick(last_tick);
+    }
 }
 
 void ScaleSong::undo()
 {
-    const int amount = actions.size();
-    for (int a=0; a<amount; a++)
-    {
-        actions[a].undo();
-    }
+    ScaleTrackTask task(actions, true);
+    Parallel::forEach(actions.size(), &task);
 }
 
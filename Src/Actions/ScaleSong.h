@@ -43,6 +43,7 @@ namespace AriaMaestosa
             void perform();
             void undo();
             virtual ~ScaleSong();
+            virtual long long getMemoryUsage() const;
         };
         
     }
@@ -16,7 +16,9 @@
 
 #include "Actions/ScaleTrack.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
 #include "Midi/MeasureData.h"
+#include "Midi/NoteKernels.h"
 #include "Midi/Track.h"
 
 #include <wx/intl.h>
@@ -42,6 +44,14 @@ ScaleTrack::~ScaleTrack()
 
 // ----------------------------------------------------------------------------------------------------------
 
+long long ScaleTrack::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(relocator.notes) +
+           MemoryUsage::getVectorBytes(m_note_start) + MemoryUsage::getVectorBytes(m_note_end);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void ScaleTrack::undo()
 {
     Note* current_note;
@@ -64,39 +74,51 @@ void ScaleTrack::perform()
 {
     ASSERT(m_track != NULL);
     
-    ptr_vector<Note>& notes = m_visitor->getNotesVector();
-    const int noteAmount = notes.size();
-    
-    int last_tick = -1;
-    
-    for (int n=0; n<noteAmount; n++)
-    {
-        // skip unselected notes if we only want to affect selection
-        if (m_selection_only and not notes[n].isSelected()) continue; 
-        
-        const int startTick = notes[n].getTick();
-        const int endTick   = notes[n].getEndTick();
-        
-        m_note_start.push_back( startTick );
-        m_note_end.push_back( endTick );
-        
-        notes[n].setTick   ( (int)( (startTick - m_relative_to)*m_factor + m_relative_to ) );
-        notes[n].setEndTick( (int)( (endTick   - m_relative_to)*m_factor + m_relative_to ) );
-        relocator.rememberNote(notes[n]);
-        
-        if (notes[n].getEndTick() > last_tick) last_tick = notes[n].getEndTick();
-        
-    }//next
+    const int last_tick = scaleNotes();
     
     MeasureData* md = m_track->getSequence()->getMeasureData();
     if (last_tick > md->getTotalTickAmount())
     {        
         md->extendToTick(last_tick);
     }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int ScaleTrack::scaleNotes()
+{
+    ASSERT(m_track != NULL);
+    
+    // skip unselected notes if we only want to affect selection
+    NoteBatch batch;
+    if (m_selection_only)
+    {
+        batch.gatherSelection(m_track, NoteBatch::TICKS | NoteBatch::END_TICKS);
+    }
+    else
+    {
+        batch.gather(m_visitor->getNotesVector(), false, NoteBatch::TICKS | NoteBatch::END_TICKS);
+    }
+    
+    m_note_start.insert(m_note_start.end(), batch.m_ticks.begin(),     batch.m_ticks.end());
+    m_note_end.insert  (m_note_end.end(),   batch.m_end_ticks.begin(), batch.m_end_ticks.end());
     
+    const int noteAmount = batch.size();
+    NoteKernels::scale(NoteBatch::data(batch.m_ticks),     noteAmount, m_factor, m_relative_to);
+    NoteKernels::scale(NoteBatch::data(batch.m_end_ticks), noteAmount, m_factor, m_relative_to);
+    batch.scatter(NoteBatch::TICKS | NoteBatch::END_TICKS);
+    
+    for (int n=0; n<noteAmount; n++)
+    {
+        relocator.rememberNote(batch.m_notes[n]);
+    }
+    
+    const int last_tick = NoteKernels::getMax(NoteBatch::data(batch.m_end_ticks), noteAmount, -1);
     
     m_track->reorderNoteVector();
     m_track->reorderNoteOffVector();
+    
+    return last_tick;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -44,8 +44,17 @@ namespace AriaMaestosa
             
             ScaleTrack(float factor, int relative_to, bool selectionOnly);
             void perform();
+            
+            /**
+              * @brief the part of 'perform' that only modifies the track, so that ScaleSong can run it
+              *        for several tracks at once
+              * @return the end tick of the last scaled note, or -1 if none was scaled; the song must be
+              *         extended up to it (see MeasureData::extendToTick)
+              */
+            int scaleNotes();
             void undo();
             virtual ~ScaleTrack();
+            virtual long long getMemoryUsage() const;
         };
         
     }
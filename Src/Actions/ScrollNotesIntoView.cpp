@@ -67,8 +67,6 @@ void ScrollNotesIntoView::perform()
     int trackCount;
     float sbPosition;
     
-    wxBeginBusyCursor();
-    
     trackCount = m_sequence->getTrackAmount();
     m_positions.clear();
     
@@ -84,8 +82,6 @@ void ScrollNotesIntoView::perform()
         // Performs action
         keyboardEditor->scrollNotesIntoView();
     }
-
-    wxEndBusyCursor();
     
     Display::render();
 }
@@ -67,10 +67,13 @@ void SetAccidentalSign::perform()
 
     ptr_vector<Note>& notes = m_visitor->getNotesVector();
     
-    const int noteAmount = notes.size();
-    for (int n=0; n<noteAmount; n++)
+    std::vector<int> selection;
+    m_track->getSelectedNoteIDs(selection);
+    
+    const int selectedAmount = selection.size();
+    for (int i=0; i<selectedAmount; i++)
     {
-        if (not notes[n].isSelected()) continue;
+        const int n = selection[i];
 
         m_original_signs.push_back( notes[n].getPreferredAccidentalSign() );
         m_pitch.push_back( notes[n].getPitchID() );
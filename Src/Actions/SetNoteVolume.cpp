@@ -16,6 +16,8 @@
 
 #include "Actions/SetNoteVolume.h"
 #include "Actions/EditAction.h"
+#include "MemoryUsage.h"
+#include "Midi/NoteKernels.h"
 #include "Midi/Track.h"
 
 #include <wx/intl.h>
@@ -35,6 +37,14 @@ SetNoteVolume::~SetNoteVolume()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+long long SetNoteVolume::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(relocator.notes) +
+           MemoryUsage::getVectorBytes(m_volumes);
+}
+
 void SetNoteVolume::undo()
 {
     Note* current_note;
@@ -57,26 +67,27 @@ void SetNoteVolume::perform()
 
     if (m_note_ID == SELECTED_NOTES)
     {
-        bool played = false;
-        const int noteAmount = notes.size();
+        NoteBatch batch;
+        batch.gatherSelection(m_track, NoteBatch::VOLUMES);
+        m_volumes.insert(m_volumes.end(), batch.m_volumes.begin(), batch.m_volumes.end());
+        
+        const int noteAmount = batch.size();
+        if (m_increment)
+        {
+            NoteKernels::addClamped(NoteBatch::data(batch.m_volumes), noteAmount, m_value, 0, SCHAR_MAX);
+        }
+        else
+        {
+            NoteKernels::fill(NoteBatch::data(batch.m_volumes), noteAmount, m_value);
+        }
+        batch.scatter(NoteBatch::VOLUMES);
         
         for (int n=0; n<noteAmount; n++)
         {
-            if (notes[n].isSelected())
-            {
-                volume = notes[n].getVolume();
-                m_volumes.push_back(volume);
-                adjustVolume(volume);
-                notes[n].setVolume(volume);
-                relocator.rememberNote(notes[n]);
-                if (not played)
-                {
-                    notes[n].play(true);
-                    played = true;
-                }
-            }
-        }//next note
+            relocator.rememberNote(batch.m_notes[n]);
+        }
         
+        if (noteAmount > 0) batch.m_notes[0]->play(true);
     }
     else
     {
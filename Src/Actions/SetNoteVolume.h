@@ -53,6 +53,7 @@ namespace AriaMaestosa
             void perform();
             void undo();
             virtual ~SetNoteVolume();
+            virtual long long getMemoryUsage() const;
         };
         
     }
@@ -17,6 +17,7 @@
 #include "Actions/ShiftBySemiTone.h"
 #include "Actions/EditAction.h"
 
+#include "Midi/NoteKernels.h"
 #include "Midi/Track.h"
 
 #include <wx/intl.h>
@@ -71,24 +72,18 @@ void ShiftBySemiTone::perform()
     // concerns all selected notes
     if (m_note_id == SELECTED_NOTES)
     {
-        bool played = false;
-        const int amount_n = notes.size();
+        NoteBatch batch;
+        batch.gatherSelection(m_track, NoteBatch::PITCHES);
+        NoteKernels::add(NoteBatch::data(batch.m_pitches), batch.size(), m_delta_y);
+        batch.scatter(NoteBatch::PITCHES);
+        
+        const int amount_n = batch.size();
         for (int n=0; n<amount_n; n++)
         {
-            Note* note = notes.get(n);
-            
-            if (not note->isSelected()) continue;
-            
-            note->setPitchID( note->getPitchID() + m_delta_y );
-            m_relocator.rememberNote( notes[n] );
-            
-            if (not played)
-            {
-                note->play(true);
-                played = true;
-            }
-        }//next
+            m_relocator.rememberNote( batch.m_notes[n] );
+        }
         
+        if (amount_n > 0) batch.m_notes[0]->play(true);
     }
     // only concernes one specific note
     else
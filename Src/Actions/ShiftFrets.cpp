@@ -60,10 +60,14 @@ void ShiftFrets::perform()
     {
         
         bool played = false;
-        const int noteAmount = notes.size();
-        for (int n=0; n<noteAmount; n++)
+        
+        std::vector<int> selection;
+        m_track->getSelectedNoteIDs(selection);
+        
+        const int selectedAmount = selection.size();
+        for (int i=0; i<selectedAmount; i++)
         {
-            if (not notes[n].isSelected()) continue;
+            const int n = selection[i];
             
             m_strings.push_back( notes[n].getString() );
             m_frets.push_back( notes[n].getFret() );
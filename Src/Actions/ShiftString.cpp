@@ -71,11 +71,14 @@ void ShiftString::perform()
     {
         
         bool played=false;
-        const int amount_n = notes.size();
         
-        for (int n=0; n<amount_n; n++)
+        std::vector<int> selection;
+        m_track->getSelectedNoteIDs(selection);
+        
+        const int selectedAmount = selection.size();
+        for (int i=0; i<selectedAmount; i++)
         {
-            if (not notes[n].isSelected()) continue;
+            const int n = selection[i];
             
             m_frets.push_back( notes[n].getFret() );
             m_strings.push_back( notes[n].getString() );
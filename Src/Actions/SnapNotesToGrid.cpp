@@ -17,6 +17,9 @@
 #include "Actions/SnapNotesToGrid.h"
 #include "Actions/EditAction.h"
 
+#include "MemoryUsage.h"
+#include "Midi/MeasureData.h"
+#include "Midi/NoteKernels.h"
 #include "Midi/Track.h"
 
 #include <wx/intl.h>
@@ -33,6 +36,14 @@ SnapNotesToGrid::~SnapNotesToGrid()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+long long SnapNotesToGrid::getMemoryUsage() const
+{
+    return EditAction::getMemoryUsage() + MemoryUsage::getVectorBytes(relocator.notes) +
+           MemoryUsage::getVectorBytes(note_start) + MemoryUsage::getVectorBytes(note_end);
+}
+
 void SnapNotesToGrid::undo()
 {
     Note* current_note;
@@ -55,31 +66,60 @@ void SnapNotesToGrid::perform()
     
     ASSERT(m_track != NULL);
     
-    ptr_vector<Note>& notes = m_visitor->getNotesVector();
+    NoteBatch batch;
+    batch.gatherSelection(m_track, NoteBatch::TICKS | NoteBatch::END_TICKS);
+    
+    note_start = batch.m_ticks;
+    note_end   = batch.m_end_ticks;
+    
+    const int amount = batch.size();
+    for (int n=0; n<amount; n++)
+    {
+        relocator.rememberNote(batch.m_notes[n]);
+    }
     
-    const int n_amount = notes.size();
-    for (int n=0; n<n_amount; n++)
+    if (m_track->getSequence()->getMeasureData()->isMeasureLengthConstant())
     {
-        Note* note = notes.get(n);
-        if (not note->isSelected()) continue;
+        // the grid is the same everywhere, snap all notes at once
+        int origin;
+        float startStep, lengthStep;
+        m_track->getMagneticGridStep(0, true,  &origin, &startStep);
+        m_track->getMagneticGridStep(0, false, &origin, &lengthStep);
         
-        note_start.push_back( note->getTick() );
-        note_end.push_back( note->getEndTick() );
+        std::vector<int> lengths(amount);
+        for (int n=0; n<amount; n++) lengths[n] = batch.m_end_ticks[n] - batch.m_ticks[n];
         
-        int len = note->getEndTick() - note->getTick();
-        note->setTick( m_track->snapMidiTickToGrid( note->getTick(), true ) );
+        // a note that would collapse uses the 'ceil' variant instead
+        std::vector<int> ceilLengths = lengths;
+        NoteKernels::snapToGrid(NoteBatch::data(batch.m_ticks), amount, origin, startStep,  false);
+        NoteKernels::snapToGrid(NoteBatch::data(lengths),       amount, origin, lengthStep, false);
+        NoteKernels::snapToGrid(NoteBatch::data(ceilLengths),   amount, origin, lengthStep, true);
         
-        int end_tick = note->getTick() + m_track->snapMidiTickToGrid( len, false );
-        if ( note->getTick() == end_tick )
+        for (int n=0; n<amount; n++)
         {
-            // note was collapsed, not good.
-            // use the 'ceil' variant of snapTickToGrid instead
-            end_tick = note->getTick() + m_track->snapMidiTickToGrid( len, false, true );
+            batch.m_end_ticks[n] = batch.m_ticks[n] + (lengths[n] == 0 ? ceilLengths[n] : lengths[n]);
         }
-        
-        note->setEndTick( end_tick );
-        relocator.rememberNote(notes[n]);
     }
+    else
+    {
+        // the grid starts over at each measure
+        for (int n=0; n<amount; n++)
+        {
+            const int len = batch.m_end_ticks[n] - batch.m_ticks[n];
+            batch.m_ticks[n] = m_track->snapMidiTickToGrid( batch.m_ticks[n], true );
+            
+            int end_tick = batch.m_ticks[n] + m_track->snapMidiTickToGrid( len, false );
+            if ( batch.m_ticks[n] == end_tick )
+            {
+                // note was collapsed, not good.
+                // use the 'ceil' variant of snapTickToGrid instead
+                end_tick = batch.m_ticks[n] + m_track->snapMidiTickToGrid( len, false, true );
+            }
+            batch.m_end_ticks[n] = end_tick;
+        }
+    }
+    
+    batch.scatter(NoteBatch::TICKS | NoteBatch::END_TICKS);
     
     
     m_track->reorderNoteVector();
@@ -249,7 +249,7 @@ namespace AriaMaestosa
         ScoreAnalyser() {}
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(ScoreAnalyser);
         
         SortableVector<NoteRenderInfo> m_note_render_info;
         
@@ -257,6 +257,18 @@ namespace AriaMaestosa
         
         virtual ~ScoreAnalyser() {}
         
+        /** @brief frees the notes analysed by the last render; they are analysed again on the next one */
+        void releaseMemory()
+        {
+            SortableVector<NoteRenderInfo>().swap(m_note_render_info);
+        }
+        
+        /** @return the approximate number of bytes used by this analyser */
+        long long getMemoryBytes() const
+        {
+            return sizeof(ScoreAnalyser) + (long long)m_note_render_info.capacity()*sizeof(NoteRenderInfo);
+        }
+        
         /**
          * @return a new ScoreAnalyser, that contains a subset of the current one.
          * @note   The returned pointer must be freed.
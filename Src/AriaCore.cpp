@@ -15,14 +15,20 @@
  */
 
 #include "AriaCore.h"
+#ifndef ARIA_BENCH
 #include "main.h"
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
+#endif
 #include "PreferencesData.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "version.h"
 
+#ifdef RENDERER_HEADLESS
+#include "Renderers/HeadlessRenderer.h"
+#endif
+
 #include <wx/string.h>
 #include <wx/font.h>
 #include <wx/dcmemory.h>
@@ -50,6 +56,8 @@ namespace AriaMaestosa
             mainPane = pane;
         }
         
+#ifndef ARIA_BENCH
+        // aria_bench has no window, it links its own versions of these (see Bench/BenchStubs.cpp)
         void activateRenderLoop(bool on)
         {
             wxGetApp().activateRenderLoop(on);
@@ -71,6 +79,7 @@ namespace AriaMaestosa
         {
             return getMainFrame()->getInstrumentPicker();
         }
+#endif
         
         // TODO: move this into the midi player
         PlayDuringEditMode g_play_during_edit = PLAY_ALWAYS;
@@ -82,17 +91,21 @@ namespace AriaMaestosa
         {
             return g_play_during_edit;
         }
+#ifndef ARIA_BENCH
         void songHasFinishedPlaying()
         {
             getMainFrame()->songHasFinishedPlaying();
         }
+#endif
         
     } // end Core namespace
     
+#ifndef ARIA_BENCH
     MainFrame* getMainFrame()
     {
         return wxGetApp().frame;
     }
+#endif
     
     ICurrentSequenceProvider* g_provider;
     void setCurrentSequenceProvider(ICurrentSequenceProvider* provider)
@@ -115,10 +128,12 @@ namespace AriaMaestosa
     //    return g_provider->getCurrentGraphicalSequence();
     //}
     
+#ifndef ARIA_BENCH
     bool isPlaybackMode()
     {
         return getMainFrame()->isPlaybackMode();
     }
+#endif
     
     namespace Display
     {
@@ -126,28 +141,42 @@ namespace AriaMaestosa
         wxDC* renderDC;
         //#endif
         
+#ifndef ARIA_BENCH
+#ifdef RENDERER_HEADLESS
+        /** without a main pane (unit tests), editors see a virtual viewport and a mouse at rest */
+        #define HEADLESS_FALLBACK(value) if (mainPane == NULL) return value
+#else
+        #define HEADLESS_FALLBACK(value)
+#endif
+        
         void render()
         {
+            HEADLESS_FALLBACK();
             mainPane->renderNow();
         }
         int getWidth()
         {
+            HEADLESS_FALLBACK(AriaRender::getViewportWidth());
             return mainPane->getWidth();
         }
         int getHeight()
         {
+            HEADLESS_FALLBACK(AriaRender::getViewportHeight());
             return mainPane->getHeight();
         }
         bool isMouseDown()
         {
+            HEADLESS_FALLBACK(false);
             return mainPane->isMouseDown();
         }
         bool isSelectLessPressed()
         {
+            HEADLESS_FALLBACK(false);
             return mainPane->isSelectLessPressed();
         }
         bool isSelectMorePressed()
         {
+            HEADLESS_FALLBACK(false);
             return mainPane->isSelectMorePressed();
         }
         
@@ -159,32 +188,39 @@ namespace AriaMaestosa
         
         RelativeXCoord getMouseX_current()
         {
+            HEADLESS_FALLBACK(RelativeXCoord_empty());
             return mainPane->getMouseX_current();
         }
         int getMouseY_current()
         {
+            HEADLESS_FALLBACK(-1);
             return mainPane->getMouseY_current();
         }
         RelativeXCoord getMouseX_initial()
         {
+            HEADLESS_FALLBACK(RelativeXCoord_empty());
             return mainPane->getMouseX_initial();
         }
         int getMouseY_initial()
         {
+            HEADLESS_FALLBACK(-1);
             return mainPane->getMouseY_initial();
         }
         
         bool leftArrow()
         {
+            HEADLESS_FALLBACK(false);
             return mainPane->isLeftArrowVisible();
         }
         bool rightArrow()
         {
+            HEADLESS_FALLBACK(false);
             return mainPane->isRightArrowVisible();
         }
         
         bool isVisible()
         {
+            HEADLESS_FALLBACK(false);
             return mainPane->isVisible();
         }
         
@@ -214,19 +250,27 @@ namespace AriaMaestosa
         {
             mainPane->SetFocus();
         }
+#endif
         
         void getTextExtents(wxString string, const wxFont& font, wxCoord* txw, wxCoord* txh, wxCoord* descent, wxCoord* externalLeading)
         {
+#ifdef RENDERER_HEADLESS
+            HeadlessString::getTextExtents(string, font, txw, txh);
+            if (descent != NULL)         *descent = 0;
+            if (externalLeading != NULL) *externalLeading = 0;
+#else
             wxBitmap dummyBmp(5,5);
             wxMemoryDC dummy(dummyBmp);
             ASSERT(dummy.IsOk());
             dummy.SetFont( font );
             dummy.GetTextExtent(string, txw, txh, descent, externalLeading);
+#endif
         }
         
     }// end Display namespace
     
     
+#ifndef ARIA_BENCH
     namespace DisplayFrame
     {
         void updateHorizontalScrollbar(const int thumbPos)
@@ -244,6 +288,7 @@ namespace AriaMaestosa
             }
         }
     } // end DisplayFrame namespace
+#endif
     
     
     bool aboutEqual(const float float1, const float float2)
@@ -265,6 +310,7 @@ namespace AriaMaestosa
 #pragma mark -
 #endif
 
+#ifndef ARIA_BENCH
     
     class VersionCheckThread : public wxThread
     {
@@ -408,4 +454,5 @@ namespace AriaMaestosa
         }
         */
     }
+#endif
 }
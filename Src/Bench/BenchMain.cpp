@@ -0,0 +1,772 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Entry point of 'aria_bench' ('scons aria_bench'), which times model operations on generated songs.
+// It is only compiled in that target, which leaves out main.cpp and every window (see BenchStubs.cpp).
+#ifdef ARIA_BENCH
+
+#include "Actions/AddNote.h"
+#include "Actions/DeleteSelected.h"
+#include "Actions/DuplicateMeasures.h"
+#include "Actions/EditAction.h"
+#include "Actions/InsertEmptyMeasures.h"
+#include "Actions/MoveNotes.h"
+#include "Actions/Paste.h"
+#include "Actions/RemoveMeasures.h"
+#include "Actions/RemoveOverlapping.h"
+#include "Actions/ScaleSong.h"
+#include "AriaCore.h"
+#include "Bench/SyntheticSong.h"
+#include "Editors/ControllerEditor.h"
+#include "Editors/KeyboardEditor.h"
+#include "Editors/ScoreEditor.h"
+#include "GUI/GraphicalSequence.h"
+#include "GUI/GraphicalTrack.h"
+#include "GUI/ImageProvider.h"
+#include "IO/AriaFileWriter.h"
+#include "IO/MidiFileReader.h"
+#include "Midi/CommonMidiUtils.h"
+#include "Midi/MeasureData.h"
+#include "Midi/Players/PlaybackState.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "MemoryUsage.h"
+#include "Parallel.h"
+#include "PreferencesData.h"
+#include "Printing/SymbolPrinter/PrintLayout/PrintLayoutMeasure.h"
+#include "Renderers/HeadlessRenderer.h"
+#include "ptr_vector.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/image.h>
+#include <wx/init.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    namespace Bench
+    {
+
+        /** actions look the current sequence up through this */
+        class BenchSequenceProvider : public ICurrentSequenceProvider
+        {
+        public:
+            GraphicalSequence* m_gseq;
+
+            BenchSequenceProvider() { m_gseq = NULL; }
+
+            virtual Sequence* getCurrentSequence()
+            {
+                return (m_gseq == NULL ? NULL : m_gseq->getModel());
+            }
+
+            virtual GraphicalSequence* getCurrentGraphicalSequence()
+            {
+                return m_gseq;
+            }
+        };
+
+        BenchSequenceProvider g_provider;
+
+        /** what every scenario is given */
+        struct Context
+        {
+            SyntheticSong m_song;
+            wxString      m_midi_path;
+            wxString      m_aria_path;
+
+            /** notes added, copied... by the scenarios that edit a part of a track */
+            int           m_edit_size;
+        };
+
+        /**
+          * @brief an operation to time; only 'run' is timed, each repetition is prepared and cleaned
+          *        up by 'setUp' and 'tearDown'
+          */
+        class Scenario
+        {
+        protected:
+            OwnerPtr<GraphicalSequence> m_gseq;
+
+            /** @brief makes an empty sequence, the current one */
+            Sequence* makeSequence()
+            {
+                m_gseq = new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false));
+                g_provider.m_gseq = m_gseq;
+                return m_gseq->getModel();
+            }
+
+            /** @brief makes a sequence with the song to benchmark, the current one */
+            Sequence* makeSong(const Context& context)
+            {
+                Sequence* sequence = makeSequence();
+                generate(sequence, context.m_song);
+                return sequence;
+            }
+
+        public:
+
+            virtual ~Scenario() {}
+
+            virtual const char* getName() const = 0;
+
+            virtual void setUp(const Context& context) { makeSong(context); }
+            virtual void run(const Context& context) = 0;
+
+            virtual void tearDown()
+            {
+                g_provider.m_gseq = NULL;
+                m_gseq = NULL;
+            }
+        };
+
+        // ------------------------------------------------------------------------------------------------------
+
+        class GenerateScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "generate"; }
+            virtual void setUp(const Context& context) { makeSequence(); }
+            virtual void run(const Context& context) { generate(m_gseq->getModel(), context.m_song); }
+        };
+
+        class ExportScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "export"; }
+            virtual void run(const Context& context) { exportMidiFile(m_gseq->getModel(), context.m_midi_path); }
+        };
+
+        class ImportScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "import"; }
+            virtual void setUp(const Context& context) { makeSequence(); }
+            virtual void run(const Context& context)
+            {
+                std::set<wxString> warnings;
+                loadMidiFile(m_gseq, context.m_midi_path, warnings);
+            }
+        };
+
+        class SaveScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "save"; }
+            virtual void run(const Context& context) { saveAriaFile(m_gseq, context.m_aria_path); }
+        };
+
+        class LoadScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "load"; }
+            virtual void setUp(const Context& context) { makeSequence(); }
+            virtual void run(const Context& context) { loadAriaFile(m_gseq, context.m_aria_path); }
+        };
+
+        /** adds notes one by one all over the first track, like a user entering notes */
+        class AddNoteScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "addNote"; }
+            virtual void run(const Context& context)
+            {
+                Sequence* sequence = m_gseq->getModel();
+                Track* track = sequence->getTrack(0);
+                const int songLength = sequence->getMeasureData()->getTotalTickAmount();
+                const int beat = sequence->ticksPerQuarterNote();
+
+                for (int n=0; n<context.m_edit_size; n++)
+                {
+                    const int tick = (int)((long long)songLength * n / context.m_edit_size);
+                    track->action( new Action::AddNote(60 + n % 24, tick, tick + beat, 100) );
+                }
+            }
+        };
+
+        /** pastes notes copied from the first track into the second */
+        class PasteScenario : public Scenario
+        {
+        protected:
+
+            void paste()
+            {
+                Track* destination = m_gseq->getModel()->getTrack(1);
+                destination->action( new Action::Paste(m_gseq->getGraphicsFor(destination)->getKeyboardEditor(),
+                                                       false) );
+            }
+
+        public:
+            virtual const char* getName() const { return "paste"; }
+            virtual void setUp(const Context& context)
+            {
+                Sequence* sequence = makeSong(context);
+                Track* source = sequence->getTrack(0);
+                source->selectNote(ALL_NOTES, false, true);
+
+                const int amount = std::min(context.m_edit_size, source->getNoteAmount());
+                for (int n=0; n<amount; n++) source->selectNote(n, true, true);
+                source->copy();
+            }
+            virtual void run(const Context& context) { paste(); }
+        };
+
+        /** undoes the paste of PasteScenario */
+        class UndoScenario : public PasteScenario
+        {
+        public:
+            virtual const char* getName() const { return "undo"; }
+            virtual void setUp(const Context& context)
+            {
+                PasteScenario::setUp(context);
+                paste();
+            }
+            virtual void run(const Context& context) { m_gseq->getModel()->undo(); }
+        };
+
+        /** selects a few notes spread over the first track; the edit of the selection is timed */
+        class SelectionScenario : public Scenario
+        {
+        public:
+            virtual void setUp(const Context& context)
+            {
+                Sequence* sequence = makeSong(context);
+                Track* track = sequence->getTrack(0);
+                track->selectNote(ALL_NOTES, false, true);
+
+                const int noteAmount = track->getNoteAmount();
+                const int amount = std::min(context.m_edit_size, noteAmount);
+                for (int n=0; n<amount; n++)
+                {
+                    track->selectNote((int)((long long)noteAmount * n / amount), true, true);
+                }
+            }
+        };
+
+        /** moves the selected notes of the first track by one beat */
+        class MoveSelectionScenario : public SelectionScenario
+        {
+        public:
+            virtual const char* getName() const { return "moveSelection"; }
+            virtual void run(const Context& context)
+            {
+                Sequence* sequence = m_gseq->getModel();
+                Track* track = sequence->getTrack(0);
+                track->action( new Action::MoveNotes(m_gseq->getGraphicsFor(track)->getKeyboardEditor(),
+                                                     sequence->ticksPerQuarterNote(), 0, SELECTED_NOTES) );
+            }
+        };
+
+        /** deletes the selected notes of the first track */
+        class DeleteSelectionScenario : public SelectionScenario
+        {
+        public:
+            virtual const char* getName() const { return "deleteSelection"; }
+            virtual void run(const Context& context)
+            {
+                Track* track = m_gseq->getModel()->getTrack(0);
+                track->action( new Action::DeleteSelected(m_gseq->getGraphicsFor(track)->getKeyboardEditor()) );
+            }
+        };
+
+        class ScaleScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "scale"; }
+            virtual void run(const Context& context) { m_gseq->getModel()->action( new Action::ScaleSong(1.5f, 0) ); }
+        };
+
+        /** inserts measures at the beginning of the song, so that all events move */
+        class InsertMeasuresScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "insertMeasures"; }
+            virtual void run(const Context& context)
+            {
+                m_gseq->getModel()->action( new Action::InsertEmptyMeasures(1, 4) );
+            }
+        };
+
+        /** removes the first half of the song */
+        class RemoveMeasuresScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "removeMeasures"; }
+            virtual void run(const Context& context)
+            {
+                Sequence* sequence = m_gseq->getModel();
+                const int measures = sequence->getMeasureData()->getMeasureAmount();
+                sequence->action( new Action::RemoveMeasures(1, std::max(2, measures/2)) );
+            }
+        };
+
+        /** duplicates the first quarter of the song */
+        class DuplicateMeasuresScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "duplicateMeasures"; }
+            virtual void run(const Context& context)
+            {
+                Sequence* sequence = m_gseq->getModel();
+                const int measures = sequence->getMeasureData()->getMeasureAmount();
+                sequence->action( new Action::DuplicateMeasures(1, std::max(2, measures/4)) );
+            }
+        };
+
+        /** removes overlapping notes from the first track, where one note in four is doubled */
+        class RemoveOverlappingScenario : public Scenario
+        {
+        public:
+            virtual const char* getName() const { return "removeOverlapping"; }
+            virtual void setUp(const Context& context)
+            {
+                SyntheticSong song = context.m_song;
+                song.m_overlap_every = 4;
+                generate(makeSequence(), song);
+            }
+            virtual void run(const Context& context)
+            {
+                m_gseq->getModel()->getTrack(0)->action( new Action::RemoveOverlapping() );
+            }
+        };
+
+        /**
+          * looks for the measures that repeat earlier ones, as printing does, in a 500 measure song where
+          * each track cycles through a few one-measure patterns and one measure in sixteen is unique
+          */
+        class SimilarMeasuresScenario : public Scenario
+        {
+            static const int MEASURE_AMOUNT = 500;
+
+            ptr_vector<PrintLayoutMeasure> m_measures;
+
+        public:
+            virtual const char* getName() const { return "findSimilarMeasures"; }
+            virtual void setUp(const Context& context)
+            {
+                Sequence* sequence = makeSequence();
+                const int beat = sequence->ticksPerQuarterNote();
+
+                {
+                    ScopedMeasureITransaction tr(sequence->getMeasureData()->startImportTransaction());
+                    OwnerPtr<Sequence::Import> import(sequence->startImport());
+
+                    for (int t=0; t<context.m_song.m_track_amount; t++)
+                    {
+                        Track* track = new Track(sequence);
+                        for (int m=0; m<MEASURE_AMOUNT; m++)
+                        {
+                            const int pattern = (m + t) % 8;
+                            for (int b=0; b<4; b++)
+                            {
+                                // a chord per beat, stored low to high or high to low depending on the measure
+                                const int tick = (m*4 + b)*beat;
+                                const int root = 40 + (pattern*5 + b*2) % 24;
+                                track->addNote_import(m % 2 == 0 ? root : root + 7, tick, tick + beat, 100);
+                                track->addNote_import(root + 4,                     tick, tick + beat, 100);
+                                track->addNote_import(m % 2 == 0 ? root + 7 : root, tick, tick + beat, 100);
+                            }
+                            if (m % 16 == 15)
+                            {
+                                const int tick = m*4*beat + 1 + m/16;
+                                track->addNote_import(80, tick, tick + beat, 100);
+                            }
+                        }
+                        sequence->addTrack(track);
+                    }
+                }
+
+                {
+                    ScopedMeasureTransaction tr(sequence->getMeasureData()->startTransaction());
+                    tr->setMeasureAmount(MEASURE_AMOUNT);
+                }
+
+                // give each measure a reference to each track, like the print layout does
+                for (int m=0; m<MEASURE_AMOUNT; m++) m_measures.push_back( new PrintLayoutMeasure(m, sequence) );
+                for (int t=0; t<sequence->getTrackAmount(); t++)
+                {
+                    GraphicalTrack* gtrack = m_gseq->getGraphicsFor(sequence->getTrack(t));
+                    int note = 0;
+                    for (int m=0; m<MEASURE_AMOUNT; m++) note = m_measures[m].addTrackReference(note, gtrack);
+                }
+            }
+            virtual void run(const Context& context)
+            {
+                PrintLayoutMeasure::findSimilarMeasures(m_measures, MEASURE_AMOUNT);
+            }
+            virtual void tearDown()
+            {
+                m_measures.clearAndDeleteAll();
+                Scenario::tearDown();
+            }
+        };
+
+        // ------------------------------------------------------------------------------------------------------
+
+        struct Result
+        {
+            const char* m_name;
+            double      m_min_ms;
+            double      m_median_ms;
+            double      m_mean_ms;
+        };
+
+        Result measure(Scenario* scenario, const Context& context, const int repeat)
+        {
+            std::vector<double> times;
+            for (int n=0; n<repeat; n++)
+            {
+                scenario->setUp(context);
+
+                const long long startUs = PlaybackState::getTimeUs();
+                scenario->run(context);
+                times.push_back( (PlaybackState::getTimeUs() - startUs) / 1000.0 );
+
+                scenario->tearDown();
+            }
+            std::sort(times.begin(), times.end());
+
+            double total = 0;
+            for (unsigned int n=0; n<times.size(); n++) total += times[n];
+
+            Result result;
+            result.m_name      = scenario->getName();
+            result.m_min_ms    = times[0];
+            result.m_median_ms = times[times.size() / 2];
+            result.m_mean_ms   = total / times.size();
+            return result;
+        }
+
+        // ------------------------------------------------------------------------------------------------------
+
+        /** @return the resident set size of the process in bytes, or -1 where it can't be read */
+        long long getResidentBytes()
+        {
+#if defined(__linux__)
+            std::ifstream statm("/proc/self/statm");
+            long long pages = -1, residentPages = -1;
+            statm >> pages >> residentPages;
+            if (not statm) return -1;
+            return residentPages * sysconf(_SC_PAGESIZE);
+#elif defined(__APPLE__)
+            mach_task_basic_info_data_t info;
+            mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+            if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+            {
+                return -1;
+            }
+            return info.resident_size;
+#else
+            return -1;
+#endif
+        }
+
+        /** @brief gives freed memory back to the system where the allocator can be asked to */
+        void trimHeap()
+        {
+#ifdef __GLIBC__
+            malloc_trim(0);
+#endif
+        }
+
+        /** memory of many songs open at once, as open tabs */
+        struct TabsResult
+        {
+            int m_tabs;
+
+            /** resident set size, after opening the songs, after rendering them and after hibernating
+              * all but one of them (see GraphicalSequence::hibernate) */
+            long long m_rss_opened;
+            long long m_rss_rendered;
+            long long m_rss_hibernated;
+
+            /** same as above, as estimated by GraphicalSequence::getMemoryUsage */
+            long long m_estimate_rendered;
+            long long m_estimate_hibernated;
+        };
+
+        long long getEstimate(const ptr_vector<GraphicalSequence>& sequences)
+        {
+            MemoryUsage usage;
+            for (int n=0; n<sequences.size(); n++) sequences.getConst(n)->getMemoryUsage(usage);
+            return usage.getTotalBytes();
+        }
+
+        /**
+          * @brief opens the song in 'tabs' sequences, renders the keyboard, score and controller editors
+          *        of all their tracks (as if each tab had been shown), then hibernates all tabs but the last
+          *        one, like the main frame does when switching tabs
+          */
+        TabsResult measureTabs(const Context& context, const int tabs)
+        {
+            wxInitAllImageHandlers();
+            if (not ImageProvider::imagesLoaded()) ImageProvider::loadImages();
+            AriaRender::setViewportSize(1024, 768);
+
+            TabsResult result;
+            result.m_tabs = tabs;
+
+            ptr_vector<GraphicalSequence> sequences;
+            for (int n=0; n<tabs; n++)
+            {
+                GraphicalSequence* gseq = new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false));
+                sequences.push_back(gseq);
+                g_provider.m_gseq = gseq;
+                generate(gseq->getModel(), context.m_song);
+            }
+            trimHeap();
+            result.m_rss_opened = getResidentBytes();
+
+            for (int n=0; n<tabs; n++)
+            {
+                g_provider.m_gseq = sequences.get(n);
+                for (int t=0; t<sequences[n].getTrackAmount(); t++)
+                {
+                    GraphicalTrack* gtrack = sequences[n].getTrack(t);
+                    gtrack->getTrack()->setNotationType(SCORE, true);
+                    gtrack->getTrack()->setNotationType(CONTROLLER, true);
+                    gtrack->setHeight(600);
+                    gtrack->layout(MEASURE_BAR_Y + sequences[n].getMeasureBar()->getMeasureBarHeight());
+
+                    AriaRender::clearCommands();
+                    gtrack->getKeyboardEditor()->render();
+                    gtrack->getScoreEditor()->render();
+                    gtrack->getControllerEditor()->render();
+                }
+            }
+            AriaRender::clearCommands();
+            result.m_rss_rendered      = getResidentBytes();
+            result.m_estimate_rendered = getEstimate(sequences);
+
+            for (int n=0; n<tabs - 1; n++) sequences[n].hibernate();
+            trimHeap();
+            result.m_rss_hibernated      = getResidentBytes();
+            result.m_estimate_hibernated = getEstimate(sequences);
+
+            g_provider.m_gseq = NULL;
+            sequences.clearAndDeleteAll();
+            return result;
+        }
+
+        // ------------------------------------------------------------------------------------------------------
+
+        /** writes the results as JSON, to compare runs of different builds */
+        void writeResults(std::ostream& out, const Context& context, const int repeat,
+                          const std::vector<Result>& results, const TabsResult* tabs)
+        {
+            const SyntheticSong& song = context.m_song;
+            out << "{\n  \"song\": {\"tracks\": " << song.m_track_amount
+                << ", \"notes_per_track\": "       << song.m_notes_per_track
+                << ", \"controllers_per_track\": " << song.m_controllers_per_track
+                << ", \"tempo_changes\": "         << song.m_tempo_changes
+                << ", \"time_sig_changes\": "      << song.m_time_sig_changes
+                << ", \"seed\": "                  << song.m_seed
+                << "},\n  \"edit_size\": " << context.m_edit_size
+                << ",\n  \"threads\": " << Parallel::getWorkerCount()
+                << ",\n  \"repeat\": " << repeat
+                << ",\n  \"results\": [\n";
+            for (unsigned int n=0; n<results.size(); n++)
+            {
+                out << "    {\"scenario\": \"" << results[n].m_name << "\", \"min_ms\": " << results[n].m_min_ms
+                    << ", \"median_ms\": " << results[n].m_median_ms << ", \"mean_ms\": " << results[n].m_mean_ms
+                    << "}" << (n + 1 < results.size() ? "," : "") << "\n";
+            }
+            out << "  ]";
+            if (tabs != NULL)
+            {
+                out << ",\n  \"tabs\": {\"open\": " << tabs->m_tabs
+                    << ", \"rss_opened\": "          << tabs->m_rss_opened
+                    << ", \"rss_rendered\": "        << tabs->m_rss_rendered
+                    << ", \"rss_hibernated\": "      << tabs->m_rss_hibernated
+                    << ", \"estimate_rendered\": "   << tabs->m_estimate_rendered
+                    << ", \"estimate_hibernated\": " << tabs->m_estimate_hibernated << "}";
+            }
+            out << "\n}\n";
+        }
+
+        void printUsage(const char* program)
+        {
+            std::cerr << "Usage : " << program << " [options]\n"
+                      << "  --tracks N         tracks in the generated song (default 8)\n"
+                      << "  --notes N          notes per track (default 1000)\n"
+                      << "  --controllers N    controller events per track (default 0)\n"
+                      << "  --tempo N          tempo changes (default 0)\n"
+                      << "  --timesig N        time signature changes (default 0)\n"
+                      << "  --seed N           seed of the generator (default 1)\n"
+                      << "  --edit N           notes added, pasted or selected by 'addNote', 'paste', 'undo',\n"
+                      << "                     'moveSelection' and 'deleteSelection' (default 1000)\n"
+                      << "  --repeat N         times each scenario runs (default 5)\n"
+                      << "  --threads N        threads used by song-wide actions like 'scale' (default : one per CPU)\n"
+                      << "  --only NAME        only runs the given scenario (can be repeated)\n"
+                      << "  --tabs N           also measures the memory of N copies of the song open at once,\n"
+                      << "                     before and after hibernating all but one (default 0 : not measured)\n"
+                      << "  --output FILE      where to write the JSON results (default aria_bench.json)\n";
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    using namespace AriaMaestosa::Bench;
+
+    Context context;
+    context.m_edit_size = 1000;
+    int repeat = 5;
+    int tabs = 0;
+    int threads = 0;
+    const char* output = "aria_bench.json";
+    std::set<std::string> only;
+
+    for (int n=1; n<argc; n++)
+    {
+        const bool hasValue = (n + 1 < argc);
+        const char* arg = argv[n];
+
+        if      (hasValue and strcmp(arg, "--tracks")      == 0) context.m_song.m_track_amount          = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--notes")       == 0) context.m_song.m_notes_per_track       = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--controllers") == 0) context.m_song.m_controllers_per_track = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--tempo")       == 0) context.m_song.m_tempo_changes         = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--timesig")     == 0) context.m_song.m_time_sig_changes      = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--seed")        == 0) context.m_song.m_seed                  = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--edit")        == 0) context.m_edit_size                    = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--repeat")      == 0) repeat                                 = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--threads")     == 0) threads                                = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--only")        == 0) only.insert(argv[++n]);
+        else if (hasValue and strcmp(arg, "--tabs")        == 0) tabs                                   = atoi(argv[++n]);
+        else if (hasValue and strcmp(arg, "--output")      == 0) output                                 = argv[++n];
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // 'paste' and 'undo' need a second track
+    if (context.m_song.m_track_amount < 2 or context.m_song.m_notes_per_track < 1 or repeat < 1)
+    {
+        std::cerr << "[aria_bench] ERROR: needs at least 2 tracks, 1 note per track and 1 repetition" << std::endl;
+        return 1;
+    }
+    if (threads < 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    Parallel::setWorkerLimit(threads);
+
+    // no wxApp is linked in, so this only sets up a console app : no toolkit, no display
+    wxInitializer initializer;
+    if (not initializer.IsOk())
+    {
+        std::cerr << "[aria_bench] ERROR: could not initialize wxWidgets" << std::endl;
+        return 1;
+    }
+
+    okToLog = false;
+    Core::setPlayDuringEdit(PLAY_NEVER);
+    PreferencesData::getInstance()->init();
+    setCurrentSequenceProvider(&g_provider);
+
+    const wxString tempPath = wxFileName::CreateTempFileName(wxT("aria_bench"));
+    context.m_midi_path = tempPath + wxT(".mid");
+    context.m_aria_path = tempPath + wxT(".aria");
+
+    ptr_vector<Scenario> scenarios;
+    scenarios.push_back(new GenerateScenario());
+    scenarios.push_back(new ExportScenario());
+    scenarios.push_back(new ImportScenario());
+    scenarios.push_back(new SaveScenario());
+    scenarios.push_back(new LoadScenario());
+    scenarios.push_back(new AddNoteScenario());
+    scenarios.push_back(new PasteScenario());
+    scenarios.push_back(new UndoScenario());
+    scenarios.push_back(new MoveSelectionScenario());
+    scenarios.push_back(new DeleteSelectionScenario());
+    scenarios.push_back(new ScaleScenario());
+    scenarios.push_back(new InsertMeasuresScenario());
+    scenarios.push_back(new RemoveMeasuresScenario());
+    scenarios.push_back(new DuplicateMeasuresScenario());
+    scenarios.push_back(new RemoveOverlappingScenario());
+    scenarios.push_back(new SimilarMeasuresScenario());
+
+    // 'import' and 'load' read the files 'export' and 'save' write, so these always run first
+    std::vector<Result> results;
+    for (int n=0; n<scenarios.size(); n++)
+    {
+        const std::string name = scenarios[n].getName();
+        const bool writesInput = (name == "export" or name == "save");
+        if (not only.empty() and only.count(name) == 0 and not writesInput) continue;
+
+        const Result result = measure(scenarios.get(n), context, repeat);
+        if (only.empty() or only.count(name) > 0)
+        {
+            results.push_back(result);
+            std::cerr << "[aria_bench] " << name << " : " << result.m_median_ms << " ms (median of "
+                      << repeat << ")" << std::endl;
+        }
+    }
+    scenarios.clearAndDeleteAll();
+
+    TabsResult tabsResult;
+    if (tabs > 0)
+    {
+        tabsResult = measureTabs(context, tabs);
+        std::cerr << "[aria_bench] " << tabs << " tabs : RSS " << tabsResult.m_rss_opened / (1024*1024)
+                  << " MB opened, " << tabsResult.m_rss_rendered / (1024*1024) << " MB rendered, "
+                  << tabsResult.m_rss_hibernated / (1024*1024) << " MB with all but one hibernating" << std::endl;
+    }
+
+    wxRemoveFile(tempPath);
+    wxRemoveFile(context.m_midi_path);
+    wxRemoveFile(context.m_aria_path);
+
+    // results go to a file of their own, since the model logs to the standard output
+    std::ofstream file(output);
+    writeResults(file, context, repeat, results, (tabs > 0 ? &tabsResult : NULL));
+    if (not file.good())
+    {
+        std::cerr << "[aria_bench] ERROR: could not write " << output << std::endl;
+        return 1;
+    }
+    std::cerr << "[aria_bench] results written to " << output << std::endl;
+
+    Parallel::stopWorkers();
+    return 0;
+}
+
+#endif
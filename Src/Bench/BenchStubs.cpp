@@ -0,0 +1,134 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// 'aria_bench' is built without main.cpp, the main frame, the main pane, the dialogs and the picker
+// windows, so that it never needs a display. This file holds what the model and the editors call
+// into those : there is never a main frame, a mouse or a menu in the benchmark, so none of these
+// do anything.
+#ifdef ARIA_BENCH
+
+#include "AriaCore.h"
+#include "Dialogs/WaitWindow.h"
+#include "GUI/MainFrame.h"
+#include "GUI/MainPane.h"
+#include "Pickers/DrumPicker.h"
+#include "Pickers/InstrumentPicker.h"
+#include "Pickers/KeyPicker.h"
+#include "Pickers/TimeSigPicker.h"
+#include "Pickers/TuningPicker.h"
+#include "Pickers/VolumeSlider.h"
+#include "Renderers/RenderAPI.h"
+
+namespace AriaMaestosa
+{
+    // events the sequencer and the editors post to the main frame
+    DEFINE_LOCAL_EVENT_TYPE(wxEVT_EXTEND_TICK)
+    DEFINE_LOCAL_EVENT_TYPE(wxEVT_SHOW_TRACK_CONTEXTUAL_MENU)
+
+    namespace Core
+    {
+        void activateRenderLoop(bool on)      { }
+        void songHasFinishedPlaying()         { }
+
+        TuningPicker*     getTuningPicker()     { return NULL; }
+        KeyPicker*        getKeyPicker()        { return NULL; }
+        DrumPicker*       getDrumPicker()       { return NULL; }
+        InstrumentPicker* getInstrumentPicker() { return NULL; }
+    }
+
+    MainFrame* getMainFrame()
+    {
+        return NULL;
+    }
+
+    bool isPlaybackMode()
+    {
+        return false;
+    }
+
+    namespace Display
+    {
+        // editors see a virtual viewport and a mouse at rest
+        void render()              { }
+        int  getWidth()            { return AriaRender::getViewportWidth();  }
+        int  getHeight()           { return AriaRender::getViewportHeight(); }
+        bool isMouseDown()         { return false; }
+        bool isSelectLessPressed() { return false; }
+        bool isSelectMorePressed() { return false; }
+        bool isVisible()           { return false; }
+
+        RelativeXCoord getMouseX_current() { return RelativeXCoord_empty(); }
+        int            getMouseY_current() { return -1; }
+        RelativeXCoord getMouseX_initial() { return RelativeXCoord_empty(); }
+        int            getMouseY_initial() { return -1; }
+
+        bool leftArrow()     { return false; }
+        bool rightArrow()    { return false; }
+        void enterPlayLoop() { }
+        void exitPlayLoop()  { }
+        void requestFocus()  { }
+
+        void popupMenu(wxMenu* menu, const int x, const int y) { }
+
+        void clientToScreen(const int x_in, const int y_in, int* x_out, int* y_out)
+        {
+            *x_out = x_in;
+            *y_out = y_in;
+        }
+        void screenToClient(const int x_in, const int y_in, int* x_out, int* y_out)
+        {
+            *x_out = x_in;
+            *y_out = y_in;
+        }
+    }
+
+    namespace DisplayFrame
+    {
+        void updateHorizontalScrollbar(const int thumbPos) { }
+        void updateVerticalScrollbar()                     { }
+    }
+
+    namespace WaitWindow
+    {
+        void show(wxWindow* parent, wxString message, bool progress_known) { }
+        void setProgress(int progress) { }
+        void hide() { }
+        bool isShown() { return false; }
+    }
+
+    void showVolumeSlider(int x, int y, int noteID, Track* track) { }
+    void showVolumeSlider(int x, int y, Track* track) { }
+    void showTimeSigPicker(GraphicalSequence* parent, const int x, const int y, const int num, const int denom) { }
+
+    // only reached through a main frame or a picker, which the benchmark never has
+    void MainFrame::setStatusText(wxString text) { }
+    void MainFrame::setResizingCursor() { }
+    void MainFrame::setMovingCursor() { }
+    void MainFrame::setNormalCursor() { }
+    void MainFrame::updateTopBarAndScrollbarsForSequence(const GraphicalSequence* seq) { }
+    void MainFrame::onTimeSigSelectionChanged(int num, int denom) { }
+
+    bool MainPane::isCommandDown() { return false; }
+
+    void KeyPicker::setParent(GraphicalTrack* parent_arg) { }
+    void KeyPicker::setChecks(bool musicalNotationEnabled, bool linearNotationEnabled, bool f_clef, bool g_clef,
+                              int octave_shift) { }
+    void TuningPicker::setModel(GuitarTuning* model, Track* parent) { }
+    void DrumPicker::setModel(DrumChoice* model) { }
+    void InstrumentPicker::setModel(InstrumentChoice* choice) { }
+}
+
+#endif
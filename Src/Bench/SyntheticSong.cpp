@@ -0,0 +1,139 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Bench/SyntheticSong.h"
+
+#include "Midi/CommonMidiUtils.h"
+#include "Midi/ControllerEvent.h"
+#include "Midi/MeasureData.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+
+#include <algorithm>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    namespace Bench
+    {
+        /** small linear congruential generator, so that songs don't depend on the C library */
+        class Random
+        {
+            unsigned int m_state;
+            
+        public:
+            
+            Random(const unsigned int seed) { m_state = seed; }
+            
+            /** @return a number in range [from .. to] */
+            int next(const int from, const int to)
+            {
+                m_state = m_state*1664525u + 1013904223u;
+                return from + (int)((m_state >> 8) % (unsigned int)(to - from + 1));
+            }
+        };
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+Bench::SyntheticSong::SyntheticSong()
+{
+    m_track_amount          = 8;
+    m_notes_per_track       = 1000;
+    m_controllers_per_track = 0;
+    m_tempo_changes         = 0;
+    m_time_sig_changes      = 0;
+    m_overlap_every         = 0;
+    m_seed                  = 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Bench::generate(Sequence* sequence, const SyntheticSong& song)
+{
+    ASSERT_E(sequence->getTrackAmount(), ==, 0);
+    
+    Random random(song.m_seed);
+    
+    const int beat = sequence->ticksPerQuarterNote();
+    
+    // four notes per beat, so that a track is about as dense as a busy piano part
+    const int noteSpacing = beat / 4;
+    const int songLength  = song.m_notes_per_track*noteSpacing + beat*4;
+    
+    {
+        ScopedMeasureITransaction tr(sequence->getMeasureData()->startImportTransaction());
+        OwnerPtr<Sequence::Import> import(sequence->startImport());
+        
+        sequence->setTempo(120);
+        for (int n=1; n<=song.m_tempo_changes; n++)
+        {
+            const int tick = (int)((long long)songLength * n / (song.m_tempo_changes + 1));
+            import->addTempoEvent(new ControllerEvent(PSEUDO_CONTROLLER_TEMPO, tick,
+                                                      convertBPMToTempoBend((float)random.next(60, 180))));
+        }
+        
+        // alternate between 3/4 and 4/4, changing on measure boundaries
+        const int measuresBetweenChanges = std::max(1, songLength / (beat*4) / (song.m_time_sig_changes + 1));
+        int timeSigTick = 0;
+        int numerator   = 4;
+        for (int n=1; n<=song.m_time_sig_changes; n++)
+        {
+            timeSigTick += measuresBetweenChanges * numerator * beat;
+            numerator = (n % 2 == 1 ? 3 : 4);
+            tr->addTimeSigChange(timeSigTick, numerator, 4);
+        }
+        
+        for (int t=0; t<song.m_track_amount; t++)
+        {
+            Track* track = new Track(sequence);
+            track->setChannel(t % 16 == 9 ? 15 : t % 16);
+            
+            for (int n=0; n<song.m_notes_per_track; n++)
+            {
+                const int tick   = n*noteSpacing;
+                const int length = noteSpacing * random.next(1, 4);
+                const int pitch  = random.next(36, 96);
+                track->addNote_import(pitch, tick, tick + length, random.next(40, 127));
+                
+                if (song.m_overlap_every > 0 and n % song.m_overlap_every == 0)
+                {
+                    track->addNote_import(pitch, tick + noteSpacing/2, tick + length, 100);
+                }
+            }
+            
+            // half volume changes, half pitch bends
+            for (int n=0; n<song.m_controllers_per_track; n++)
+            {
+                const int tick = (int)((long long)songLength * n / song.m_controllers_per_track);
+                track->addControlEvent_import(tick, random.next(0, 127),
+                                              (n % 2 == 0 ? 7 : PSEUDO_CONTROLLER_PITCH_BEND));
+            }
+            
+            sequence->addTrack(track);
+        }
+    }
+    
+    MeasureData* md = sequence->getMeasureData();
+    {
+        ScopedMeasureTransaction tr(md->startTransaction());
+        tr->setMeasureAmount(md->measureAtTick(songLength) + 1);
+    }
+    
+    sequence->clearUndoStack();
+}
@@ -0,0 +1,65 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __SYNTHETIC_SONG_H__
+#define __SYNTHETIC_SONG_H__
+
+namespace AriaMaestosa
+{
+    class Sequence;
+    
+    namespace Bench
+    {
+        
+        /**
+          * @brief describes a generated song, to benchmark the model on songs of any size
+          *
+          * Songs with the same description are identical : notes, controllers and tempo are
+          * picked by a pseudo-random generator seeded with 'm_seed'.
+          */
+        struct SyntheticSong
+        {
+            int m_track_amount;
+            int m_notes_per_track;
+            
+            /** volume (controller 7) and pitch bend events per track, evenly spread over the song */
+            int m_controllers_per_track;
+            
+            /** tempo events, evenly spread over the song */
+            int m_tempo_changes;
+            
+            /** time signature changes, on measures evenly spread over the song */
+            int m_time_sig_changes;
+            
+            /** one note in this many is doubled by a note that overlaps it (0 for none) */
+            int m_overlap_every;
+            
+            unsigned int m_seed;
+            
+            /** a small song, the amounts can then be changed */
+            SyntheticSong();
+        };
+        
+        /**
+          * @brief fills the given sequence (that must have no track) with the described song, the
+          *        way importing a MIDI file would (the undo stack is left empty)
+          */
+        void generate(Sequence* sequence, const SyntheticSong& song);
+        
+    }
+}
+
+#endif
@@ -40,7 +40,7 @@ namespace AriaMaestosa
         int dialogID;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(AboutDialog);
         
         AboutDialog(wxWindow* parent);
         void show();
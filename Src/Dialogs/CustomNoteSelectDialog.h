@@ -58,7 +58,7 @@ namespace AriaMaestosa
         Track* m_current_track;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(CustomNoteSelectDialog);
         CustomNoteSelectDialog();
         
         void okClicked(wxCommandEvent& evt);
@@ -0,0 +1,156 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Dialogs/MemoryReportDialog.h"
+#include "GUI/GraphicalSequence.h"
+#include "GUI/MainFrame.h"
+#include "MemoryUsage.h"
+#include "Midi/Sequence.h"
+
+#include <sstream>
+#include <wx/button.h>
+#include <wx/font.h>
+#include <wx/intl.h>
+#include <wx/sizer.h>
+#include <wx/textctrl.h>
+
+using namespace AriaMaestosa;
+
+namespace
+{
+    const int FIRST_COLUMN_WIDTH = 20;
+    const int COLUMN_WIDTH       = 14;
+
+    /** @return 'text', cut or padded with spaces to 'width' characters */
+    wxString cell(const wxString& text, const unsigned int width)
+    {
+        if (text.Length() >= width) return text.Left(width - 1) + wxT(" ");
+
+        wxString out = text;
+        out.Pad(width - text.Length());
+        return out;
+    }
+
+    /** @return 'text', padded with spaces on the left to 'width' characters */
+    wxString rightAlignedCell(const wxString& text, const unsigned int width)
+    {
+        if (text.Length() >= width - 1) return text + wxT(" ");
+        return wxString(wxT(' '), width - 1 - text.Length()) + text + wxT(" ");
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// ---------------------------------------------------------------------------------------------------------
+
+MemoryReportDialog::MemoryReportDialog(MainFrame* parent) :
+        //I18N: - title of the dialog showing how much memory open songs use
+        wxDialog(parent, wxID_ANY, _("Memory Report"), wxDefaultPosition, wxSize(760, 600),
+                 wxCAPTION | wxCLOSE_BOX | wxRESIZE_BORDER)
+{
+    m_main_frame = parent;
+
+    wxBoxSizer* sizer = new wxBoxSizer(wxVERTICAL);
+
+    m_text = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize,
+                            wxTE_MULTILINE | wxTE_READONLY | wxTE_DONTWRAP);
+    m_text->SetFont(wxFont(11, wxFONTFAMILY_TELETYPE, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
+    sizer->Add(m_text, 1, wxALL | wxEXPAND, 5);
+
+    wxBoxSizer* buttonsizer = new wxBoxSizer(wxHORIZONTAL);
+    wxButton* refreshBtn = new wxButton(this, wxID_REFRESH, _("Refresh"));
+    wxButton* closeBtn   = new wxButton(this, wxID_OK, _("Close"));
+    closeBtn->SetDefault();
+    buttonsizer->Add(refreshBtn, 0, wxALL, 5);
+    buttonsizer->AddStretchSpacer();
+    buttonsizer->Add(closeBtn, 0, wxALL, 5);
+    sizer->Add(buttonsizer, 0, wxALL | wxEXPAND, 5);
+
+    SetSizer(sizer);
+
+    refreshBtn->Connect(refreshBtn->GetId(), wxEVT_COMMAND_BUTTON_CLICKED,
+                        wxCommandEventHandler(MemoryReportDialog::onRefresh), NULL, this);
+
+    m_text->SetValue(getReport(m_main_frame));
+    Center();
+}
+
+// ---------------------------------------------------------------------------------------------------------
+
+wxString MemoryReportDialog::getReport(MainFrame* mainFrame)
+{
+    const int count = mainFrame->getSequenceAmount();
+
+    std::vector<MemoryUsage> usages(count);
+    MemoryUsage total;
+    for (int n=0; n<count; n++)
+    {
+        mainFrame->getGraphicalSequence(n)->getMemoryUsage(usages[n]);
+        total += usages[n];
+    }
+
+    // one row per category, one column per open sequence
+    wxString report = cell(wxEmptyString, FIRST_COLUMN_WIDTH);
+    for (int n=0; n<count; n++)
+    {
+        report += rightAlignedCell(mainFrame->getSequence(n)->suggestTitle().Left(COLUMN_WIDTH - 2),
+                                   COLUMN_WIDTH);
+    }
+    //I18N: - in the memory report, the column that sums all open songs
+    report += rightAlignedCell(_("Total"), COLUMN_WIDTH) + wxT("\n");
+
+    for (int c=0; c<MemoryUsage::CATEGORY_COUNT; c++)
+    {
+        const MemoryUsage::Category category = (MemoryUsage::Category)c;
+        report += cell(MemoryUsage::getCategoryName(category), FIRST_COLUMN_WIDTH);
+        for (int n=0; n<count; n++)
+        {
+            report += rightAlignedCell(MemoryUsage::formatBytes(usages[n].getBytes(category)), COLUMN_WIDTH);
+        }
+        report += rightAlignedCell(MemoryUsage::formatBytes(total.getBytes(category)), COLUMN_WIDTH) + wxT("\n");
+    }
+
+    report += cell(_("Total"), FIRST_COLUMN_WIDTH);
+    for (int n=0; n<count; n++)
+    {
+        report += rightAlignedCell(MemoryUsage::formatBytes(usages[n].getTotalBytes()), COLUMN_WIDTH);
+    }
+    report += rightAlignedCell(MemoryUsage::formatBytes(total.getTotalBytes()), COLUMN_WIDTH) + wxT("\n\n");
+
+    //I18N: - in the memory report. %i are numbers of notes, events, actions that can be undone and textures
+    report += wxString::Format(_("Open songs hold %i notes, %i controller events, %i text events, %i actions that can be undone and %i textures."),
+                               total.getObjects(MemoryUsage::NOTES), total.getObjects(MemoryUsage::CONTROLLER_EVENTS),
+                               total.getObjects(MemoryUsage::TEXT_EVENTS), total.getObjects(MemoryUsage::UNDO_STACK),
+                               total.getObjects(MemoryUsage::TEXTURES));
+    report += wxT("\n");
+
+#ifdef _MORE_DEBUG_CHECKS
+    // counters are per class, so they cover all open sequences (and the GUI)
+    std::ostringstream out;
+    out << "\nLive objects of all open sequences:\n\n";
+    MemoryLeaks::writeReport(out, MemoryLeaks::getSampleInterval() > 0);
+    report += wxString(out.str().c_str(), wxConvUTF8);
+#endif
+
+    return report;
+}
+
+// ---------------------------------------------------------------------------------------------------------
+
+void MemoryReportDialog::onRefresh(wxCommandEvent& evt)
+{
+    m_text->SetValue(getReport(m_main_frame));
+}
+
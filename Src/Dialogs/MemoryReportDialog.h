@@ -0,0 +1,54 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __MEMORY_REPORT_DIALOG_H__
+#define __MEMORY_REPORT_DIALOG_H__
+
+#include "Utils.h"
+
+#include <wx/dialog.h>
+class wxTextCtrl;
+
+namespace AriaMaestosa
+{
+    class MainFrame;
+
+    /**
+      * @ingroup dialogs
+      * @brief Dialog showing how much memory each open sequence uses, by subsystem (see MemoryUsage);
+      *        debug builds also list the live object count and bytes of each class marked with
+      *        LEAK_CHECK (see MemoryLeaks)
+      */
+    class MemoryReportDialog : public wxDialog
+    {
+        MainFrame*  m_main_frame;
+        wxTextCtrl* m_text;
+
+    public:
+        LEAK_CHECK(MemoryReportDialog);
+
+        MemoryReportDialog(MainFrame* parent);
+
+        /** @return the text shown in the dialog */
+        static wxString getReport(MainFrame* mainFrame);
+
+        /** @brief callback invoked when the Refresh button is pressed */
+        void onRefresh(wxCommandEvent& evt);
+    };
+
+}
+
+#endif
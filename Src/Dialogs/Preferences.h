@@ -51,7 +51,7 @@ namespace AriaMaestosa
         ptr_vector<SettingWidget> m_setting_widgets;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(PreferencesDialog);
 
         PreferencesDialog(wxWindow* parent, PreferencesData* data);
         ~PreferencesDialog();
@@ -42,7 +42,7 @@ namespace AriaMaestosa
         void updateList();
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(PresetEditor);
         
         PresetEditor(wxWindow* parent, PresetGroup* presets);
         ~PresetEditor();
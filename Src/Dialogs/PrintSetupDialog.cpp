@@ -503,7 +503,7 @@ namespace AriaMaestosa
         
     public:
         
-        LEAK_CHECK();
+        LEAK_CHECK(PrintSetupDialog);
         
         PrintSetupDialog(wxWindow *parent, Sequence* sequence) :
             wxFrame(parent, wxID_ANY,
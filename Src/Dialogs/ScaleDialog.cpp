@@ -63,7 +63,7 @@ namespace AriaMaestosa
         Sequence* m_sequence;
 
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(ScalePickerFrame);
 
         ScalePickerFrame(Sequence* seq) : wxDialog(getMainFrame(), wxID_ANY,
                                                    //I18N: - title of the scale dialog
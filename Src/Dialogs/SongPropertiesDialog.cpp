@@ -77,7 +77,7 @@ class SongPropertiesDialog : public wxDialog
     int m_code;
 
 public:
-    LEAK_CHECK();
+    LEAK_CHECK(SongPropertiesDialog);
     
     
     SongPropertiesDialog(Sequence* seq) : wxDialog(getMainFrame(), wxID_ANY,
@@ -22,6 +22,7 @@
 #include "GUI/MainFrame.h"
 #include "Midi/DrumChoice.h"
 #include "Midi/InstrumentChoice.h"
+#include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
 
@@ -34,6 +35,7 @@
 #include <wx/textctrl.h>
 #include <wx/sizer.h>
 #include <wx/checkbox.h>
+#include <wx/choice.h>
 #include <wx/stattext.h>
 #include <iostream>
 
@@ -42,7 +44,7 @@ namespace AriaMaestosa
     class BackgroundChoicePanel : public wxPanel
     {
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(BackgroundChoicePanel);
         
         wxBoxSizer* sizer;
         wxCheckBox* active;
@@ -112,6 +114,9 @@ namespace AriaMaestosa
         wxTextCtrl* m_volume_text;
         wxSlider* m_volume_slider;
         
+        /** first item is the default output, the others are as given by PlatformMidiManager::getOutputChoices */
+        wxChoice* m_output_choice;
+        
         ptr_vector<BackgroundChoicePanel> m_choice_panels;
         
         GraphicalTrack* m_parent;
@@ -120,7 +125,7 @@ namespace AriaMaestosa
         
     
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(TrackPropertiesDialog);
         
         ~TrackPropertiesDialog()
         {
@@ -217,11 +222,27 @@ namespace AriaMaestosa
             
             right_subsizer->Add(default_volume_subsizer, 0, wxALL, 0);
             
+            wxStaticBoxSizer* output_subsizer = new wxStaticBoxSizer(wxHORIZONTAL, properties_panel, _("MIDI output"));
+            
+            wxArrayString outputs = PlatformMidiManager::get()->getOutputChoices();
+            outputs.Insert(_("Default output"), 0);
+            
+            // keep the output of the track even if its device is not currently available
+            const wxString& trackOutput = parent_t->getOutputDevice();
+            if (not trackOutput.IsEmpty() and outputs.Index(trackOutput) == wxNOT_FOUND) outputs.Add(trackOutput);
+            
+            m_output_choice = new wxChoice(properties_panel, wxID_ANY, wxDefaultPosition, wxDefaultSize, outputs);
+            m_output_choice->SetSelection(trackOutput.IsEmpty() ? 0 : outputs.Index(trackOutput));
+            output_subsizer->Add(m_output_choice, 1, wxALL, 5);
+            
+            right_subsizer->Add(output_subsizer, 0, wxEXPAND | wxTOP, 5);
+            
             //right_subsizer->Add( new wxButton(properties_panel, wxID_ANY, wxT("Editor-specific options")), 1, wxALL, 5 );
             
             properties_panel->SetSizer(props_sizer);
             
             default_volume_subsizer->Layout();
+            output_subsizer->Layout();
             right_subsizer->Layout();
             props_sizer->Layout();
             props_sizer->SetSizeHints(properties_panel);
@@ -297,6 +318,9 @@ namespace AriaMaestosa
                 wxBell();
             }
             
+            const int output = m_output_choice->GetSelection();
+            m_parent->getTrack()->setOutputDevice(output > 0 ? m_output_choice->GetString(output) : wxString());
+            
             const int amount = m_choice_panels.size();
             Sequence* seq = m_parent->getSequence()->getModel();
             
@@ -43,7 +43,7 @@ namespace AriaMaestosa
         NotePickerWidget* m_note_pickers[10];
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(TuningDialog);
         
         TuningDialog();
         ~TuningDialog();
@@ -63,7 +63,7 @@ namespace AriaMaestosa
         bool m_progress_known;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(WaitWindowClass);
         
         WaitWindowClass(wxWindow* parent, wxString message, bool progressKnown) :
             wxDialog( parent, wxID_ANY,  _("Please wait..."), wxDefaultPosition, wxSize(250,200),
@@ -152,7 +152,11 @@ namespace AriaMaestosa
         
         void setProgress(int progress)
         {
-            waitWindow->setProgress( progress );
+            // progress may be reported by code that also runs headless (e.g. file export)
+            if (waitWindow != NULL)
+            {
+                waitWindow->setProgress( progress );
+            }
         }
         
         void hide()
@@ -29,6 +29,7 @@
 #include "GUI/GraphicalTrack.h"
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
+#include "MemoryUsage.h"
 #include "Midi/CommonMidiUtils.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
@@ -36,6 +37,7 @@
 #include "Pickers/ControllerChoice.h"
 #include "Pickers/InstrumentPicker.h"
 #include "Renderers/RenderAPI.h"
+#include "Profiler.h"
 
 #include <string>
 #include <cmath>
@@ -62,7 +64,7 @@ class ControlChangeInput : public wxMiniFrame
     
 public:
     
-    LEAK_CHECK();
+    LEAK_CHECK(ControlChangeInput);
     
     ControlChangeInput(ControllerEditor* parent, int tick, wxPoint where) : wxMiniFrame(NULL, wxID_ANY, wxT(""), where, wxDefaultSize,
 #ifdef __WXGTK__
@@ -269,6 +271,7 @@ ControllerEditor::ControllerEditor(GraphicalTrack* track) : Editor(track),
     m_has_been_resizing = false;
 
     m_controller_choice = new ControllerChoice();
+    m_event_index       = new ControllerEventIndex(m_track);
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -279,6 +282,27 @@ ControllerEditor::~ControllerEditor()
 
 // ----------------------------------------------------------------------------------------------------------
 
+void ControllerEditor::getMemoryUsage(MemoryUsage& usage) const
+{
+    Editor::getMemoryUsage(usage);
+    usage.add(MemoryUsage::ANALYSERS, m_event_index->getMemoryBytes(), 1);
+    usage.add(MemoryUsage::RENDER_CACHES, MemoryUsage::getVectorBytes(m_steps));
+    usage.addTexture(m_instrument_name.getTextureBytes());
+    usage.add(MemoryUsage::OTHER, sizeof(ControllerEditor) - sizeof(Editor));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ControllerEditor::hibernate()
+{
+    Editor::hibernate();
+    m_event_index->clear();
+    std::vector<ControllerStep>().swap(m_steps);
+    m_instrument_name.releaseTexture();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void ControllerEditor::renderEvents()
 {
     const int area_from_y = getAreaYFrom();
@@ -288,184 +312,150 @@ void ControllerEditor::renderEvents()
     AriaRender::color(0, 0.4, 1);
     AriaRender::lineWidth(3);
 
-    ControllerEvent* tmp;
-    int previous_location = -1, previous_value = -1;
-
     const int currentController = m_controller_choice->getControllerID();
-
-    const int eventAmount = m_track->getControllerEventAmount(currentController == PSEUDO_CONTROLLER_LYRICS,
-                                                              Track::isTempoController(currentController) );
+    const std::vector<ControllerEvent*>& events = m_event_index->getEvents(currentController);
+    const int eventAmount = events.size();
     
-    if (currentController == PSEUDO_CONTROLLER_LYRICS or
-        currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE or
-        currentController == 0 /* bank select */)
+    const int x_scroll = m_gsequence->getXScrollInPixels();
+    
+    // -------- Value events (drawn as steps, at most one per pixel column)
+    if (currentController != PSEUDO_CONTROLLER_LYRICS and
+        currentController != PSEUDO_CONTROLLER_INSTRUMENT_CHANGE and
+        currentController != 0 /* bank select */)
     {
-        AriaRender::images();
+        m_steps.clear();
+        ControllerEventIndex::collectSteps(events, m_gsequence->getZoom(), Editor::getEditorXStart(), x_scroll,
+                                           Editor::getEditorXStart(), getXEnd(), m_steps);
+        
+        const int stepAmount = m_steps.size();
+        for (int n=0; n<stepAmount; n++)
+        {
+            const ControllerStep& step = m_steps[n];
+            AriaRender::line(step.x_from, area_from_y + step.value*y_zoom,
+                             step.x_to,   area_from_y + step.value*y_zoom);
+        }
+        return;
     }
     
-    const int x_scroll = m_gsequence->getXScrollInPixels();
-    int eventsOfThisType = 0;
+    // -------- Events drawn as labels
+    AriaRender::images();
     
-    for (int n=0; n<eventAmount; n++)
-    {        
-        tmp = m_track->getControllerEvent(n, currentController);
-        if (tmp->getController() != currentController) continue; // only draw events of this controller
-        eventsOfThisType++;
+    // labels extend to the right of their event, so start with those that may still overlap the editor
+    int label_width;
+    if      (currentController == PSEUDO_CONTROLLER_LYRICS)             label_width = 100; // we support lyrics up to 100 pixels long
+    else if (currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE)  label_width = 200; // we support instrument names 200 pixels long
+    else                                                                label_width = 50;
+    
+    const int first_tick = (int)floor( (x_scroll - label_width) / m_gsequence->getZoom() );
+    
+    for (int n=ControllerEventIndex::firstEventAtOrAfter(events, first_tick); n<eventAmount; n++)
+    {
+        ControllerEvent* tmp = events[n];
         
         const int xloc = ControllerEditor::getPositionInPixels(tmp->getTick(), m_gsequence);
+        const int scrolled_x = xloc - x_scroll;
         
-        if (dynamic_cast<TextEvent*>(tmp) != NULL)
+        if (scrolled_x > getXEnd()) break; // if events are no more visible, stop drawing
+        if (scrolled_x <= Editor::getEditorXStart() - label_width) continue;
+        
+        if (currentController == PSEUDO_CONTROLLER_LYRICS)
         {
-            // we support lyrics up to 100 pixels long
-            if (xloc - x_scroll > Editor::getEditorXStart() - 100)
+            TextEvent* evt = static_cast<TextEvent*>(tmp);
+            evt->getText().bind();
+            AriaRender::color(0,0,0);
+            
+            int y;
+            
+            switch (n % 3)
             {
-                TextEvent* evt = dynamic_cast<TextEvent*>(tmp);
-                evt->getText().bind();
-                AriaRender::color(0,0,0);
-                
-                int y;
-                
-                switch (n % 3)
-                {
-                    case 0:
-                        y = (area_from_y + area_from_y + area_to_y)/3;
-                        break;
-                    case 1:
-                        y = (area_from_y + area_to_y)/2;
-                        break;
-                    default:
-                        y = (area_from_y + area_to_y + area_to_y)/3;
-                        break;
-                }
-                
-                AriaRender::primitives();
-                
-                if (tmp->getTick() >= std::min(m_selection_begin, m_selection_end) and
-                    tmp->getTick() <= std::max(m_selection_begin, m_selection_end))
-                {
-                    AriaRender::color(0, 0.75f, 0);
-                }
-                else
-                {
-                    AriaRender::color(0.6f, 0.6f, 0.6f);
-                }
-                
-                AriaRender::bordered_rect(xloc - x_scroll - 3, y - 12, xloc - x_scroll + 3, y - 5);
-                
-                AriaRender::images();
-                
-                
-                evt->getText().render(xloc - x_scroll + 6, y);
+                case 0:
+                    y = (area_from_y + area_from_y + area_to_y)/3;
+                    break;
+                case 1:
+                    y = (area_from_y + area_to_y)/2;
+                    break;
+                default:
+                    y = (area_from_y + area_to_y + area_to_y)/3;
+                    break;
             }
+            
+            AriaRender::primitives();
+            
+            if (tmp->getTick() >= std::min(m_selection_begin, m_selection_end) and
+                tmp->getTick() <= std::max(m_selection_begin, m_selection_end))
+            {
+                AriaRender::color(0, 0.75f, 0);
+            }
+            else
+            {
+                AriaRender::color(0.6f, 0.6f, 0.6f);
+            }
+            
+            AriaRender::bordered_rect(scrolled_x - 3, y - 12, scrolled_x + 3, y - 5);
+            
+            AriaRender::images();
+            
+            evt->getText().render(scrolled_x + 6, y);
         }
         else if (currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE)
         {
-            const int scrolled_x = xloc - x_scroll;
+            const int y = (area_from_y + area_to_y + area_to_y)/3;
             
-            // we support instrument names 200 pixels long
-            if (scrolled_x > Editor::getEditorXStart() - 200)
+            AriaRender::primitives();
+            
+            if (tmp->getTick() >= std::min(m_selection_begin, m_selection_end) and
+                tmp->getTick() <= std::max(m_selection_begin, m_selection_end))
             {
-                const int y = (area_from_y + area_to_y + area_to_y)/3;
-                
-                AriaRender::primitives();
-                
-                if (tmp->getTick() >= std::min(m_selection_begin, m_selection_end) and
-                    tmp->getTick() <= std::max(m_selection_begin, m_selection_end))
-                {
-                    AriaRender::color(0, 0.75f, 0);
-                }
-                else
-                {
-                    AriaRender::color(0.6f, 0.6f, 0.6f);
-                }
-                
-                AriaRender::bordered_rect(scrolled_x - 3, y - 6, scrolled_x + 3, y);
-                
-                AriaRender::images();
-                const unsigned short value = tmp->getValue();
-                
-                m_instrument_name.getModel()->setValue(InstrumentChoice::getInstrumentName( value ));
-                
-                // draw instrument name
-                AriaRender::color(0,0,0);
-                
-                m_instrument_name.bind();
-                m_instrument_name.render(scrolled_x + 6, y);
+                AriaRender::color(0, 0.75f, 0);
+            }
+            else
+            {
+                AriaRender::color(0.6f, 0.6f, 0.6f);
             }
+            
+            AriaRender::bordered_rect(scrolled_x - 3, y - 6, scrolled_x + 3, y);
+            
+            AriaRender::images();
+            const unsigned short value = tmp->getValue();
+            
+            m_instrument_name.getModel()->setValue(InstrumentChoice::getInstrumentName( value ));
+            
+            // draw instrument name
+            AriaRender::color(0,0,0);
+            
+            m_instrument_name.bind();
+            m_instrument_name.render(scrolled_x + 6, y);
         }
-        else if (currentController == 0) /* bank select */
+        else /* bank select */
         {
-            const int scrolled_x = xloc - x_scroll;
+            const int y = (area_from_y + area_to_y + area_to_y)/3;
+            
+            AriaRender::primitives();
             
-            if (scrolled_x > Editor::getEditorXStart() - 50)
+            if (tmp->getTick() >= std::min(m_selection_begin, m_selection_end) and
+                tmp->getTick() <= std::max(m_selection_begin, m_selection_end))
             {
-                const int y = (area_from_y + area_to_y + area_to_y)/3;
-                
-                AriaRender::primitives();
-                
-                if (tmp->getTick() >= std::min(m_selection_begin, m_selection_end) and
-                    tmp->getTick() <= std::max(m_selection_begin, m_selection_end))
-                {
-                    AriaRender::color(0, 0.75f, 0);
-                }
-                else
-                {
-                    AriaRender::color(0.6f, 0.6f, 0.6f);
-                }
-                
-                AriaRender::bordered_rect(scrolled_x - 3, y - 6, scrolled_x + 3, y);
-                
-                AriaRender::images();
-                const unsigned short value = (int)round(127.0f - tmp->getValue());
-                m_instrument_name.getModel()->setValue(to_wxString(value));
-                
-                AriaRender::color(0,0,0);
-                
-                m_instrument_name.bind();
-                m_instrument_name.render(scrolled_x + 6, y);
+                AriaRender::color(0, 0.75f, 0);
             }
-        }
-        else
-        {
-            // -------- Other events
-            const wxFloat64 value = tmp->getValue();
-
-            if (previous_location - x_scroll > getXEnd()) // if events are no more visible, stop drawing
-                return;
-
-            if (xloc - x_scroll > Editor::getEditorXStart())
+            else
             {
-                if (previous_location != -1 and previous_value != -1)
-                {
-                    AriaRender::line(previous_location - x_scroll,
-                                     area_from_y + previous_value*y_zoom,
-                                     xloc - x_scroll,
-                                     area_from_y + previous_value*y_zoom);
-                }
+                AriaRender::color(0.6f, 0.6f, 0.6f);
             }
-            previous_value = value;
+            
+            AriaRender::bordered_rect(scrolled_x - 3, y - 6, scrolled_x + 3, y);
+            
+            AriaRender::images();
+            const unsigned short value = (int)round(127.0f - tmp->getValue());
+            m_instrument_name.getModel()->setValue(to_wxString(value));
+            
+            AriaRender::color(0,0,0);
+            
+            m_instrument_name.bind();
+            m_instrument_name.render(scrolled_x + 6, y);
         }
-        
-        previous_location = xloc;
     }// next
     
-    if (currentController == PSEUDO_CONTROLLER_LYRICS or
-        currentController == PSEUDO_CONTROLLER_INSTRUMENT_CHANGE or
-        currentController == 0 /* bank select */)
-    {
-        AriaRender::primitives();
-    }
-    else
-    {
-        // draw horizontal line from last event to end of visible area
-        if (eventsOfThisType > 0)
-        {
-            AriaRender::line(previous_location - x_scroll,
-                             area_from_y + previous_value*y_zoom,
-                             getXEnd(),
-                             area_from_y + previous_value*y_zoom);
-        }
-    }
+    AriaRender::primitives();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -473,6 +463,8 @@ void ControllerEditor::renderEvents()
 void ControllerEditor::render(RelativeXCoord mousex_current, int mousey_current,
                               RelativeXCoord mousex_initial, int mousey_initial, bool focus)
 {
+    PROFILE_ZONE("ControllerEditor::render");
+    
     AriaRender::beginScissors(LEFT_EDGE_X, getEditorYStart(), m_width - RIGHT_SCISSOR, m_height);
     
     // -------------------------------- background ----------------------------
@@ -693,7 +685,7 @@ void ControllerEditor::mouseDown(RelativeXCoord x, const int y)
     if (window_x < Editor::getEditorXStart() and y > getEditorYStart() and
         not m_graphical_track->isCollapsed() )
     {
-        Display::popupMenu(m_controller_choice, window_x, y + 15);
+        Display::popupMenu(m_controller_choice->getMenu(), window_x, y + 15);
         getMainFrame()->getMainPane()->SetFocus();
     }
     
@@ -18,6 +18,7 @@
 #ifndef __CONTROLLER_EDITOR_H__
 #define __CONTROLLER_EDITOR_H__
 
+#include "Editors/ControllerEventIndex.h"
 #include "Editors/Editor.h"
 #include "Pickers/ControllerChoice.h"
 
@@ -45,6 +46,12 @@ namespace AriaMaestosa
         
         OwnerPtr<ControllerChoice>  m_controller_choice;
         
+        /** Tick-sorted views of the events of each controller, used to render only what is visible */
+        OwnerPtr<ControllerEventIndex> m_event_index;
+        
+        /** Steps of the controller curve for the current frame (kept as a member to reuse its storage) */
+        std::vector<ControllerStep> m_steps;
+        
         int m_selection_begin, m_selection_end;
         
         int m_mouse_y;
@@ -91,6 +98,9 @@ namespace AriaMaestosa
         ControllerEditor(GraphicalTrack* track);
         ~ControllerEditor();
         
+        virtual void getMemoryUsage(MemoryUsage& usage) const;
+        virtual void hibernate();
+        
         virtual void render(RelativeXCoord mousex_current, int mousey_current,
                             RelativeXCoord mousex_initial, int mousey_initial, bool focus=false);
         
@@ -0,0 +1,241 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Editors/ControllerEventIndex.h"
+
+#include "AriaCore.h"
+#include "Midi/ControllerEvent.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    /** sort predicate; stable sorting keeps the original order of events on the same tick */
+    bool controllerEventTickIsLess(const ControllerEvent* a, const ControllerEvent* b)
+    {
+        return a->getTick() < b->getTick();
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+ControllerEventIndex::ControllerEventIndex(Track* track)
+{
+    m_track    = track;
+    m_revision = -1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const std::vector<ControllerEvent*>& ControllerEventIndex::getEvents(const int controller)
+{
+    const int revision = m_track->getSequence()->getEventsRevision();
+    if (revision != m_revision)
+    {
+        m_views.clear();
+        m_revision = revision;
+    }
+    
+    std::map< int, std::vector<ControllerEvent*> >::iterator it = m_views.find(controller);
+    if (it != m_views.end()) return it->second;
+    
+    std::vector<ControllerEvent*>& view = m_views[controller];
+    
+    const int eventAmount = m_track->getControllerEventAmount(controller == PSEUDO_CONTROLLER_LYRICS,
+                                                              Track::isTempoController(controller));
+    for (int n=0; n<eventAmount; n++)
+    {
+        ControllerEvent* evt = m_track->getControllerEvent(n, controller);
+        if (evt->getController() == controller) view.push_back(evt);
+    }
+    
+    std::stable_sort(view.begin(), view.end(), controllerEventTickIsLess);
+    return view;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ControllerEventIndex::clear()
+{
+    m_views.clear();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+long long ControllerEventIndex::getMemoryBytes() const
+{
+    long long bytes = sizeof(ControllerEventIndex);
+    
+    std::map< int, std::vector<ControllerEvent*> >::const_iterator it;
+    for (it = m_views.begin(); it != m_views.end(); it++)
+    {
+        // map nodes hold the key, the vector and 3 pointers + a color
+        bytes += sizeof(*it) + 4*sizeof(void*) + (long long)it->second.capacity()*sizeof(ControllerEvent*);
+    }
+    return bytes;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int ControllerEventIndex::firstEventAtOrAfter(const std::vector<ControllerEvent*>& events, const int tick)
+{
+    int from = 0;
+    int to   = events.size();
+    
+    while (from < to)
+    {
+        const int middle = from + (to - from)/2;
+        if (events[middle]->getTick() < tick) from = middle + 1;
+        else                                  to   = middle;
+    }
+    
+    return from;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ControllerEventIndex::collectSteps(const std::vector<ControllerEvent*>& events, const float zoom,
+                                        const int x_start, const int x_scroll, const int x_min, const int x_max,
+                                        std::vector<ControllerStep>& out)
+{
+    const int count = events.size();
+    if (count == 0) return;
+    
+    // start with the last event before the visible area, its step enters the view
+    const int first_visible_tick = (int)floor( (x_min - x_start + x_scroll) / zoom );
+    const int first = std::max(0, firstEventAtOrAfter(events, first_visible_tick) - 1);
+    
+    bool have_step = false;
+    ControllerStep step;
+    
+    for (int n=first; n<count; n++)
+    {
+        const int x = (int)(events[n]->getTick()*zoom + x_start) - x_scroll;
+        
+        if (not have_step)
+        {
+            if (x > x_max) return; // nothing visible
+            
+            step.x_from = x;
+            have_step   = true;
+        }
+        else if (x != step.x_from)
+        {
+            if (x > x_min)
+            {
+                step.x_to = x;
+                out.push_back(step);
+            }
+            if (x > x_max) return;
+            
+            step.x_from = x;
+        }
+        
+        // when several events share a pixel column, the last one gives the value leaving it
+        step.value = (int)events[n]->getValue();
+    }
+    
+    // draw horizontal line from last event to end of visible area
+    step.x_to = x_max;
+    out.push_back(step);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestControllerEventIndex
+{
+    using namespace AriaMaestosa;
+    
+    UNIT_TEST(TestDenseAutomationFrameTime)
+    {
+        const int EVENT_AMOUNT = 100000;
+        const int VIEW_WIDTH   = 1000;
+        
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<EVENT_AMOUNT; n++)
+            {
+                // pitch bend events every 4 ticks, interleaved with a modulation curve
+                t->addControlEvent_import(n*4, 64 + (n % 64), PSEUDO_CONTROLLER_PITCH_BEND);
+                if (n % 10 == 0) t->addControlEvent_import(n*4, n % 128, 1 /* modulation */);
+            }
+        }
+        seq->addTrack(t);
+        
+        ControllerEventIndex index(t);
+        
+        wxStopWatch buildTime;
+        const std::vector<ControllerEvent*>& pitchBend = index.getEvents(PSEUDO_CONTROLLER_PITCH_BEND);
+        const long buildMs = buildTime.Time();
+        
+        require_e((int)pitchBend.size(), ==, EVENT_AMOUNT, "the view contains all events of its controller");
+        require_e((int)index.getEvents(1).size(), ==, EVENT_AMOUNT/10, "the view contains all events of its controller");
+        
+        for (int n=1; n<(int)pitchBend.size(); n++)
+        {
+            require(pitchBend[n-1]->getTick() <= pitchBend[n]->getTick(), "views are sorted by tick");
+        }
+        
+        require_e(ControllerEventIndex::firstEventAtOrAfter(pitchBend, 0), ==, 0, "binary search");
+        require_e(ControllerEventIndex::firstEventAtOrAfter(pitchBend, 401), ==, 101, "binary search");
+        require_e(ControllerEventIndex::firstEventAtOrAfter(pitchBend, EVENT_AMOUNT*4), ==, EVENT_AMOUNT,
+                  "binary search");
+        
+        // zoomed out (whole song in view) and zoomed in near the end of the song
+        const float zooms[]   = { VIEW_WIDTH/(EVENT_AMOUNT*4.0f), 2.0f };
+        const int   scrolls[] = { 0, EVENT_AMOUNT*4*2 - VIEW_WIDTH*2 };
+        
+        for (int z=0; z<2; z++)
+        {
+            const int FRAMES = 100;
+            std::vector<ControllerStep> steps;
+            
+            wxStopWatch frameTime;
+            for (int frame=0; frame<FRAMES; frame++)
+            {
+                steps.clear();
+                ControllerEventIndex::collectSteps(pitchBend, zooms[z], 0, scrolls[z], 0, VIEW_WIDTH, steps);
+            }
+            const long totalMs = frameTime.Time();
+            
+            require(not steps.empty(), "steps are produced");
+            require_e((int)steps.size(), <=, VIEW_WIDTH + 2, "at most one step per pixel column");
+            for (unsigned int n=1; n<steps.size(); n++)
+            {
+                require_e(steps[n].x_from, >, steps[n-1].x_from, "steps advance by whole pixel columns");
+            }
+            
+            std::cout << "[ControllerEventIndex] zoom " << zooms[z] << " : " << steps.size() << " steps, "
+                      << (totalMs / (float)FRAMES) << " ms per frame (views built in " << buildMs << " ms)"
+                      << std::endl;
+        }
+        
+        delete seq;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __CONTROLLER_EVENT_INDEX_H__
+#define __CONTROLLER_EVENT_INDEX_H__
+
+#include "Utils.h"
+
+#include <map>
+#include <vector>
+
+namespace AriaMaestosa
+{
+    
+    class ControllerEvent;
+    class Track;
+    
+    /**
+      * @brief a horizontal step of a controller curve, in window coordinates
+      * @ingroup editors
+      */
+    struct ControllerStep
+    {
+        int x_from;
+        int x_to;
+        
+        /** value of the step (127 - [midi value]) */
+        int value;
+    };
+    
+    /**
+      * @brief per-controller views over the events shown in the controller editor, sorted by tick
+      *
+      * The controller events of a track are stored all types mixed together; tempo and lyrics
+      * events live in the sequence. This keeps one tick-sorted vector per controller type, built
+      * on demand, so that rendering can jump straight to the first visible event. All views are
+      * dropped when the events revision of the sequence changes.
+      *
+      * @ingroup editors
+      */
+    class ControllerEventIndex
+    {
+        Track* m_track;
+        
+        /** events revision of the sequence the views were built against */
+        int m_revision;
+        
+        std::map< int, std::vector<ControllerEvent*> > m_views;
+        
+    public:
+        
+        LEAK_CHECK(ControllerEventIndex);
+        
+        ControllerEventIndex(Track* track);
+        
+        /** @return the events of the given controller type (or pseudo-controller), sorted by tick */
+        const std::vector<ControllerEvent*>& getEvents(const int controller);
+        
+        /** @brief drops all views; they are built again when next asked for */
+        void clear();
+        
+        /** @return the approximate number of bytes used by the views built so far */
+        long long getMemoryBytes() const;
+        
+        /**
+          * @return the index of the first event at or after 'tick', or the size of 'events' if
+          *         there is none (binary search)
+          */
+        static int firstEventAtOrAfter(const std::vector<ControllerEvent*>& events, const int tick);
+        
+        /**
+          * Compute the steps to draw for a value controller within [x_min, x_max] (window coordinates).
+          * Events that fall within the same pixel column are merged, so at most one step is produced
+          * per column; the last event of a column gives the value leaving it. The last step extends
+          * to 'x_max' when the curve does not go past the visible area.
+          *
+          * @param x_start  window x coordinate of tick 0 when not scrolled
+          * @param x_scroll horizontal scrolling, in pixels
+          */
+        static void collectSteps(const std::vector<ControllerEvent*>& events, const float zoom,
+                                 const int x_start, const int x_scroll, const int x_min, const int x_max,
+                                 std::vector<ControllerStep>& out);
+    };
+    
+}
+
+#endif
@@ -26,6 +26,7 @@
 #include "GUI/GraphicalSequence.h"
 #include "GUI/GraphicalTrack.h"
 #include "GUI/ImageProvider.h"
+#include "MemoryUsage.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Track.h"
 #include "Midi/Sequence.h"
@@ -33,6 +34,7 @@
 #include "PreferencesData.h"
 #include "Renderers/Drawable.h"
 #include "Renderers/RenderAPI.h"
+#include "Profiler.h"
 
 #include "AriaCore.h"
 
@@ -288,6 +290,23 @@ DrumEditor::~DrumEditor()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void DrumEditor::getMemoryUsage(MemoryUsage& usage) const
+{
+    Editor::getMemoryUsage(usage);
+    usage.addTexture(m_drum_names_renderer.getTextureBytes());
+    usage.add(MemoryUsage::OTHER, sizeof(DrumEditor) - sizeof(Editor) + MemoryUsage::getVectorBytes(m_drums));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void DrumEditor::hibernate()
+{
+    Editor::hibernate();
+    m_drum_names_renderer.releaseTexture();
+}
+
 
 // ----------------------------------------------------------------------------------------------------------
 void DrumEditor::useCustomDrumSet()
@@ -620,9 +639,15 @@ int DrumEditor::getYForDrum(const int given_drumID)
 
 NoteSearchResult DrumEditor::noteAt(RelativeXCoord x, const int y, int& noteID)
 {
-    const int noteAmount = m_track->getNoteAmount();
-    for (int n=0; n<noteAmount; n++)
+    // drums are hit within a few pixels of their start; their order on screen is not the midi
+    // order, so only the time range is used to narrow down the candidates
+    const int x_edit = x.getRelativeTo(EDITOR);
+    findNotesInXRange(x_edit - 5, x_edit + 1);
+
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n     = m_found_notes[i];
         const int drumx = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
 
         ASSERT(m_track->getNotePitchID(n)>0);
@@ -739,9 +764,16 @@ void DrumEditor::moveNote(Note& note, const int relativeX, const int relativeY)
 void DrumEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mousey_current,
                                    RelativeXCoord& mousex_initial, int mousey_initial)
 {
-    const int count = m_track->getNoteAmount();
-    for (int n=0; n<count; n++)
+    // notes outside the rectangle get deselected (selectNote honours the select more/less modifiers)
+    m_track->selectNote(ALL_NOTES, false);
+
+    findNotesInXRange(std::min(mousex_current.getRelativeTo(EDITOR), mousex_initial.getRelativeTo(EDITOR)),
+                      std::max(mousex_current.getRelativeTo(EDITOR), mousex_initial.getRelativeTo(EDITOR)));
+
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n     = m_found_notes[i];
         const int drumx = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
 
         ASSERT(m_track->getNotePitchID(n)>0);
@@ -759,10 +791,6 @@ void DrumEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mousey_cu
         {
             m_graphical_track->selectNote(n, true);
         }
-        else
-        {
-            m_graphical_track->selectNote(n, false);
-        }
 
     }//next note
 }
@@ -874,25 +902,41 @@ void DrumEditor::mouseUp(RelativeXCoord mousex_current, const int mousey_current
 #pragma mark Rendering
 #endif
 
+void DrumEditor::getBackgroundState(std::vector<int>& state)
+{
+    Editor::getBackgroundState(state);
+    state.push_back( m_drums.size() );
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void DrumEditor::render(RelativeXCoord mousex_current, int mousey_current,
                         RelativeXCoord mousex_initial, int mousey_initial, bool focus)
 {
+    PROFILE_ZONE("DrumEditor::render");
+    
     AriaRender::beginScissors(LEFT_EDGE_X, getEditorYStart(), m_width - RIGHT_SCISSOR, m_height);
 
-    drawVerticalMeasureLines(getEditorYStart(), getYEnd());
-
-    // ----------------------- draw horizontal lines ---------------------
-    AriaRender::primitives();
-    AriaRender::color(0.5, 0.5, 0.5);
-    const int drumAmount = m_drums.size();
-    for (int drumID=0; drumID<drumAmount+1; drumID++)
+    if (beginBackground())
     {
-        const int y = getEditorYStart() + drumID*Y_STEP - getYScrollInPixels();
-        if (y < getEditorYStart() or y > getYEnd()) continue;
+        drawVerticalMeasureLines(getEditorYStart(), getYEnd());
+
+        // ----------------------- draw horizontal lines ---------------------
+        AriaRender::primitives();
+        AriaRender::color(0.5, 0.5, 0.5);
+        const int drumAmount = m_drums.size();
+        for (int drumID=0; drumID<drumAmount+1; drumID++)
+        {
+            const int y = getEditorYStart() + drumID*Y_STEP - getYScrollInPixels();
+            if (y < getEditorYStart() or y > getYEnd()) continue;
 
-        AriaRender::line(Editor::getEditorXStart(), y, getXEnd(), y);
+            AriaRender::line(Editor::getEditorXStart(), y, getXEnd(), y);
 
+        }
+        
+        endBackground();
     }
+    AriaRender::primitives();
 
 
     // ---------------------- draw notes ----------------------------
@@ -988,9 +1032,12 @@ void DrumEditor::render(RelativeXCoord mousex_current, int mousey_current,
         {
             // move a bunch of notes
 
-            for (int n=0; n<noteAmount; n++)
+            std::vector<int> selection;
+            m_track->getSelectedNoteIDs(selection);
+
+            for (unsigned int i=0; i<selection.size(); i++)
             {
-                if (not m_track->isNoteSelected(n)) continue;
+                const int n = selection[i];
 
                 const int drumx = m_graphical_track->getNoteStartInPixels(n) -
                                   m_gsequence->getXScrollInPixels() +
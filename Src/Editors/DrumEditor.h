@@ -61,12 +61,18 @@ namespace AriaMaestosa
         DrumEditor(GraphicalTrack* track);
         ~DrumEditor();
         
+        virtual void getMemoryUsage(MemoryUsage& usage) const;
+        virtual void hibernate();
+        
         void useCustomDrumSet();
         void useDefaultDrumSet();
         
         virtual void render(RelativeXCoord mousex_current, int mousey_current,
                             RelativeXCoord mousex_initial, int mousey_initial, bool focus=false);
         
+        /** the background depends on the amount of drum lines; overriden from Editor */
+        virtual void getBackgroundState(std::vector<int>& state);
+        
         /** @return vector that says in which order the drums are drawn, how they're divided in sections, etc. */
         const std::vector<DrumInfo>& getDrums() const { return m_drums; }
         
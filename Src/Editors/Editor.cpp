@@ -26,6 +26,7 @@
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
 #include "IO/IOUtils.h"
+#include "MemoryUsage.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
@@ -36,6 +37,8 @@
 #include "UnitTest.h"
 #include "Utils.h"
 
+#include <algorithm>
+#include <cmath>
 #include <wx/tokenzr.h>
 
 
@@ -94,6 +97,8 @@ Editor::Editor(GraphicalTrack* track)
     m_is_duplicating_note = false;
 
     m_relative_height = 1.0f;
+    
+    m_background_layer = new AriaRender::Layer();
 }
 
 // ------------------------------------------------------------------------------------------------------------
@@ -104,6 +109,29 @@ Editor::~Editor()
 
 // ------------------------------------------------------------------------------------------------------------
 
+void Editor::getMemoryUsage(MemoryUsage& usage) const
+{
+    const long long layerBytes = m_background_layer->getCachedBytes();
+    usage.add(MemoryUsage::RENDER_CACHES, layerBytes, (layerBytes > 0 ? 1 : 0));
+    usage.add(MemoryUsage::RENDER_CACHES, MemoryUsage::getVectorBytes(m_found_notes) +
+              MemoryUsage::getVectorBytes(m_background_state) + MemoryUsage::getVectorBytes(m_background_state_now));
+    usage.add(MemoryUsage::OTHER, sizeof(Editor));
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
+void Editor::hibernate()
+{
+    m_background_layer->invalidate();
+    
+    // swap with empty vectors, since 'clear' keeps the memory
+    std::vector<int>().swap(m_found_notes);
+    std::vector<int>().swap(m_background_state);
+    std::vector<int>().swap(m_background_state_now);
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
 void Editor::useInstantNotes(bool enabled)
 {
     ASSERT( MAGIC_NUMBER_OK() );
@@ -134,6 +162,62 @@ void Editor::render()
 
 // ------------------------------------------------------------------------------------------------------------
 
+void Editor::getBackgroundState(std::vector<int>& state)
+{
+    state.push_back( getEditorYStart() );
+    state.push_back( m_width );
+    state.push_back( m_height );
+    state.push_back( Display::getWidth() );
+    state.push_back( Display::getHeight() );
+    state.push_back( m_gsequence->getXScrollInPixels() );
+    state.push_back( getYScrollInPixels() );
+    state.push_back( m_y_step );
+    state.push_back( m_gsequence->getZoomInPercent() );
+    state.push_back( m_sequence->getMeasureData()->getRevision() );
+    state.push_back( m_track->isPlayed() );
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
+bool Editor::beginBackground()
+{
+    // the area that is both within the editor's scissors, the track's background and the window
+    const int x1 = LEFT_EDGE_X;
+    const int x2 = std::min(LEFT_EDGE_X + m_width - RIGHT_SCISSOR, Display::getWidth() - MARGIN);
+    const int y1 = std::max(getEditorYStart(), 0);
+    const int y2 = std::min(getEditorYStart() + m_height, Display::getHeight());
+    if (x2 <= x1 or y2 <= y1) return false;
+    
+    m_background_state_now.clear();
+    getBackgroundState(m_background_state_now);
+    
+    if (m_background_state_now == m_background_state and
+        AriaRender::drawLayer(*m_background_layer, x1, y1, x2 - x1, y2 - y1))
+    {
+        return false;
+    }
+    
+    m_background_state.swap(m_background_state_now);
+    AriaRender::beginLayer(*m_background_layer, x1, y1, x2 - x1, y2 - y1);
+    
+    // same fill as the area under the editors in GraphicalTrack, since layers are opaque
+    AriaRender::primitives();
+    if (m_track->isPlayed()) AriaRender::color(1, 1, 1);
+    else                     AriaRender::color(0.9, 0.9, 0.9);
+    AriaRender::rect(x1, y1, x2, y2);
+    
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
+void Editor::endBackground()
+{
+    AriaRender::endLayer(*m_background_layer);
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
 void Editor::drawVerticalMeasureLines(const int from_y, const int to_y)
 {
     ASSERT( MAGIC_NUMBER_OK() );
@@ -874,6 +958,22 @@ int Editor::getLevelAtY(const int y)
     
 // ------------------------------------------------------------------------------------------------------------
 
+void Editor::findNotesInXRange(const int x_from, const int x_to, const int pitch_from, const int pitch_to)
+{
+    const float zoom    = m_gsequence->getZoom();
+    const int   xscroll = m_gsequence->getXScrollInPixels();
+    
+    // notes are placed in pixels by truncation; widen by one pixel on each side so rounding can't
+    // leave out a note that the exact pixel tests would accept
+    const int tick_from = (int)floor( (x_from + xscroll - 1) / zoom );
+    const int tick_to   = (int)ceil ( (x_to   + xscroll + 1) / zoom );
+    
+    m_found_notes.clear();
+    m_track->getNoteIndex().findNotes(tick_from, tick_to, pitch_from, pitch_to, m_found_notes);
+}
+
+// ------------------------------------------------------------------------------------------------------------
+
 void Editor::makeMoveNoteEvent(const int relativeX, const int relativeY, const int noteID,
                                Action::Duplicate* duplicateParent)
 {
@@ -960,15 +1060,7 @@ void Editor::processKeyPress(int keycode, bool commandDown, bool shiftDown)
     
     if (keycode == WXK_TAB)
     {
-        int idSelectedNote = -1;
-        for (int i = 0; i < m_track->getNoteAmount(); i++)
-        {
-            if (m_track->isNoteSelected(i))
-            {
-                idSelectedNote = i;
-                break;
-            }
-        }
+        const int idSelectedNote = m_track->getFirstSelectedNote();
         
         if (idSelectedNote != -1)
         {
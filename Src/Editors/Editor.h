@@ -26,10 +26,13 @@
 #include "ptr_vector.h"
 #include "Utils.h"
 
+#include <vector>
+
 
 namespace AriaMaestosa
 {
     namespace Action { class Duplicate; }
+    namespace AriaRender { class Layer; }
     
     const int BORDER_SIZE = 20;
     const int MARGIN = 5;
@@ -43,6 +46,7 @@ namespace AriaMaestosa
     class Track;
     class InstrumentChoice;
     class GraphicalSequence;
+    class MemoryUsage;
     
     enum NoteSearchResult
     {
@@ -131,6 +135,16 @@ namespace AriaMaestosa
         
         ptr_vector<Track, REF> m_background_tracks;
         
+        /** IDs of notes returned by 'findNotesInXRange', kept to avoid reallocating on each query */
+        std::vector<int> m_found_notes;
+        
+        /** cached rendering of the static background (lanes, strings, measure lines), see 'beginBackground' */
+        OwnerPtr<AriaRender::Layer> m_background_layer;
+        
+        /** the state the background layer was drawn for, see 'getBackgroundState' */
+        std::vector<int> m_background_state;
+        std::vector<int> m_background_state_now;
+        
         /** Only used upon loading aria file */
         wxString m_background_tracks_temp_string;
         
@@ -144,6 +158,15 @@ namespace AriaMaestosa
         
         void makeMoveNoteEvent(const int relativeX, const int relativeY, const int m_last_clicked_note,
                                Action::Duplicate* duplicateParent=NULL);
+        
+        /**
+          * @brief Look up (through the track's NoteIndex) the notes that may be drawn between the given
+          *        x coordinates, relative to the editor, with a pitch ID in [pitch_from, pitch_to].
+          *
+          * Results are stored in 'm_found_notes', in increasing note order. They may include a few notes
+          * just outside of the range, so callers still perform their exact pixel tests on them.
+          */
+        void findNotesInXRange(const int x_from, const int x_to, const int pitch_from=0, const int pitch_to=131);
 
         /** @brief if you use a scrollbar, call this method somewhere near the end of your render method. */
         void renderScrollbar();
@@ -154,6 +177,26 @@ namespace AriaMaestosa
          */
         void setYStep(const int height);
         
+        /**
+          * @brief draw the static background of the editor from its cache, if still valid.
+          *
+          * Call after setting up the editor's scissors.
+          * @return true if the background must be drawn; it is then drawn normally, followed by a call
+          *         to 'endBackground' that caches it. The area was already filled with the track color.
+          *         false if the cached background was drawn.
+          */
+        bool beginBackground();
+        
+        /** @brief cache the background drawn after 'beginBackground' returned true */
+        void endBackground();
+        
+        /**
+          * @brief collect the values the background depends on; the cache is redrawn when any changes.
+          * The base implementation covers position, size, scrolling, zoom, measures and the track's
+          * played state. Editors whose background depends on more (key, tuning...) add to it.
+          */
+        virtual void getBackgroundState(std::vector<int>& state);
+        
         void setPaleLineColor();
         void setStrongLineColor();
         virtual void updateMovingCursor();
@@ -167,7 +210,7 @@ namespace AriaMaestosa
         MainFrame*         m_main_frame;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(Editor);
         DECLARE_MAGIC_NUMBER();
         
         Editor(GraphicalTrack* track);
@@ -261,6 +304,15 @@ namespace AriaMaestosa
         /** @brief called when it's time to render; invokes the other render method in derived editor class */
         void render();
         
+        /** @brief adds the memory used by this editor (caches, analysers, textures; see MemoryUsage) */
+        virtual void getMemoryUsage(MemoryUsage& usage) const;
+        
+        /**
+          * @brief frees what this editor keeps between two renders (cached background, textures,
+          *        analysers), while its sequence is not shown; all of it is rebuilt by the next render
+          */
+        virtual void hibernate();
+        
         /** @brief Called whenever the mouse is moved; override if you need this information */
         virtual void processMouseMove(RelativeXCoord x, int y) {}
 
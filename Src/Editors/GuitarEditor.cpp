@@ -30,6 +30,7 @@
 #include "Midi/Track.h"
 #include "Pickers/TuningPicker.h"
 #include "PreferencesData.h"
+#include "Profiler.h"
 #include "Renderers/RenderAPI.h"
 #include "Singleton.h"
 #include <cstddef>
@@ -97,6 +98,8 @@ GuitarEditor::~GuitarEditor()
 void GuitarEditor::render(RelativeXCoord mousex_current, int mousey_current,
                           RelativeXCoord mousex_initial, int mousey_initial, bool focus)
 {
+    PROFILE_ZONE("GuitarEditor::render");
+    
 
     if (not ImageProvider::imagesLoaded()) return;
 
@@ -105,18 +108,25 @@ void GuitarEditor::render(RelativeXCoord mousex_current, int mousey_current,
 
     AriaRender::beginScissors(LEFT_EDGE_X, getEditorYStart(), m_width - RIGHT_SCISSOR, m_height);
 
-    drawVerticalMeasureLines(getEditorYStart() + first_string_position,
-                             getEditorYStart() + first_string_position + (string_amount-1)*m_y_step);
-
-    // ------------------------------- draw strings -------------------------------
-    AriaRender::color(0,0,0);
-
     const int stringCount = tuning->tuning.size();
-    for (int n=0; n<stringCount; n++)
+    
+    if (beginBackground())
     {
-        AriaRender::line(Editor::getEditorXStart(), getEditorYStart() + first_string_position + n*m_y_step,
-                        getXEnd(), getEditorYStart() + first_string_position + n*m_y_step);
+        drawVerticalMeasureLines(getEditorYStart() + first_string_position,
+                                 getEditorYStart() + first_string_position + (string_amount-1)*m_y_step);
+
+        // ------------------------------- draw strings -------------------------------
+        AriaRender::color(0,0,0);
+
+        for (int n=0; n<stringCount; n++)
+        {
+            AriaRender::line(Editor::getEditorXStart(), getEditorYStart() + first_string_position + n*m_y_step,
+                            getXEnd(), getEditorYStart() + first_string_position + n*m_y_step);
+        }
+        
+        endBackground();
     }
+    AriaRender::primitives();
 
     int lastNote[stringCount];
     int lastNoteTick[stringCount];
@@ -137,11 +147,14 @@ void GuitarEditor::render(RelativeXCoord mousex_current, int mousey_current,
     const int mouse_y1 = std::min(mousey_current, mousey_initial);
     const int mouse_y2 = std::max(mousey_current, mousey_initial);
     
+    const int pscroll = m_gsequence->getXScrollInPixels();
+    const std::vector<int>& noteStarts = m_graphical_track->getNoteStartsInPixels();
+    const std::vector<int>& noteEnds   = m_graphical_track->getNoteEndsInPixels();
+    
     for (int n=0; n<noteAmount; n++)
     {
-        const int pscroll = m_gsequence->getXScrollInPixels();
-        int x1 = m_graphical_track->getNoteStartInPixels(n) - pscroll;
-        int x2 = m_graphical_track->getNoteEndInPixels(n)   - pscroll;
+        int x1 = noteStarts[n] - pscroll;
+        int x2 = noteEnds[n]   - pscroll;
 
         
         // don't draw notes that won't visible
@@ -321,9 +334,12 @@ void GuitarEditor::render(RelativeXCoord mousex_current, int mousey_current,
         {
             // move a bunch of notes
 
-            for (int n=0; n<m_track->getNoteAmount(); n++)
+            std::vector<int> selection;
+            m_track->getSelectedNoteIDs(selection);
+
+            for (unsigned int i=0; i<selection.size(); i++)
             {
-                if (not m_track->isNoteSelected(n)) continue;
+                const int n = selection[i];
 
                 const int x1     = m_graphical_track->getNoteStartInPixels(n) -
                                    m_gsequence->getXScrollInPixels();
@@ -411,12 +427,29 @@ void GuitarEditor::mouseDown(RelativeXCoord x, const int y)
 
 // ----------------------------------------------------------------------------------------------------------
 
+void GuitarEditor::getBackgroundState(std::vector<int>& state)
+{
+    Editor::getBackgroundState(state);
+    state.push_back( m_track->getGuitarTuning()->tuning.size() );
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void GuitarEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mousey_current,
                                      RelativeXCoord& mousex_initial, int mousey_initial)
 {
-    const int count = m_track->getNoteAmount();
-    for (int n=0; n<count; n++)
+    // notes outside the rectangle get deselected (selectNote honours the select more/less modifiers)
+    m_track->selectNote(ALL_NOTES, false);
+    
+    // strings are not ordered by pitch, so only the time range is used to narrow down the candidates
+    findNotesInXRange(std::min(mousex_current.getRelativeTo(EDITOR), mousex_initial.getRelativeTo(EDITOR)),
+                      std::max(mousex_current.getRelativeTo(EDITOR), mousex_initial.getRelativeTo(EDITOR)));
+    
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n = m_found_notes[i];
+        
         // on-screen pixel where note starts
         const int x1 = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
         
@@ -433,10 +466,6 @@ void GuitarEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mousey_
         {
             m_graphical_track->selectNote(n, true);
         }
-        else
-        {
-            m_graphical_track->selectNote(n, false);
-        }
     }//next
 }
 
@@ -466,11 +495,12 @@ NoteSearchResult GuitarEditor::noteAt(RelativeXCoord x, const int y, int& noteID
 {
     const int x_edit = x.getRelativeTo(EDITOR);
 
-    const int noteAmount = m_track->getNoteAmount();
+    findNotesInXRange(x_edit, x_edit);
     
     // iterate through notes in reverse order (last drawn note appears on top and must be first selected)
-    for (int n=noteAmount-1; n>-1; n--)
+    for (int i=(int)m_found_notes.size()-1; i>-1; i--)
     {
+        const int n  = m_found_notes[i];
         const int x1 = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
         const int x2 = m_graphical_track->getNoteEndInPixels(n)   - m_gsequence->getXScrollInPixels();
 
@@ -78,6 +78,9 @@ namespace AriaMaestosa
         virtual NotationType getNotationType() const { return GUITAR; }
         
         virtual void processKeyPress(int keycode, bool commandDown, bool shiftDown);
+        
+        /** the background depends on the amount of strings; overriden from Editor */
+        virtual void getBackgroundState(std::vector<int>& state);
     };
     
 }
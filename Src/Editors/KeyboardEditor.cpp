@@ -30,6 +30,7 @@
 #include "GUI/GraphicalTrack.h"
 #include "GUI/ImageProvider.h"
 #include "GUI/MainFrame.h"
+#include "MemoryUsage.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
@@ -38,6 +39,7 @@
 #include "Renderers/RenderAPI.h"
 #include "Utils.h"
 #include "PreferencesData.h"
+#include "Profiler.h"
 
 #define SHOW_MIDI_PITCH 0
 
@@ -120,6 +122,25 @@ KeyboardEditor::~KeyboardEditor()
 
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void KeyboardEditor::getMemoryUsage(MemoryUsage& usage) const
+{
+    Editor::getMemoryUsage(usage);
+    usage.addTexture(m_sharp_notes_names.getTextureBytes());
+    usage.addTexture(m_flat_notes_names.getTextureBytes());
+    usage.add(MemoryUsage::OTHER, sizeof(KeyboardEditor) - sizeof(Editor));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void KeyboardEditor::hibernate()
+{
+    Editor::hibernate();
+    m_sharp_notes_names.releaseTexture();
+    m_flat_notes_names.releaseTexture();
+}
+
 // **********************************************************************************************************
 // ****************************************    EVENTS      **************************************************
 // **********************************************************************************************************
@@ -185,13 +206,31 @@ void KeyboardEditor::addNote(const int snapped_start_tick, const int snapped_end
 
 // -----------------------------------------------------------------------------------------------------------
 
+void KeyboardEditor::getBackgroundState(std::vector<int>& state)
+{
+    Editor::getBackgroundState(state);
+    
+    const KeyInclusionType* key_notes = m_track->getKeyNotes();
+    for (int n=0; n<131; n++)
+    {
+        state.push_back( key_notes[n] );
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 NoteSearchResult KeyboardEditor::noteAt(RelativeXCoord x, const int y, int& noteID)
 {
     const int x_edit = x.getRelativeTo(EDITOR);
+    const int y_edit = y - getEditorYStart() + getYScrollInPixels();
 
-    const int noteAmount = m_track->getNoteAmount();
-    for (int n=0; n<noteAmount; n++)
+    // only notes overlapping the clicked tick, on the one or two rows under the mouse, are candidates
+    findNotesInXRange(x_edit, x_edit, (y_edit - 12)/m_y_step, y_edit/m_y_step + 1);
+
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n  = m_found_notes[i];
         const int x1 = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
         const int x2 = m_graphical_track->getNoteEndInPixels(n)   - m_gsequence->getXScrollInPixels();
         const int y1 = m_track->getNotePitchID(n)*m_y_step + getEditorYStart() - getYScrollInPixels();
@@ -228,9 +267,15 @@ void KeyboardEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mouse
     const int mouse_y_max = std::max( mousey_current, mousey_initial );
     const int xscroll = m_gsequence->getXScrollInPixels();
     
-    const int count = m_track->getNoteAmount();
-    for (int n=0; n<count; n++)
+    // notes outside the rectangle get deselected (selectNote honours the select more/less modifiers)
+    m_track->selectNote(ALL_NOTES, false);
+    
+    findNotesInXRange(mouse_x_min, mouse_x_max, getLevelAtY(mouse_y_min) - 1, getLevelAtY(mouse_y_max) + 1);
+    
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n   = m_found_notes[i];
         int x1        = m_graphical_track->getNoteStartInPixels(n);
         int x2        = m_graphical_track->getNoteEndInPixels(n);
         int from_note = m_track->getNotePitchID(n);
@@ -241,10 +286,6 @@ void KeyboardEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mouse
         {
             m_graphical_track->selectNote(n, true);
         }
-        else
-        {
-            m_graphical_track->selectNote(n, false);
-        }
     }//next
 
 }
@@ -406,6 +447,8 @@ void KeyboardEditor::scrollNotesIntoView()
 void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
                             RelativeXCoord mousex_initial, int mousey_initial, bool focus)
 {
+    PROFILE_ZONE("KeyboardEditor::render");
+    
     AriaColor ariaColor;
     bool showNoteNames;
     
@@ -418,61 +461,66 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
 
     // ------------------ draw lined background ----------------
 
-    int levelid = getYScrollInPixels()/m_y_step;
-    const int yscroll = getYScrollInPixels();
-    const int last_note = ( yscroll + getYEnd() - getEditorYStart() )/m_y_step;
-    const int editor_x1 = getEditorXStart();
-    const int editor_x2 = getXEnd();
+    if (beginBackground())
+    {
+        int levelid = getYScrollInPixels()/m_y_step;
+        const int yscroll = getYScrollInPixels();
+        const int last_note = ( yscroll + getYEnd() - getEditorYStart() )/m_y_step;
+        const int editor_x1 = getEditorXStart();
+        const int editor_x2 = getXEnd();
 
-    const KeyInclusionType* key_notes = m_track->getKeyNotes();
+        const KeyInclusionType* key_notes = m_track->getKeyNotes();
     
-    // white background
-    AriaRender::primitives();
+        // white background
+        AriaRender::primitives();
     
-    // horizontal lines
-    if (m_track->isPlayed())
-    {
-        AriaRender::color(0.94, 0.94, 0.94, 1);
-    }
-    else
-    {
-        AriaRender::color(0.8,0.8,0.8);
-    }
-
-    while (levelid < last_note)
-    {
-        //const int note12 = 11 - ((levelid - 3) % 12);
-        const int pitchID = levelid; //FIXME: fix this conflation of level and pitch ID. it's handy in keyboard
-                                     // editor, but a pain everywhere else...
-
-        if (key_notes[pitchID] != KEY_INCLUSION_FULL)
+        // horizontal lines
+        if (m_track->isPlayed())
         {
-            AriaRender::rect(editor_x1, levelToY(levelid),
-                             editor_x2, levelToY(levelid+1));
+            AriaRender::color(0.94, 0.94, 0.94, 1);
         }
         else
         {
-            AriaRender::line(editor_x1, levelToY(levelid+1),
-                             editor_x2, levelToY(levelid+1));
+            AriaRender::color(0.8,0.8,0.8);
         }
 
+        while (levelid < last_note)
+        {
+            //const int note12 = 11 - ((levelid - 3) % 12);
+            const int pitchID = levelid; //FIXME: fix this conflation of level and pitch ID. it's handy in keyboard
+                                         // editor, but a pain everywhere else...
+
+            if (key_notes[pitchID] != KEY_INCLUSION_FULL)
+            {
+                AriaRender::rect(editor_x1, levelToY(levelid),
+                                 editor_x2, levelToY(levelid+1));
+            }
+            else
+            {
+                AriaRender::line(editor_x1, levelToY(levelid+1),
+                                 editor_x2, levelToY(levelid+1));
+            }
+
         
 #if SHOW_MIDI_PITCH
-        const int midiID = (131 - pitchID);
-        // octave number
-        AriaRender::images();
-        AriaRender::color(0,0,0);
+            const int midiID = (131 - pitchID);
+            // octave number
+            AriaRender::images();
+            AriaRender::color(0,0,0);
         
-        AriaRender::renderNumber(midiID, 100, levelToY(levelid+1));
+            AriaRender::renderNumber(midiID, 100, levelToY(levelid+1));
         
-        AriaRender::primitives();
-        AriaRender::color(0.94, 0.94, 0.94, 1);
+            AriaRender::primitives();
+            AriaRender::color(0.94, 0.94, 0.94, 1);
 #endif
 
-        levelid++;
-    }
+            levelid++;
+        }
 
-    drawVerticalMeasureLines(getEditorYStart(), getYEnd());
+        drawVerticalMeasureLines(getEditorYStart(), getYEnd());
+        
+        endBackground();
+    }
 
     // ---------------------- draw background notes ------------------
 
@@ -488,6 +536,9 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
             GraphicalTrack* otherGTrack = m_gsequence->getGraphicsFor(otherTrack);
             ASSERT(otherGTrack != NULL);
             const int noteAmount = otherTrack->getNoteAmount();
+            const int xscroll    = m_gsequence->getXScrollInPixels();
+            const std::vector<int>& noteStarts = otherGTrack->getNoteStartsInPixels();
+            const std::vector<int>& noteEnds   = otherGTrack->getNoteEndsInPixels();
             
             ariaColor = pickColor(colorIndex);
         
@@ -495,8 +546,8 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
             for (int n=0; n<noteAmount; n++)
             {
                 int x,y;
-                int x1 = otherGTrack->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels();
-                int x2 = otherGTrack->getNoteEndInPixels(n)   - m_gsequence->getXScrollInPixels();
+                int x1 = noteStarts[n] - xscroll;
+                int x2 = noteEnds[n]   - xscroll;
 
                 // don't draw notes that won't be visible
                 if (x2 < 0)       continue;
@@ -534,11 +585,13 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
     const int mouse_y_max = std::max(mousey_current, mousey_initial);
 
     const int noteAmount = m_track->getNoteAmount();
+    const std::vector<int>& noteStarts = m_graphical_track->getNoteStartsInPixels();
+    const std::vector<int>& noteEnds   = m_graphical_track->getNoteEndsInPixels();
     for (int n=0; n<noteAmount; n++)
     {
         int x;
-        const int x1 = m_graphical_track->getNoteStartInPixels(n) - pscroll;
-        const int x2 = m_graphical_track->getNoteEndInPixels(n)   - pscroll;
+        const int x1 = noteStarts[n] - pscroll;
+        const int x2 = noteEnds[n]   - pscroll;
 
         // don't draw notes that won't be visible
         if (x2 < 0)       continue;
@@ -659,10 +712,12 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
                 // resize a bunch of notes
                 ariaColor.set(0.0, 0.0, 0.0, 1.0);
 
-                for (int n=0; n<m_track->getNoteAmount(); n++)
+                std::vector<int> selection;
+                m_track->getSelectedNoteIDs(selection);
+
+                for (unsigned int i=0; i<selection.size(); i++)
                 {
-                    if (not m_track->isNoteSelected(n)) continue;
-                    drawResizedNote(n, x_step_resize, ariaColor, showNoteNames);
+                    drawResizedNote(selection[i], x_step_resize, ariaColor, showNoteNames);
                 }//next
 
             }
@@ -686,10 +741,12 @@ void KeyboardEditor::render(RelativeXCoord mousex_current, int mousey_current,
                 // move a bunch of notes
                 ariaColor.set(0.0, 0.0, 0.0, 1.0);
 
-                for (int n=0; n<m_track->getNoteAmount(); n++)
+                std::vector<int> selection;
+                m_track->getSelectedNoteIDs(selection);
+
+                for (unsigned int i=0; i<selection.size(); i++)
                 {
-                    if (not m_track->isNoteSelected(n)) continue;
-                    drawMovedNote(n, x_step_move, y_step_move, ariaColor, showNoteNames);
+                    drawMovedNote(selection[i], x_step_move, y_step_move, ariaColor, showNoteNames);
                 }//next
 
             }
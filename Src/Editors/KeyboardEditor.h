@@ -40,6 +40,9 @@ namespace AriaMaestosa
         KeyboardEditor(GraphicalTrack* data);
         virtual ~KeyboardEditor();
         
+        virtual void getMemoryUsage(MemoryUsage& usage) const;
+        virtual void hibernate();
+        
         /** event callback from base class */
         virtual void mouseDown(RelativeXCoord x, const int y);
         virtual void processMouseMove(RelativeXCoord x, int y);
@@ -125,6 +128,9 @@ namespace AriaMaestosa
         void checkCursor(RelativeXCoord x, int y);
         NoteSearchResult flownOverNoteAt(RelativeXCoord x, const int y, int& noteID);
         
+        /** the lanes of the background depend on the key; overriden from Editor */
+        virtual void getBackgroundState(std::vector<int>& state);
+        
     };
 
 }
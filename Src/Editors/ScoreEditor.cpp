@@ -24,6 +24,7 @@
 #include "GUI/GraphicalSequence.h"
 #include "GUI/GraphicalTrack.h"
 #include "GUI/MainFrame.h"
+#include "MemoryUsage.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
 #include "Midi/MeasureData.h"
@@ -33,6 +34,7 @@
 #include "Renderers/Drawable.h"
 #include "Renderers/ImageBase.h"
 #include "Renderers/RenderAPI.h"
+#include "Profiler.h"
 
 #include "AriaCore.h"
 
@@ -432,6 +434,24 @@ ScoreEditor::~ScoreEditor()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void ScoreEditor::getMemoryUsage(MemoryUsage& usage) const
+{
+    Editor::getMemoryUsage(usage);
+    usage.add(MemoryUsage::ANALYSERS, m_g_clef_analyser->getMemoryBytes() + m_f_clef_analyser->getMemoryBytes(), 2);
+    usage.add(MemoryUsage::OTHER, sizeof(ScoreEditor) - sizeof(Editor));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void ScoreEditor::hibernate()
+{
+    Editor::hibernate();
+    m_g_clef_analyser->releaseMemory();
+    m_f_clef_analyser->releaseMemory();
+}
+
 // ----------------------------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------------------------
 #if 0
@@ -890,6 +910,8 @@ void renderSilence(const Sequence* seq, const int duration, const int tick, cons
 void ScoreEditor::render(RelativeXCoord mousex_current, int mousey_current,
                          RelativeXCoord mousex_initial, int mousey_initial, bool focus)
 {
+    PROFILE_ZONE("ScoreEditor::render");
+    
     TrackRenderContext ctx;
     AriaColor ariaColor;
     bool renderSilences;
@@ -1051,9 +1073,12 @@ void ScoreEditor::render(RelativeXCoord mousex_current, int mousey_current,
         {
             // move a bunch of notes
 
-            for (int n=0; n<m_track->getNoteAmount(); n++)
+            std::vector<int> selection;
+            m_track->getSelectedNoteIDs(selection);
+
+            for (unsigned int i=0; i<selection.size(); i++)
             {
-                if (not m_track->isNoteSelected(n)) continue;
+                const int n = selection[i];
 
                 const int x1 = m_graphical_track->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels() +
                                Editor::getEditorXStart();
@@ -1246,10 +1271,22 @@ void ScoreEditor::renderTrack(Track* track, const TrackRenderContext& ctx, bool
     m_g_clef_analyser->clearAndPrepare();
     m_f_clef_analyser->clearAndPrepare();
     
+    const int x_offset = Editor::getEditorXStart() - m_gsequence->getXScrollInPixels();
+    const std::vector<int>& noteStarts = otherGTrack->getNoteStartsInPixels();
+    const std::vector<int>& noteEnds   = otherGTrack->getNoteEndsInPixels();
+    
     // render pass 1. draw linear notation if relevant, gather information and do initial rendering for
     // musical notation
     for (int n=0; n<noteAmount; n++)
     {
+        const int original_x1 = noteStarts[n] + x_offset;
+        int       x1 = original_x1;
+        const int x2 = noteEnds[n] + x_offset;
+
+        // don't consider notes that won't be visible (checked first, converting to a level costs more)
+        if (x2 < ctx.first_x_to_consider) continue;
+        if (x1 > ctx.last_x_to_consider)  break;
+        
         PitchSign note_sign;
         const int noteLevel = m_converter->noteToLevel(track->getNote(n), &note_sign);
 
@@ -1260,16 +1297,6 @@ void ScoreEditor::renderTrack(Track* track, const TrackRenderContext& ctx, bool
         previous_tick = tick;
         const int noteLength = track->getNoteEndInMidiTicks(n) - tick;
 
-        const int original_x1 = otherGTrack->getNoteStartInPixels(n) - m_gsequence->getXScrollInPixels() +
-                                Editor::getEditorXStart();
-        int       x1 = original_x1;
-        const int x2 = otherGTrack->getNoteEndInPixels(n)   - m_gsequence->getXScrollInPixels() +
-                       Editor::getEditorXStart();
-
-        // don't consider notes that won't be visible
-        if (x2 < ctx.first_x_to_consider) continue;
-        if (x1 > ctx.last_x_to_consider)  break;
-
         if (m_linear_notation_enabled)
         {
             if (m_musical_notation_enabled) x1 += 8;
@@ -1622,11 +1649,17 @@ int ScoreEditor::getYScrollInPixels()
 NoteSearchResult ScoreEditor::noteAt(RelativeXCoord x, const int y, int& noteID)
 {
     const int head_radius = noteOpen->getImageHeight()/2;
-    const int noteAmount  = m_track->getNoteAmount();
     const int mx          = x.getRelativeTo(WINDOW);
 
-    for (int n=0; n<noteAmount; n++)
+    // heads are hit up to 11 pixels right of the note start. Levels depend on the key, so only the
+    // time range is used to narrow down the candidates
+    const int x_edit = mx - Editor::getEditorXStart();
+    findNotesInXRange(x_edit - 11, x_edit);
+
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n = m_found_notes[i];
 
         //const int notePitch = track->getNotePitchID(n);
         const int noteLevel = m_converter->noteToLevel( m_track->getNote(n) );
@@ -1735,13 +1768,21 @@ void ScoreEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mousey_c
                                     RelativeXCoord& mousex_initial, int mousey_initial)
 {
     const int head_radius = noteOpen->getImageHeight()/2;
-    const int noteAmount  = m_track->getNoteAmount();
     
     const int mxc = mousex_current.getRelativeTo(WINDOW);
     const int mxi = mousex_initial.getRelativeTo(WINDOW);
 
-    for (int n=0; n<noteAmount; n++)
+    // notes outside the rectangle get deselected (selectNote honours the select more/less modifiers)
+    m_track->selectNote(ALL_NOTES, false);
+    
+    // the middle of the head must be within the rectangle
+    const int x_offset = Editor::getEditorXStart() + head_radius;
+    findNotesInXRange(std::min(mxc, mxi) - x_offset, std::max(mxc, mxi) - x_offset);
+    
+    const int count = m_found_notes.size();
+    for (int i=0; i<count; i++)
     {
+        const int n = m_found_notes[i];
         const int noteLevel = m_converter->noteToLevel( m_track->getNote(n) );
         if (noteLevel == -1) continue;
         
@@ -1755,10 +1796,6 @@ void ScoreEditor::selectNotesInRect(RelativeXCoord& mousex_current, int mousey_c
         {
             m_graphical_track->selectNote(n, true);
         }
-        else
-        {
-            m_graphical_track->selectNote(n, false);
-        }
 
     }
 }
@@ -119,7 +119,7 @@ namespace AriaMaestosa
         
     public:
         
-        LEAK_CHECK();
+        LEAK_CHECK(ScoreMidiConverter);
         
         ScoreMidiConverter(GraphicalSequence* parent);
         void setNoteSharpness(Note7 note, PitchSign sharpness);
@@ -203,6 +203,9 @@ namespace AriaMaestosa
         
         ScoreEditor(GraphicalTrack* track);
         ~ScoreEditor();
+        
+        virtual void getMemoryUsage(MemoryUsage& usage) const;
+        virtual void hibernate();
 
         ScoreMidiConverter* getScoreMidiConverter() { return m_converter; }
         const ScoreMidiConverter* getScoreMidiConverter() const { return m_converter; }
@@ -18,6 +18,7 @@
 #include "GUI/GraphicalSequence.h"
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
+#include "MemoryUsage.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "PreferencesData.h"
@@ -38,6 +39,7 @@ GraphicalSequence::GraphicalSequence(Sequence* s) : m_name_renderer(s->getNameMo
     m_zoom_percent          = 100;
     m_dock_height           = 0;
     m_maximize_track_mode   = false;
+    m_hibernating           = false;
     m_x_scroll_in_pixels    = 0;
     y_scroll                = 0;
     reorderYScroll          = 0;
@@ -55,6 +57,7 @@ void GraphicalSequence::createViewForTrack(Track* t)
     ASSERT( getGraphicsFor(t) == NULL );
     GraphicalTrack* gt = new GraphicalTrack(t, this, t->getMagneticGrid());
     m_gtracks.push_back(gt);
+    t->setGraphics(gt);
     gt->createEditors();
 }
 
@@ -79,6 +82,44 @@ void GraphicalSequence::createViewForTracks(int id)
 
 // ----------------------------------------------------------------------------------------------------------
 
+void GraphicalSequence::getMemoryUsage(MemoryUsage& usage) const
+{
+    m_sequence->getMemoryUsage(usage);
+    
+    usage.addTexture(m_name_renderer.getTextureBytes());
+    
+    const int count = m_gtracks.size();
+    for (int n=0; n<count; n++)
+    {
+        m_gtracks.getConst(n)->getMemoryUsage(usage);
+    }
+    usage.add(MemoryUsage::OTHER, sizeof(GraphicalSequence));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void GraphicalSequence::hibernate()
+{
+    if (m_hibernating) return;
+    
+    // the name of the sequence stays, it is drawn in the tab bar
+    const int textAmount = m_sequence->getTextEventAmount();
+    for (int n=0; n<textAmount; n++)
+    {
+        m_sequence->getTextEvent(n)->getText().releaseTexture();
+    }
+    
+    const int count = m_gtracks.size();
+    for (int n=0; n<count; n++)
+    {
+        m_gtracks[n].hibernate();
+    }
+    
+    m_hibernating = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void GraphicalSequence::onTrackAdded(Track* t)
 {
     createViewForTrack(t);
@@ -100,6 +141,9 @@ void GraphicalSequence::onTrackRemoved(Track* t)
     
     ASSERT(gt != NULL);
     
+    // the track may come back through undo, a new view will then be created
+    t->setGraphics(NULL);
+    
     const bool success = m_gtracks.erase(gt);
     ASSERT(success);
 }
@@ -108,26 +152,19 @@ void GraphicalSequence::onTrackRemoved(Track* t)
 
 GraphicalTrack* GraphicalSequence::getGraphicsFor(const Track* t)
 {
-    const int count = m_gtracks.size();
-    for (int n=0; n<count; n++)
-    {
-        if (m_gtracks[n].getTrack() == t) return m_gtracks.get(n);
-    }
+    // tracks hold a pointer to their view; only hand out views that belong to this sequence
+    if (t->getSequence() != m_sequence.raw_ptr) return NULL;
     
-    return NULL;
+    // views are owned by this object, so giving out a mutable one is fine
+    return const_cast<GraphicalTrack*>(t->getGraphics());
 }
 
 // ----------------------------------------------------------------------------------------------------------
 
 const GraphicalTrack* GraphicalSequence::getGraphicsFor(const Track* t) const
 {
-    const int count = m_gtracks.size();
-    for (int n=0; n<count; n++)
-    {
-        if (m_gtracks[n].getTrack() == t) return m_gtracks.getConst(n);
-    }
-    
-    return NULL;
+    if (t->getSequence() != m_sequence.raw_ptr) return NULL;
+    return t->getGraphics();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -275,11 +312,24 @@ void GraphicalSequence::renderTracks(int currentTick, RelativeXCoord mousex, int
         
         ASSERT(m_gtracks.size() == trackAmount);
         
+        // tracks are painted over by the tab bar and measure bar above this point
+        const int visible_from_y = MEASURE_BAR_Y + m_measure_bar->getMeasureBarHeight();
+        const int visible_to_y   = Display::getHeight();
+        
         for (int n=0; n<trackAmount; n++)
         {
             Track* track = m_sequence->getTrack(n);
             track->setId(n);
-            y = getGraphicsFor(track)->render(y, currentTick, (n == currentTrack));
+            
+            // all tracks are laid out, so that editors know where they are, but only visible ones are drawn
+            GraphicalTrack* gtrack = getGraphicsFor(track);
+            const int next_y = gtrack->layout(y);
+            
+            if (not gtrack->isDocked() and next_y > visible_from_y and y < visible_to_y)
+            {
+                gtrack->render(currentTick, (n == currentTrack));
+            }
+            y = next_y;
         }
         
     }
@@ -26,6 +26,7 @@
 namespace AriaMaestosa
 {
     class MainPane;
+    class MemoryUsage;
 
     class GraphicalSequence : public ITrackSetListener
     {
@@ -55,6 +56,9 @@ namespace AriaMaestosa
 
         AriaRenderString m_name_renderer;
         
+        /** whether textures and render caches were freed since the sequence was last shown */
+        bool m_hibernating;
+        
     public:
         
         /** 
@@ -70,6 +74,23 @@ namespace AriaMaestosa
           */
         void createViewForTracks(int id);
         
+        /** @brief adds the memory used by the sequence and by its graphics (see MemoryUsage) */
+        void getMemoryUsage(MemoryUsage& usage) const;
+        
+        /**
+          * @brief frees the textures, render caches and analysers of all tracks, when the sequence is
+          *        not shown anymore (e.g. another tab was selected). The model is kept as is.
+          *
+          * Nothing needs to be done before showing the sequence again: what was freed is rebuilt as
+          * it is rendered (see wake). With the OpenGL renderer, the GL context must be current.
+          */
+        void hibernate();
+        
+        /** @brief called when the sequence is shown again after 'hibernate' */
+        void wake() { m_hibernating = false; }
+        
+        bool isHibernating() const { return m_hibernating; }
+        
         Sequence* getModel() { return m_sequence; }
         const Sequence* getModel() const { return m_sequence.raw_ptr; }
 
@@ -19,6 +19,7 @@
 #include <wx/numdlg.h>
 #include <wx/wfstream.h>
 #include <wx/textdlg.h>
+#include <wx/stopwatch.h>
 
 #include "Utils.h"
 #include "GUI/GraphicalTrack.h"
@@ -32,10 +33,12 @@
 #include "Editors/RelativeXCoord.h"
 #include "Editors/ControllerEditor.h"
 #include "Editors/ScoreEditor.h"
+#include "GUI/GraphicalSequence.h"
 #include "GUI/ImageProvider.h"
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
 #include "IO/IOUtils.h"
+#include "MemoryUsage.h"
 #include "Midi/DrumChoice.h"
 #include "Midi/InstrumentChoice.h"
 #include "Midi/MeasureData.h"
@@ -50,6 +53,8 @@
 #include "Renderers/Drawable.h"
 #include "Renderers/ImageBase.h"
 #include "Renderers/RenderAPI.h"
+#include "Profiler.h"
+#include "UnitTest.h"
 
 #include "irrXML/irrXML.h"
 
@@ -71,7 +76,7 @@ namespace AriaMaestosa
         wxString m_tooltip;
 
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(AriaWidget);
         
         AriaWidget(int width)
         {
@@ -296,7 +301,7 @@ namespace AriaMaestosa
         ptr_vector<AriaWidget, HOLD> m_widgets_right;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(WidgetLayoutManager);
         
         WidgetLayoutManager()
         {
@@ -399,7 +404,8 @@ GraphicalTrack::GraphicalTrack(Track* track, GraphicalSequence* seq, MagneticGri
     
     ASSERT(track);
     
-    m_grid = new MagneticGridPicker(this, magneticGrid);
+    // the grid picker is a menu, don't build it until it is needed (see getGridPicker)
+    m_magnetic_grid = magneticGrid;
     
     m_last_mouse_y = 0;
     
@@ -409,6 +415,11 @@ GraphicalTrack::GraphicalTrack(Track* track, GraphicalSequence* seq, MagneticGri
     
     m_height = 128;
     
+    m_note_pixels_zoom            = -1.0f;
+    m_note_pixels_events_revision = -1;
+    m_note_pixels_notes_revision  = -1;
+    m_drawn_notes_revision        = -1;
+    
     // create widgets
     m_components = new WidgetLayoutManager();
     
@@ -505,6 +516,41 @@ GraphicalTrack::~GraphicalTrack()
 {
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void GraphicalTrack::getMemoryUsage(MemoryUsage& usage) const
+{
+    usage.addTexture(m_name_renderer.getTextureBytes());
+    usage.addTexture(m_instrument_name.getTextureBytes());
+    usage.add(MemoryUsage::RENDER_CACHES, MemoryUsage::getVectorBytes(m_note_x1) +
+                                          MemoryUsage::getVectorBytes(m_note_x2));
+    
+    const int count = m_all_editors.size();
+    for (int n=0; n<count; n++)
+    {
+        m_all_editors.getConst(n)->getMemoryUsage(usage);
+    }
+    usage.add(MemoryUsage::OTHER, sizeof(GraphicalTrack));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void GraphicalTrack::hibernate()
+{
+    m_name_renderer.releaseTexture();
+    m_instrument_name.releaseTexture();
+    
+    // 'updateNotePixels' computes them again, since their size no more matches the notes
+    std::vector<int>().swap(m_note_x1);
+    std::vector<int>().swap(m_note_x2);
+    
+    const int count = m_all_editors.size();
+    for (int n=0; n<count; n++)
+    {
+        m_all_editors[n].hibernate();
+    }
+}
+
 // ----------------------------------------------------------------------------------------------------------
     
 void GraphicalTrack::createEditors()
@@ -788,25 +834,25 @@ bool GraphicalTrack::processMouseDown(RelativeXCoord mousex, int mousey)
             wxCommandEvent fake_event;
 
             if ( m_grid_combo->getItem(0).clickIsOnThisWidget(winX, mousey) )
-                m_grid->grid1selected(fake_event);
+                getGridPicker()->grid1selected(fake_event);
             else if ( m_grid_combo->getItem(1).clickIsOnThisWidget(winX, mousey) )
-                m_grid->grid2selected(fake_event);
+                getGridPicker()->grid2selected(fake_event);
             else if ( m_grid_combo->getItem(2).clickIsOnThisWidget(winX, mousey) )
-                m_grid->grid4selected(fake_event);
+                getGridPicker()->grid4selected(fake_event);
             else if ( m_grid_combo->getItem(3).clickIsOnThisWidget(winX, mousey) )
-                m_grid->grid8selected(fake_event);
+                getGridPicker()->grid8selected(fake_event);
             else if ( m_grid_combo->getItem(4).clickIsOnThisWidget(winX, mousey) )
-                m_grid->grid16selected(fake_event);
+                getGridPicker()->grid16selected(fake_event);
             else if ( m_grid_combo->getItem(5).clickIsOnThisWidget(winX, mousey) )
-                m_grid->grid32selected(fake_event);
+                getGridPicker()->grid32selected(fake_event);
             else if ( m_grid_combo->getItem(6).clickIsOnThisWidget(winX, mousey) )
-                m_grid->toggleTriplet();
+                getGridPicker()->toggleTriplet();
             else if ( m_grid_combo->getItem(7).clickIsOnThisWidget(winX, mousey) )
-                m_grid->toggleDotted();
+                getGridPicker()->toggleDotted();
             else if ( winX > m_grid_combo->getItem(7).getX() + 16)
             {
-                m_grid->syncWithModel();
-                Display::popupMenu(m_grid, m_grid_combo->getX() + 5, m_from_y + 30);
+                getGridPicker()->syncWithModel();
+                Display::popupMenu(getGridPicker(), m_grid_combo->getX() + 5, m_from_y + 30);
             }
         }
 
@@ -1299,16 +1345,63 @@ void GraphicalTrack::onNotationTypeChange()
 
 // ---------------------------------------------------------------------------------------------------------------
 
+void GraphicalTrack::updateNotePixels() const
+{
+    const float zoom       = m_gsequence->getZoom();
+    const int   events     = m_track->getSequence()->getEventsRevision();
+    const int   notes      = m_track->getNotesRevision();
+    const int   noteAmount = m_track->getNoteAmount();
+    
+    if (zoom == m_note_pixels_zoom and events == m_note_pixels_events_revision and
+        notes == m_note_pixels_notes_revision and (int)m_note_x1.size() == noteAmount)
+    {
+        return;
+    }
+    
+    m_note_x1.resize(noteAmount);
+    m_note_x2.resize(noteAmount);
+    for (int n=0; n<noteAmount; n++)
+    {
+        m_note_x1[n] = (int)( (float)m_track->getNoteStartInMidiTicks(n) * zoom );
+        m_note_x2[n] = (int)( (float)m_track->getNoteEndInMidiTicks(n)   * zoom );
+    }
+    
+    m_note_pixels_zoom            = zoom;
+    m_note_pixels_events_revision = events;
+    m_note_pixels_notes_revision  = notes;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+bool GraphicalTrack::isShowingTempo() const
+{
+    return not m_collapsed and m_track->isNotationTypeEnabled(CONTROLLER) and
+           Track::isTempoController(m_controller_editor->getCurrentControllerType());
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
 int GraphicalTrack::getNoteStartInPixels(const int id) const
 {
-    return (int)( (float)m_track->getNoteStartInMidiTicks(id) * m_gsequence->getZoom() );
+    updateNotePixels();
+    ASSERT_E(id, <, (int)m_note_x1.size());
+#ifdef _MORE_DEBUG_CHECKS
+    // catches note edits that did not go through an action nor notify the track
+    ASSERT_E(m_note_x1[id], ==, (int)( (float)m_track->getNoteStartInMidiTicks(id) * m_gsequence->getZoom() ));
+#endif
+    return m_note_x1[id];
 }
 
 // ---------------------------------------------------------------------------------------------------------------
 
 int GraphicalTrack::getNoteEndInPixels(const int id) const
 {
-    return (int)( (float)m_track->getNoteEndInMidiTicks(id) * m_gsequence->getZoom() );
+    updateNotePixels();
+    ASSERT_E(id, <, (int)m_note_x2.size());
+#ifdef _MORE_DEBUG_CHECKS
+    ASSERT_E(m_note_x2[id], ==, (int)( (float)m_track->getNoteEndInMidiTicks(id) * m_gsequence->getZoom() ));
+#endif
+    return m_note_x2[id];
 }
 
 // ---------------------------------------------------------------------------------------------------------------
@@ -1673,7 +1766,7 @@ void GraphicalTrack::renderHeader(const int x, const int y, const bool closed, c
 
     // draw grid label
     int grid_selection_x;
-    switch (m_grid->getModel()->getDivider())
+    switch (m_magnetic_grid->getDivider())
     {
         case 1:
             grid_selection_x = mgrid_1->getX();
@@ -1705,12 +1798,12 @@ void GraphicalTrack::renderHeader(const int x, const int y, const bool closed, c
     AriaRender::primitives();
     AriaRender::color(0,0,0);
     AriaRender::hollow_rect(grid_selection_x, y+15, grid_selection_x+16, y+30);
-    if (m_grid->getModel()->isTriplet())
+    if (m_magnetic_grid->isTriplet())
     {
         AriaRender::hollow_rect(mgrid_triplet->getX(),      y + 15,
                                 mgrid_triplet->getX() + 16, y + 30);
     }
-    if (m_grid->getModel()->isDotted())
+    if (m_magnetic_grid->isDotted())
     {
         AriaRender::hollow_rect(mgrid_dotted->getX(),      y + 15,
                                 mgrid_dotted->getX() + 16, y + 30);
@@ -1752,11 +1845,8 @@ void GraphicalTrack::renderHeader(const int x, const int y, const bool closed, c
 
 // ----------------------------------------------------------------------------------------------------------
 
-int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
+int GraphicalTrack::layout(const int y)
 {
-    
-    if (not ImageProvider::imagesLoaded()) return 0;
-    
     // docked tracks are not drawn
     if (m_docked)
     {
@@ -1779,18 +1869,9 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
     }
     
     // tell the editor(s) about its/their new location
-    int count = 0;
-    if (m_track->isNotationTypeEnabled(SCORE))      count++;
-    if (m_track->isNotationTypeEnabled(KEYBOARD))   count++;
-    if (m_track->isNotationTypeEnabled(GUITAR))     count++;
-    if (m_track->isNotationTypeEnabled(DRUM))       count++;
-    if (m_track->isNotationTypeEnabled(CONTROLLER)) count++;
-    
     const int editor_height = (m_to_y - editor_from_y - 5);
     int editor_to_y = editor_from_y; //editor_from_y + editor_height;
 
-    const int original_editor_from_y = editor_from_y;
-    
     if (m_track->isNotationTypeEnabled(SCORE))
     {
         int h = m_score_editor->getRelativeHeight()*editor_height;
@@ -1827,9 +1908,22 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         editor_from_y = editor_to_y + 1;
     }
     
-    // don't waste time drawing it if out of bounds
-    if (m_to_y < 0) return m_to_y;
-    if (m_from_y > Display::getHeight()) return m_to_y;
+    return m_to_y;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void GraphicalTrack::render(const int currentTick, const bool focus)
+{
+    PROFILE_ZONE("GraphicalTrack::render");
+    
+    if (not ImageProvider::imagesLoaded()) return;
+    
+    ASSERT(not m_docked);
+    
+    m_drawn_notes_revision = m_track->getNotesRevision();
+    
+    const int y = m_from_y;
     
     renderHeader(0, y, m_collapsed, focus);
     
@@ -1843,6 +1937,13 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
         const RelativeXCoord x2 = Display::getMouseX_initial();
         const int y2 = Display::getMouseY_initial();
         
+        int count = 0;
+        if (m_track->isNotationTypeEnabled(SCORE))      count++;
+        if (m_track->isNotationTypeEnabled(KEYBOARD))   count++;
+        if (m_track->isNotationTypeEnabled(GUITAR))     count++;
+        if (m_track->isNotationTypeEnabled(DRUM))       count++;
+        if (m_track->isNotationTypeEnabled(CONTROLLER)) count++;
+        
         int rcount = 0;
 
         if (m_track->isNotationTypeEnabled(SCORE))
@@ -1917,7 +2018,7 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
             
             AriaRender::lineWidth(1);
             
-            AriaRender::line(x_coord, original_editor_from_y,
+            AriaRender::line(x_coord, getEditorFromY(),
                              x_coord, m_to_y - 5);
             
         }
@@ -1971,9 +2072,6 @@ int GraphicalTrack::render(const int y, const int currentTick, const bool focus)
     }
     
     AriaRender::images();
-    
-    // done
-    return m_to_y;
 }
 
 
@@ -1983,9 +2081,9 @@ void GraphicalTrack::switchDivider(int index)
     /*
     int divider;
     
-    divider = m_grid->getModel()->getDivider();
+    divider = m_magnetic_grid->getDivider();
     
-    if (m_grid->getModel()->isTriplet())
+    if (m_magnetic_grid->isTriplet())
     {
         divider -= divider/3;
     }
@@ -2014,20 +2112,27 @@ void GraphicalTrack::switchDivider(int index)
 }
 
 
+MagneticGridPicker* GraphicalTrack::getGridPicker()
+{
+    if (m_grid.raw_ptr == NULL) m_grid = new MagneticGridPicker(this, m_magnetic_grid);
+    return m_grid;
+}
+
+
 void GraphicalTrack::setDivider(int divider)
 {
     wxCommandEvent fake_event;
     
     switch (divider)
     {
-        case   1 : m_grid->grid1selected(fake_event); break;
-        case   2 : m_grid->grid2selected(fake_event); break;
-        case   4 : m_grid->grid4selected(fake_event); break;
-        case   8 : m_grid->grid8selected(fake_event); break;
-        case  16 : m_grid->grid16selected(fake_event); break;
-        case  32 : m_grid->grid32selected(fake_event); break;
-        case  64 : m_grid->grid64selected(fake_event); break;
-        case 128 : m_grid->grid128selected(fake_event); break;
+        case   1 : getGridPicker()->grid1selected(fake_event); break;
+        case   2 : getGridPicker()->grid2selected(fake_event); break;
+        case   4 : getGridPicker()->grid4selected(fake_event); break;
+        case   8 : getGridPicker()->grid8selected(fake_event); break;
+        case  16 : getGridPicker()->grid16selected(fake_event); break;
+        case  32 : getGridPicker()->grid32selected(fake_event); break;
+        case  64 : getGridPicker()->grid64selected(fake_event); break;
+        case 128 : getGridPicker()->grid128selected(fake_event); break;
     }
 }
 
@@ -2104,7 +2209,7 @@ void GraphicalTrack::saveToFile(wxFileOutputStream& fileout)
               wxT("\"/>\n"), fileout);
     writeData(wxT("  </editors>\n"), fileout );
     
-    m_grid->getModel()->saveToFile( fileout );
+    m_magnetic_grid->saveToFile( fileout );
     //keyboardEditor->instrument->saveToFile(fileout);
     //drumEditor->drumKit->saveToFile(fileout);
 
@@ -2444,3 +2549,91 @@ bool GraphicalTrack::readFromFile(irr::io::IrrXMLReader* xml)
 }
 
 // ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestGraphicalTrack
+{
+    using namespace AriaMaestosa;
+
+    UNIT_TEST(TestNotePixelCache)
+    {
+        const int NOTE_AMOUNT = 100000;
+        const int PASSES      = 50;
+
+        OwnerPtr<GraphicalSequence> gseq( new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false)) );
+        Sequence* seq = gseq->getModel();
+        const int beat = seq->ticksPerQuarterNote();
+
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<NOTE_AMOUNT; n++)
+            {
+                t->addNote_import(40 + n % 48, n*beat/4, n*beat/4 + beat/2 + (n % 7)*beat/8, 80, -1);
+            }
+        }
+        seq->addTrack(t);
+
+        GraphicalTrack* gtrack = gseq->getGraphicsFor(t);
+        require(gtrack != NULL, "a view was created for the track");
+
+        // ---- cached pixels match the ones computed from ticks, at any zoom
+        const int zooms[] = { 25, 250, 100 };
+        for (int z=0; z<3; z++)
+        {
+            gseq->setZoom(zooms[z]);
+            const float zoom = gseq->getZoom();
+            for (int n=0; n<NOTE_AMOUNT; n+=97)
+            {
+                require_e(gtrack->getNoteStartInPixels(n), ==, (int)( (float)t->getNoteStartInMidiTicks(n) * zoom ),
+                          "cached note starts follow the zoom");
+                require_e(gtrack->getNoteEndInPixels(n),   ==, (int)( (float)t->getNoteEndInMidiTicks(n) * zoom ),
+                          "cached note ends follow the zoom");
+            }
+        }
+
+        // ---- the cache follows edits
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(60, NOTE_AMOUNT*beat/4 + beat, NOTE_AMOUNT*beat/4 + beat*2, 80, -1);
+        }
+        const int noteAmount = t->getNoteAmount();
+        require_e((int)gtrack->getNoteStartsInPixels().size(), ==, noteAmount, "added notes are cached");
+        require_e(gtrack->getNoteEndInPixels(noteAmount - 1), ==,
+                  (int)( (float)t->getNoteEndInMidiTicks(noteAmount - 1) * gseq->getZoom() ),
+                  "added notes are cached");
+
+        // ---- what render loops pay per frame, without and with the cache
+        unsigned int checksum = 0;
+        wxStopWatch computedTime;
+        for (int pass=0; pass<PASSES; pass++)
+        {
+            for (int n=0; n<noteAmount; n++)
+            {
+                checksum += (int)( (float)t->getNoteStartInMidiTicks(n) * gseq->getZoom() );
+                checksum += (int)( (float)t->getNoteEndInMidiTicks(n)   * gseq->getZoom() );
+            }
+        }
+        const long computedMs = computedTime.Time();
+
+        unsigned int cachedChecksum = 0;
+        wxStopWatch cachedTime;
+        for (int pass=0; pass<PASSES; pass++)
+        {
+            const std::vector<int>& noteStarts = gtrack->getNoteStartsInPixels();
+            const std::vector<int>& noteEnds   = gtrack->getNoteEndsInPixels();
+            for (int n=0; n<noteAmount; n++)
+            {
+                cachedChecksum += noteStarts[n];
+                cachedChecksum += noteEnds[n];
+            }
+        }
+        const long cachedMs = cachedTime.Time();
+
+        require_e(cachedChecksum, ==, checksum, "the cache holds the same pixels as the computation");
+
+        std::cout << "[GraphicalTrack] pixel positions of " << noteAmount << " notes : "
+                  << (computedMs / (float)PASSES) << " ms per frame computed from ticks, "
+                  << (cachedMs / (float)PASSES) << " ms read from the cache" << std::endl;
+    }
+}
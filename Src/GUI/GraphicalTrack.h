@@ -24,6 +24,8 @@
 #include "Pickers/MagneticGridPicker.h"
 #include "Renderers/RenderAPI.h"
 
+#include <vector>
+
 
 class wxFileOutputStream;
 // forward
@@ -44,6 +46,7 @@ namespace AriaMaestosa
     class ScoreEditor;
     class RelativeXCoord;
     class GraphicalSequence;
+    class MemoryUsage;
         
     // lightweight components
     class BlankField;
@@ -109,6 +112,9 @@ namespace AriaMaestosa
          */
         int m_to_y;
         
+        MagneticGrid* m_magnetic_grid;
+        
+        /** the menu to pick the grid from, created on first use (see 'getGridPicker') */
         OwnerPtr<MagneticGridPicker>  m_grid;
 
         ptr_vector<Editor, REF> m_all_editors;
@@ -124,23 +130,56 @@ namespace AriaMaestosa
         Editor* m_resizing_subeditor;
         Editor* m_next_to_resizing_subeditor;
         
+        /** start and end of each note in pixels (not scrolled), at zoom 'm_note_pixels_zoom' */
+        mutable std::vector<int> m_note_x1;
+        mutable std::vector<int> m_note_x2;
+        
+        /** zoom and revisions the note pixel cache was computed against, see 'updateNotePixels' */
+        mutable float m_note_pixels_zoom;
+        mutable int   m_note_pixels_events_revision;
+        mutable int   m_note_pixels_notes_revision;
+        
+        /** notes revision of the track when this view was last drawn, see 'isDirty' */
+        int m_drawn_notes_revision;
+        
+        /** recompute 'm_note_x1' and 'm_note_x2' if the zoom or the notes changed since last time */
+        void updateNotePixels() const;
+        
         void evenlyDistributeSpace();
         
+        MagneticGridPicker* getGridPicker();
+        
         bool handleEditorChanges(int x, BitmapButton* button, Editor* editor, NotationType type);
         wxString getInstrumentName(int instId);
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(GraphicalTrack);
         
         GraphicalTrack(Track* track, GraphicalSequence* parent, MagneticGrid* magneticGrid);
         ~GraphicalTrack();
         
+        /** @brief adds the memory used by the graphics of this track and by its editors (see MemoryUsage) */
+        void getMemoryUsage(MemoryUsage& usage) const;
+        
+        /** @brief frees textures and render caches of this track and its editors, see GraphicalSequence::hibernate */
+        void hibernate();
+        
         int getEditorHeight() const { return m_height; }
         int getTotalHeight () const;
         
         void renderHeader(const int x, const int y, const bool close, const bool focus=false);
         
-        int render(const int y, const int currentTick, bool focus);
+        /**
+          * @brief Place this track and its editors, starting at the given y coordinate, without drawing
+          * @return the y coordinate where the next track starts
+          */
+        int layout(const int y);
+        
+        /**
+          * @brief Draw this track at the position computed by the last call to 'layout'
+          * @pre   'layout' was called for this frame, and the track is not docked
+          */
+        void render(const int currentTick, bool focus);
         void setCollapsed(const bool collapsed);
         void setHeight(const int height);
         void maximizeHeight(bool maximize=true);
@@ -218,6 +257,12 @@ namespace AriaMaestosa
         
         int getFromY() const { return m_from_y; }
         int getToY()   const { return m_to_y;   }
+        
+        /** @return whether the track was edited since this view was last drawn (see Track::getNotesRevision) */
+        bool isDirty() const { return m_track->getNotesRevision() != m_drawn_notes_revision; }
+        
+        /** @return whether the controller editor of this track is shown and shows the tempo of the song */
+        bool isShowingTempo() const;
 
         AriaRenderString& getNameRenderer() { return m_name_renderer; }
         
@@ -240,6 +285,13 @@ namespace AriaMaestosa
         
         int getNoteStartInPixels(const int id) const;
         int getNoteEndInPixels(const int id) const;
+        
+        /**
+          * @return the start (resp. end) of all notes of the track in pixels, not scrolled, indexed by
+          *         note ID. Meant for render loops; the reference is valid until notes or zoom change.
+          */
+        const std::vector<int>& getNoteStartsInPixels() const { updateNotePixels(); return m_note_x1; }
+        const std::vector<int>& getNoteEndsInPixels()   const { updateNotePixels(); return m_note_x2; }
                 
         void onTrackRemoved(Track* t);
         
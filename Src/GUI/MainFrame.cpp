@@ -39,6 +39,8 @@
 #include "IO/IOUtils.h"
 #include "IO/MidiFileReader.h"
 
+#include "MemoryUsage.h"
+
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
 #include "Midi/Players/PlatformMidiManager.h"
@@ -344,6 +346,8 @@ MainFrame::MainFrame() : wxFrame(NULL, wxID_ANY, wxT("Aria Maestosa"), wxPoint(1
     m_disabled_for_welcome_screen = false;
     m_paused = false;
     m_reload_mode = false;
+    m_over_memory_budget = false;
+    m_main_pane = NULL;
 
     m_root_sizer = new wxBoxSizer(wxVERTICAL);
     m_root_sizer->Add(m_main_panel, 1, wxEXPAND | wxALL, 0);
@@ -503,7 +507,7 @@ void MainFrame::init(const wxArrayString& filesToOpen, bool fileInCommandLine)
     m_main_pane = new MainPane(m_main_panel, args);
     m_border_sizer->Add( dynamic_cast<wxGLCanvas*>(m_main_pane), 1, wxEXPAND | wxTOP | wxLEFT, 1);
 
-#elif defined(RENDERER_WXWIDGETS)
+#elif defined(RENDERER_WXWIDGETS) || defined(RENDERER_HEADLESS)
 
     m_main_pane = new MainPane(m_main_panel, NULL);
     m_border_sizer->Add( dynamic_cast<wxPanel*>(m_main_pane), 1, wxEXPAND | wxTOP | wxLEFT, 1);
@@ -1969,6 +1973,21 @@ void MainFrame::setCurrentSequence(int n, bool updateView)
     ASSERT_E(n,<,m_sequences.size());
 
     m_current_sequence = n;
+    
+    // sequences that are not shown free their textures and render caches, until they are shown again
+    m_sequences[n].wake();
+    if (m_main_pane != NULL)
+    {
+#ifdef RENDERER_OPENGL
+        m_main_pane->setCurrent(); // textures are freed from the context they were created in
+#endif
+        const int count = m_sequences.size();
+        for (int i=0; i<count; i++)
+        {
+            if (i != n) m_sequences[i].hibernate();
+        }
+    }
+    
     if (updateView)
     {
         m_paused = false;
@@ -2087,6 +2106,7 @@ void MainFrame::loadAriaFile(const wxString& filePath)
 
     Display::render();
     addRecentFile(filePath);
+    checkMemoryBudget();
 }
 
 
@@ -2161,6 +2181,7 @@ void MainFrame::loadMidiFile(const wxString& filePath)
     }
     
     addRecentFile(filePath);
+    checkMemoryBudget();
 }
 
 
@@ -2329,6 +2350,49 @@ void MainFrame::evt_newVersionAvailable(wxCommandEvent& evt)
 
 // ----------------------------------------------------------------------------------------------------------
 
+void MainFrame::checkMemoryBudget()
+{
+    const long budgetMB = PreferencesData::getInstance()->getIntValue(SETTING_ID_MEMORY_BUDGET);
+    if (budgetMB <= 0) return;
+
+    MemoryUsage usage;
+    const int count = m_sequences.size();
+    for (int n=0; n<count; n++)
+    {
+        m_sequences[n].getMemoryUsage(usage);
+    }
+
+    const bool over = (usage.getTotalBytes() > (long long)budgetMB*1024*1024);
+    const bool crossed = (over and not m_over_memory_budget);
+    m_over_memory_budget = over;
+    if (not crossed) return;
+
+    //I18N: - %s is an amount of memory, e.g. "512.0 MB"
+    wxString message = wxString::Format(_("The songs that are open use %s of memory, more than the limit set in the preferences. Closing songs you are not editing frees memory; see Help > Memory Report for details."),
+                                        MemoryUsage::formatBytes(usage.getTotalBytes()).c_str());
+
+    // don't hide warnings that were just shown (e.g. about the midi file that was imported)
+    if (m_notification_panel->IsShown())
+    {
+        message = m_notification_text->GetLabel() + wxT("\n\n") + message;
+    }
+    else
+    {
+        setNotificationWarning();
+#if wxCHECK_VERSION(2,9,1)
+        m_notification_link->Hide();
+#endif
+    }
+
+    m_notification_text->SetLabel(message);
+    m_notification_panel->Layout();
+    m_notification_panel->GetSizer()->SetSizeHints(m_notification_panel);
+    m_notification_panel->Show();
+    Layout();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void MainFrame::evt_asyncErrMessage(wxCommandEvent& evt)
 {
     wxMessageBox(evt.GetString(), _("An error occurred"), wxOK | wxICON_ERROR);
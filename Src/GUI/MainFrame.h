@@ -201,6 +201,8 @@ namespace AriaMaestosa
         MENU_STOP,
         MENU_RECORD,
 
+        MENU_HELP_MEMORY_REPORT,
+
         MENU_FILE_LOAD_RECENT_FILE = wxID_HIGHEST + 100,
         MENU_OUTPUT_DEVICE = wxID_HIGHEST + 200,
         MENU_INPUT_DEVICE = wxID_HIGHEST + 300
@@ -376,6 +378,15 @@ namespace AriaMaestosa
         void setNotificationWarning();
         void setNotificationInfo();
 
+        /** whether open sequences used more memory than the budget the last time it was checked */
+        bool m_over_memory_budget;
+
+        /**
+         * @brief shows a warning when open sequences use more memory than the budget set in the
+         *        preferences (SETTING_ID_MEMORY_BUDGET); only once each time the budget is exceeded
+         */
+        void checkMemoryBudget();
+
         wxBoxSizer* m_root_sizer;
 
         int m_current_sequence;
@@ -435,7 +446,7 @@ namespace AriaMaestosa
         wxMenuItem* lookForRecentFileListMenuItem(int menuItemId);
 
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MainFrame);
 
         // READ AND WRITE
         bool changingValues; // set this to true when modifying the controls in the top bar, this allows to ignore all events thrown by their modification.
@@ -526,6 +537,7 @@ namespace AriaMaestosa
         void menuEvent_quit(wxCommandEvent& evt);
         void menuEvent_about(wxCommandEvent& evt);
         void menuEvent_manual(wxCommandEvent& evt);
+        void menuEvent_memoryReport(wxCommandEvent& evt);
         void menuEvent_automaticChannelModeSelected(wxCommandEvent& evt);
         void menuEvent_manualChannelModeSelected(wxCommandEvent& evt);
         void menuEvent_expandedMeasuresSelected(wxCommandEvent& evt);
@@ -28,6 +28,7 @@
 #include "Dialogs/AboutDialog.h"
 #include "Dialogs/SongPropertiesDialog.h"
 #include "Dialogs/CustomNoteSelectDialog.h"
+#include "Dialogs/MemoryReportDialog.h"
 #include "Dialogs/Preferences.h"
 #include "Dialogs/PrintSetupDialog.h"
 #include "Dialogs/ScaleDialog.h"
@@ -376,6 +377,8 @@ void MainFrame::initMenuBar()
     m_help_menu->QUICK_ADD_MENU(wxID_ABOUT,  _("&About Aria Maestosa"), MainFrame::menuEvent_about);
     //I18N: - in help menu - see the help files
     m_help_menu->QUICK_ADD_MENU(wxID_HELP,  _("User's &Manual"), MainFrame::menuEvent_manual);
+    //I18N: - in help menu - see how much memory open songs use
+    m_help_menu->QUICK_ADD_MENU(MENU_HELP_MEMORY_REPORT, _("Memory Report"), MainFrame::menuEvent_memoryReport);
 
 #ifdef __WXMAC__
     // On OSX a menu item named "&Help" will be translated by wx into a native help menu
@@ -959,13 +962,18 @@ void MainFrame::menuEvent_scale(wxCommandEvent& evt)
 
 void MainFrame::menuEvent_removeOverlapping(wxCommandEvent& evt)
 {
+    // the busy cursor is shown here rather than in the actions, which also run without a window
+    wxBeginBusyCursor();
     getCurrentSequence()->getCurrentTrack()->action( new Action::RemoveOverlapping() );
+    wxEndBusyCursor();
 }
 
 
 void MainFrame::menuEvent_scrollNotesIntoView(wxCommandEvent& evt)
 {
+    wxBeginBusyCursor();
     getCurrentSequence()->action( new Action::ScrollNotesIntoView() );
+    wxEndBusyCursor();
 }
 
 // -----------------------------------------------------------------------------------------------------------
@@ -1372,6 +1380,14 @@ void MainFrame::menuEvent_about(wxCommandEvent& evt)
 
 // -----------------------------------------------------------------------------------------------------------
 
+void MainFrame::menuEvent_memoryReport(wxCommandEvent& evt)
+{
+    MemoryReportDialog dialog(this);
+    dialog.ShowModal();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 #if wxUSE_WEBVIEW && !defined(__WXMSW__)
 class ManualView : public wxFrame
 {
@@ -20,6 +20,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 #include "Actions/EditAction.h"
 #include "Actions/ResizeNotes.h"
@@ -37,21 +38,27 @@
 #include "Renderers/RenderAPI.h"
 #include "Renderers/Drawable.h"
 #include "GUI/ImageProvider.h"
+#include "GUI/ProfilerOverlay.h"
 #include "Midi/CommonMidiUtils.h"
 #include "Midi/Track.h"
 #include "Midi/Note.h"
 #include "Midi/Sequence.h"
 #include "Midi/MeasureData.h"
+#include "Midi/Players/LivePlayback.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Pickers/MagneticGridPicker.h"
 #include "Pickers/InstrumentPicker.h"
 #include "Pickers/DrumPicker.h"
 #include "PreferencesData.h"
+#include "Profiler.h"
 #include "Editors/RelativeXCoord.h"
 #include "Editors/KeyboardEditor.h"
 
 #include <wx/dcbuffer.h>
+#include <wx/filename.h>
+#include <wx/msgdlg.h>
 #include <wx/timer.h>
+#include <wx/stopwatch.h>
 #include <wx/spinctrl.h> // for wxSpinEvent
 
 #include "Utils.h"
@@ -60,7 +67,7 @@ using namespace AriaMaestosa;
 
 #ifdef RENDERER_OPENGL
 BEGIN_EVENT_TABLE(MainPane, wxGLCanvas)
-#elif defined(RENDERER_WXWIDGETS)
+#elif defined(RENDERER_WXWIDGETS) || defined(RENDERER_HEADLESS)
 BEGIN_EVENT_TABLE(MainPane, wxPanel)
 #endif
 
@@ -173,6 +180,19 @@ MainPane::MainPane(wxWindow* parent, int* args) :
 
     m_left_arrow  = false;
     m_right_arrow = false;
+    
+    m_last_playhead_x         = -1;
+    m_last_events_revision    = -1;
+    m_last_measures_revision  = -1;
+    m_render_requested        = false;
+    m_playback_frames         = -1;
+    m_playback_partial_frames = 0;
+    m_playback_cpu_start      = 0;
+    m_live_edit_rebuilder     = NULL;
+    
+#ifdef ARIA_PROFILER
+    m_profiler_overlay = new ProfilerOverlay();
+#endif
 
     m_mouse_down_timer = new MouseDownTimer(this);
 
@@ -198,6 +218,7 @@ MainPane::MainPane(wxWindow* parent, int* args) :
 
 MainPane::~MainPane()
 {
+    stopLiveEdits();
 }
 
 // -----------------------------------------------------------------------------------------------------------
@@ -253,7 +274,14 @@ void MainPane::paintEvent(wxPaintEvent& evt)
     Display::renderDC = &mydc;
 
     beginFrame();
-    if (do_render()) endFrame();
+    if (do_render())
+    {
+#ifdef ARIA_PROFILER
+        m_profiler_overlay->frameDone();
+        m_profiler_overlay->render(getWidth() - 5, MEASURE_BAR_Y + MEASURE_BAR_H + 5);
+#endif
+        endFrame();
+    }
     else { printf("***** do_render returned false!!\n"); }
     Display::renderDC = NULL;
 }
@@ -262,6 +290,13 @@ void MainPane::paintEvent(wxPaintEvent& evt)
 
 void MainPane::renderNow()
 {
+    // while playing, the playback loop paints at its next frame, only what changed when it can
+    if (m_playback_frames != -1)
+    {
+        m_render_requested = true;
+        return;
+    }
+    
     /*
     wxClientDC dc(this);
     wxBufferedDC bdc(&dc);
@@ -276,6 +311,68 @@ void MainPane::renderNow()
         
 // -----------------------------------------------------------------------------------------------------------
 
+#ifdef _MORE_DEBUG_CHECKS
+
+void MainPane::benchmarkTrackScrolling()
+{
+    const int TRACK_AMOUNT    = 100;
+    const int MEASURE_AMOUNT  = 200;
+    const int SCROLL_STEP     = 40;
+    
+    MainFrame* mf = getMainFrame();
+    mf->addSequence(false);
+    
+    GraphicalSequence* gseq = mf->getCurrentGraphicalSequence();
+    Sequence* seq = gseq->getModel();
+    
+    while (seq->getTrackAmount() < TRACK_AMOUNT) seq->addTrack(false);
+    
+    {
+        ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+        tr->setMeasureAmount(MEASURE_AMOUNT);
+    }
+    
+    {
+        OwnerPtr<Sequence::Import> import(seq->startImport());
+        
+        // one eighth note per beat on each track, climbing through two octaves
+        const int beat = seq->ticksPerQuarterNote();
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            Track* track = seq->getTrack(t);
+            for (int n=0; n<MEASURE_AMOUNT*4; n++)
+            {
+                track->addNote_import(40 + (n + t) % 24, n*beat, n*beat + beat/2, 80, -1);
+            }
+        }
+    }
+    
+    mf->updateVerticalScrollbar();
+    
+    const int totalHeight = gseq->getTotalHeight();
+    int frames = 0;
+    
+    wxStopWatch frameTime;
+    for (int y=0; y<totalHeight; y += SCROLL_STEP)
+    {
+        gseq->setYScroll(y);
+        Refresh();
+        Update(); // paint right away
+        frames++;
+    }
+    const long totalMs = frameTime.Time();
+    
+    gseq->setYScroll(0);
+    Refresh();
+    
+    std::cout << "[MainPane] scrolled through " << TRACK_AMOUNT << " tracks (" << totalHeight << " pixels) in "
+              << frames << " frames : " << (totalMs / (float)std::max(1, frames)) << " ms per frame" << std::endl;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------------------------------------
+
 MainPane::WelcomeResult MainPane::drawWelcomeMenu()
 {
     getMainFrame()->disableMenusForWelcomeScreen(true);
@@ -508,6 +605,8 @@ MainPane::WelcomeResult MainPane::drawWelcomeMenu()
 
 bool MainPane::do_render()
 {
+    PROFILE_ZONE("MainPane::do_render");
+    
     MainFrame* mf = getMainFrame();
     
     if (not ImageProvider::imagesLoaded())  return false;
@@ -1348,6 +1447,30 @@ void MainPane::keyPressed(wxKeyEvent& evt)
         x.setValue(ScreenToClient(p).x, WINDOW);
         printf("Tick : %i\n", x.getRelativeTo(MIDI));
     }
+    else if (keyCode == WXK_F4)
+    {
+        benchmarkTrackScrolling();
+        return;
+    }
+#endif
+    
+#ifdef ARIA_PROFILER
+    if (keyCode == WXK_F5)
+    {
+        m_profiler_overlay->toggle();
+        Display::render();
+        return;
+    }
+    else if (keyCode == WXK_F6)
+    {
+        // load in chrome://tracing or Perfetto
+        const wxString path = wxGetHomeDir() + wxFileName::GetPathSeparator() + wxT("aria_trace.json");
+        if (not Profiler::writeTrace(path.mb_str()))
+        {
+            wxMessageBox(wxT("Could not write ") + path);
+        }
+        return;
+    }
 #endif
 
     // ---------------- resize notes -----------------
@@ -1535,37 +1658,107 @@ void MainPane::enterPlayLoop()
     Sequence* seq = getMainFrame()->getCurrentSequence();
     m_follow_playback_time = seq->getMeasureData()->defaultMeasureLengthInTicks();
     m_last_tick = -1;
+    m_last_playhead_x = -1;
+    m_last_events_revision   = seq->getEventsRevision();
+    m_last_measures_revision = seq->getMeasureData()->getRevision();
+    m_render_requested       = false;
+    
+    m_playback_frames         = 0;
+    m_playback_partial_frames = 0;
+    m_playback_cpu_start      = clock();
+    m_playback_time.Start();
+    
+    // edits made while the song plays are heard right away, when the player supports it
+    stopLiveEdits();
+    m_live_edit_rebuilder = new LiveEditRebuilder(seq, &PlatformMidiManager::get()->getLiveEdits());
+    if (not m_live_edit_rebuilder->start())
+    {
+        delete m_live_edit_rebuilder;
+        m_live_edit_rebuilder = NULL;
+    }
+    
     Core::activateRenderLoop(true);
 }
 
 // -----------------------------------------------------------------------------------------------------------
 
+void MainPane::stopLiveEdits()
+{
+    if (m_live_edit_rebuilder == NULL) return;
+    
+    m_live_edit_rebuilder->stop();
+    delete m_live_edit_rebuilder;
+    m_live_edit_rebuilder = NULL;
+    
+#ifdef ARIA_PROFILER
+    int count;
+    double meanMs, maxMs;
+    PlatformMidiManager::get()->getLiveEdits().getLatency(&count, &meanMs, &maxMs);
+    if (count > 0)
+    {
+        std::cout << "[MainPane] " << count << " live edits heard, edit-to-audible latency " << meanMs
+                  << " ms on average, " << maxMs << " ms at most" << std::endl;
+    }
+#endif
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
 void MainPane::exitPlayLoop()
 {
     PlatformMidiManager* midi = PlatformMidiManager::get();
     
     if (midi->isRecording()) midi->stopRecording();
     midi->stop();
+    stopLiveEdits();
     
     getMainFrame()->toolsExitPlaybackMode();
     Core::activateRenderLoop(false);
     setCurrentTick( -1 );
     Refresh();
+    
+    if (m_playback_frames >= 0)
+    {
+#ifdef ARIA_PROFILER
+        const long wallMs = m_playback_time.Time();
+        const float cpuMs = (clock() - m_playback_cpu_start) * 1000.0f / CLOCKS_PER_SEC;
+        
+        std::cout << "[MainPane] playback : " << m_playback_frames << " frames ("
+                  << m_playback_partial_frames << " partial) in " << wallMs << " ms, CPU "
+                  << (wallMs > 0 ? cpuMs*100.0f/wallMs : 0.0f) << "%" << std::endl;
+#endif
+        m_playback_frames = -1;
+    }
 }
 
 // -----------------------------------------------------------------------------------------------------------
 
 void MainPane::playbackRenderLoop()
 {
-    const int currentTick = PlatformMidiManager::get()->trackPlaybackProgression();
-
-    // check if song is over
-    if (currentTick == -1 or not PlatformMidiManager::get()->isPlaying())
+    PlatformMidiManager* midi = PlatformMidiManager::get();
+    
+    // while the player publishes its position, interpolate it to the time of this frame; this doesn't
+    // need any of its locks
+    const PlaybackState::Snapshot state = midi->getPlaybackState().read();
+    
+    int currentTick;
+    if (state.m_playing)
     {
-        if (not PlatformMidiManager::get()->isRecording())
+        currentTick = state.getTickAt(PlaybackState::getTimeUs());
+    }
+    else
+    {
+        // not started yet, already over, or a player that doesn't publish its position
+        currentTick = midi->trackPlaybackProgression();
+        
+        // check if song is over
+        if (currentTick == -1 or not midi->isPlaying())
         {
-            exitPlayLoop();
-            return;
+            if (not midi->isRecording())
+            {
+                exitPlayLoop();
+                return;
+            }
         }
     }
     
@@ -1573,9 +1766,15 @@ void MainPane::playbackRenderLoop()
     Sequence* seq = gseq->getModel();
     const int startTick = seq->getPlaybackStartTick();
     
+    // the extrapolated position may run slightly ahead of the next publication; don't let the playhead
+    // jitter back for that (a bigger jump back is a loop, or a seek)
+    const int backwards = m_last_tick - (startTick + currentTick);
+    if (backwards > 0 and backwards < seq->ticksPerQuarterNote()/4) currentTick = m_last_tick - startTick;
+    
     // only draw if it has changed
-    if (m_last_tick != startTick + currentTick)
+    if (m_last_tick != startTick + currentTick or m_render_requested)
     {
+        const int x_scroll_before = gseq->getXScrollInPixels();
         
         // if user has clicked on a little red arrow
         if (m_scroll_to_playback_position)
@@ -1611,12 +1810,110 @@ void MainPane::playbackRenderLoop()
         setCurrentTick( startTick + currentTick );
         
         RelativeXCoord tick(m_current_tick, MIDI, gseq);
-        Display::render();
-        m_last_tick = startTick + currentTick;
+        const int playhead_x = tick.getRelativeTo(WINDOW);
+        const bool playhead_visible = (playhead_x >= Editor::getEditorXStart() and playhead_x <= getWidth());
+        
+        // when nothing scrolled and the line stays within view, only the strips the line moved across and
+        // the editors that were edited need to be painted again
+        if (gseq->getXScrollInPixels() == x_scroll_before and playhead_visible and m_last_playhead_x != -1 and
+            refreshEditedTracks(gseq))
+        {
+            if (playhead_x != m_last_playhead_x)
+            {
+                refreshPlayheadStrip(m_last_playhead_x);
+                refreshPlayheadStrip(playhead_x);
+            }
+            if (playhead_x != m_last_playhead_x or seq->getEventsRevision() != m_last_events_revision)
+            {
+                m_playback_partial_frames++;
+                m_playback_frames++;
+            }
+        }
+        else
+        {
+            Refresh();
+            m_playback_frames++;
+        }
+        
+        m_last_playhead_x        = (playhead_visible ? playhead_x : -1);
+        m_last_tick              = startTick + currentTick;
+        m_last_events_revision   = seq->getEventsRevision();
+        m_last_measures_revision = seq->getMeasureData()->getRevision();
+        m_render_requested       = false;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+bool MainPane::refreshEditedTracks(GraphicalSequence* gseq)
+{
+    Sequence* seq = gseq->getModel();
+    
+    if (seq->getEventsRevision() == m_last_events_revision)
+    {
+        // nothing was edited; a repaint that was asked for anyway is for something else (mouse feedback,
+        // vertical scrolling...)
+        return not m_render_requested;
+    }
+    
+    // measures and time signatures are drawn across all tracks, and in the measure bar
+    if (seq->getMeasureData()->getRevision() != m_last_measures_revision) return false;
+    
+    const int visible_from_y = MEASURE_BAR_Y + gseq->getMeasureBar()->getMeasureBarHeight();
+    const int visible_to_y   = getHeight();
+    
+    std::vector<GraphicalTrack*> visible;
+    bool edited      = false;
+    bool tempoEdited = false;
+    
+    const int trackAmount = seq->getTrackAmount();
+    for (int n=0; n<trackAmount; n++)
+    {
+        GraphicalTrack* gtrack = gseq->getGraphicsFor(seq->getTrack(n));
+        if (gtrack->isDocked() or gtrack->getToY() <= visible_from_y or gtrack->getFromY() >= visible_to_y)
+        {
+            continue;
+        }
+        
+        visible.push_back(gtrack);
+        if (gtrack->isDirty())
+        {
+            edited = true;
+            
+            // tempo events are shown by every track that shows the tempo
+            if (gtrack->isShowingTempo()) tempoEdited = true;
+        }
     }
+    
+    // events changed outside of an action on a track in view (e.g. while recording, or through the menus);
+    // there is no telling where they show
+    if (not edited) return false;
+    
+    int repainted = 0;
+    for (unsigned int n=0; n<visible.size(); n++)
+    {
+        GraphicalTrack* gtrack = visible[n];
+        if (gtrack->isDirty() or (tempoEdited and gtrack->isShowingTempo()))
+        {
+            RefreshRect( wxRect(0, gtrack->getFromY(), getWidth(), gtrack->getToY() - gtrack->getFromY()),
+                         false /* don't erase background */ );
+            repainted++;
+        }
+    }
+    
+    // the tab shows whether there is something to undo
+    RefreshRect( wxRect(0, TAB_BAR_Y, getWidth(), 20), false /* don't erase background */ );
+    
+    // when every editor in view changed, it's a whole frame anyway
+    return repainted < (int)visible.size();
+}
+
+// -----------------------------------------------------------------------------------------------------------
 
-    // FIXME - why pause the main thread, aren't there better ways?
-    wxMilliSleep(10);
+void MainPane::refreshPlayheadStrip(const int x)
+{
+    // the line is 2 pixels wide in the measure bar; leave a little room for antialiasing
+    RefreshRect( wxRect(x - 2, 0, 5, getHeight()), false /* don't erase background */ );
 }
 
 // -----------------------------------------------------------------------------------------------------------
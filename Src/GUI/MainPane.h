@@ -24,13 +24,17 @@
 #include "Renderers/GLPane.h"
 #elif defined(RENDERER_WXWIDGETS)
 #include "Renderers/wxRenderPane.h"
+#elif defined(RENDERER_HEADLESS)
+#include "Renderers/HeadlessRenderPane.h"
 #else
 #error No renderer defined
 #endif
 
 #include "Renderers/RenderAPI.h"
 
+#include <ctime>
 #include <vector>
+#include <wx/stopwatch.h>
 
 namespace AriaMaestosa
 {
@@ -40,6 +44,9 @@ namespace AriaMaestosa
     
     class MouseDownTimer;
     class MainFrame;
+    class GraphicalSequence;
+    class LiveEditRebuilder;
+    class ProfilerOverlay;
 
     /**
       * @ingroup gui
@@ -96,6 +103,52 @@ namespace AriaMaestosa
         // used during playback
         int m_follow_playback_time;
         int m_last_tick;
+        
+        /** During playback, x coordinate (in window) of the playback line at the last frame, or -1 if
+          * it was not visible; used to repaint only the strips where the line moved */
+        int m_last_playhead_x;
+        
+        /** During playback, events and measures revisions of the sequence at the last frame; used to find
+          * the tracks edited since (see 'refreshEditedTracks') */
+        int m_last_events_revision;
+        int m_last_measures_revision;
+        
+        /** During playback, whether a repaint was asked for (see 'renderNow'); done at the next frame */
+        bool m_render_requested;
+        
+        /** Playback statistics : number of frames requested since playback started, -1 when not playing */
+        int m_playback_frames;
+        
+        /** Playback statistics : number of frames where only the playback line strips and the edited tracks
+          * were repainted */
+        int m_playback_partial_frames;
+        
+        /** Playback statistics : wall-clock time since playback started */
+        wxStopWatch m_playback_time;
+        
+        /** Playback statistics : process CPU time when playback started */
+        clock_t m_playback_cpu_start;
+        
+        /** During playback, rebuilds the tracks being edited so that edits are heard, NULL if not playing */
+        LiveEditRebuilder* m_live_edit_rebuilder;
+        
+        /** Stops rebuilding edited tracks for the player, and prints the edit-to-audible latency */
+        void stopLiveEdits();
+        
+#ifdef ARIA_PROFILER
+        /** Frame time and profiled zones, drawn over the pane (profiler builds; toggled with F5) */
+        OwnerPtr<ProfilerOverlay> m_profiler_overlay;
+#endif
+        
+        /** Marks for repaint the vertical strip covered by the playback line at the given x coordinate */
+        void refreshPlayheadStrip(const int x);
+        
+        /**
+          * During playback, marks for repaint the tracks in view that were edited since the last frame
+          * (see GraphicalTrack::isDirty).
+          * @return false if the whole frame must be painted instead
+          */
+        bool refreshEditedTracks(GraphicalSequence* gseq);
 
         bool m_scroll_to_playback_position;
 
@@ -130,7 +183,7 @@ namespace AriaMaestosa
         wxCursor m_plus_cursor;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MainPane);
 
         MainPane(wxWindow* parent, int* args);
         ~MainPane();
@@ -139,7 +192,12 @@ namespace AriaMaestosa
 
         void enterPlayLoop();
 
-        /** This method is called repeatedly during playback */
+        /**
+          * Called by the render loop timer during playback, at most once per display refresh.
+          * Repaints only what the moving playback line touches, and the editors that were edited, when
+          * nothing scrolled. This saves drawing with the wxWidgets renderer, whose frames are clipped to
+          * the repainted rectangles; an OpenGL frame is always drawn in full.
+          */
         void playbackRenderLoop();
 
         /** This is called when the song us playing. MainPane needs to know the current tick because when it renders
@@ -218,8 +276,17 @@ namespace AriaMaestosa
         
         virtual void resized(wxSizeEvent& evt);
         
+        /** @brief repaints the pane; during playback, this is left to the next frame of the playback loop */
         void renderNow();
         
+#ifdef _MORE_DEBUG_CHECKS
+        /**
+          * @brief Open a new sequence with 100 tracks and scroll through it, reporting the time per frame
+          * (debug builds; bound to F4)
+          */
+        void benchmarkTrackScrolling();
+#endif
+        
         // ---- rendering
         bool isVisible() const { return m_is_visible; }
         void paintEvent(wxPaintEvent& evt);
@@ -64,7 +64,7 @@ class SelectedMenu : public wxMenu
     GraphicalSequence* m_gseq;
 
 public:
-    LEAK_CHECK();
+    LEAK_CHECK(SelectedMenu);
     
     SelectedMenu(GraphicalSequence* parent) : wxMenu()
     {
@@ -143,7 +143,7 @@ class UnselectedMenu : public wxMenu
     GraphicalSequence* m_gseq;
 
 public:
-    LEAK_CHECK();
+    LEAK_CHECK(UnselectedMenu);
 
     UnselectedMenu(GraphicalSequence* gseq) : wxMenu()
     {
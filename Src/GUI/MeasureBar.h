@@ -54,7 +54,7 @@ namespace AriaMaestosa
         void getFirstAndLastSelectedMeasure(int* first, int* last);
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MeasureBar);
         
         MeasureBar(MeasureData* parent, GraphicalSequence* gseq);
         ~MeasureBar();
@@ -0,0 +1,138 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef ARIA_PROFILER
+
+#include "GUI/ProfilerOverlay.h"
+
+#include "Midi/Players/PlaybackState.h"
+#include "Renderers/RenderAPI.h"
+
+#include <algorithm>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    /** the time a zone took in the last interval, for sorting zones from the most to the least expensive */
+    struct ZoneLine
+    {
+        long long m_total_us;
+        wxString  m_text;
+        
+        bool operator<(const ZoneLine& other) const { return m_total_us > other.m_total_us; }
+    };
+}
+
+const int LINE_HEIGHT   = 14;
+const int OVERLAY_WIDTH = 330;
+
+// -----------------------------------------------------------------------------------------------------------
+
+ProfilerOverlay::ProfilerOverlay()
+{
+    m_shown          = false;
+    m_frames         = 0;
+    m_frames_us      = 0;
+    m_last_frame_us  = -1;
+    m_last_update_us = PlaybackState::getTimeUs();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void ProfilerOverlay::frameDone()
+{
+    const long long nowUs = PlaybackState::getTimeUs();
+    if (m_last_frame_us != -1)
+    {
+        m_frames++;
+        m_frames_us += nowUs - m_last_frame_us;
+    }
+    m_last_frame_us = nowUs;
+    
+    if (nowUs - m_last_update_us >= UPDATE_INTERVAL_MS*1000LL) update(nowUs);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void ProfilerOverlay::update(const long long nowUs)
+{
+    std::vector<Profiler::ZoneStats> current;
+    Profiler::getZones(current);
+    
+    std::vector<ZoneLine> zones;
+    for (unsigned int n=0; n<current.size(); n++)
+    {
+        int       count   = current[n].m_count;
+        long long totalUs = current[n].m_total_us;
+        for (unsigned int p=0; p<m_previous.size(); p++)
+        {
+            if (m_previous[p].m_name != current[n].m_name) continue;
+            count   -= m_previous[p].m_count;
+            totalUs -= m_previous[p].m_total_us;
+            break;
+        }
+        if (count <= 0) continue;
+        
+        ZoneLine line;
+        line.m_total_us = totalUs;
+        line.m_text     = wxString::Format(wxT("%s : %.2f ms x %i"), wxString(current[n].m_name, wxConvUTF8).c_str(),
+                                           totalUs / 1000.0 / count, count);
+        zones.push_back(line);
+    }
+    std::sort(zones.begin(), zones.end());
+    
+    m_lines.clear();
+    if (m_frames > 0)
+    {
+        const double frameMs = m_frames_us / 1000.0 / m_frames;
+        m_lines.push_back(wxString::Format(wxT("frame : %.2f ms (%.1f fps)"), frameMs, 1000.0 / frameMs));
+    }
+    else
+    {
+        m_lines.push_back(wxT("frame : -"));
+    }
+    for (unsigned int n=0; n<zones.size(); n++) m_lines.push_back(zones[n].m_text);
+    
+    m_previous       = current;
+    m_frames         = 0;
+    m_frames_us      = 0;
+    m_last_update_us = nowUs;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void ProfilerOverlay::render(const int x, const int y)
+{
+    if (not m_shown) return;
+    
+    const int height = m_lines.size()*LINE_HEIGHT + 6;
+    
+    AriaRender::primitives();
+    AriaRender::color(1, 1, 1, 0.85);
+    AriaRender::rect(x - OVERLAY_WIDTH, y, x, y + height);
+    AriaRender::color(0, 0, 0);
+    AriaRender::hollow_rect(x - OVERLAY_WIDTH, y, x, y + height);
+    
+    AriaRender::images();
+    AriaRender::color(0, 0, 0);
+    for (unsigned int n=0; n<m_lines.size(); n++)
+    {
+        AriaRender::renderString(m_lines[n], x - OVERLAY_WIDTH + 5, y + (n + 1)*LINE_HEIGHT, OVERLAY_WIDTH - 10);
+    }
+}
+
+#endif
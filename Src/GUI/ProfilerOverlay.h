@@ -0,0 +1,77 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROFILER_OVERLAY_H__
+#define __PROFILER_OVERLAY_H__
+
+#ifdef ARIA_PROFILER
+
+#include "Profiler.h"
+#include "Utils.h"
+
+#include <vector>
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief draws the frame time and the average time spent in each profiled zone over the main pane
+      *
+      * Figures are averaged over the last UPDATE_INTERVAL_MS, so that they can be read while they change.
+      * Only exists in profiler builds (see Profiler).
+      *
+      * @ingroup gui
+      */
+    class ProfilerOverlay
+    {
+        bool m_shown;
+        
+        /** frames counted since the figures were last updated, and the time between them */
+        int       m_frames;
+        long long m_frames_us;
+        long long m_last_frame_us;
+        long long m_last_update_us;
+        
+        /** zone statistics when the figures were last updated */
+        std::vector<Profiler::ZoneStats> m_previous;
+        
+        std::vector<wxString> m_lines;
+        
+        void update(const long long nowUs);
+        
+    public:
+        LEAK_CHECK(ProfilerOverlay);
+        
+        static const int UPDATE_INTERVAL_MS = 500;
+        
+        ProfilerOverlay();
+        
+        bool isShown() const { return m_shown; }
+        void toggle()        { m_shown = not m_shown; }
+        
+        /** @brief to be called once per frame (whether the overlay is shown or not) */
+        void frameDone();
+        
+        /** @brief draws the overlay with its top-right corner at the given coordinates */
+        void render(const int x, const int y);
+    };
+    
+}
+
+#endif
+
+#endif
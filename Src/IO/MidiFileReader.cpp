@@ -23,6 +23,7 @@
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
 #include "PreferencesData.h"
+#include "Profiler.h"
 
 #include "jdksmidi/world.h"
 #include "jdksmidi/track.h"
@@ -52,6 +53,8 @@ public:
 
 bool AriaMaestosa::loadMidiFile(GraphicalSequence* gseq, wxString filepath, std::set<wxString>& warnings)
 {
+    PROFILE_ZONE("loadMidiFile");
+    
     Sequence* sequence = gseq->getModel();
     
     OwnerPtr<Sequence::Import> import(sequence->startImport());
@@ -43,7 +43,7 @@ namespace AriaMaestosa
         int pos, length;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MidiToMemoryStream);
         
         MidiToMemoryStream();
         ~MidiToMemoryStream();
@@ -52,6 +52,9 @@ namespace AriaMaestosa
         int  WriteChar( const int c );
         int  getDataLength();
         void storeMidiData(char* midiData);
+        
+        /** @return the bytes written so far */
+        const std::vector<char>& getData() const { return data; }
     };
     
 }
@@ -15,110 +15,402 @@
  */
 
 #include "Utils.h"
-#include <ptr_vector.h>
 
 #ifdef _MORE_DEBUG_CHECKS
 
-#define GET_STACK_TRACE 0
+#include "LeakCheck.h"
+#include "Midi/Players/PlaybackState.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <wx/thread.h>
 
-#ifdef __WXMAC__
-#include <Availability.h>
+#if defined(__GLIBC__) || defined(__APPLE__)
 #include <execinfo.h>
+#define HAVE_BACKTRACE 1
+#else
+#define HAVE_BACKTRACE 0
 #endif
 
-#include <set>
-
-#include "LeakCheck.h"
-#include <iostream>
-
 namespace AriaMaestosa
 {
     namespace MemoryLeaks
     {
-        
-        std::set<MyObject*> g_all_objs;
-        
-        void addObj(MyObject* myObj)
+        /** number of frames kept for each sampled allocation */
+        const int MAX_FRAMES = 24;
+
+        struct Site
         {
-            //std::cout << "addObj " << myObj->file << " (" << myObj->line << ")" << std::endl;
-            //g_all_objs.push_back(myObj);
-            g_all_objs.insert(myObj);
-        }
-        
-        void removeObj(MyObject* myObj)
-        {
-            //std::cout << "removeObj " << myObj->file << " (" << myObj->line << ")" << std::endl;
-            //g_all_objs.remove(myObj);
-            g_all_objs.erase(myObj);
-            delete myObj;
-            //std::cout << "removeObj done" << std::endl;
-        }
-        
-        MyObject::MyObject(AbstractLeakCheck* objArg)
-        {
-            obj = objArg;
-            
-#if (GET_STACK_TRACE == 1) && defined(MAC_OS_X_VERSION_10_5)
-            
-            const int maxsize = 32;
-            void* callstack[maxsize];
-            stackSize = backtrace(callstack, maxsize);
-            
-            stack = backtrace_symbols(callstack, stackSize);
-#else
-            stack = NULL;
-#endif
-            
+            TypeCounter* m_type;
+            void*        m_frames[MAX_FRAMES];
+            int          m_depth;
+        };
+
+        TypeCounter* g_types = NULL;
+
+        int readSampleInterval()
+        {
+            const char* value = getenv("ARIA_ALLOCATION_SAMPLING");
+            return (value == NULL ? 0 : std::max(0, atoi(value)));
         }
-        
-        void MyObject::print()
+        int g_sample_interval = readSampleInterval();
+
+        /**
+          * Sampled objects, by address. Only sampled objects touch it, so a spin lock is good enough
+          * (and, unlike a wxMutex, it can be used before wx is initialized).
+          */
+        std::map<const void*, Site> g_sites;
+        int g_sites_lock = 0;
+
+        class SitesLock
         {
-            obj->print();
-            
-            if (stack == NULL)
+        public:
+            SitesLock()
             {
-                printf("    (No stack information available)\n");
-            }
-            else
-            {
-                for (int i = 0; i < stackSize; ++i)
+                while (__atomic_exchange_n(&g_sites_lock, 1, __ATOMIC_ACQUIRE) != 0)
                 {
-                    printf("    %s\n", stack[i]);
+                    wxThread::Yield();
                 }
             }
-            
-        }
-        
-        void checkForLeaks()
-        {
-            
-            std::cout << "checking for leaks... " << std::endl;
-            
-            if (g_all_objs.size()>0)
-            {
-                std::cout << "leaks detected!!" << std::endl;
-                std::cout << "\n\n* * * * WARNING * * * * WARNING * * * * MEMORY LEAK! * * * *\n" << std::endl;
-            }
-            else
+            ~SitesLock()
             {
-                std::cout << "ok (no watched class left leaking)" << std::endl;
-                return;
+                __atomic_store_n(&g_sites_lock, 0, __ATOMIC_RELEASE);
             }
-            std::cout << "LEAK CHECK: " << g_all_objs.size() << " watched objects leaking" << std::endl;
-            
-            std::set<MyObject*>::iterator it;
-            for (it = g_all_objs.begin(); it != g_all_objs.end(); ++it)
+        };
+
+        void captureSite(TypeCounter* type, const void* object)
+        {
+#if HAVE_BACKTRACE
+            Site site;
+            site.m_type  = type;
+            site.m_depth = backtrace(site.m_frames, MAX_FRAMES);
+
+            SitesLock lock;
+            g_sites[object] = site;
+            __atomic_add_fetch(&type->m_sampled_live, 1, __ATOMIC_RELEASE);
+#endif
+        }
+
+        bool compareLiveBytes(const TypeStats& a, const TypeStats& b)
+        {
+            if (a.getLiveBytes() != b.getLiveBytes()) return a.getLiveBytes() > b.getLiveBytes();
+            return a.m_peak > b.m_peak;
+        }
+    }
+}
+
+using namespace AriaMaestosa;
+using namespace AriaMaestosa::MemoryLeaks;
+
+// ----------------------------------------------------------------------------------------------------------
+
+TypeCounter::TypeCounter(const char* name, const int size)
+{
+    m_name         = name;
+    m_size         = size;
+    m_live         = 0;
+    m_peak         = 0;
+    m_created      = 0;
+    m_sampled_live = 0;
+
+    // counters are static, and never removed from the list once added
+    m_next = __atomic_load_n(&g_types, __ATOMIC_ACQUIRE);
+    while (not __atomic_compare_exchange_n(&g_types, &m_next, this, true, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+    {
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void TypeCounter::add(const void* object)
+{
+    const int live = __atomic_add_fetch(&m_live, 1, __ATOMIC_RELAXED);
+
+    int peak = __atomic_load_n(&m_peak, __ATOMIC_RELAXED);
+    while (live > peak and
+           not __atomic_compare_exchange_n(&m_peak, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+
+    const long long created = __atomic_fetch_add(&m_created, 1, __ATOMIC_RELAXED);
+    const int every = __atomic_load_n(&g_sample_interval, __ATOMIC_RELAXED);
+    if (every > 0 and created % every == 0) captureSite(this, object);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void TypeCounter::remove(const void* object)
+{
+    __atomic_sub_fetch(&m_live, 1, __ATOMIC_RELAXED);
+
+    if (__atomic_load_n(&m_sampled_live, __ATOMIC_ACQUIRE) > 0)
+    {
+        SitesLock lock;
+        std::map<const void*, Site>::iterator it = g_sites.find(object);
+        if (it != g_sites.end())
+        {
+            g_sites.erase(it);
+            __atomic_sub_fetch(&m_sampled_live, 1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MemoryLeaks::getTypes(std::vector<TypeStats>& out)
+{
+    out.clear();
+    for (TypeCounter* type = __atomic_load_n(&g_types, __ATOMIC_ACQUIRE); type != NULL; type = type->m_next)
+    {
+        TypeStats stats;
+        stats.m_name         = type->m_name;
+        stats.m_size         = type->m_size;
+        stats.m_live         = __atomic_load_n(&type->m_live,         __ATOMIC_RELAXED);
+        stats.m_peak         = __atomic_load_n(&type->m_peak,         __ATOMIC_RELAXED);
+        stats.m_created      = __atomic_load_n(&type->m_created,      __ATOMIC_RELAXED);
+        stats.m_sampled_live = __atomic_load_n(&type->m_sampled_live, __ATOMIC_RELAXED);
+        out.push_back(stats);
+    }
+    std::sort(out.begin(), out.end(), compareLiveBytes);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MemoryLeaks::setSampleInterval(const int every)
+{
+    __atomic_store_n(&g_sample_interval, std::max(0, every), __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int MemoryLeaks::getSampleInterval()
+{
+    return __atomic_load_n(&g_sample_interval, __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MemoryLeaks::writeReport(std::ostream& out, const bool withSites)
+{
+    std::vector<TypeStats> types;
+    getTypes(types);
+
+    char line[256];
+    snprintf(line, 256, "%-32s %10s %10s %12s %14s\n", "class", "live", "peak", "created", "live bytes");
+    out << line;
+
+    long long totalBytes = 0;
+    for (unsigned int n=0; n<types.size(); n++)
+    {
+        snprintf(line, 256, "%-32s %10i %10i %12lli %14lli\n", types[n].m_name, types[n].m_live,
+                 types[n].m_peak, types[n].m_created, types[n].getLiveBytes());
+        out << line;
+        totalBytes += types[n].getLiveBytes();
+    }
+    snprintf(line, 256, "%-32s %10s %10s %12s %14lli\n", "total", "", "", "", totalBytes);
+    out << line;
+
+    if (not withSites) return;
+
+#if HAVE_BACKTRACE
+    // group the live sampled objects by call stack, so that each allocation site is printed once
+    typedef std::pair<TypeCounter*, std::vector<void*> > SiteKey;
+    std::map<SiteKey, int> sites;
+    {
+        SitesLock lock;
+        for (std::map<const void*, Site>::iterator it = g_sites.begin(); it != g_sites.end(); it++)
+        {
+            const Site& site = it->second;
+            sites[SiteKey(site.m_type, std::vector<void*>(site.m_frames, site.m_frames + site.m_depth))]++;
+        }
+    }
+
+    if (sites.empty()) return;
+
+    out << "\nallocation sites of the sampled live objects (one object out of " << getSampleInterval()
+        << " is sampled):\n";
+    for (std::map<SiteKey, int>::iterator it = sites.begin(); it != sites.end(); it++)
+    {
+        const std::vector<void*>& frames = it->first.second;
+        out << "\n" << it->second << " x " << it->first.first->m_name << "\n";
+
+        char** symbols = backtrace_symbols(&frames[0], frames.size());
+        if (symbols == NULL) continue;
+
+        // skip the frames of the sampling code itself (only recognizable when symbols are exported)
+        unsigned int first = 0;
+        while (first < frames.size() - 1 and (strstr(symbols[first], "MemoryLeaks") != NULL or
+                                              strstr(symbols[first], "LeakCheck") != NULL))
+        {
+            first++;
+        }
+
+        for (unsigned int n=first; n<frames.size(); n++)
+        {
+            out << "    " << symbols[n] << "\n";
+        }
+        free(symbols);
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MemoryLeaks::checkForLeaks()
+{
+    std::cout << "checking for leaks... " << std::endl;
+
+    std::vector<TypeStats> types;
+    getTypes(types);
+
+    int leaking = 0;
+    for (unsigned int n=0; n<types.size(); n++)
+    {
+        leaking += types[n].m_live;
+    }
+
+    if (leaking == 0)
+    {
+        std::cout << "ok (no watched class left leaking)" << std::endl;
+        return;
+    }
+
+    std::cout << "leaks detected!!" << std::endl;
+    std::cout << "\n\n* * * * WARNING * * * * WARNING * * * * MEMORY LEAK! * * * *\n" << std::endl;
+    std::cout << "LEAK CHECK: " << leaking << " watched objects leaking" << std::endl;
+
+    for (unsigned int n=0; n<types.size(); n++)
+    {
+        if (types[n].m_live > 0)
+        {
+            std::cout << "    " << types[n].m_live << " x " << types[n].m_name << std::endl;
+        }
+    }
+
+    if (getSampleInterval() > 0)
+    {
+        writeReport(std::cout, true);
+    }
+    else
+    {
+        std::cout << "(set ARIA_ALLOCATION_SAMPLING=n to see where one leaked object out of n was allocated)"
+                  << std::endl;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestLeakCheck
+{
+    using namespace AriaMaestosa;
+
+    class CountedObject
+    {
+        char m_payload[40];
+
+    public:
+        LEAK_CHECK(CountedObject);
+
+        CountedObject() { m_payload[0] = 0; }
+    };
+
+    /** Creates and destroys counted objects from a thread of its own */
+    class AllocationThread : public wxThread
+    {
+        int m_amount;
+
+    public:
+
+        AllocationThread(const int amount) : wxThread(wxTHREAD_JOINABLE)
+        {
+            m_amount = amount;
+        }
+
+        virtual ExitCode Entry()
+        {
+            for (int n=0; n<m_amount; n++)
             {
-                (*it)->print();
+                delete new CountedObject();
             }
-            /*
-            for (int n=0; n<g_all_objs.size(); n++)
-            {
-                g_all_objs[n].print();
-            }*/
+            return 0;
+        }
+    };
+
+    const TypeStats* findType(const std::vector<TypeStats>& types, const char* name)
+    {
+        for (unsigned int n=0; n<types.size(); n++)
+        {
+            if (strcmp(types[n].m_name, name) == 0) return &types[n];
+        }
+        return NULL;
+    }
+
+    UNIT_TEST(TestObjectCountersFromSeveralThreads)
+    {
+        const int AMOUNT = 200000;
+        const int previousInterval = getSampleInterval();
+        setSampleInterval(0);
+
+        AllocationThread first(AMOUNT), second(AMOUNT);
+        require(first.Create()  == wxTHREAD_NO_ERROR and first.Run()  == wxTHREAD_NO_ERROR, "thread started");
+        require(second.Create() == wxTHREAD_NO_ERROR and second.Run() == wxTHREAD_NO_ERROR, "thread started");
+
+        std::vector<CountedObject*> kept;
+        const long long startUs = PlaybackState::getTimeUs();
+        for (int n=0; n<AMOUNT; n++)
+        {
+            kept.push_back(new CountedObject());
+        }
+        const long long elapsedUs = PlaybackState::getTimeUs() - startUs;
+
+        first.Wait();
+        second.Wait();
+
+        std::vector<TypeStats> types;
+        getTypes(types);
+        const TypeStats* stats = findType(types, "CountedObject");
+        require(stats != NULL, "the counted class is listed");
+        require_e(stats->m_live, ==, AMOUNT, "objects destroyed by the threads are not counted as live");
+        require_e(stats->m_created, ==, AMOUNT*3, "every object created is counted");
+        require_e(stats->m_peak, >=, AMOUNT, "the peak is at least the live count");
+        require_e(stats->getLiveBytes(), ==, (long long)AMOUNT*sizeof(CountedObject), "bytes are counted by class size");
+
+#if HAVE_BACKTRACE
+        setSampleInterval(1000);
+        for (int n=0; n<5000; n++)
+        {
+            kept.push_back(new CountedObject());
+        }
+        setSampleInterval(0);
+
+        getTypes(types);
+        stats = findType(types, "CountedObject");
+        require_e(stats->m_sampled_live, ==, 5, "one object out of 1000 is sampled");
+
+        std::ostringstream report;
+        writeReport(report, true);
+        require(report.str().find("5 x CountedObject") != std::string::npos, "sampled sites are reported");
+#endif
+
+        for (unsigned int n=0; n<kept.size(); n++)
+        {
+            delete kept[n];
         }
-        
-        
+        setSampleInterval(previousInterval);
+
+        getTypes(types);
+        stats = findType(types, "CountedObject");
+        require_e(stats->m_live, ==, 0, "no object left");
+        require_e(stats->m_sampled_live, ==, 0, "samples are dropped with their object");
+
+        std::cout << "[LeakCheck] " << elapsedUs*1000.0/AMOUNT << " ns per counted allocation" << std::endl;
     }
 }
+
 #endif
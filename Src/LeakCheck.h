@@ -19,71 +19,110 @@
 #define __LEAK_CHECK_H__
 
 #ifdef _MORE_DEBUG_CHECKS
+
+#include <ostream>
+#include <vector>
+
 namespace AriaMaestosa
 {
+    /**
+      * @brief counts the live objects of each class marked with LEAK_CHECK(ClassName)
+      *
+      * Each class gets one TypeCounter, updated with atomic operations when an instance is created or
+      * destroyed, so that counting costs no allocation and no lock, and is safe from the sequencer and
+      * recording threads. Optionally (see setSampleInterval), one object out of N also records where it
+      * was allocated, so that leaked objects can be traced back to the code that created them.
+      *
+      * Only compiled in debug builds (_MORE_DEBUG_CHECKS); LEAK_CHECK expands to nothing otherwise.
+      */
     namespace MemoryLeaks
     {
-        
-        class AbstractLeakCheck;
-        
-        class MyObject
+        /** @brief the live/peak counters of one class */
+        class TypeCounter
         {
-            char** stack;
-            int stackSize;
         public:
-            AbstractLeakCheck* obj;
-            
-            MyObject(AbstractLeakCheck* obj);
-            void print();
+            const char* m_name;
+            int         m_size;
+
+            int         m_live;
+            int         m_peak;
+            long long   m_created;
+
+            /** number of live objects of this class whose allocation site was sampled */
+            int         m_sampled_live;
+
+            /** next counter in the list of all counters, see 'getTypes' */
+            TypeCounter* m_next;
+
+            TypeCounter(const char* name, const int size);
+
+            /** @brief called when an object is created, may be called from any thread */
+            void add(const void* object);
+
+            /** @brief called when an object is destroyed, may be called from any thread */
+            void remove(const void* object);
         };
-        
-        void checkForLeaks();
-        
-        void addObj(MyObject* myObj);
-        void removeObj(MyObject* myObj);
-        
-        class AbstractLeakCheck
+
+        /** @brief the counters of a class at one point in time */
+        struct TypeStats
         {
-            MyObject* myObj;
-        public:
-            AbstractLeakCheck()
-            {
-                myObj = new MyObject( this );
-                addObj( myObj );
-            }
-            
-            AbstractLeakCheck(const AbstractLeakCheck &t)
-            {
-                myObj = new MyObject( this );
-                addObj( myObj );
-            }
-            
-            virtual ~AbstractLeakCheck()
-            {
-                removeObj( myObj );
-            }
-            
-            virtual void print() const
-            {
-            }
+            const char* m_name;
+            int         m_size;
+            int         m_live;
+            int         m_peak;
+            long long   m_created;
+            int         m_sampled_live;
+
+            long long getLiveBytes() const { return (long long)m_live*m_size; }
         };
-        
+
+        /** @brief the counters of every class that had at least one instance so far, by decreasing live bytes */
+        void getTypes(std::vector<TypeStats>& out);
+
+        /**
+          * @brief records the allocation site of one object out of 'every' (0 to record none, the default
+          *        unless the ARIA_ALLOCATION_SAMPLING environment variable says otherwise)
+          *
+          * Only has an effect where backtraces are available (glibc and OS X).
+          */
+        void setSampleInterval(const int every);
+        int  getSampleInterval();
+
+        /**
+          * @brief writes the live count and bytes of each class, followed by the allocation sites of the
+          *        sampled objects that are still alive (grouped by call stack), if 'withSites' is true
+          */
+        void writeReport(std::ostream& out, const bool withSites);
+
+        /** @brief prints the classes that still have live objects (called on exit) */
+        void checkForLeaks();
+
+        /** @brief the counter of class T (T being the class that contains the LeakCheck member) */
+        template<typename T>
+        inline TypeCounter& getCounter(const char* name)
+        {
+            static TypeCounter counter(name, sizeof(T));
+            return counter;
+        }
     }
 }
 
-#define LEAK_CHECK() \
-class LeakCheck : public MemoryLeaks::AbstractLeakCheck\
-{  public:\
-virtual void print() const\
+/**
+  * @brief counts the instances of the class it is placed in (given as argument), see MemoryLeaks
+  */
+#define LEAK_CHECK(TYPE) \
+class LeakCheck \
 { \
-printf("Undeleted object at %s : %i\n",  __FILE__, __LINE__);\
-} \
-virtual ~LeakCheck() {} \
+public: \
+    LeakCheck()                  { ::AriaMaestosa::MemoryLeaks::getCounter<TYPE>(#TYPE).add(this);    } \
+    LeakCheck(const LeakCheck&)  { ::AriaMaestosa::MemoryLeaks::getCounter<TYPE>(#TYPE).add(this);    } \
+    ~LeakCheck()                 { ::AriaMaestosa::MemoryLeaks::getCounter<TYPE>(#TYPE).remove(this); } \
+    LeakCheck& operator=(const LeakCheck&) { return *this; } \
 }; \
-LeakCheck leack_check_instance;
+LeakCheck leack_check_instance
 
 #else
-#define LEAK_CHECK()
+#define LEAK_CHECK(TYPE)
 #endif
 
 #endif
@@ -0,0 +1,100 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MemoryUsage.h"
+
+#include <wx/intl.h>
+
+using namespace AriaMaestosa;
+
+// ----------------------------------------------------------------------------------------------------------
+
+MemoryUsage::MemoryUsage()
+{
+    for (int n=0; n<CATEGORY_COUNT; n++)
+    {
+        m_bytes[n]   = 0;
+        m_objects[n] = 0;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void MemoryUsage::add(const Category category, const long long bytes, const int objects)
+{
+    m_bytes[category]   += bytes;
+    m_objects[category] += objects;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+long long MemoryUsage::getTotalBytes() const
+{
+    long long total = 0;
+    for (int n=0; n<CATEGORY_COUNT; n++)
+    {
+        total += m_bytes[n];
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other)
+{
+    for (int n=0; n<CATEGORY_COUNT; n++)
+    {
+        m_bytes[n]   += other.m_bytes[n];
+        m_objects[n] += other.m_objects[n];
+    }
+    return *this;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+wxString MemoryUsage::getCategoryName(const Category category)
+{
+    switch (category)
+    {
+        //I18N: - in the memory report, what memory is used for
+        case NOTES:             return _("Notes");
+        //I18N: - in the memory report, what memory is used for
+        case CONTROLLER_EVENTS: return _("Controller events");
+        //I18N: - in the memory report, what memory is used for
+        case TEXT_EVENTS:       return _("Text events");
+        //I18N: - in the memory report, what memory is used for
+        case UNDO_STACK:        return _("Undo");
+        //I18N: - in the memory report, what memory is used for
+        case TEXTURES:          return _("Text textures");
+        //I18N: - in the memory report, what memory is used for
+        case RENDER_CACHES:     return _("Render caches");
+        //I18N: - in the memory report, what memory is used for
+        case ANALYSERS:         return _("Analysers");
+        //I18N: - in the memory report, what memory is used for
+        case OTHER:             return _("Other");
+        default:                return wxEmptyString;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+wxString MemoryUsage::formatBytes(const long long bytes)
+{
+    if (bytes >= 1024*1024*1024) return wxString::Format(wxT("%.2f GB"), bytes/(1024.0*1024.0*1024.0));
+    if (bytes >= 1024*1024)      return wxString::Format(wxT("%.1f MB"), bytes/(1024.0*1024.0));
+    if (bytes >= 1024)           return wxString::Format(wxT("%.1f KB"), bytes/1024.0);
+    return wxString::Format(wxT("%i B"), (int)bytes);
+}
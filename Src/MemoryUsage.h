@@ -0,0 +1,110 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __MEMORY_USAGE_H__
+#define __MEMORY_USAGE_H__
+
+#include "ptr_vector.h"
+
+#include <vector>
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief an estimate of the memory used by an open sequence, by subsystem
+      *
+      * Filled by the objects that make up a sequence (see Sequence::getMemoryUsage and
+      * GraphicalSequence::getMemoryUsage), each adding the bytes it holds to the category they belong
+      * to. Bytes are estimated from object sizes and container lengths, not measured; the estimate is
+      * meant to tell which subsystem to trim, not to match the figures of the operating system.
+      */
+    class MemoryUsage
+    {
+    public:
+
+        enum Category
+        {
+            NOTES,
+            CONTROLLER_EVENTS,
+            TEXT_EVENTS,
+            UNDO_STACK,
+            /** textures (or bitmaps) of rendered strings */
+            TEXTURES,
+            /** cached renderings and what editors keep between two frames */
+            RENDER_CACHES,
+            /** score analysers and the indexes editors search events with */
+            ANALYSERS,
+            /** tracks, editors and widgets themselves */
+            OTHER,
+
+            CATEGORY_COUNT
+        };
+
+    private:
+
+        long long m_bytes[CATEGORY_COUNT];
+        int       m_objects[CATEGORY_COUNT];
+
+    public:
+
+        MemoryUsage();
+
+        /** @brief adds 'bytes' and 'objects' (notes, events, actions, textures... ) to the given category */
+        void add(const Category category, const long long bytes, const int objects=0);
+
+        /** @brief adds a texture, if it was created (i.e. if 'bytes' is not 0) */
+        void addTexture(const long long bytes)
+        {
+            if (bytes > 0) add(TEXTURES, bytes, 1);
+        }
+
+        long long getBytes  (const Category category) const { return m_bytes[category];   }
+        int       getObjects(const Category category) const { return m_objects[category]; }
+        long long getTotalBytes() const;
+
+        MemoryUsage& operator+=(const MemoryUsage& other);
+
+        static wxString getCategoryName(const Category category);
+
+        /** @return the bytes allocated by a vector for its elements */
+        template<typename T>
+        static long long getVectorBytes(const std::vector<T>& vector)
+        {
+            return (long long)vector.capacity()*sizeof(T);
+        }
+
+        /** @return the bytes of the objects held by a ptr_vector (only of the pointers for a REF vector) */
+        template<typename T, VECTOR_TYPE H>
+        static long long getVectorBytes(const ptr_vector<T, H>& vector)
+        {
+            return (long long)vector.size()*(H == HOLD ? sizeof(T) + sizeof(T*) : sizeof(T*));
+        }
+
+        /** @return the bytes used by the characters of a string */
+        static long long getStringBytes(const wxString& string)
+        {
+            return (long long)string.length()*sizeof(wxChar);
+        }
+
+        /** @return the given number of bytes as a short text, e.g. "12.5 MB" */
+        static wxString formatBytes(const long long bytes);
+    };
+
+}
+
+#endif
@@ -20,16 +20,20 @@
 #include "GUI/GraphicalTrack.h"
 #include "Dialogs/WaitWindow.h"
 #include "Midi/CommonMidiUtils.h"
+#include "Midi/CompactMidiTrack.h"
 #include "Midi/MeasureData.h"
+#include "Midi/Players/OutputRouter.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Sequence.h"
 #include "Midi/Track.h"
+#include "Parallel.h"
 #include "UnitTest.h"
 #include "ptr_vector.h"
 
 #include "jdksmidi/world.h"
 #include "jdksmidi/track.h"
 #include "jdksmidi/multitrack.h"
+#include "jdksmidi/sequencer.h"
 #include "jdksmidi/filereadmultitrack.h"
 #include "jdksmidi/fileread.h"
 #include "jdksmidi/fileshow.h"
@@ -37,10 +41,14 @@
 #include "jdksmidi/msg.h"
 #include "jdksmidi/sysex.h"
 
+#include <wx/file.h>
 #include <wx/intl.h>
 #include <wx/timer.h>
 #include <wx/msgdlg.h>
+#include <wx/stopwatch.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 
@@ -110,29 +118,26 @@ bool AriaMaestosa::exportMidiFile(Sequence* sequence, wxString filepath)
     const int firstMeasureValue = sequence->getMeasureData()->getFirstMeasure();
     sequence->getMeasureData()->setFirstMeasure(0);
     
-    jdksmidi::MIDIMultiTrack tracks;
+    CompactMidiSequence tracks;
     int length = -1, start = -1, numTracks = -1;
-    makeJDKMidiSequence(sequence, tracks, false, &length, &start, &numTracks, false);
+    makeCompactMidiSequence(sequence, tracks, false, &length, &start, &numTracks, false);
     
-#ifdef __WXMSW__
-    jdksmidi::MIDIFileWriteStreamFileName file_stream( (const wchar_t*)filepath.wc_str() );
-#else
-    jdksmidi::MIDIFileWriteStreamFileName file_stream( (const char*)filepath.mb_str(wxConvUTF8) );
-#endif
-
-    jdksmidi::MIDIFileWriteMultiTrack writer2(
-                                             &tracks,
-                                             &file_stream
-                                             );
+    sequence->getMeasureData()->setFirstMeasure(firstMeasureValue);
     
-    // write the output file
-    if (not writer2.Write(numTracks, sequence->ticksPerQuarterNote()))
+    std::vector<char> bytes;
+    if (not tracks.writeMidiBytes(bytes))
     {
         fprintf(stderr, "[exportMidiFile] Error writing midi file\n");
         return false;
     }
     
-    sequence->getMeasureData()->setFirstMeasure(firstMeasureValue);
+    // write the output file, all at once
+    wxFile file;
+    if (not file.Create(filepath, true) or file.Write(&bytes[0], bytes.size()) != bytes.size())
+    {
+        fprintf(stderr, "[exportMidiFile] Error writing midi file\n");
+        return false;
+    }
     
     return true;
     
@@ -374,6 +379,44 @@ UNIT_TEST( MergeTest )
 
 // ----------------------------------------------------------------------------------------------------------
 
+namespace AriaMaestosa
+{
+    /** Generates the events of each track of a sequence into its own libjdkmidi track */
+    class TrackEventsTask : public IParallelTask
+    {
+        Sequence* m_sequence;
+        jdksmidi::MIDIMultiTrack& m_tracks;
+        const std::vector<int>& m_channels;
+        int m_first_measure;
+        
+    public:
+        
+        /** value returned by Track::addMidiEvents for each track */
+        std::vector<int> m_lengths;
+        
+        /** start tick reported by Track::addMidiEvents for each track (-1 if none) */
+        std::vector<int> m_first_notes;
+        
+        TrackEventsTask(Sequence* sequence, jdksmidi::MIDIMultiTrack& tracks, const std::vector<int>& channels,
+                        const int firstMeasure) : m_tracks(tracks), m_channels(channels)
+        {
+            m_sequence      = sequence;
+            m_first_measure = firstMeasure;
+            m_lengths.resize(channels.size(), -1);
+            m_first_notes.resize(channels.size(), -1);
+        }
+        
+        virtual void run(const int id)
+        {
+            jdksmidi::MIDITrack* target = m_tracks.GetTrack(id + 1);
+            m_lengths[id] = m_sequence->getTrack(id)->addMidiEvents(target, m_channels[id], m_first_measure,
+                                                                    false, m_first_notes[id]);
+        }
+    };
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 bool AriaMaestosa::makeJDKMidiSequence(Sequence* sequence, jdksmidi::MIDIMultiTrack& tracks, bool selectionOnly,
                                        /*out*/int* songLengthInTicks, /*out*/int* startTick,
                                        /*out*/ int* numTracks, bool playing)
@@ -384,12 +427,14 @@ bool AriaMaestosa::makeJDKMidiSequence(Sequence* sequence, jdksmidi::MIDIMultiTr
     int substract_ticks;
     const bool addMetronome = (sequence->playWithMetronome() and playing);
     
+    // one MIDI track for tempo and other song-wide events, one per track, and one for the metronome
+    const int neededTracks = sequence->getTrackAmount() + 2;
+    if (tracks.GetNumTracks() < neededTracks) tracks.ClearAndResize(neededTracks);
+    
     tracks.SetClksPerBeat( sequence->ticksPerQuarterNote() );
     
     MeasureData* md = sequence->getMeasureData();
     
-    bool tooManyChannelsMessageShown = false;
-    
     const int past_end_time = (playing and not sequence->isLoopEnabled() ? sequence->ticksPerQuarterNote()*4 : 0);
     
     if (selectionOnly)
@@ -421,57 +466,32 @@ bool AriaMaestosa::makeJDKMidiSequence(Sequence* sequence, jdksmidi::MIDIMultiTr
         // play from beginning
         (*startTick) = -1;
         
+        // channels are handed out in track order, so pick them all before generating tracks in parallel
+        bool tooManyChannels = false;
+        const std::vector<int> channels = getTrackChannels(sequence, &tooManyChannels);
+        if (tooManyChannels)
+        {
+            if (WaitWindow::isShown()) WaitWindow::hide();
+            wxMessageBox(_("WARNING: this song has too many\nchannels, expect unpredictable output"));
+            std::cout << "WARNING: this song has too many channels, expect unpredictable output" << std::endl;
+        }
         const int trackAmount = sequence->getTrackAmount();
+        
+        // ---- add events to tracks
+        TrackEventsTask task(sequence, tracks, channels, md->getFirstMeasure());
+        Parallel::forEach(trackAmount, &task);
+        
         for (int n=0; n<trackAmount; n++)
         {
-            bool drum_track = (sequence->getTrack(n)->isNotationTypeEnabled(DRUM));
-            
-            int trackFirstNote = -1;
-            
-            if (n+1 < tracks.GetNumTracks())
-            {
-                trackLength = sequence->getTrack(n)->addMidiEvents(tracks.GetTrack(n+1), (drum_track ? 9 : channel),
-                                                                   md->getFirstMeasure(), false,
-                                                                   trackFirstNote );
-            }
-            else
-            {
-                if (not tooManyChannelsMessageShown)
-                {
-                    if (WaitWindow::isShown()) WaitWindow::hide();
-                    wxMessageBox(_("WARNING: this song has too many\nchannels, expect unpredictable output"));
-                    std::cout << "WARNING: this song has too many channels, expect unpredictable output" << std::endl;
-                    tooManyChannelsMessageShown = true;
-                }
-                trackLength = sequence->getTrack(n)->addMidiEvents(tracks.GetTrack(1), (drum_track ? 9 : channel),
-                                                                   md->getFirstMeasure(), false,
-                                                                   trackFirstNote );
-            }
-            
+            const int trackFirstNote = task.m_first_notes[n];
             if ((trackFirstNote<(*startTick) and trackFirstNote != -1) or (*startTick) == -1)
             {
                 (*startTick) = trackFirstNote;
             }
             
-            
+            trackLength = task.m_lengths[n];
             if (trackLength == -1) continue; // nothing to play in track (empty track - skip it)
             if (trackLength > *songLengthInTicks) *songLengthInTicks = trackLength;
-            
-            if (not drum_track)
-            {
-                if (channel > 15 and sequence->getChannelManagementType() == CHANNEL_AUTO)
-                {
-                    if (not tooManyChannelsMessageShown)
-                    {
-                        if (WaitWindow::isShown()) WaitWindow::hide();
-                        wxMessageBox(_("WARNING: this song has too many\nchannels, expect unpredictable output"));
-                        std::cout << "WARNING: this song has too many channels, expect unpredictable output" << std::endl;
-                        tooManyChannelsMessageShown = true;
-                    }
-                    channel = 0;
-                }
-                channel++; if (channel==9) channel++;
-            }
         }
         
         if (sequence->isLoopEnabled())
@@ -727,21 +747,9 @@ bool AriaMaestosa::makeJDKMidiSequence(Sequence* sequence, jdksmidi::MIDIMultiTr
         const int count = sequence->getTrackAmount();
         for (int n=0; n<count; n++)
         {
-            if (n+1 < tracks.GetNumTracks())
+            if (not tracks.GetTrack(n+1)->PutEvent( m ))
             {
-                if (not tracks.GetTrack(n+1)->PutEvent( m ))
-                {
-                    std::cerr << "Error adding dummy end midi event!" << std::endl;
-                }
-            }
-            else
-            {
-                std::cerr << "Too many tracks, expect unpredictable output" << std::endl;
-
-                if (not tracks.GetTrack(1)->PutEvent( m ))
-                {
-                    std::cerr << "Error adding dummy end midi event!" << std::endl;
-                }
+                std::cerr << "Error adding dummy end midi event!" << std::endl;
             }
         }//next
 
@@ -820,8 +828,7 @@ bool AriaMaestosa::makeJDKMidiSequence(Sequence* sequence, jdksmidi::MIDIMultiTr
         const int metronomeInstrument = 37; // 31 (stick), 56 (cowbell), 37 (side stick)
         const int metronomeVolume = 127;
         
-        // FIXME: if the user adds lots of tracks, just using the last track here may not be safe.
-        const int metronomeTrackId = sequence->getTrackAmount() + 1; //tracks.GetNumTracks() - 1;
+        const int metronomeTrackId = sequence->getTrackAmount() + 1;
         jdksmidi::MIDITrack* metronomeTrack = tracks.GetTrack(metronomeTrackId);
         
         *numTracks = *numTracks + 1;
@@ -920,29 +927,135 @@ void AriaMaestosa::allocAsMidiBytes(Sequence* sequence, bool selectionOnly, /*ou
 {
     int numTracks = -1;
     
-    jdksmidi::MIDIMultiTrack tracks;
-    
-    makeJDKMidiSequence(sequence, tracks, selectionOnly, songlength, startTick, &numTracks, playing);
+    CompactMidiSequence tracks;
     
-    // create the output stream
-    OwnerPtr<MidiToMemoryStream>  out_stream;
-    out_stream = new MidiToMemoryStream();
-    
-    jdksmidi::MIDIFileWriteMultiTrack writer(
-                                            &tracks,
-                                            out_stream
-                                            );
+    makeCompactMidiSequence(sequence, tracks, selectionOnly, songlength, startTick, &numTracks, playing);
     
     // write the output data
-    if ( !writer.Write( numTracks, sequence->ticksPerQuarterNote() ) )
+    std::vector<char> bytes;
+    if (not tracks.writeMidiBytes(bytes))
     {
         fprintf( stderr, "[allocAsMidiBytes] Error writing midi file\n");
         return;
     }
     
-    (*midiSongData) = (char*)malloc(out_stream->getDataLength());
-    out_stream->storeMidiData( (*midiSongData) );
-    *datalength = out_stream->getDataLength();
+    (*midiSongData) = (char*)malloc(bytes.size());
+    memcpy(*midiSongData, &bytes[0], bytes.size());
+    *datalength = bytes.size();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::makeCompactMidiSequence(Sequence* sequence, CompactMidiSequence& tracks, bool selectionOnly,
+                                           /*out*/int* songLengthInTicks, /*out*/int* startTick,
+                                           /*out*/ int* numTracks, bool playing, /*out*/ wxArrayString* outputs)
+{
+    jdksmidi::MIDIMultiTrack jdkTracks;
+    const bool success = makeJDKMidiSequence(sequence, jdkTracks, selectionOnly, songLengthInTicks, startTick,
+                                             numTracks, playing);
+    
+    // the jdksmidi tracks are only used while converting, all their messages are freed on return
+    tracks.set(jdkTracks, std::max(*numTracks, 0)); // nothing to play leaves 'numTracks' at -1
+    
+    // MIDI track 0 holds the tempo and time signature events, track n+1 the events of Aria track n
+    wxArrayString outputNames;
+    const std::vector<int> trackOutputs = getTrackOutputs(sequence, outputNames);
+    const int routedAmount = std::min((int)trackOutputs.size(), tracks.getTrackAmount() - 1);
+    for (int n=0; n<routedAmount; n++)
+    {
+        tracks.setTrackOutput(n + 1, trackOutputs[n]);
+    }
+    
+    if (outputs != NULL) *outputs = outputNames;
+    return success;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void AriaMaestosa::makeCompactMidiTrack(Sequence* sequence, const int trackId, const int channel,
+                                        const int firstMeasure, const int songLengthInTicks,
+                                        /*out*/ CompactMidiTrack& out)
+{
+    out.clear();
+    
+    jdksmidi::MIDITrack track;
+    int startTick = -1;
+    sequence->getTrack(trackId)->addMidiEvents(&track, channel, firstMeasure, false, startTick);
+    
+    // same dummy end event as makeJDKMidiSequence adds to each track when playing
+    jdksmidi::MIDITimedBigMessage m;
+    m.SetTime( songLengthInTicks );
+    m.SetControlChange(0, 127, 0);
+    if (not track.PutEvent( m ))
+    {
+        std::cerr << "Error adding dummy end midi event!" << std::endl;
+    }
+    
+    out.addEvents(track);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+std::vector<int> AriaMaestosa::getTrackChannels(Sequence* sequence, /*out*/ bool* tooManyChannels)
+{
+    if (tooManyChannels != NULL) *tooManyChannels = false;
+    
+    // each output device has channels of its own
+    wxArrayString outputNames;
+    const std::vector<int> outputs = getTrackOutputs(sequence, outputNames);
+    std::vector<int> outputChannels(outputNames.size(), 0);
+    
+    const int trackAmount = sequence->getTrackAmount();
+    std::vector<int> channels(trackAmount);
+    for (int n=0; n<trackAmount; n++)
+    {
+        int& channel = outputChannels[outputs[n]];
+        
+        const bool drum_track = (sequence->getTrack(n)->isNotationTypeEnabled(DRUM));
+        channels[n] = (drum_track ? 9 : channel);
+        
+        // muted tracks have nothing to play (Track::addMidiEvents returns -1) and don't use up a channel
+        if (not sequence->getTrack(n)->isPlayed()) continue;
+        
+        if (not drum_track)
+        {
+            if (channel > 15 and sequence->getChannelManagementType() == CHANNEL_AUTO)
+            {
+                if (tooManyChannels != NULL) *tooManyChannels = true;
+                channel = 0;
+            }
+            channel++; if (channel==9) channel++;
+        }
+    }
+    return channels;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+std::vector<int> AriaMaestosa::getTrackOutputs(Sequence* sequence, /*out*/ wxArrayString& outputs)
+{
+    outputs.Clear();
+    outputs.Add(wxEmptyString);
+    
+    const int trackAmount = sequence->getTrackAmount();
+    std::vector<int> trackOutputs(trackAmount, 0);
+    for (int n=0; n<trackAmount; n++)
+    {
+        const wxString& device = sequence->getTrack(n)->getOutputDevice();
+        if (device.IsEmpty()) continue;
+        
+        int output = outputs.Index(device);
+        if (output == wxNOT_FOUND)
+        {
+            // outputs are kept in a byte of each event, see CompactMidiEvent::getOutput
+            if (outputs.size() >= 256) continue;
+            
+            output = outputs.size();
+            outputs.Add(device);
+        }
+        trackOutputs[n] = output;
+    }
+    return trackOutputs;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -1038,3 +1151,254 @@ int AriaMaestosa::getTimeAtTick(int tick, const Sequence* seq)
     return (int)round(song_duration);
 }
 
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestMidiExport
+{
+    using namespace AriaMaestosa;
+
+    UNIT_TEST(TestParallelMidiExport)
+    {
+        const int TRACK_AMOUNT    = 16;
+        const int NOTES_PER_TRACK = 20000;
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        const int beat = seq->ticksPerQuarterNote();
+
+        {
+            ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+            tr->setMeasureAmount(NOTES_PER_TRACK/16 + 1); // four notes per beat
+        }
+
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            Track* track = new Track(seq);
+            {
+                OwnerPtr<Sequence::Import> import(seq->startImport());
+                for (int n=0; n<NOTES_PER_TRACK; n++)
+                {
+                    track->addNote_import(36 + (n*7 + t) % 60, n*beat/4, (n + 1)*beat/4, 100, -1);
+                    track->addControlEvent_import(n*beat/4, (n + t) % 128, 7 /* volume */);
+                }
+            }
+            seq->addTrack(track);
+        }
+
+        // ---- event generation : one track after the other, then on worker threads
+        jdksmidi::MIDIMultiTrack serialTracks;
+        wxStopWatch serialTime;
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            int firstNote = -1;
+            seq->getTrack(t)->addMidiEvents(serialTracks.GetTrack(t + 1), (t < 9 ? t : t + 1), 0, false, firstNote);
+        }
+        const long serialMs = serialTime.Time();
+
+        jdksmidi::MIDIMultiTrack tracks;
+        int length = -1, start = -1, numTracks = -1;
+        wxStopWatch parallelTime;
+        makeJDKMidiSequence(seq, tracks, false, &length, &start, &numTracks, false);
+        const long parallelMs = parallelTime.Time();
+
+        require_e(numTracks, ==, TRACK_AMOUNT + 1, "every track was exported");
+
+        int eventAmount = 0;
+        for (int t=0; t<numTracks; t++) eventAmount += tracks.GetTrack(t)->GetNumEvents();
+
+        // ---- serialization : libjdkmidi writer, then one chunk per worker thread (see exportMidiFile)
+        MidiToMemoryStream stream;
+        jdksmidi::MIDIFileWriteMultiTrack writer(&tracks, &stream);
+        wxStopWatch writerTime;
+        require(writer.Write(numTracks, beat), "libjdkmidi can write the sequence");
+        const long writerMs = writerTime.Time();
+
+        std::vector<char> bytes;
+        wxStopWatch chunkTime;
+        CompactMidiSequence compact;
+        compact.set(tracks, numTracks);
+        require(compact.writeMidiBytes(bytes), "the sequence can be written in chunks");
+        const long chunkMs = chunkTime.Time();
+
+        require_e(bytes.size(), ==, stream.getData().size(), "chunked writing produces a file of the same size");
+        require(bytes == stream.getData(), "chunked writing produces the same bytes as libjdkmidi");
+
+        std::cout << "[MidiExport] " << eventAmount << " events on " << Parallel::getWorkerCount()
+                  << " worker thread(s) : generating " << serialMs << " ms serially vs " << parallelMs
+                  << " ms in parallel; writing " << writerMs << " ms with libjdkmidi vs " << chunkMs
+                  << " ms in chunks (" << (chunkMs > 0 ? (int)(eventAmount / (chunkMs/1000.0f)) : -1)
+                  << " events/s)" << std::endl;
+
+        delete seq;
+    }
+
+    UNIT_TEST(TestTrackOutputRouting)
+    {
+        // more tracks than one device has channels, half of them routed to a second device
+        const int TRACK_AMOUNT = 24;
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        const int beat = seq->ticksPerQuarterNote();
+
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            Track* track = new Track(seq);
+            {
+                OwnerPtr<Sequence::Import> import(seq->startImport());
+                for (int n=0; n<16; n++) track->addNote_import(48 + t, n*beat, (n + 1)*beat, 100, -1);
+            }
+            if (t % 2 == 1) track->setOutputDevice(wxT("20:0 Second Synth"));
+            seq->addTrack(track);
+        }
+
+        CompactMidiSequence tracks;
+        wxArrayString outputs;
+        int length = -1, start = -1, numTracks = -1;
+        require(makeCompactMidiSequence(seq, tracks, false, &length, &start, &numTracks, false, &outputs),
+                "the sequence can be generated");
+
+        require_e(outputs.size(), ==, 2u, "two outputs are used");
+        require(outputs[0].IsEmpty(), "the first output is the default one");
+        require(outputs[1] == wxT("20:0 Second Synth"), "the second output is the one of the routed tracks");
+
+        // channels are picked separately on each output, so no two tracks of an output share one
+        std::vector<bool> channelTaken(outputs.size()*16, false);
+        int routedEvents = 0;
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            const CompactMidiTrack& track = tracks.getTrack(t + 1);
+            const int output = tracks.getTrackOutput(t + 1);
+            require_e(output, ==, t % 2, "each track is routed to its output");
+
+            int channel = -1;
+            for (int e=0; e<track.getEventAmount(); e++)
+            {
+                const CompactMidiEvent& ev = track.getEvent(e);
+                if (ev.hasPayload()) continue;
+                if (channel == -1) channel = ev.getChannel();
+                require_e(ev.getChannel(), ==, channel, "a track plays on a single channel");
+                if (output == 1) routedEvents++;
+            }
+            require(channel != -1, "every track has events");
+            require(not channelTaken[output*16 + channel], "tracks of an output don't share channels");
+            channelTaken[output*16 + channel] = true;
+        }
+
+        CompactMidiTrack stream;
+        tracks.mergeTracks(stream);
+        require_e(stream.getOutputAmount(), ==, 2, "the playback stream uses both outputs");
+
+        int streamRoutedEvents = 0;
+        for (int e=0; e<stream.getEventAmount(); e++)
+        {
+            const CompactMidiEvent& ev = stream.getEvent(e);
+            if (not ev.hasPayload() and ev.getOutput() == 1) streamRoutedEvents++;
+        }
+        require_e(streamRoutedEvents, ==, routedEvents, "merging keeps the output of each event");
+
+        delete seq;
+    }
+
+    /** Output that drops everything it receives, only counting note ons */
+    class NullOutputSink : public IOutputSink
+    {
+        int* m_note_ons;
+
+    public:
+
+        NullOutputSink(int* noteOns) { m_note_ons = noteOns; }
+
+        virtual void send(const RoutedMessage& message)
+        {
+            if (message.getType() == 0x90 and message.m_data2 > 0) (*m_note_ons)++;
+        }
+    };
+
+    UNIT_TEST(TestManyTracksPlayback)
+    {
+        // well past the 64 tracks libjdkmidi's sequencer used to be limited to
+        const int TRACK_AMOUNT    = 512;
+        const int NOTES_PER_TRACK = 32;
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        const int beat = seq->ticksPerQuarterNote();
+
+        // channels are picked by hand so that running out of them doesn't bring up a warning
+        seq->setChannelManagementType(CHANNEL_MANUAL);
+        {
+            ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+            tr->setMeasureAmount(NOTES_PER_TRACK/4 + 1);
+        }
+
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            Track* track = new Track(seq);
+            {
+                OwnerPtr<Sequence::Import> import(seq->startImport());
+                for (int n=0; n<NOTES_PER_TRACK; n++)
+                {
+                    track->addNote_import(36 + (n + t) % 60, n*beat, n*beat + beat/2, 100, -1);
+                }
+            }
+            seq->addTrack(track);
+        }
+
+        jdksmidi::MIDIMultiTrack tracks;
+        int length = -1, start = -1, numTracks = -1;
+        wxStopWatch generateTime;
+        require(makeJDKMidiSequence(seq, tracks, false, &length, &start, &numTracks, true),
+                "the sequence can be generated");
+        const long generateMs = generateTime.Time();
+
+        require_e(numTracks, ==, TRACK_AMOUNT + 1, "every track has a MIDI track of its own");
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            int noteOns = 0;
+            const jdksmidi::MIDITrack* track = tracks.GetTrack(t + 1);
+            for (int e=0; e<track->GetNumEvents(); e++)
+            {
+                if (track->GetEventAddress(e)->IsNoteOn()) noteOns++;
+            }
+            require_e(noteOns, ==, NOTES_PER_TRACK, "no track was merged into another");
+        }
+
+        // ---- play it through the libjdkmidi sequencer, into an output that drops everything
+        int outputNoteOns = 0;
+        OutputRouter router;
+        require(router.addOutput(new NullOutputSink(&outputNoteOns)), "the null output could be opened");
+
+        std::vector<int> playedNotes(numTracks, 0);
+        int playedEvents = 0;
+
+        jdksmidi::MIDISequencer sequencer(&tracks);
+        require_e(sequencer.GetNumTracks(), >=, numTracks, "the sequencer keeps the state of every track");
+
+        wxStopWatch playTime;
+        sequencer.GoToTimeMs(0);
+        int track;
+        jdksmidi::MIDITimedBigMessage ev;
+        while (sequencer.GetNextEvent(&track, &ev))
+        {
+            if (not ev.IsChannelMsg()) continue;
+            if (ev.IsNoteOn() and ev.GetVelocity() > 0 and track < numTracks) playedNotes[track]++;
+            router.post(0, RoutedMessage(ev.GetStatus(), ev.GetByte1(), ev.GetByte2()));
+            playedEvents++;
+        }
+        router.waitUntilSent();
+        const long playMs = playTime.Time();
+
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            require_e(playedNotes[t + 1], ==, NOTES_PER_TRACK, "the notes of every track are played");
+        }
+        require_e(outputNoteOns, ==, TRACK_AMOUNT*NOTES_PER_TRACK, "every note reached the output");
+
+        std::cout << "[MidiExport] " << TRACK_AMOUNT << " tracks : generated in " << generateMs << " ms, "
+                  << playedEvents << " events played through a null output in " << playMs << " ms ("
+                  << (playMs > 0 ? (long)(playedEvents / (playMs/1000.0f)) : -1) << " events/s)" << std::endl;
+
+        router.clear();
+        delete seq;
+    }
+}
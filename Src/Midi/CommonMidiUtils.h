@@ -20,6 +20,8 @@
 /** @defgroup midi */
 
 #include <wx/string.h>
+#include <wx/arrstr.h>
+#include <vector>
 
 // forward
 namespace jdksmidi{ class MIDIMultiTrack; }
@@ -28,6 +30,8 @@ namespace AriaMaestosa
 {
     
     class Sequence; // forward
+    class CompactMidiSequence;
+    class CompactMidiTrack;
     
     /**
       * @brief used to ease generating midi data
@@ -43,11 +47,53 @@ namespace AriaMaestosa
     
     /**
       * @brief converts an Aria sequence into a libjdkmidi sequence
+      *
+      * The events of each track are generated on worker threads (see Parallel::forEach).
       * @ingroup midi
       */
     bool makeJDKMidiSequence(Sequence* sequence, jdksmidi::MIDIMultiTrack& tracks, bool selectionOnly,
                              /*out*/int* songLengthInTicks, /*out*/int* startTick, /*out*/ int* numTracks, bool playing);
     
+    /**
+      * @brief converts an Aria sequence into compact MIDI tracks (see CompactMidiSequence)
+      *
+      * Same parameters as makeJDKMidiSequence; the events are generated through libjdkmidi, then
+      * converted, so that the large libjdkmidi messages don't outlive this call.
+      * Each track is routed to its output device (see getTrackOutputs).
+      * @param[out] outputs  if not NULL, receives the output devices the tracks are routed to
+      * @ingroup midi
+      */
+    bool makeCompactMidiSequence(Sequence* sequence, CompactMidiSequence& tracks, bool selectionOnly,
+                                 /*out*/int* songLengthInTicks, /*out*/int* startTick, /*out*/ int* numTracks,
+                                 bool playing, /*out*/ wxArrayString* outputs = NULL);
+    
+    /**
+      * @brief generates the events of a single track for playback, like makeCompactMidiSequence does for
+      *        each track of the song (used to replace a track while the song plays, see LiveEditRebuilder)
+      * @param channel            channel the track plays on, see getTrackChannels
+      * @param firstMeasure       measure playback started from
+      * @param songLengthInTicks  length given by makeCompactMidiSequence when playback started
+      * @ingroup midi
+      */
+    void makeCompactMidiTrack(Sequence* sequence, const int trackId, const int channel,
+                              const int firstMeasure, const int songLengthInTicks,
+                              /*out*/ CompactMidiTrack& out);
+    
+    /**
+      * @brief picks the channel each track of a sequence is played on when playing the whole song
+      * @param[out] tooManyChannels  if not NULL, set to true when tracks had to share channels
+      * @ingroup midi
+      */
+    std::vector<int> getTrackChannels(Sequence* sequence, /*out*/ bool* tooManyChannels = NULL);
+    
+    /**
+      * @brief lists the output devices the tracks of a sequence are played on (see Track::getOutputDevice)
+      * @param[out] outputs  the devices used; the first one is always the default output (an empty name)
+      * @return the index in 'outputs' of the device of each track of the sequence
+      * @ingroup midi
+      */
+    std::vector<int> getTrackOutputs(Sequence* sequence, /*out*/ wxArrayString& outputs);
+    
     /**
       * @brief For use with the controller editor, when entering tempo bends
       * @ingroup midi
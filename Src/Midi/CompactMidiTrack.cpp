@@ -0,0 +1,743 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Midi/CompactMidiTrack.h"
+
+#include "AriaCore.h"
+#include "IO/MidiToMemoryStream.h"
+#include "Midi/CommonMidiUtils.h"
+#include "Midi/MeasureData.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "Parallel.h"
+#include "UnitTest.h"
+
+#include "jdksmidi/world.h"
+#include "jdksmidi/filewritemultitrack.h"
+#include "jdksmidi/midi.h"
+#include "jdksmidi/msg.h"
+#include "jdksmidi/multitrack.h"
+#include "jdksmidi/sequencer.h"
+#include "jdksmidi/sysex.h"
+#include "jdksmidi/track.h"
+
+#include <algorithm>
+#include <iostream>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    /** payload indices are stored on 24 bits */
+    const int MAX_PAYLOADS_PER_TRACK = (1 << 24);
+
+    void writeLong(std::vector<char>& out, const unsigned long value)
+    {
+        out.push_back((char)((value >> 24) & 0xFF));
+        out.push_back((char)((value >> 16) & 0xFF));
+        out.push_back((char)((value >> 8)  & 0xFF));
+        out.push_back((char)( value        & 0xFF));
+    }
+
+    /** same encoding as jdksmidi::MIDIFileWrite::WriteVariableNum */
+    void writeVariableNum(std::vector<char>& out, unsigned long value)
+    {
+        unsigned long buffer = value & 0x7F;
+        while ((value >>= 7) > 0)
+        {
+            buffer <<= 8;
+            buffer |= 0x80;
+            buffer += (value & 0x7F);
+        }
+
+        while (true)
+        {
+            out.push_back((char)(buffer & 0xFF));
+            if (buffer & 0x80) buffer >>= 8;
+            else               break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int CompactMidiEvent::getMessageLength() const
+{
+    if (m_status < 0xF0) return jdksmidi::GetMessageLength(m_status);
+    else                 return jdksmidi::GetSystemMessageLength(m_status);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#pragma mark CompactMidiTrack
+#endif
+
+CompactMidiTrack::CompactMidiTrack()
+{
+    m_end_tick = 0;
+    m_output_amount = 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::clear()
+{
+    m_events.clear();
+    m_payloads.clear();
+    m_arena.clear();
+    m_end_tick = 0;
+    m_output_amount = 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::reserve(const int eventAmount)
+{
+    m_events.reserve(eventAmount);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::swap(CompactMidiTrack& other)
+{
+    m_events.swap(other.m_events);
+    m_payloads.swap(other.m_payloads);
+    m_arena.swap(other.m_arena);
+    std::swap(m_end_tick, other.m_end_tick);
+    std::swap(m_output_amount, other.m_output_amount);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::addChannelEvent(const unsigned int tick, const unsigned char status,
+                                       const unsigned char data1, const unsigned char data2,
+                                       const unsigned char output)
+{
+    CompactMidiEvent ev;
+    ev.m_tick   = tick;
+    ev.m_status = status;
+    ev.m_data1  = data1;
+    ev.m_data2  = data2;
+    ev.m_extra  = output;
+    m_events.push_back(ev);
+
+    if (tick > m_end_tick) m_end_tick = tick;
+    if (output >= m_output_amount) m_output_amount = output + 1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::addPayloadEvent(const unsigned int tick, const unsigned char status,
+                                       const unsigned char metaType, const unsigned char* data,
+                                       const int length)
+{
+    const int index = m_payloads.size();
+    if (index >= MAX_PAYLOADS_PER_TRACK)
+    {
+        std::cerr << "[CompactMidiTrack] too many meta events in track, skipping" << std::endl;
+        return;
+    }
+
+    Payload payload;
+    payload.m_offset    = m_arena.size();
+    payload.m_length    = length;
+    payload.m_meta_type = metaType;
+    m_payloads.push_back(payload);
+    m_arena.insert(m_arena.end(), data, data + length);
+
+    CompactMidiEvent ev;
+    ev.m_tick   = tick;
+    ev.m_status = status;
+    ev.m_data1  = (unsigned char)( index        & 0xFF);
+    ev.m_data2  = (unsigned char)((index >> 8)  & 0xFF);
+    ev.m_extra  = (unsigned char)((index >> 16) & 0xFF);
+    m_events.push_back(ev);
+
+    if (tick > m_end_tick) m_end_tick = tick;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::addMetaEvent(const unsigned int tick, const unsigned char type,
+                                    const unsigned char* data, const int length)
+{
+    addPayloadEvent(tick, 0xFF, type, data, length);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::addSysExEvent(const unsigned int tick, const unsigned char status,
+                                     const unsigned char* data, const int length)
+{
+    addPayloadEvent(tick, status, 0, data, length);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool CompactMidiTrack::addEvent(const jdksmidi::MIDITimedBigMessage& msg)
+{
+    // service events (NoOp, beat markers, ...) only exist within libjdkmidi
+    if (msg.IsNoOp() or msg.IsBeatMarker() or msg.IsUserAppMarker()) return false;
+
+    const unsigned int tick = msg.GetTime();
+
+    if (msg.IsMetaEvent())
+    {
+        // the payload holds the same bytes jdksmidi::MIDIFileWrite writes after the length
+        if (msg.GetSysEx() != NULL)
+        {
+            addMetaEvent(tick, msg.GetMetaType(), msg.GetSysEx()->GetBuf(), msg.GetSysEx()->GetLengthSE());
+            return true;
+        }
+
+        unsigned char data[5];
+        int length;
+        if (msg.IsTempo())
+        {
+            data[0] = msg.GetByte2();
+            data[1] = msg.GetByte3();
+            data[2] = msg.GetByte4();
+            length = 3;
+        }
+        else if (msg.IsKeySig())
+        {
+            data[0] = msg.GetByte2();
+            data[1] = msg.GetByte3();
+            length = 2;
+        }
+        else if (msg.IsTimeSig())
+        {
+            // numerator, denominator power, clocks per metronome beat, 32nds per quarter note
+            data[0] = msg.GetByte2();
+            data[1] = msg.GetByte4();
+            data[2] = msg.GetByte5();
+            data[3] = msg.GetByte6();
+            length = 4;
+        }
+        else
+        {
+            length = msg.GetDataLength();
+            if (length > 5) return false; // not a valid meta event, libjdkmidi doesn't write it either
+
+            data[0] = msg.GetByte2();
+            data[1] = msg.GetByte3();
+            data[2] = msg.GetByte4();
+            data[3] = msg.GetByte5();
+            data[4] = msg.GetByte6();
+        }
+
+        addMetaEvent(tick, msg.GetMetaType(), data, length);
+        return true;
+    }
+
+    if (msg.IsSystemExclusive() and msg.GetSysEx() != NULL)
+    {
+        addSysExEvent(tick, msg.GetStatus(), msg.GetSysEx()->GetBuf(), msg.GetSysEx()->GetLengthSE());
+        return true;
+    }
+
+    if (msg.GetLengthMSG() <= 0) return false;
+
+    addChannelEvent(tick, msg.GetStatus(), msg.GetByte1(), msg.GetByte2());
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiTrack::addEvents(const jdksmidi::MIDITrack& track)
+{
+    const int eventAmount = track.GetNumEvents();
+    reserve(m_events.size() + eventAmount);
+
+    for (int n=0; n<eventAmount; n++)
+    {
+        const jdksmidi::MIDITimedBigMessage* ev = track.GetEventAddress(n);
+        if (ev == NULL or ev->IsNoOp()) continue;
+
+        // like jdksmidi::MIDIFileWriteMultiTrack, the track ends at its end-of-track event, if any
+        if (ev->IsDataEnd())
+        {
+            m_end_tick = ev->GetTime();
+            return;
+        }
+
+        addEvent(*ev);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const unsigned char* CompactMidiTrack::getPayloadData(const CompactMidiEvent& event) const
+{
+    const Payload& payload = getPayload(event);
+    if (payload.m_length == 0) return NULL;
+    return &m_arena[payload.m_offset];
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+unsigned long CompactMidiTrack::getTempo32(const CompactMidiEvent& event) const
+{
+    ASSERT(isTempo(event));
+
+    const Payload& payload = getPayload(event);
+    if (payload.m_length < 3) return 120*32;
+
+    // tempo is in microseconds per beat
+    const unsigned char* data = &m_arena[payload.m_offset];
+    unsigned long tempo = (data[0] << 16) | (data[1] << 8) | data[2];
+    if (tempo == 0) tempo = 1;
+
+    return (unsigned long)(0.5 + (32*60*1e6) / (double)tempo);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+long CompactMidiTrack::getMemoryUsage() const
+{
+    return m_events.capacity()*sizeof(CompactMidiEvent) + m_payloads.capacity()*sizeof(Payload) +
+           m_arena.capacity();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool CompactMidiTrack::writeChunk(std::vector<char>& out) const
+{
+    const int chunkStart = out.size();
+
+    out.push_back('M');
+    out.push_back('T');
+    out.push_back('r');
+    out.push_back('k');
+    writeLong(out, 0); // rewritten below, once the length is known
+
+    unsigned int trackTime     = 0;
+    unsigned char runningStatus = 0;
+
+    const int eventAmount = m_events.size();
+    for (int n=0; n<eventAmount; n++)
+    {
+        const CompactMidiEvent& ev = m_events[n];
+        if (ev.m_tick < trackTime) return false; // events out of order
+
+        writeVariableNum(out, ev.m_tick - trackTime);
+        trackTime = ev.m_tick;
+
+        if (ev.hasPayload())
+        {
+            const Payload& payload = getPayload(ev);
+            out.push_back((char)ev.m_status);
+            if (ev.isMeta()) out.push_back((char)payload.m_meta_type);
+            writeVariableNum(out, payload.m_length);
+            out.insert(out.end(), m_arena.begin() + payload.m_offset,
+                       m_arena.begin() + payload.m_offset + payload.m_length);
+            runningStatus = 0;
+        }
+        else
+        {
+            const int length = ev.getMessageLength();
+            if (runningStatus != ev.m_status)
+            {
+                out.push_back((char)ev.m_status);
+                runningStatus = ev.m_status;
+            }
+            if (length > 1) out.push_back((char)ev.m_data1);
+            if (length > 2) out.push_back((char)ev.m_data2);
+        }
+    }
+
+    // end of track
+    if (m_end_tick < trackTime) return false;
+    writeVariableNum(out, m_end_tick - trackTime);
+    out.push_back((char)0xFF);
+    out.push_back((char)0x2F);
+    out.push_back((char)0x00);
+
+    const unsigned long length = out.size() - chunkStart - 8;
+    out[chunkStart + 4] = (char)((length >> 24) & 0xFF);
+    out[chunkStart + 5] = (char)((length >> 16) & 0xFF);
+    out[chunkStart + 6] = (char)((length >> 8)  & 0xFF);
+    out[chunkStart + 7] = (char)( length        & 0xFF);
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#pragma mark CompactMidiSequence
+#endif
+
+CompactMidiSequence::CompactMidiSequence()
+{
+    m_clks_per_beat = 960;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiSequence::set(const jdksmidi::MIDIMultiTrack& tracks, int numTracks)
+{
+    numTracks = std::min(numTracks, tracks.GetNumTracks());
+
+    m_clks_per_beat = tracks.GetClksPerBeat();
+    m_tracks.clear();
+    m_tracks.resize(numTracks);
+    m_track_outputs.assign(numTracks, 0);
+
+    for (int n=0; n<numTracks; n++)
+    {
+        m_tracks[n].addEvents(*tracks.GetTrack(n));
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiSequence::swapTrack(const int track, CompactMidiTrack& other)
+{
+    m_tracks[track].swap(other);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiSequence::setTrackOutput(const int track, const int output)
+{
+    ASSERT_E(output, >=, 0);
+    ASSERT_E(output, <, 256);
+    m_track_outputs[track] = (unsigned char)output;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+long CompactMidiSequence::getMemoryUsage() const
+{
+    long total = 0;
+    const int trackAmount = m_tracks.size();
+    for (int n=0; n<trackAmount; n++) total += m_tracks[n].getMemoryUsage();
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void CompactMidiSequence::mergeTracks(CompactMidiTrack& out) const
+{
+    out.clear();
+
+    const int trackAmount = m_tracks.size();
+    int eventAmount = 0;
+    for (int n=0; n<trackAmount; n++) eventAmount += m_tracks[n].getEventAmount();
+    out.reserve(eventAmount);
+
+    // there are at most a few dozen tracks, a linear scan for the earliest one is cheaper than a heap.
+    // Like jdksmidi::MIDIMultiTrackIterator, the scan starts after the track the previous event came
+    // from, so that tracks take turns when their events happen at the same tick
+    std::vector<int> positions(trackAmount, 0);
+    int current_track = 0;
+    for (int e=0; e<eventAmount; e++)
+    {
+        int min_track = -1;
+        unsigned int min_tick = 0;
+        for (int j=0; j<trackAmount; j++)
+        {
+            const int n = (j + current_track + 1) % trackAmount;
+            if (positions[n] >= m_tracks[n].getEventAmount()) continue;
+
+            const unsigned int tick = m_tracks[n].getEvent(positions[n]).m_tick;
+            if (min_track == -1 or tick < min_tick)
+            {
+                min_track = n;
+                min_tick  = tick;
+            }
+        }
+        ASSERT(min_track != -1);
+        current_track = min_track;
+
+        const CompactMidiTrack&  track = m_tracks[min_track];
+        const CompactMidiEvent&  ev    = track.getEvent(positions[min_track]++);
+
+        if (not ev.hasPayload())
+        {
+            out.addChannelEvent(ev.m_tick, ev.m_status, ev.m_data1, ev.m_data2, m_track_outputs[min_track]);
+        }
+        else if (ev.isMeta())
+        {
+            out.addMetaEvent(ev.m_tick, track.getPayload(ev).m_meta_type, track.getPayloadData(ev),
+                             track.getPayload(ev).m_length);
+        }
+        else
+        {
+            out.addSysExEvent(ev.m_tick, ev.m_status, track.getPayloadData(ev), track.getPayload(ev).m_length);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+namespace AriaMaestosa
+{
+    /** Serializes each compact track into its own MTrk chunk */
+    class CompactChunkTask : public IParallelTask
+    {
+        const CompactMidiSequence& m_sequence;
+
+    public:
+
+        std::vector< std::vector<char> > m_chunks;
+        std::vector<bool> m_success;
+
+        CompactChunkTask(const CompactMidiSequence& sequence) : m_sequence(sequence)
+        {
+            m_chunks.resize(sequence.getTrackAmount());
+            m_success.resize(sequence.getTrackAmount(), false);
+        }
+
+        virtual void run(const int id)
+        {
+            m_success[id] = m_sequence.getTrack(id).writeChunk(m_chunks[id]);
+        }
+    };
+}
+
+bool CompactMidiSequence::writeMidiBytes(std::vector<char>& out) const
+{
+    const int numTracks = m_tracks.size();
+
+    CompactChunkTask task(*this);
+    Parallel::forEach(numTracks, &task);
+
+    int totalLength = 14;
+    for (int n=0; n<numTracks; n++)
+    {
+        if (not task.m_success[n])
+        {
+            fprintf(stderr, "[CompactMidiSequence] Error writing track %i\n", n);
+            return false;
+        }
+        totalLength += task.m_chunks[n].size();
+    }
+
+    out.clear();
+    out.reserve(totalLength);
+
+    // same header as jdksmidi::MIDIFileWrite::WriteFileHeader
+    const int format = (numTracks > 1 ? 1 : 0);
+    out.push_back('M');
+    out.push_back('T');
+    out.push_back('h');
+    out.push_back('d');
+    writeLong(out, 6);
+    out.push_back((char)((format          >> 8) & 0xFF)); out.push_back((char)(format          & 0xFF));
+    out.push_back((char)((numTracks       >> 8) & 0xFF)); out.push_back((char)(numTracks       & 0xFF));
+    out.push_back((char)((m_clks_per_beat >> 8) & 0xFF)); out.push_back((char)(m_clks_per_beat & 0xFF));
+
+    for (int n=0; n<numTracks; n++)
+    {
+        out.insert(out.end(), task.m_chunks[n].begin(), task.m_chunks[n].end());
+    }
+
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestCompactMidi
+{
+    using namespace AriaMaestosa;
+
+    /** estimate of the memory held by a libjdkmidi sequence : messages, plus their sysex buffers */
+    long getJDKMemoryUsage(const jdksmidi::MIDIMultiTrack& tracks, const int numTracks)
+    {
+        long total = 0;
+        for (int t=0; t<numTracks; t++)
+        {
+            const jdksmidi::MIDITrack* track = tracks.GetTrack(t);
+            const int eventAmount = track->GetNumEvents();
+            total += eventAmount*sizeof(jdksmidi::MIDITimedBigMessage);
+            for (int n=0; n<eventAmount; n++)
+            {
+                const jdksmidi::MIDISystemExclusive* sysex = track->GetEventAddress(n)->GetSysEx();
+                if (sysex != NULL) total += sizeof(jdksmidi::MIDISystemExclusive) + sysex->GetLengthSE();
+            }
+        }
+        return total;
+    }
+
+    UNIT_TEST(TestCompactMidiEvents)
+    {
+        const int TRACK_AMOUNT    = 16;
+        const int NOTES_PER_TRACK = 20000;
+
+        require_e(sizeof(CompactMidiEvent), ==, 8u, "compact events take 8 bytes");
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        const int beat = seq->ticksPerQuarterNote();
+
+        {
+            ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+            tr->setMeasureAmount(NOTES_PER_TRACK/16 + 1); // four notes per beat
+        }
+
+        for (int t=0; t<TRACK_AMOUNT; t++)
+        {
+            Track* track = new Track(seq);
+            {
+                OwnerPtr<Sequence::Import> import(seq->startImport());
+                for (int n=0; n<NOTES_PER_TRACK; n++)
+                {
+                    track->addNote_import(36 + (n*7 + t) % 60, n*beat/4, (n + 1)*beat/4, 100, -1);
+                    track->addControlEvent_import(n*beat/4, (n + t) % 128, (n % 2 ? 7 /* volume */ :
+                                                                            PSEUDO_CONTROLLER_PITCH_BEND));
+                }
+            }
+            track->setName(wxString::Format(wxT("Track %i"), t));
+            seq->addTrack(track);
+        }
+
+        jdksmidi::MIDIMultiTrack tracks;
+        int length = -1, start = -1, numTracks = -1;
+        makeJDKMidiSequence(seq, tracks, false, &length, &start, &numTracks, false);
+
+        // ---- conversion and memory use
+        CompactMidiSequence compact;
+        wxStopWatch convertTime;
+        compact.set(tracks, numTracks);
+        const long convertMs = convertTime.Time();
+
+        require_e(compact.getTrackAmount(), ==, numTracks, "every track was converted");
+
+        int eventAmount = 0;
+        for (int t=0; t<numTracks; t++) eventAmount += compact.getTrack(t).getEventAmount();
+
+        const long jdkBytes     = getJDKMemoryUsage(tracks, numTracks);
+        const long compactBytes = compact.getMemoryUsage();
+        require_e(compactBytes, <, jdkBytes, "compact events use less memory");
+
+        // ---- export : same bytes as libjdkmidi
+        MidiToMemoryStream expectedStream;
+        jdksmidi::MIDIFileWriteMultiTrack writer(&tracks, &expectedStream);
+        require(writer.Write(numTracks, beat), "libjdkmidi can write the sequence");
+        const std::vector<char>& expected = expectedStream.getData();
+
+        std::vector<char> bytes;
+        wxStopWatch writeTime;
+        require(compact.writeMidiBytes(bytes), "the compact sequence can be written");
+        const long writeMs = writeTime.Time();
+
+        require_e(bytes.size(), ==, expected.size(), "the compact writer produces a file of the same size");
+        require(bytes == expected, "the compact writer produces the same bytes as libjdkmidi");
+
+        // ---- playback : same channel events, in the same order, as jdksmidi::MIDISequencer
+        CompactMidiTrack stream;
+        compact.mergeTracks(stream);
+        require_e(stream.getEventAmount(), ==, eventAmount, "merging keeps all events");
+
+        // the dispatch below mimics AriaSequenceTimer::run, without sending anything
+        const int PASSES = 5;
+
+        jdksmidi::MIDISequencer sequencer(&tracks);
+        long jdkChecksum = 0;
+        int  jdkEvents   = 0;
+        bool sameOrder   = true;
+        wxStopWatch jdkTime;
+        for (int pass=0; pass<PASSES; pass++)
+        {
+            sequencer.GoToTimeMs(0);
+
+            int streamPos = 0;
+            int track;
+            jdksmidi::MIDITimedBigMessage ev;
+            while (sequencer.GetNextEvent(&track, &ev))
+            {
+                if (ev.IsNoteOn())             jdkChecksum += ev.GetNote() + ev.GetVelocity();
+                else if (ev.IsNoteOff())       jdkChecksum += ev.GetNote();
+                else if (ev.IsControlChange()) jdkChecksum += ev.GetController() + ev.GetControllerValue();
+                else if (ev.IsPitchBend())     jdkChecksum += ev.GetBenderValue();
+                else if (ev.IsProgramChange()) jdkChecksum += ev.GetPGValue();
+                else if (ev.IsTempo())         jdkChecksum += ev.GetTempo32()/32;
+                else continue;
+
+                if (pass > 0) continue;
+                jdkEvents++;
+
+                // compare with the next compact event that would be dispatched as well
+                while (streamPos < stream.getEventAmount() and stream.getEvent(streamPos).hasPayload() and
+                       not stream.isTempo(stream.getEvent(streamPos)))
+                {
+                    streamPos++;
+                }
+                if (streamPos >= stream.getEventAmount()) { sameOrder = false; continue; }
+
+                const CompactMidiEvent& compactEv = stream.getEvent(streamPos++);
+                if (compactEv.m_tick != ev.GetTime() or
+                    (not compactEv.hasPayload() and (compactEv.m_status != ev.GetStatus() or
+                                                     compactEv.m_data1  != ev.GetByte1()  or
+                                                     compactEv.m_data2  != ev.GetByte2())))
+                {
+                    sameOrder = false;
+                }
+            }
+        }
+        const long jdkMs = jdkTime.Time();
+
+        long compactChecksum = 0;
+        int  compactEvents   = 0;
+        wxStopWatch compactTime;
+        for (int pass=0; pass<PASSES; pass++)
+        {
+            const int amount = stream.getEventAmount();
+            for (int n=0; n<amount; n++)
+            {
+                const CompactMidiEvent& ev = stream.getEvent(n);
+                switch (ev.getType())
+                {
+                    case 0x90: compactChecksum += ev.m_data1 + ev.m_data2; break;
+                    case 0x80: compactChecksum += ev.m_data1; break;
+                    case 0xB0: compactChecksum += ev.m_data1 + ev.m_data2; break;
+                    case 0xE0: compactChecksum += ev.getBenderValue(); break;
+                    case 0xC0: compactChecksum += ev.m_data1; break;
+                    case 0xF0:
+                        if (stream.isTempo(ev)) compactChecksum += stream.getTempo32(ev)/32;
+                        else continue;
+                        break;
+                    default: continue;
+                }
+                if (pass == 0) compactEvents++;
+            }
+        }
+        const long compactMs = compactTime.Time();
+
+        require(sameOrder, "the merged stream plays the same events in the same order as the libjdkmidi sequencer");
+        require_e(compactEvents, ==, jdkEvents, "the same amount of events is played");
+        require_e(compactChecksum, ==, jdkChecksum, "the same events are played");
+
+        std::cout << "[CompactMidi] " << eventAmount << " events : " << jdkBytes << " bytes with libjdkmidi vs "
+                  << compactBytes << " bytes compact (" << (jdkBytes / (float)compactBytes)
+                  << "x less), converted in " << convertMs << " ms, written in " << writeMs << " ms; playback "
+                  << (jdkMs > 0 ? (long)(jdkEvents*(float)PASSES / (jdkMs/1000.0f)) : -1)
+                  << " events/s through MIDISequencer vs "
+                  << (compactMs > 0 ? (long)(compactEvents*(float)PASSES / (compactMs/1000.0f)) : -1)
+                  << " events/s through the merged stream" << std::endl;
+
+        delete seq;
+    }
+}
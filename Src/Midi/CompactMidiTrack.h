@@ -0,0 +1,227 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __COMPACT_MIDI_TRACK_H__
+#define __COMPACT_MIDI_TRACK_H__
+
+#include <vector>
+
+namespace jdksmidi
+{
+    class MIDIMultiTrack;
+    class MIDITimedBigMessage;
+    class MIDITrack;
+}
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief a MIDI event, in 8 bytes
+      *
+      * Channel messages are held entirely in the event. Meta events (status 0xFF) and system
+      * exclusive events (status 0xF0 or 0xF7) keep their data out of line, in the arena of the
+      * track they belong to; their three data bytes then hold the index of that payload.
+      *
+      * @ingroup midi
+      */
+    struct CompactMidiEvent
+    {
+        unsigned int  m_tick;
+        unsigned char m_status;
+        unsigned char m_data1;
+        unsigned char m_data2;
+
+        /**
+          * holds the high byte of a payload index; in a playback stream (see CompactMidiSequence::mergeTracks),
+          * channel events keep the output they are routed to here instead
+          */
+        unsigned char m_extra;
+
+        bool hasPayload() const { return m_status == 0xFF or m_status == 0xF0 or m_status == 0xF7; }
+        bool isMeta()     const { return m_status == 0xFF; }
+
+        int getType()    const { return m_status & 0xF0; }
+        int getChannel() const { return m_status & 0x0F; }
+
+        int getPayloadIndex() const { return m_data1 | (m_data2 << 8) | (m_extra << 16); }
+
+        /** @return the output a channel event of a playback stream is routed to, 0 being the default output */
+        int getOutput() const { return m_extra; }
+
+        /** @return the signed 14 bit value of a pitch bend event */
+        int getBenderValue() const { return ((m_data2 << 7) | m_data1) - 8192; }
+
+        /** @return the number of bytes of a channel or system common message, status included */
+        int getMessageLength() const;
+    };
+
+    /**
+      * @brief a flat, time-ordered list of compact MIDI events, along with the arena holding the
+      *        data of its meta and system exclusive events
+      *
+      * Used for playback (where all tracks of a song are merged into a single stream, see
+      * CompactMidiSequence::mergeTracks) and for writing standard MIDI files.
+      *
+      * @ingroup midi
+      */
+    class CompactMidiTrack
+    {
+    public:
+
+        /** location of the data of a meta or system exclusive event in the arena */
+        struct Payload
+        {
+            unsigned int  m_offset;
+            unsigned int  m_length;
+
+            /** meta event type, unused for system exclusive events */
+            unsigned char m_meta_type;
+        };
+
+    private:
+
+        std::vector<CompactMidiEvent> m_events;
+        std::vector<Payload>          m_payloads;
+        std::vector<unsigned char>    m_arena;
+
+        /** tick at which the track ends (written with the end-of-track meta event) */
+        unsigned int m_end_tick;
+
+        /** number of outputs the channel events of this track are routed to */
+        int m_output_amount;
+
+        void addPayloadEvent(const unsigned int tick, const unsigned char status, const unsigned char metaType,
+                             const unsigned char* data, const int length);
+
+    public:
+
+        CompactMidiTrack();
+
+        void clear();
+        void reserve(const int eventAmount);
+
+        /** @brief exchanges the contents of two tracks, without copying their events */
+        void swap(CompactMidiTrack& other);
+
+        /** @param output  output the event is routed to during playback (see CompactMidiEvent::getOutput) */
+        void addChannelEvent(const unsigned int tick, const unsigned char status,
+                             const unsigned char data1, const unsigned char data2,
+                             const unsigned char output = 0);
+        void addMetaEvent(const unsigned int tick, const unsigned char type,
+                          const unsigned char* data, const int length);
+        void addSysExEvent(const unsigned int tick, const unsigned char status,
+                           const unsigned char* data, const int length);
+
+        /**
+          * @brief appends an event of libjdkmidi
+          * @return false if the event has no SMF representation (e.g. NoOp events) and was skipped
+          */
+        bool addEvent(const jdksmidi::MIDITimedBigMessage& msg);
+
+        /** @brief appends all events of a libjdkmidi track, up to its end-of-track event */
+        void addEvents(const jdksmidi::MIDITrack& track);
+
+        int getEventAmount() const { return m_events.size(); }
+        const CompactMidiEvent& getEvent(const int id) const { return m_events[id]; }
+        const std::vector<CompactMidiEvent>& getEvents() const { return m_events; }
+
+        const Payload& getPayload(const CompactMidiEvent& event) const
+        {
+            return m_payloads[event.getPayloadIndex()];
+        }
+        const unsigned char* getPayloadData(const CompactMidiEvent& event) const;
+
+        /** @return the meta type of the given event, or -1 if it is not a meta event */
+        int getMetaType(const CompactMidiEvent& event) const
+        {
+            return (event.isMeta() ? getPayload(event).m_meta_type : -1);
+        }
+
+        bool isTempo(const CompactMidiEvent& event) const { return getMetaType(event) == 0x51; }
+
+        /** @return the tempo of a tempo meta event, in 1/32 bpm (same as jdksmidi's GetTempo32) */
+        unsigned long getTempo32(const CompactMidiEvent& event) const;
+
+        unsigned int getEndTick() const { return m_end_tick; }
+
+        /** @return 1 + the highest output a channel event of this track is routed to */
+        int getOutputAmount() const { return m_output_amount; }
+
+        /** @return the number of bytes held by the events, payload table and arena of this track */
+        long getMemoryUsage() const;
+
+        /**
+          * @brief appends this track, as a MTrk chunk (with running status), to 'out'
+          * @return false if the events of the track are not in time order
+          */
+        bool writeChunk(std::vector<char>& out) const;
+    };
+
+    /**
+      * @brief the compact tracks of a song, as generated for playback or export
+      * @ingroup midi
+      */
+    class CompactMidiSequence
+    {
+        std::vector<CompactMidiTrack> m_tracks;
+        int m_clks_per_beat;
+
+        /** output each track is played on (see setTrackOutput) */
+        std::vector<unsigned char> m_track_outputs;
+
+    public:
+
+        CompactMidiSequence();
+
+        /** @brief replaces the contents of this sequence with the first 'numTracks' tracks of 'tracks' */
+        void set(const jdksmidi::MIDIMultiTrack& tracks, int numTracks);
+
+        int getTrackAmount() const { return m_tracks.size(); }
+        const CompactMidiTrack& getTrack(const int id) const { return m_tracks[id]; }
+        int getClksPerBeat() const { return m_clks_per_beat; }
+
+        /** @brief exchanges a track of this sequence with 'other', e.g. to take it out without copying it */
+        void swapTrack(const int track, CompactMidiTrack& other);
+
+        /**
+          * @brief routes the channel events of a track to the given output when playing
+          * @param output  index in the list of outputs given by getTrackOutputs (0 is the default output)
+          */
+        void setTrackOutput(const int track, const int output);
+        int  getTrackOutput(const int track) const { return m_track_outputs[track]; }
+
+        long getMemoryUsage() const;
+
+        /**
+          * @brief merges the events of all tracks in a single time-ordered stream, for playback
+          *
+          * Events happening at the same tick are interleaved between tracks like jdksmidi::MIDISequencer does.
+          * Channel events are tagged with the output of their track (see setTrackOutput).
+          */
+        void mergeTracks(CompactMidiTrack& out) const;
+
+        /**
+          * @brief serializes the sequence as a standard MIDI file
+          * @return false if a track could not be written (e.g. its events are out of order)
+          */
+        bool writeMidiBytes(std::vector<char>& out) const;
+    };
+
+}
+
+#endif
@@ -57,7 +57,7 @@ namespace AriaMaestosa
         wxFloat64 m_value;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(ControllerEvent);
         
         /** 
           * @param controller MIDI ID of the controller
@@ -45,7 +45,7 @@ namespace AriaMaestosa
         void updateLabel();
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MagneticGrid);
         
         MagneticGrid();
         virtual ~MagneticGrid();
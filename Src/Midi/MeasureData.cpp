@@ -32,6 +32,7 @@ MeasureData::MeasureData(Sequence* seq, int measureAmount)
 {
     m_something_selected = false;
     m_selected_time_sig  = 0;
+    m_revision           = 0;
     m_measure_amount     = measureAmount;
     m_first_measure      = 0;
     m_loop_end_measure   = 0;
@@ -90,6 +91,7 @@ void MeasureData::setMeasureAmount(int measureAmount)
 void MeasureData::setFirstMeasure(int firstMeasureID)
 {
     m_first_measure = firstMeasureID;
+    m_revision++;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -405,6 +407,8 @@ void MeasureData::eraseTimeSig(int id)
 
 int MeasureData::addTimeSigChange(int measure, int num, int denom) // -1 means "same as previous event"
 {
+    m_revision++;
+    
     const int timeSig_amount_minus_one = m_time_sig_changes.size()-1;
 
     // if there are no events, just add it. otherwise, add in time order.
@@ -502,6 +506,8 @@ void MeasureData::updateVector(int newSize)
 
 void MeasureData::updateMeasureInfo()
 {
+    m_revision++;
+    
     const int amount = m_measure_info.size();
     //const float zoom = sequence->getZoom();
     
@@ -661,6 +667,7 @@ void MeasureData::afterImporting()
         m_expanded_mode = false;
     }
     if (not isMeasureLengthConstant()) updateMeasureInfo();
+    m_revision++;
 }
 
 // ----------------------------------------------------------------------------------------------------------
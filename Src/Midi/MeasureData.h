@@ -93,6 +93,9 @@ namespace AriaMaestosa
         bool m_something_selected;
         int  m_selected_time_sig;
         
+        /** incremented whenever measures or time signatures may have changed, see 'getRevision' */
+        int  m_revision;
+        
         // Only access this in expanded mode otherwise they're empty
         int totalNeededLengthInTicks;
         //int totalNeededLengthInPixels;
@@ -266,7 +269,7 @@ namespace AriaMaestosa
         };
         
         
-        LEAK_CHECK();
+        LEAK_CHECK(MeasureData);
                 
         MeasureData(Sequence* seq, int measureAmount);
         ~MeasureData();
@@ -298,6 +301,12 @@ namespace AriaMaestosa
         /** @return the amount of time signature events */
         int   getTimeSigAmount() const { return m_time_sig_changes.size(); }
         
+        /**
+          * @return a number that changes whenever measures or time signatures may have changed. Views
+          *         that cache drawing derived from measures compare it to know when to redraw.
+          */
+        int   getRevision() const { return m_revision; }
+        
         const TimeSigChange& getTimeSig(int id)
         {
             ASSERT_E(id,>=,0);
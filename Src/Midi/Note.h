@@ -158,9 +158,13 @@ namespace AriaMaestosa
         short string, fret;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(Note);
         
 
+        /**
+          * @brief sets the selection flag only; notes that are part of a track are selected through
+          *        Track::setNoteSelected or Track::selectNote, so that the track knows about it
+          */
         void setSelected(const bool selected);
         bool isSelected() const { return m_selected; }
         
@@ -0,0 +1,311 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Midi/NoteIndex.h"
+
+#include "AriaCore.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <iostream>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    /** average amount of notes per time bucket */
+    const int NOTES_PER_BUCKET = 8;
+
+    /** pitch IDs are grouped by octave; pitch IDs range from 0 to 131 */
+    const int PITCH_BIN_SIZE  = 12;
+    const int PITCH_BIN_COUNT = 11;
+
+    int getPitchBin(const int pitchID)
+    {
+        return std::max(0, std::min(PITCH_BIN_COUNT - 1, pitchID / PITCH_BIN_SIZE));
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+NoteIndex::NoteIndex(const Track* track)
+{
+    m_track        = track;
+    m_revision     = -1;
+    m_valid        = false;
+    m_bucket_ticks = 1;
+    m_bucket_count = 0;
+    m_tree_leaves  = 0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteIndex::build()
+{
+    m_ids.clear();
+    m_bin_offsets.clear();
+    m_max_end.clear();
+    m_bucket_count = 0;
+    m_tree_leaves  = 0;
+
+    const int noteAmount = m_track->getNoteAmount();
+    if (noteAmount == 0) return;
+
+    int last_start = 0;
+    for (int n=0; n<noteAmount; n++)
+    {
+        last_start = std::max(last_start, m_track->getNoteStartInMidiTicks(n));
+    }
+
+    m_bucket_count = std::max(1, noteAmount / NOTES_PER_BUCKET);
+    m_bucket_ticks = last_start / m_bucket_count + 1;
+
+    // ---- counting sort of the notes into (bucket, pitch bin) groups
+    std::vector<int> group(noteAmount);
+    m_bin_offsets.assign(m_bucket_count*PITCH_BIN_COUNT + 1, 0);
+
+    m_tree_leaves = 1;
+    while (m_tree_leaves < m_bucket_count) m_tree_leaves *= 2;
+    m_max_end.assign(m_tree_leaves*2, -1);
+
+    for (int n=0; n<noteAmount; n++)
+    {
+        const int bucket = std::min(m_bucket_count - 1, m_track->getNoteStartInMidiTicks(n) / m_bucket_ticks);
+        group[n] = bucket*PITCH_BIN_COUNT + getPitchBin(m_track->getNotePitchID(n));
+        m_bin_offsets[group[n] + 1]++;
+
+        int& leaf = m_max_end[m_tree_leaves + bucket];
+        leaf = std::max(leaf, m_track->getNoteEndInMidiTicks(n));
+    }
+
+    for (unsigned int g=1; g<m_bin_offsets.size(); g++)
+    {
+        m_bin_offsets[g] += m_bin_offsets[g-1];
+    }
+
+    // filling in note order keeps IDs increasing within each group
+    m_ids.resize(noteAmount);
+    std::vector<int> fill(m_bin_offsets.begin(), m_bin_offsets.end() - 1);
+    for (int n=0; n<noteAmount; n++)
+    {
+        m_ids[ fill[group[n]]++ ] = n;
+    }
+
+    for (int node=m_tree_leaves-1; node>0; node--)
+    {
+        m_max_end[node] = std::max(m_max_end[node*2], m_max_end[node*2 + 1]);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteIndex::collect(const int node, const int node_from, const int node_to, const int last_bucket,
+                        const int tick_from, const int tick_to, const int bin_from, const int bin_to,
+                        const int pitch_from, const int pitch_to, std::vector<int>& out) const
+{
+    // buckets are ordered by note start; skip those starting too late, and those whose notes all
+    // end before the queried range
+    if (node_from > last_bucket or m_max_end[node] < tick_from) return;
+
+    if (node_from == node_to)
+    {
+        for (int bin=bin_from; bin<=bin_to; bin++)
+        {
+            const int group = node_from*PITCH_BIN_COUNT + bin;
+            const int to    = m_bin_offsets[group + 1];
+            for (int i=m_bin_offsets[group]; i<to; i++)
+            {
+                const int id    = m_ids[i];
+                const int pitch = m_track->getNotePitchID(id);
+                if (m_track->getNoteStartInMidiTicks(id) <= tick_to and
+                    m_track->getNoteEndInMidiTicks(id)   >= tick_from and
+                    pitch >= pitch_from and pitch <= pitch_to)
+                {
+                    out.push_back(id);
+                }
+            }
+        }
+        return;
+    }
+
+    const int middle = (node_from + node_to)/2;
+    collect(node*2,     node_from,  middle,  last_bucket, tick_from, tick_to, bin_from, bin_to,
+            pitch_from, pitch_to, out);
+    collect(node*2 + 1, middle + 1, node_to, last_bucket, tick_from, tick_to, bin_from, bin_to,
+            pitch_from, pitch_to, out);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteIndex::findNotes(const int tick_from, const int tick_to, const int pitch_from, const int pitch_to,
+                          std::vector<int>& out)
+{
+    const int revision = m_track->getSequence()->getEventsRevision();
+    if (not m_valid or revision != m_revision)
+    {
+        build();
+        m_valid    = true;
+        m_revision = revision;
+    }
+
+    if (m_bucket_count == 0 or tick_to < tick_from or pitch_to < pitch_from or tick_to < 0) return;
+
+    const int last_bucket = std::min(m_bucket_count - 1, tick_to / m_bucket_ticks);
+    const int first_found = out.size();
+
+    collect(1, 0, m_tree_leaves - 1, last_bucket, tick_from, tick_to,
+            getPitchBin(pitch_from), getPitchBin(pitch_to), pitch_from, pitch_to, out);
+
+    // groups of several pitch bins are visited one after the other within a bucket
+    std::sort(out.begin() + first_found, out.end());
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestNoteIndex
+{
+    using namespace AriaMaestosa;
+
+    /** simple deterministic generator, so that the test is reproducible */
+    int nextRandom(unsigned int& seed, const int max)
+    {
+        seed = seed*1103515245 + 12345;
+        return (seed >> 16) % max;
+    }
+
+    void findNotesLinear(const Track* t, const int tick_from, const int tick_to,
+                         const int pitch_from, const int pitch_to, std::vector<int>& out)
+    {
+        const int noteAmount = t->getNoteAmount();
+        for (int n=0; n<noteAmount; n++)
+        {
+            const int pitch = t->getNotePitchID(n);
+            if (t->getNoteStartInMidiTicks(n) <= tick_to and t->getNoteEndInMidiTicks(n) >= tick_from and
+                pitch >= pitch_from and pitch <= pitch_to)
+            {
+                out.push_back(n);
+            }
+        }
+    }
+
+    UNIT_TEST(TestHitTestingLatency)
+    {
+        const int NOTE_AMOUNT  = 100000;
+        const int QUERY_AMOUNT = 1000;
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        const int beat = seq->ticksPerQuarterNote();
+
+        unsigned int seed = 42;
+
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<NOTE_AMOUNT; n++)
+            {
+                // four notes per beat, mostly short, with a few very long held notes
+                const int start  = (n/4)*beat + nextRandom(seed, beat);
+                const int length = (n % 1000 == 0 ? beat*400 : beat/4 + nextRandom(seed, beat*2));
+                t->addNote_import(20 + nextRandom(seed, 90), start, start + length, 80, -1);
+            }
+        }
+        seq->addTrack(t);
+
+        const int song_length = (NOTE_AMOUNT/4)*beat;
+
+        std::vector<int> found;
+        std::vector<int> expected;
+
+        // ---- check results against a linear scan
+        for (int q=0; q<200; q++)
+        {
+            const int tick  = nextRandom(seed, song_length);
+            const int pitch = 20 + nextRandom(seed, 90);
+            const int width = (q % 2 == 0 ? 0 : nextRandom(seed, beat*32));
+            const int range = (q % 2 == 0 ? 0 : nextRandom(seed, 36));
+
+            found.clear();
+            expected.clear();
+            t->getNoteIndex().findNotes(tick, tick + width, pitch, pitch + range, found);
+            findNotesLinear(t, tick, tick + width, pitch, pitch + range, expected);
+
+            require_e(found.size(), ==, expected.size(), "the index finds the same notes as a linear scan");
+            require(found == expected, "the index finds the same notes as a linear scan, in note order");
+        }
+
+        // ---- the index is rebuilt after an edit
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            t->addNote_import(5, song_length + beat, song_length + beat*2, 80, -1);
+        }
+        found.clear();
+        t->getNoteIndex().findNotes(song_length + beat, song_length + beat, 5, 5, found);
+        require_e(found.size(), ==, 1u, "notes added after the index was built are found");
+
+        // ---- latency of clicks (point queries) and drag-selections (rectangle queries)
+        for (int rect=0; rect<2; rect++)
+        {
+            std::vector<int> ticks, pitches;
+            for (int q=0; q<QUERY_AMOUNT; q++)
+            {
+                ticks.push_back(nextRandom(seed, song_length));
+                pitches.push_back(20 + nextRandom(seed, 90));
+            }
+
+            // a drag-selection covers 8 measures and two octaves
+            const int width = (rect ? beat*32 : 0);
+            const int range = (rect ? 24 : 0);
+
+            int found_amount = 0;
+
+            // indexed queries are too fast to time individually with millisecond precision
+            const int INDEX_PASSES = 100;
+
+            wxStopWatch indexTime;
+            for (int pass=0; pass<INDEX_PASSES; pass++)
+            {
+                for (int q=0; q<QUERY_AMOUNT; q++)
+                {
+                    found.clear();
+                    t->getNoteIndex().findNotes(ticks[q], ticks[q] + width, pitches[q], pitches[q] + range,
+                                                found);
+                    if (pass == 0) found_amount += found.size();
+                }
+            }
+            const long indexMs = indexTime.Time();
+
+            wxStopWatch linearTime;
+            for (int q=0; q<QUERY_AMOUNT; q++)
+            {
+                expected.clear();
+                findNotesLinear(t, ticks[q], ticks[q] + width, pitches[q], pitches[q] + range, expected);
+            }
+            const long linearMs = linearTime.Time();
+
+            std::cout << "[NoteIndex] " << (rect ? "drag-select" : "click") << " on " << NOTE_AMOUNT
+                      << " notes : " << (indexMs*1000.0f / (QUERY_AMOUNT*INDEX_PASSES)) << " us per query with the index, "
+                      << (linearMs*1000.0f / QUERY_AMOUNT) << " us with a linear scan ("
+                      << (found_amount / (float)QUERY_AMOUNT) << " notes found on average)" << std::endl;
+        }
+
+        delete seq;
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __NOTE_INDEX_H__
+#define __NOTE_INDEX_H__
+
+#include "Utils.h"
+
+#include <vector>
+
+namespace AriaMaestosa
+{
+
+    class Track;
+
+    /**
+      * @brief 2D (tick x pitch) index over the notes of a track, used for hit-testing and selection
+      *
+      * Notes are grouped in time buckets (by note start), and within each bucket in pitch bins of
+      * one octave. A max-tree over the buckets keeps the latest note end of each range of buckets,
+      * so that a query only visits the buckets that can hold a note overlapping the queried time
+      * range, even in the presence of long notes.
+      *
+      * The index is rebuilt lazily : the track invalidates it whenever notes are added, removed or
+      * reordered, and it is also dropped when the events revision of the sequence changes.
+      *
+      * @ingroup midi
+      */
+    class NoteIndex
+    {
+        const Track* m_track;
+
+        /** events revision of the sequence the index was built against */
+        int m_revision;
+
+        bool m_valid;
+
+        int m_bucket_ticks;
+        int m_bucket_count;
+
+        /** note IDs, grouped by bucket then by pitch bin, in increasing order within each group */
+        std::vector<int> m_ids;
+
+        /** start of each (bucket, pitch bin) group in 'm_ids'; has one more entry for the end */
+        std::vector<int> m_bin_offsets;
+
+        /** max-tree (heap layout) holding the latest note end within each range of buckets */
+        std::vector<int> m_max_end;
+        int m_tree_leaves;
+
+        void build();
+
+        void collect(const int node, const int node_from, const int node_to, const int last_bucket,
+                     const int tick_from, const int tick_to, const int bin_from, const int bin_to,
+                     const int pitch_from, const int pitch_to, std::vector<int>& out) const;
+
+    public:
+
+        LEAK_CHECK(NoteIndex);
+
+        NoteIndex(const Track* track);
+
+        /** Called by the track when its notes were added, removed or reordered */
+        void invalidate() { m_valid = false; }
+
+        /** @return the bytes allocated for the index (the index keeps them until the next rebuild) */
+        long long getMemoryBytes() const
+        {
+            return (long long)(m_ids.capacity() + m_bin_offsets.capacity() + m_max_end.capacity())*sizeof(int);
+        }
+
+        /**
+          * Find the notes overlapping the given area (bounds are inclusive; a note overlaps when it
+          * starts at or before 'tick_to' and ends at or after 'tick_from').
+          *
+          * @param[out] out receives the IDs of matching notes, in increasing order. It is not cleared
+          *                 first.
+          */
+        void findNotes(const int tick_from, const int tick_to, const int pitch_from, const int pitch_to,
+                       std::vector<int>& out);
+
+        /** Find the notes overlapping the given time range, whatever their pitch */
+        void findNotes(const int tick_from, const int tick_to, std::vector<int>& out)
+        {
+            findNotes(tick_from, tick_to, 0, 131, out);
+        }
+    };
+
+}
+
+#endif
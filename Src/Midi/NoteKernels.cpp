@@ -0,0 +1,740 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Midi/NoteKernels.h"
+
+#include "AriaCore.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "UnitTest.h"
+
+#include <iostream>
+#include <wx/stopwatch.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define NOTE_KERNELS_SSE2 1
+#endif
+
+// AVX2 variants are compiled for their own target, and only called when the CPU supports them
+#if defined(NOTE_KERNELS_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define NOTE_KERNELS_AVX2 1
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    namespace NoteKernels
+    {
+        /** the instruction set in use, or -1 before it is detected */
+        int g_instruction_set = -1;
+
+        InstructionSet detectInstructionSet()
+        {
+#ifdef NOTE_KERNELS_AVX2
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return AVX2;
+#endif
+#ifdef NOTE_KERNELS_SSE2
+            return SSE2;
+#else
+            return SCALAR;
+#endif
+        }
+
+        // ------------------------------------------------------------------------------------------------------
+        // Scalar variants, which also process what remains after the last full vector
+
+        void addScalar(int* values, const int count, const int delta)
+        {
+            for (int n=0; n<count; n++) values[n] += delta;
+        }
+
+        void addClampedScalar(int* values, const int count, const int delta, const int min, const int max)
+        {
+            for (int n=0; n<count; n++)
+            {
+                int value = values[n] + delta;
+                if (value < min) value = min;
+                if (value > max) value = max;
+                values[n] = value;
+            }
+        }
+
+        void fillScalar(int* values, const int count, const int value)
+        {
+            for (int n=0; n<count; n++) values[n] = value;
+        }
+
+        void scaleScalar(int* values, const int count, const float factor, const int origin)
+        {
+            for (int n=0; n<count; n++)
+            {
+                values[n] = (int)( (values[n] - origin)*factor + origin );
+            }
+        }
+
+        void snapToGridScalar(int* values, const int count, const int origin, const float gridLength,
+                              const bool ceil)
+        {
+            for (int n=0; n<count; n++)
+            {
+                const float steps = (float)(values[n] - origin)/gridLength;
+
+                // same as round() or ceil(), in a way that the vector variants can reproduce exactly
+                int rounded = (int)steps;
+                const float remainder = steps - (float)rounded;
+                if (ceil)
+                {
+                    if (remainder > 0.0f) rounded++;
+                }
+                else
+                {
+                    if      (remainder >=  0.5f) rounded++;
+                    else if (remainder <= -0.5f) rounded--;
+                }
+
+                values[n] = origin + (int)(rounded*(double)gridLength);
+            }
+        }
+
+        void shiftAfterScalar(int* ticks, int* endTicks, const int count, const int afterTick, const int delta)
+        {
+            for (int n=0; n<count; n++)
+            {
+                if (ticks[n] > afterTick)
+                {
+                    ticks[n] += delta;
+                    if (endTicks != NULL) endTicks[n] += delta;
+                }
+            }
+        }
+
+        int getMaxScalar(const int* values, const int count, const int initial)
+        {
+            int max = initial;
+            for (int n=0; n<count; n++)
+            {
+                if (values[n] > max) max = values[n];
+            }
+            return max;
+        }
+
+        // ------------------------------------------------------------------------------------------------------
+
+#ifdef NOTE_KERNELS_SSE2
+
+        /** @return a where mask is set, b elsewhere */
+        inline __m128i selectSSE2(const __m128i mask, const __m128i a, const __m128i b)
+        {
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+
+        void addSSE2(int* values, const int count, const int delta)
+        {
+            const __m128i deltas = _mm_set1_epi32(delta);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                __m128i* address = (__m128i*)(values + n);
+                _mm_storeu_si128(address, _mm_add_epi32(_mm_loadu_si128(address), deltas));
+            }
+            addScalar(values + n, count - n, delta);
+        }
+
+        void addClampedSSE2(int* values, const int count, const int delta, const int min, const int max)
+        {
+            const __m128i deltas = _mm_set1_epi32(delta);
+            const __m128i mins   = _mm_set1_epi32(min);
+            const __m128i maxs   = _mm_set1_epi32(max);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                __m128i* address = (__m128i*)(values + n);
+                __m128i v = _mm_add_epi32(_mm_loadu_si128(address), deltas);
+                v = selectSSE2(_mm_cmplt_epi32(v, mins), mins, v);
+                v = selectSSE2(_mm_cmpgt_epi32(v, maxs), maxs, v);
+                _mm_storeu_si128(address, v);
+            }
+            addClampedScalar(values + n, count - n, delta, min, max);
+        }
+
+        void fillSSE2(int* values, const int count, const int value)
+        {
+            const __m128i v = _mm_set1_epi32(value);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                _mm_storeu_si128((__m128i*)(values + n), v);
+            }
+            fillScalar(values + n, count - n, value);
+        }
+
+        void scaleSSE2(int* values, const int count, const float factor, const int origin)
+        {
+            const __m128i origins      = _mm_set1_epi32(origin);
+            const __m128  floatOrigins = _mm_cvtepi32_ps(origins);
+            const __m128  factors      = _mm_set1_ps(factor);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                __m128i* address = (__m128i*)(values + n);
+                const __m128 relative = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128(address), origins));
+                const __m128 scaled   = _mm_add_ps(_mm_mul_ps(relative, factors), floatOrigins);
+                _mm_storeu_si128(address, _mm_cvttps_epi32(scaled));
+            }
+            scaleScalar(values + n, count - n, factor, origin);
+        }
+
+        void snapToGridSSE2(int* values, const int count, const int origin, const float gridLength,
+                            const bool ceil)
+        {
+            const __m128i origins = _mm_set1_epi32(origin);
+            const __m128  lengths = _mm_set1_ps(gridLength);
+            const __m128d doubleLengths = _mm_set1_pd(gridLength);
+            const __m128  zeros   = _mm_setzero_ps();
+            const __m128  halves  = _mm_set1_ps(0.5f);
+            const __m128  minusHalves = _mm_set1_ps(-0.5f);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                __m128i* address = (__m128i*)(values + n);
+                const __m128 steps = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_loadu_si128(address), origins)),
+                                                lengths);
+
+                // masks are -1 where set, so subtracting them adds one
+                __m128i rounded = _mm_cvttps_epi32(steps);
+                const __m128 remainder = _mm_sub_ps(steps, _mm_cvtepi32_ps(rounded));
+                if (ceil)
+                {
+                    rounded = _mm_sub_epi32(rounded, _mm_castps_si128(_mm_cmpgt_ps(remainder, zeros)));
+                }
+                else
+                {
+                    rounded = _mm_sub_epi32(rounded, _mm_castps_si128(_mm_cmpge_ps(remainder, halves)));
+                    rounded = _mm_add_epi32(rounded, _mm_castps_si128(_mm_cmple_ps(remainder, minusHalves)));
+                }
+
+                const __m128d low  = _mm_mul_pd(_mm_cvtepi32_pd(rounded), doubleLengths);
+                const __m128d high = _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(rounded, _MM_SHUFFLE(1,0,3,2))),
+                                                doubleLengths);
+                const __m128i snapped = _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+                _mm_storeu_si128(address, _mm_add_epi32(snapped, origins));
+            }
+            snapToGridScalar(values + n, count - n, origin, gridLength, ceil);
+        }
+
+        void shiftAfterSSE2(int* ticks, int* endTicks, const int count, const int afterTick, const int delta)
+        {
+            const __m128i afters = _mm_set1_epi32(afterTick);
+            const __m128i deltas = _mm_set1_epi32(delta);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                __m128i* address = (__m128i*)(ticks + n);
+                const __m128i v = _mm_loadu_si128(address);
+                const __m128i shift = _mm_and_si128(_mm_cmpgt_epi32(v, afters), deltas);
+                _mm_storeu_si128(address, _mm_add_epi32(v, shift));
+                if (endTicks != NULL)
+                {
+                    __m128i* endAddress = (__m128i*)(endTicks + n);
+                    _mm_storeu_si128(endAddress, _mm_add_epi32(_mm_loadu_si128(endAddress), shift));
+                }
+            }
+            shiftAfterScalar(ticks + n, (endTicks == NULL ? NULL : endTicks + n), count - n, afterTick, delta);
+        }
+
+        int getMaxSSE2(const int* values, const int count, const int initial)
+        {
+            __m128i maxs = _mm_set1_epi32(initial);
+            int n = 0;
+            for (; n + 4 <= count; n += 4)
+            {
+                const __m128i v = _mm_loadu_si128((const __m128i*)(values + n));
+                maxs = selectSSE2(_mm_cmpgt_epi32(v, maxs), v, maxs);
+            }
+
+            int lanes[4];
+            _mm_storeu_si128((__m128i*)lanes, maxs);
+            return getMaxScalar(values + n, count - n, getMaxScalar(lanes, 4, initial));
+        }
+
+#endif
+
+        // ------------------------------------------------------------------------------------------------------
+
+#ifdef NOTE_KERNELS_AVX2
+
+        TARGET_AVX2 void addAVX2(int* values, const int count, const int delta)
+        {
+            const __m256i deltas = _mm256_set1_epi32(delta);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                __m256i* address = (__m256i*)(values + n);
+                _mm256_storeu_si256(address, _mm256_add_epi32(_mm256_loadu_si256(address), deltas));
+            }
+            addScalar(values + n, count - n, delta);
+        }
+
+        TARGET_AVX2 void addClampedAVX2(int* values, const int count, const int delta, const int min, const int max)
+        {
+            const __m256i deltas = _mm256_set1_epi32(delta);
+            const __m256i mins   = _mm256_set1_epi32(min);
+            const __m256i maxs   = _mm256_set1_epi32(max);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                __m256i* address = (__m256i*)(values + n);
+                const __m256i v = _mm256_add_epi32(_mm256_loadu_si256(address), deltas);
+                _mm256_storeu_si256(address, _mm256_min_epi32(_mm256_max_epi32(v, mins), maxs));
+            }
+            addClampedScalar(values + n, count - n, delta, min, max);
+        }
+
+        TARGET_AVX2 void fillAVX2(int* values, const int count, const int value)
+        {
+            const __m256i v = _mm256_set1_epi32(value);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                _mm256_storeu_si256((__m256i*)(values + n), v);
+            }
+            fillScalar(values + n, count - n, value);
+        }
+
+        TARGET_AVX2 void scaleAVX2(int* values, const int count, const float factor, const int origin)
+        {
+            const __m256i origins      = _mm256_set1_epi32(origin);
+            const __m256  floatOrigins = _mm256_cvtepi32_ps(origins);
+            const __m256  factors      = _mm256_set1_ps(factor);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                __m256i* address = (__m256i*)(values + n);
+                const __m256 relative = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256(address), origins));
+                const __m256 scaled   = _mm256_add_ps(_mm256_mul_ps(relative, factors), floatOrigins);
+                _mm256_storeu_si256(address, _mm256_cvttps_epi32(scaled));
+            }
+            scaleScalar(values + n, count - n, factor, origin);
+        }
+
+        TARGET_AVX2 void snapToGridAVX2(int* values, const int count, const int origin, const float gridLength,
+                                        const bool ceil)
+        {
+            const __m256i origins = _mm256_set1_epi32(origin);
+            const __m256  lengths = _mm256_set1_ps(gridLength);
+            const __m256d doubleLengths = _mm256_set1_pd(gridLength);
+            const __m256  zeros   = _mm256_setzero_ps();
+            const __m256  halves  = _mm256_set1_ps(0.5f);
+            const __m256  minusHalves = _mm256_set1_ps(-0.5f);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                __m256i* address = (__m256i*)(values + n);
+                const __m256 steps = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_loadu_si256(address),
+                                                                                       origins)),
+                                                   lengths);
+
+                // masks are -1 where set, so subtracting them adds one
+                __m256i rounded = _mm256_cvttps_epi32(steps);
+                const __m256 remainder = _mm256_sub_ps(steps, _mm256_cvtepi32_ps(rounded));
+                if (ceil)
+                {
+                    rounded = _mm256_sub_epi32(rounded, _mm256_castps_si256(_mm256_cmp_ps(remainder, zeros,
+                                                                                          _CMP_GT_OQ)));
+                }
+                else
+                {
+                    rounded = _mm256_sub_epi32(rounded, _mm256_castps_si256(_mm256_cmp_ps(remainder, halves,
+                                                                                          _CMP_GE_OQ)));
+                    rounded = _mm256_add_epi32(rounded, _mm256_castps_si256(_mm256_cmp_ps(remainder, minusHalves,
+                                                                                          _CMP_LE_OQ)));
+                }
+
+                const __m256d low  = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(rounded)),
+                                                   doubleLengths);
+                const __m256d high = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(rounded, 1)),
+                                                   doubleLengths);
+                const __m256i snapped = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(low)),
+                                                                _mm256_cvttpd_epi32(high), 1);
+                _mm256_storeu_si256(address, _mm256_add_epi32(snapped, origins));
+            }
+            snapToGridScalar(values + n, count - n, origin, gridLength, ceil);
+        }
+
+        TARGET_AVX2 void shiftAfterAVX2(int* ticks, int* endTicks, const int count, const int afterTick,
+                                        const int delta)
+        {
+            const __m256i afters = _mm256_set1_epi32(afterTick);
+            const __m256i deltas = _mm256_set1_epi32(delta);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                __m256i* address = (__m256i*)(ticks + n);
+                const __m256i v = _mm256_loadu_si256(address);
+                const __m256i shift = _mm256_and_si256(_mm256_cmpgt_epi32(v, afters), deltas);
+                _mm256_storeu_si256(address, _mm256_add_epi32(v, shift));
+                if (endTicks != NULL)
+                {
+                    __m256i* endAddress = (__m256i*)(endTicks + n);
+                    _mm256_storeu_si256(endAddress, _mm256_add_epi32(_mm256_loadu_si256(endAddress), shift));
+                }
+            }
+            shiftAfterScalar(ticks + n, (endTicks == NULL ? NULL : endTicks + n), count - n, afterTick, delta);
+        }
+
+        TARGET_AVX2 int getMaxAVX2(const int* values, const int count, const int initial)
+        {
+            __m256i maxs = _mm256_set1_epi32(initial);
+            int n = 0;
+            for (; n + 8 <= count; n += 8)
+            {
+                maxs = _mm256_max_epi32(maxs, _mm256_loadu_si256((const __m256i*)(values + n)));
+            }
+
+            int lanes[8];
+            _mm256_storeu_si256((__m256i*)lanes, maxs);
+            return getMaxScalar(values + n, count - n, getMaxScalar(lanes, 8, initial));
+        }
+
+#endif
+
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+NoteKernels::InstructionSet NoteKernels::getInstructionSet()
+{
+    int set = __atomic_load_n(&g_instruction_set, __ATOMIC_RELAXED);
+    if (set == -1)
+    {
+        set = detectInstructionSet();
+        __atomic_store_n(&g_instruction_set, set, __ATOMIC_RELAXED);
+    }
+    return (InstructionSet)set;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool NoteKernels::isSupported(const InstructionSet set)
+{
+    return set <= detectInstructionSet();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteKernels::setInstructionSet(const InstructionSet set)
+{
+    if (isSupported(set)) __atomic_store_n(&g_instruction_set, (int)set, __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const char* NoteKernels::getName(const InstructionSet set)
+{
+    switch (set)
+    {
+        case AVX2: return "AVX2";
+        case SSE2: return "SSE2";
+        default:   return "scalar";
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+#if defined(NOTE_KERNELS_AVX2)
+#define DISPATCH_KERNEL(NAME, ARGS) \
+    switch (getInstructionSet()) \
+    { \
+        case AVX2: return NAME##AVX2 ARGS; \
+        case SSE2: return NAME##SSE2 ARGS; \
+        default:   return NAME##Scalar ARGS; \
+    }
+#elif defined(NOTE_KERNELS_SSE2)
+#define DISPATCH_KERNEL(NAME, ARGS) \
+    if (getInstructionSet() == SSE2) return NAME##SSE2 ARGS; \
+    return NAME##Scalar ARGS;
+#else
+#define DISPATCH_KERNEL(NAME, ARGS) \
+    return NAME##Scalar ARGS;
+#endif
+
+void NoteKernels::add(int* values, const int count, const int delta)
+{
+    DISPATCH_KERNEL(add, (values, count, delta));
+}
+
+void NoteKernels::addClamped(int* values, const int count, const int delta, const int min, const int max)
+{
+    DISPATCH_KERNEL(addClamped, (values, count, delta, min, max));
+}
+
+void NoteKernels::fill(int* values, const int count, const int value)
+{
+    DISPATCH_KERNEL(fill, (values, count, value));
+}
+
+void NoteKernels::scale(int* values, const int count, const float factor, const int origin)
+{
+    DISPATCH_KERNEL(scale, (values, count, factor, origin));
+}
+
+void NoteKernels::snapToGrid(int* values, const int count, const int origin, const float gridLength,
+                             const bool ceil)
+{
+    DISPATCH_KERNEL(snapToGrid, (values, count, origin, gridLength, ceil));
+}
+
+void NoteKernels::shiftAfter(int* ticks, int* endTicks, const int count, const int afterTick, const int delta)
+{
+    DISPATCH_KERNEL(shiftAfter, (ticks, endTicks, count, afterTick, delta));
+}
+
+int NoteKernels::getMax(const int* values, const int count, const int initial)
+{
+    DISPATCH_KERNEL(getMax, (values, count, initial));
+}
+
+#undef DISPATCH_KERNEL
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteBatch::gatherSelection(const Track* track, const int fields)
+{
+    track->getSelectedNotes(m_notes);
+    gatherFields(fields);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteBatch::gatherFields(const int fields)
+{
+    const int amount = m_notes.size();
+
+    m_ticks.clear();
+    m_end_ticks.clear();
+    m_pitches.clear();
+    m_volumes.clear();
+
+    if (fields & TICKS)
+    {
+        m_ticks.resize(amount);
+        for (int n=0; n<amount; n++) m_ticks[n] = m_notes[n]->getTick();
+    }
+    if (fields & END_TICKS)
+    {
+        m_end_ticks.resize(amount);
+        for (int n=0; n<amount; n++) m_end_ticks[n] = m_notes[n]->getEndTick();
+    }
+    if (fields & PITCHES)
+    {
+        m_pitches.resize(amount);
+        for (int n=0; n<amount; n++) m_pitches[n] = m_notes[n]->getPitchID();
+    }
+    if (fields & VOLUMES)
+    {
+        m_volumes.resize(amount);
+        for (int n=0; n<amount; n++) m_volumes[n] = m_notes[n]->getVolume();
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void NoteBatch::scatter(const int fields)
+{
+    const int amount = m_notes.size();
+
+    if (fields & TICKS)
+    {
+        ASSERT_E((int)m_ticks.size(),==,amount);
+        for (int n=0; n<amount; n++) m_notes[n]->setTick(m_ticks[n]);
+    }
+    if (fields & END_TICKS)
+    {
+        ASSERT_E((int)m_end_ticks.size(),==,amount);
+        for (int n=0; n<amount; n++) m_notes[n]->setEndTick(m_end_ticks[n]);
+    }
+    if (fields & PITCHES)
+    {
+        ASSERT_E((int)m_pitches.size(),==,amount);
+        for (int n=0; n<amount; n++) m_notes[n]->setPitchID(m_pitches[n]);
+    }
+    if (fields & VOLUMES)
+    {
+        ASSERT_E((int)m_volumes.size(),==,amount);
+        for (int n=0; n<amount; n++) m_notes[n]->setVolume(m_volumes[n]);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+#if _MORE_DEBUG_CHECKS // so that utility classes are not compiled in when unit tests are disabled
+namespace TestNoteKernels
+{
+    using namespace AriaMaestosa;
+
+    int nextRandom(unsigned int& seed, const int max)
+    {
+        seed = seed*1103515245 + 12345;
+        return (seed >> 8) % max;
+    }
+
+    const int KERNEL_AMOUNT = 8;
+
+    /** runs one of the kernels on the values, the way the actions use them */
+    void runKernel(const int kernel, std::vector<int>& ticks, std::vector<int>& endTicks)
+    {
+        int* values = NoteBatch::data(ticks);
+        const int count = ticks.size();
+        switch (kernel)
+        {
+            case 0: NoteKernels::add(values, count, -7); break;
+            case 1: NoteKernels::addClamped(values, count, 20, 0, 127); break;
+            case 2: NoteKernels::fill(values, count, 64); break;
+            case 3: NoteKernels::scale(values, count, 1.37f, 960); break;
+            case 4: NoteKernels::snapToGrid(values, count, 0, 120.0f, false); break;
+            case 5: NoteKernels::snapToGrid(values, count, 1920, 180.0f, true); break;
+            case 6: NoteKernels::shiftAfter(values, NoteBatch::data(endTicks), count, 5000, 7680); break;
+            case 7: ticks.push_back(NoteKernels::getMax(values, count, -1)); break;
+        }
+    }
+
+    UNIT_TEST(TestKernelsMatchScalar)
+    {
+        const NoteKernels::InstructionSet previous = NoteKernels::getInstructionSet();
+        unsigned int seed = 7;
+
+        // exact multiples and halves of the grid, where rounding matters, then random ticks; the amount is not
+        // a multiple of the vector width so that the scalar tail is exercised too
+        std::vector<int> input;
+        for (int n=0; n<1000; n++) input.push_back(n*60);
+        for (int n=0; n<1003; n++) input.push_back(nextRandom(seed, 1 << 26));
+
+        std::vector<int> inputEnds;
+        for (unsigned int n=0; n<input.size(); n++) inputEnds.push_back(input[n] + nextRandom(seed, 4000));
+
+        for (int set=NoteKernels::SSE2; set<=NoteKernels::AVX2; set++)
+        {
+            if (not NoteKernels::isSupported((NoteKernels::InstructionSet)set)) continue;
+
+            for (int kernel=0; kernel<KERNEL_AMOUNT; kernel++)
+            {
+                std::vector<int> expected = input, expectedEnds = inputEnds;
+                NoteKernels::setInstructionSet(NoteKernels::SCALAR);
+                runKernel(kernel, expected, expectedEnds);
+
+                std::vector<int> actual = input, actualEnds = inputEnds;
+                NoteKernels::setInstructionSet((NoteKernels::InstructionSet)set);
+                runKernel(kernel, actual, actualEnds);
+
+                require(actual == expected and actualEnds == expectedEnds, "vector kernels give the scalar results");
+            }
+        }
+
+        NoteKernels::setInstructionSet(previous);
+
+        // the kernels must snap like round() and ceil() would
+        std::vector<int> ticks;
+        ticks.push_back(59);
+        ticks.push_back(60);
+        ticks.push_back(179);
+        ticks.push_back(181);
+        NoteKernels::snapToGrid(NoteBatch::data(ticks), ticks.size(), 0, 120.0f, false);
+        require(ticks[0] == 0 and ticks[1] == 120 and ticks[2] == 120 and ticks[3] == 240, "ticks are rounded");
+
+        ticks[0] = 1;
+        ticks[1] = 120;
+        NoteKernels::snapToGrid(NoteBatch::data(ticks), 2, 0, 120.0f, true);
+        require(ticks[0] == 120 and ticks[1] == 120, "ticks are rounded up with 'ceil'");
+    }
+
+    UNIT_TEST(TestKernelsOnMillionNotes)
+    {
+        const int NOTE_AMOUNT = 1000000;
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        const int beat = seq->ticksPerQuarterNote();
+        unsigned int seed = 42;
+
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<NOTE_AMOUNT; n++)
+            {
+                const int start = (n/4)*beat + nextRandom(seed, beat);
+                t->addNote_import(20 + nextRandom(seed, 90), start, start + beat/2, 80, -1);
+            }
+        }
+        seq->addTrack(t);
+        t->selectNote(ALL_NOTES, true, true);
+
+        ptr_vector<Note, REF> notes;
+        for (int n=0; n<t->getNoteAmount(); n++) notes.push_back(t->getNote(n));
+
+        // what the actions used to do : one note at a time, through its setters
+        wxStopWatch setterTime;
+        for (int n=0; n<notes.size(); n++)
+        {
+            if (notes[n].isSelected()) notes[n].setPitchID(notes[n].getPitchID() + 1);
+        }
+        const long setterMs = setterTime.Time();
+
+        NoteBatch batch;
+        wxStopWatch gatherTime;
+        batch.gather(notes, true, NoteBatch::PITCHES);
+        const long gatherMs = gatherTime.Time();
+
+        std::cout << "[NoteKernels] transposing " << NOTE_AMOUNT << " selected notes : " << setterMs
+                  << " ms through the setters; with a batch, " << gatherMs << " ms to gather the pitches, ";
+
+        const NoteKernels::InstructionSet previous = NoteKernels::getInstructionSet();
+        for (int set=NoteKernels::SCALAR; set<=NoteKernels::AVX2; set++)
+        {
+            if (not NoteKernels::isSupported((NoteKernels::InstructionSet)set)) continue;
+            NoteKernels::setInstructionSet((NoteKernels::InstructionSet)set);
+
+            // a single pass is too fast to time with millisecond precision
+            const int PASSES = 20;
+            wxStopWatch kernelTime;
+            for (int pass=0; pass<PASSES; pass++)
+            {
+                NoteKernels::add(NoteBatch::data(batch.m_pitches), batch.size(), (pass % 2 == 0 ? -1 : 1));
+            }
+            std::cout << (kernelTime.Time() / (float)PASSES) << " ms (" << NoteKernels::getName((NoteKernels::InstructionSet)set)
+                      << ") ";
+        }
+        NoteKernels::setInstructionSet(previous);
+
+        wxStopWatch scatterTime;
+        batch.scatter(NoteBatch::PITCHES);
+        std::cout << "to transpose and " << scatterTime.Time() << " ms to write them back" << std::endl;
+
+        for (int n=0; n<notes.size(); n += 997)
+        {
+            require_e(notes[n].getPitchID(), ==, batch.m_pitches[n], "the batch was written back to the notes");
+        }
+
+        delete seq;
+    }
+}
+#endif
@@ -0,0 +1,158 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __NOTE_KERNELS_H__
+#define __NOTE_KERNELS_H__
+
+#include "Midi/Note.h"
+#include "ptr_vector.h"
+
+#include <vector>
+
+namespace AriaMaestosa
+{
+
+    class Track;
+
+    /**
+      * @brief element-wise arithmetic over packed arrays of note data (ticks, pitches, volumes), used by
+      *        the actions that transform many notes at once
+      *
+      * Each kernel has an SSE2 and an AVX2 variant, and a scalar one for other CPUs; the best variant the
+      * CPU supports is picked the first time a kernel is called. All variants give exactly the same
+      * results (the floating point operations are the same, in the same order).
+      *
+      * @ingroup midi
+      */
+    namespace NoteKernels
+    {
+        enum InstructionSet
+        {
+            SCALAR,
+            SSE2,
+            AVX2
+        };
+
+        /** @return the instruction set the kernels use */
+        InstructionSet getInstructionSet();
+
+        /** @brief makes the kernels use the given instruction set, if the CPU supports it (for tests) */
+        void setInstructionSet(const InstructionSet set);
+
+        /** @return whether the CPU (and the build) supports the given instruction set */
+        bool isSupported(const InstructionSet set);
+
+        const char* getName(const InstructionSet set);
+
+        /** @brief values[n] += delta */
+        void add(int* values, const int count, const int delta);
+
+        /** @brief values[n] = clamp(values[n] + delta, min, max) */
+        void addClamped(int* values, const int count, const int delta, const int min, const int max);
+
+        /** @brief values[n] = value */
+        void fill(int* values, const int count, const int value);
+
+        /**
+          * @brief values[n] = (int)((values[n] - origin)*factor + origin), computed in single precision
+          *        (see ScaleTrack)
+          */
+        void scale(int* values, const int count, const float factor, const int origin);
+
+        /**
+          * @brief snaps each value to the closest multiple of 'gridLength' after 'origin' (see
+          *        Track::snapMidiTickToGrid), or to the next one if 'ceil' is true
+          */
+        void snapToGrid(int* values, const int count, const int origin, const float gridLength,
+                        const bool ceil);
+
+        /**
+          * @brief adds 'delta' to the values that are after 'afterTick', and to the end tick of the same
+          *        notes (see InsertEmptyMeasures)
+          * @param endTicks  may be NULL
+          */
+        void shiftAfter(int* ticks, int* endTicks, const int count, const int afterTick, const int delta);
+
+        /** @return the greatest of 'initial' and of the values */
+        int getMax(const int* values, const int count, const int initial);
+    }
+
+    /**
+      * @brief the data of some notes of a track, packed in arrays for NoteKernels
+      *
+      * 'gather' copies the fields of the notes into the arrays, the kernels transform the arrays, and
+      * 'scatter' copies them back into the notes.
+      *
+      * @ingroup midi
+      */
+    class NoteBatch
+    {
+    public:
+
+        enum Field
+        {
+            TICKS     = 1,
+            END_TICKS = 2,
+            PITCHES   = 4,
+            VOLUMES   = 8
+        };
+
+        std::vector<Note*> m_notes;
+        std::vector<int>   m_ticks;
+        std::vector<int>   m_end_ticks;
+        std::vector<int>   m_pitches;
+        std::vector<int>   m_volumes;
+
+        /**
+          * @brief takes the given fields of the notes (or only of the selected ones)
+          * @param fields  combination of values of 'Field'
+          */
+        template<VECTOR_TYPE type>
+        void gather(const ptr_vector<Note, type>& notes, const bool selectionOnly, const int fields)
+        {
+            m_notes.clear();
+            const int noteAmount = notes.size();
+            m_notes.reserve(noteAmount);
+            for (int n=0; n<noteAmount; n++)
+            {
+                Note* note = notes.contentsVector[n];
+                if (not selectionOnly or note->isSelected()) m_notes.push_back(note);
+            }
+            gatherFields(fields);
+        }
+
+        /**
+          * @brief takes the given fields of the selected notes of a track, in the order of their IDs
+          *        (without going through the notes that are not selected)
+          */
+        void gatherSelection(const Track* track, const int fields);
+
+        /** @brief writes the given fields back into the notes they were taken from */
+        void scatter(const int fields);
+
+        int size() const { return m_notes.size(); }
+
+        /** @return the address of the first value of an array, to pass to the kernels (NULL if empty) */
+        static int* data(std::vector<int>& values) { return (values.empty() ? NULL : &values[0]); }
+
+    private:
+
+        void gatherFields(const int fields);
+    };
+
+}
+
+#endif
@@ -20,6 +20,8 @@
 #include "AriaCore.h"
 #include "Midi/Players/Alsa/AlsaNotePlayer.h"
 #include "Midi/Players/Alsa/AlsaPort.h"
+#include "Midi/Players/Alsa/AlsaQueuePlayer.h"
+#include "Midi/Players/OutputRouter.h"
 #include "Midi/Players/Sequencer.h"
 #include "IO/IOUtils.h"
 
@@ -27,6 +29,7 @@
 
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/CommonMidiUtils.h"
+#include "Midi/CompactMidiTrack.h"
 #include "Midi/Sequence.h"
 #include "PreferencesData.h"
 #include "GUI/MainFrame.h"
@@ -61,6 +64,12 @@ bool sound_available = false;
 
 MidiContext* context = NULL;
 
+/** queues and threads of the output devices used by the song being played */
+OutputRouter* output_router = NULL;
+
+/** output the sequencer currently sends to (see PlatformMidiManager::seq_set_output) */
+int current_output = 0;
+
 bool must_stop=false;
 Sequence* g_sequence;
 
@@ -69,6 +78,21 @@ void cleanup_after_playback()
     if (not sound_available) return;
 
     context->setPlaying(false);
+    
+    // the default device is reset below, reset the others before closing their ports
+    const int outputAmount = output_router->getOutputAmount();
+    for (int output=1; output<outputAmount; output++)
+    {
+        for (int channel=0; channel<16; channel++)
+        {
+            output_router->post(output, RoutedMessage::controlChange(0x78 /* all sound off */, 0, channel));
+            output_router->post(output, RoutedMessage::controlChange(0x79 /* reset controllers */, 0, channel));
+            output_router->post(output, RoutedMessage::controlChange(7 /* reset volume */, 127, channel));
+            output_router->post(output, RoutedMessage::controlChange(10 /* reset pan */, 64, channel));
+        }
+    }
+    output_router->clear();
+    
     AlsaPlayerStuff::resetAllControllers();
 }
 
@@ -173,39 +197,75 @@ void* export_audio_func( void *ptr )
 
 class SequencerThread : public wxThread
 {
-    jdksmidi::MIDIMultiTrack* jdkmidiseq;
-    jdksmidi::MIDISequencer* jdksequencer;
+    LiveTrackStreams m_streams;
     int songLengthInTicks;
     bool selectionOnly;
     int m_start_tick;
     
+    /** set when the song is scheduled on an ALSA queue, NULL when events are sent as the timer wakes up */
+    OwnerPtr<AlsaQueuePlayer> m_queue_player;
+    
+    /** @brief sets up the scheduled output mode, with one port per output of the song */
+    bool openQueuePlayer(const wxArrayString& outputs)
+    {
+        m_queue_player = new AlsaQueuePlayer();
+        if (not m_queue_player->open(g_sequence->ticksPerQuarterNote(), g_sequence->getTempo())) return false;
+        
+        const int outputAmount = outputs.size();
+        for (int n=0; n<outputAmount; n++)
+        {
+            if (not m_queue_player->addOutput(context->getOutputDevice(outputs[n]))) return false;
+        }
+        return true;
+    }
+    
 public:
     
     SequencerThread(const bool selectionOnly)
     {
-        jdkmidiseq = NULL;
-        jdksequencer = NULL;
         SequencerThread::selectionOnly = selectionOnly;
     }
     ~SequencerThread()
     {
-        if (jdksequencer != NULL) delete jdksequencer;
-        if (jdkmidiseq != NULL) delete jdkmidiseq;
     }
 
     void prepareSequencer()
     {
-        jdkmidiseq = new jdksmidi::MIDIMultiTrack();
+        CompactMidiSequence tracks;
+        wxArrayString outputs;
         songLengthInTicks = -1;
         int trackAmount = -1;
         m_start_tick = 0;
-        makeJDKMidiSequence(g_sequence, *jdkmidiseq, selectionOnly, &songLengthInTicks,
-                            &m_start_tick, &trackAmount, true /* for playback */);
+        makeCompactMidiSequence(g_sequence, tracks, selectionOnly, &songLengthInTicks,
+                                &m_start_tick, &trackAmount, true /* for playback */, &outputs);
 
         //std::cout << "trackAmount=" << trackAmount << " start_tick=" << m_start_tick<<
         //        " songLengthInTicks=" << songLengthInTicks << std::endl;
 
-        jdksequencer = new jdksmidi::MIDISequencer(jdkmidiseq);
+        m_streams.set(tracks);
+
+        // edits are heard while the whole song plays (not when playing a selection, or recording)
+        LiveEditQueue& edits = PlatformMidiManager::get()->getLiveEdits();
+        const bool editable = not selectionOnly and not PlatformMidiManager::get()->isRecording();
+        m_streams.listen(&edits, edits.startPlayback(m_start_tick, songLengthInTicks, editable));
+        
+        // recording needs the timer of the generic sequencer (to go on past the end of the song)
+        const bool scheduled = PreferencesData::getInstance()->getBoolValue(SETTING_ID_ALSA_SCHEDULED_OUTPUT, true)
+                               and not PlatformMidiManager::get()->isRecording();
+        if (scheduled and not openQueuePlayer(outputs))
+        {
+            std::cerr << "failed to set up scheduled output, sending events as they come instead" << std::endl;
+            m_queue_player = NULL;
+        }
+        if (m_queue_player != NULL) return;
+        
+        // each output device gets a port, queue and thread of its own. If that fails, everything is
+        // played directly on the default device
+        current_output = 0;
+        if (not context->openOutputs(outputs, *output_router))
+        {
+            std::cerr << "failed to open the MIDI outputs of the song, playing on the default output" << std::endl;
+        }
     }
 
     void go(int* startTick /* out */)
@@ -225,8 +285,17 @@ public:
 
     ExitCode Entry()
     {
-        AriaSequenceTimer timer(g_sequence);
-        timer.run(jdksequencer, songLengthInTicks);
+        if (m_queue_player != NULL)
+        {
+            // this thread feeds the queue, the ALSA sequencer takes care of timing
+            m_queue_player->run(m_streams, songLengthInTicks, g_sequence->isLoopEnabled());
+            m_queue_player = NULL;
+        }
+        else
+        {
+            AriaSequenceTimer timer(g_sequence);
+            timer.run(m_streams, songLengthInTicks);
+        }
 
         must_stop = true;
         cleanup_after_playback();
@@ -249,6 +318,7 @@ public:
         AlsaPlayerStuff::alsa_output_module_init();
         
         context = new MidiContext();
+        output_router = new OutputRouter();
         
         const bool launchFluidSynth = (PreferencesData::getInstance()->getBoolValue("launchFluidSynth", false));
         
@@ -274,6 +344,11 @@ public:
     {
         wxLogVerbose( wxT("AlsaMidiManager::freeMidiPlayer") );
         
+        if (output_router != NULL)
+        {
+            delete output_router;
+            output_router = NULL;
+        }
         if (context != NULL)
         {
             context->closeDevice();
@@ -622,30 +697,73 @@ public:
         AlsaPlayerStuff::stopNote();
     }
 
+    // during playback, events go through the queue of their output; otherwise they are sent directly
+    // to the default device
+
+    virtual void seq_set_output(const int output)
+    {
+        current_output = output;
+    }
+
     virtual void seq_note_on(const int note, const int volume, const int channel)
     {
-        AlsaPlayerStuff::seq_note_on(note, volume, channel);
+        if (output_router->getOutputAmount() > 0)
+        {
+            output_router->post(current_output, RoutedMessage::noteOn(note, volume, channel));
+        }
+        else
+        {
+            AlsaPlayerStuff::seq_note_on(note, volume, channel);
+        }
     }
 
 
     virtual void seq_note_off(const int note, const int channel)
     {
-        AlsaPlayerStuff::seq_note_off(note, channel);
+        if (output_router->getOutputAmount() > 0)
+        {
+            output_router->post(current_output, RoutedMessage::noteOff(note, channel));
+        }
+        else
+        {
+            AlsaPlayerStuff::seq_note_off(note, channel);
+        }
     }
 
     virtual void seq_prog_change(const int instrumentID, const int channel)
     {
-        AlsaPlayerStuff::seq_prog_change(instrumentID, channel);
+        if (output_router->getOutputAmount() > 0)
+        {
+            output_router->post(current_output, RoutedMessage::programChange(instrumentID, channel));
+        }
+        else
+        {
+            AlsaPlayerStuff::seq_prog_change(instrumentID, channel);
+        }
     }
 
     virtual void seq_controlchange(const int controller, const int value, const int channel)
     {
-        AlsaPlayerStuff::seq_controlchange(controller, value, channel);
+        if (output_router->getOutputAmount() > 0)
+        {
+            output_router->post(current_output, RoutedMessage::controlChange(controller, value, channel));
+        }
+        else
+        {
+            AlsaPlayerStuff::seq_controlchange(controller, value, channel);
+        }
     }
 
     virtual void seq_pitch_bend(const int value, const int channel)
     {
-        AlsaPlayerStuff::seq_pitch_bend(value, channel);
+        if (output_router->getOutputAmount() > 0)
+        {
+            output_router->post(current_output, RoutedMessage::pitchBend(value, channel));
+        }
+        else
+        {
+            AlsaPlayerStuff::seq_pitch_bend(value, channel);
+        }
     }
 
 };
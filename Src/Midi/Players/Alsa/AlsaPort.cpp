@@ -492,6 +492,149 @@ void MidiContext::setDevice(MidiDevice** d, int index)
     PreferencesData::getInstance()->setValue(SETTING_ID_MIDI_OUTPUT, (*d)->getFullName());
 }
 
+
+MidiDevice* MidiContext::getDeviceByFullName(const wxString& fullName)
+{
+    wxString a_str = fullName.BeforeFirst(wxT(':'));
+    wxString b_str = fullName.BeforeFirst(wxT(' ')).AfterLast(wxT(':'));
+    wxString name  = fullName.AfterFirst(wxT(' '));
+    
+    int index = -1;
+    long a, b;
+    if (a_str.ToLong(&a) and b_str.ToLong(&b))
+    {
+        MidiDevice* d = getDevice(a, b, index);
+        if (d != NULL and d->name == name) return d;
+    }
+    
+    if (name.IsEmpty()) return NULL;
+    return getDevice(name, index);
+}
+
+
+MidiDevice* MidiContext::getOutputDevice(const wxString& output)
+{
+    if (output.IsEmpty()) return device;
+    
+    MidiDevice* d = getDeviceByFullName(output);
+    if (d == NULL)
+    {
+        std::cerr << "MIDI output <" << (const char*)output.utf8_str()
+                  << "> is not available, using the default output instead" << std::endl;
+        return device;
+    }
+    return d;
+}
+
+
+bool MidiContext::openOutputs(const wxArrayString& outputs, OutputRouter& router)
+{
+    router.clear();
+    
+    const int outputAmount = outputs.size();
+    for (int n=0; n<outputAmount; n++)
+    {
+        MidiDevice* target = getOutputDevice(outputs[n]);
+        
+        AlsaOutputSink* sink = new AlsaOutputSink();
+        if (target == NULL or not sink->open(target, n))
+        {
+            std::cerr << "failed to open MIDI output " << n << std::endl;
+            delete sink;
+            router.clear();
+            return false;
+        }
+        
+        if (not router.addOutput(sink))
+        {
+            router.clear();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+#if 0
+#pragma mark -
+#endif
+
+AlsaOutputSink::AlsaOutputSink()
+{
+    m_sequencer = NULL;
+}
+
+
+AlsaOutputSink::~AlsaOutputSink()
+{
+    if (m_sequencer != NULL)
+    {
+        snd_seq_drain_output(m_sequencer);
+        snd_seq_close(m_sequencer);
+    }
+}
+
+
+bool AlsaOutputSink::open(MidiDevice* device, const int id)
+{
+    if (snd_seq_open(&m_sequencer, DEFAULT_PORT.mb_str(), SND_SEQ_OPEN_OUTPUT, 0) < 0)
+    {
+        m_sequencer = NULL;
+        return false;
+    }
+    
+    snd_seq_set_client_name(m_sequencer, "Aria");
+    
+    wxString portName = wxString::Format(wxT("Aria Output %i"), id);
+    m_source.port = snd_seq_create_simple_port(m_sequencer, portName.mb_str(),
+                                               SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+                                               SND_SEQ_PORT_TYPE_APPLICATION);
+    if (m_source.port < 0) return false;
+    m_source.client = snd_seq_client_id(m_sequencer);
+    
+    return snd_seq_connect_to(m_sequencer, m_source.port, device->client, device->port) >= 0;
+}
+
+
+void AlsaOutputSink::send(const RoutedMessage& message)
+{
+    snd_seq_event_t event;
+    
+    snd_seq_ev_clear(&event);
+    
+    event.queue  = SND_SEQ_QUEUE_DIRECT;
+    event.source = m_source;
+    
+    snd_seq_ev_set_subs(&event);
+    snd_seq_ev_set_direct(&event);
+    
+    const int channel = message.getChannel();
+    switch (message.getType())
+    {
+        case 0x90:
+            snd_seq_ev_set_noteon(&event, channel, message.m_data1, message.m_data2);
+            break;
+        case 0x80:
+            snd_seq_ev_set_noteoff(&event, channel, message.m_data1, 0 /*velocity*/);
+            break;
+        case 0xB0:
+            snd_seq_ev_set_controller(&event, channel, message.m_data1, message.m_data2);
+            break;
+        case 0xC0:
+            snd_seq_ev_set_pgmchange(&event, channel, message.m_data1);
+            break;
+        case 0xE0:
+            snd_seq_ev_set_pitchbend(&event, channel, message.getBenderValue());
+            break;
+        default:
+            return;
+    }
+    
+    // may block if the device doesn't keep up; only this output's thread waits then
+    snd_seq_event_output_direct(m_sequencer, &event);
+}
+
 }
 
 #endif
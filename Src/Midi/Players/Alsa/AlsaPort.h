@@ -5,7 +5,9 @@
 #include <alsa/asoundlib.h>
 #include "glib.h"
 #include <wx/string.h>
+#include <wx/arrstr.h>
 #include "ptr_vector.h"
+#include "Midi/Players/OutputRouter.h"
 
 #include "jdksmidi/world.h"
 #include "jdksmidi/track.h"
@@ -38,7 +40,7 @@ namespace AriaMaestosa
         void setDevice(MidiDevice** d, int index);
 
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MidiContext);
 
         MidiDevice* device;
 
@@ -65,6 +67,27 @@ namespace AriaMaestosa
         MidiDevice* getDevice(int index);
         MidiDevice* getDevice(int client, int port, int& index);
         MidiDevice* getDevice(const wxString& marker, int& index);
+        
+        /**
+          * @return the device with the given full name (see MidiDevice::getFullName), or NULL if it's not
+          *         available; a device whose client number changed (e.g. a restarted soft synth) is found by name
+          */
+        MidiDevice* getDeviceByFullName(const wxString& fullName);
+        
+        /**
+          * @return the device a song output is played on : the device with the given full name, or the
+          *         default device (the one opened with openDevice) if the name is empty or not available
+          */
+        MidiDevice* getOutputDevice(const wxString& output);
+        
+        /**
+          * @brief opens one port per output used by a song, each connected to its device and given its own
+          *        queue and thread in 'router'
+          * @param outputs  device names as given by makeCompactMidiSequence; the first, empty one is the
+          *                 device opened with openDevice. Devices that are not available fall back to it.
+          * @return false if an output could not be opened ('router' is then left empty)
+          */
+        bool openOutputs(const wxArrayString& outputs, OutputRouter& router);
 
     };
 
@@ -77,7 +100,7 @@ namespace AriaMaestosa
     {
         MidiContext* midiContext;
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MidiDevice);
         snd_seq_addr_t address;
         int client, port;
         wxString name;
@@ -88,6 +111,29 @@ namespace AriaMaestosa
         wxString getFullName();
         
     };
+    
+    /**
+      * @ingroup midi.players
+      *
+      * Sends the events of one output during playback, through a sequencer client and port of its own,
+      * so that a device that is slow to accept events doesn't block the others (see OutputRouter)
+      */
+    class AlsaOutputSink : public IOutputSink
+    {
+        snd_seq_t* m_sequencer;
+        snd_seq_addr_t m_source;
+        
+    public:
+        LEAK_CHECK(AlsaOutputSink);
+        
+        AlsaOutputSink();
+        ~AlsaOutputSink();
+        
+        /** @brief opens the client and port of output 'id', and connects them to 'device' */
+        bool open(MidiDevice* device, const int id);
+        
+        virtual void send(const RoutedMessage& message);
+    };
 
 }
 
@@ -0,0 +1,500 @@
+#ifdef _ALSA
+
+#include "Midi/Players/Alsa/AlsaQueuePlayer.h"
+#include "Midi/Players/Alsa/AlsaPort.h"
+#include "Midi/Players/LivePlayback.h"
+#include "Midi/Players/PlatformMidiManager.h"
+#include "Midi/CompactMidiTrack.h"
+#include "PreferencesData.h"
+#include "UnitTest.h"
+
+#include <cmath>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <poll.h>
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+namespace AriaMaestosa
+{
+
+AlsaQueuePlayer::AlsaQueuePlayer()
+{
+    m_sequencer = NULL;
+    m_queue     = -1;
+    m_ppq       = 960;
+}
+
+
+AlsaQueuePlayer::~AlsaQueuePlayer()
+{
+    if (m_sequencer != NULL)
+    {
+        if (m_queue >= 0) snd_seq_free_queue(m_sequencer, m_queue);
+        snd_seq_close(m_sequencer);
+    }
+}
+
+
+bool AlsaQueuePlayer::open(const int ppq, const int bpm)
+{
+    if (snd_seq_open(&m_sequencer, DEFAULT_PORT.mb_str(), SND_SEQ_OPEN_OUTPUT, 0) < 0)
+    {
+        m_sequencer = NULL;
+        return false;
+    }
+    snd_seq_set_client_name(m_sequencer, "Aria");
+
+    // room for the events of the look-ahead window; when it's full, the feeder simply waits
+    snd_seq_set_client_pool_output(m_sequencer, 2048);
+
+    m_queue = snd_seq_alloc_named_queue(m_sequencer, "Aria Playback");
+    if (m_queue < 0) return false;
+
+    m_ppq = ppq;
+
+    snd_seq_queue_tempo_t* tempo;
+    snd_seq_queue_tempo_alloca(&tempo);
+    snd_seq_queue_tempo_set_ppq(tempo, ppq);
+    snd_seq_queue_tempo_set_tempo(tempo, 60000000 / (bpm > 0 ? bpm : 120));
+    return snd_seq_set_queue_tempo(m_sequencer, m_queue, tempo) >= 0;
+}
+
+
+bool AlsaQueuePlayer::addOutput(const int client, const int port)
+{
+    if (m_sequencer == NULL) return false;
+
+    wxString portName = wxString::Format(wxT("Aria Output %i"), (int)m_ports.size());
+    const int source = snd_seq_create_simple_port(m_sequencer, portName.mb_str(),
+                                                  SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+                                                  SND_SEQ_PORT_TYPE_APPLICATION);
+    if (source < 0) return false;
+    if (snd_seq_connect_to(m_sequencer, source, client, port) < 0) return false;
+
+    m_ports.push_back(source);
+    return true;
+}
+
+
+bool AlsaQueuePlayer::addOutput(MidiDevice* device)
+{
+    if (device == NULL) return false;
+    return addOutput(device->client, device->port);
+}
+
+
+unsigned int AlsaQueuePlayer::getQueueTick()
+{
+    snd_seq_queue_status_t* status;
+    snd_seq_queue_status_alloca(&status);
+    if (snd_seq_get_queue_status(m_sequencer, m_queue, status) < 0) return 0;
+    return snd_seq_queue_status_get_tick_time(status);
+}
+
+
+unsigned int AlsaQueuePlayer::getUsecPerBeat()
+{
+    snd_seq_queue_tempo_t* tempo;
+    snd_seq_queue_tempo_alloca(&tempo);
+
+    unsigned int usecPerBeat = 500000;
+    if (snd_seq_get_queue_tempo(m_sequencer, m_queue, tempo) >= 0)
+    {
+        usecPerBeat = snd_seq_queue_tempo_get_tempo(tempo);
+    }
+    if (usecPerBeat == 0) usecPerBeat = 500000;
+    return usecPerBeat;
+}
+
+
+unsigned int AlsaQueuePlayer::getLookAheadTicks()
+{
+    return (unsigned int)(LOOK_AHEAD_MS * 1000.0 * m_ppq / getUsecPerBeat()) + 1;
+}
+
+
+void AlsaQueuePlayer::schedule(const CompactMidiTrack& track, const CompactMidiEvent& ev, const int output,
+                               const unsigned int tick)
+{
+    snd_seq_event_t event;
+    snd_seq_ev_clear(&event);
+
+    if (ev.hasPayload())
+    {
+        if (not track.isTempo(ev)) return;
+
+        // getTempo32 gives 1/32 bpm, the queue wants microseconds per quarter note
+        const unsigned long tempo32 = track.getTempo32(ev);
+        if (tempo32 == 0) return;
+        snd_seq_ev_set_queue_tempo(&event, m_queue, (unsigned int)(60000000.0 * 32.0 / tempo32));
+        event.source.port = m_ports[0];
+    }
+    else
+    {
+        const int channel = ev.getChannel();
+        switch (ev.getType())
+        {
+            case 0x90:
+                snd_seq_ev_set_noteon(&event, channel, ev.m_data1, ev.m_data2);
+                break;
+            case 0x80:
+                snd_seq_ev_set_noteoff(&event, channel, ev.m_data1, 0 /*velocity*/);
+                break;
+            case 0xB0:
+                snd_seq_ev_set_controller(&event, channel, ev.m_data1, ev.m_data2);
+                break;
+            case 0xC0:
+                snd_seq_ev_set_pgmchange(&event, channel, ev.m_data1);
+                break;
+            case 0xE0:
+                snd_seq_ev_set_pitchbend(&event, channel, ev.getBenderValue());
+                break;
+            default:
+                return;
+        }
+
+        event.source.port = m_ports[output < (int)m_ports.size() ? output : 0];
+        snd_seq_ev_set_subs(&event);
+    }
+
+    snd_seq_ev_schedule_tick(&event, m_queue, 0 /* absolute */, tick);
+    snd_seq_event_output(m_sequencer, &event);
+}
+
+
+void AlsaQueuePlayer::scheduleAllNotesOff(const unsigned int tick)
+{
+    const int outputAmount = m_ports.size();
+    for (int output=0; output<outputAmount; output++)
+    {
+        for (int channel=0; channel<16; channel++)
+        {
+            snd_seq_event_t event;
+            snd_seq_ev_clear(&event);
+            snd_seq_ev_set_controller(&event, channel, 0x7B /* all notes off */, 0);
+            event.source.port = m_ports[output];
+            snd_seq_ev_set_subs(&event);
+            snd_seq_ev_schedule_tick(&event, m_queue, 0 /* absolute */, tick);
+            snd_seq_event_output(m_sequencer, &event);
+        }
+    }
+}
+
+
+void AlsaQueuePlayer::unschedule(const unsigned int tick)
+{
+    // what was already sent to the sequencer is in its queue, events at 'tick' or later are taken back
+    snd_seq_remove_events_t* remove;
+    snd_seq_remove_events_alloca(&remove);
+    snd_seq_remove_events_set_queue(remove, m_queue);
+
+    snd_seq_timestamp_t time;
+    time.tick = tick;
+    snd_seq_remove_events_set_time(remove, &time);
+    snd_seq_remove_events_set_condition(remove, SND_SEQ_REMOVE_OUTPUT | SND_SEQ_REMOVE_TIME_AFTER |
+                                                SND_SEQ_REMOVE_TIME_TICK);
+    snd_seq_remove_events(m_sequencer, remove);
+}
+
+
+void AlsaQueuePlayer::silence()
+{
+    // forget what was scheduled but not heard yet (when playback is stopped before the end)
+    snd_seq_remove_events_t* remove;
+    snd_seq_remove_events_alloca(&remove);
+    snd_seq_remove_events_set_queue(remove, m_queue);
+    snd_seq_remove_events_set_condition(remove, SND_SEQ_REMOVE_OUTPUT);
+    snd_seq_remove_events(m_sequencer, remove);
+    snd_seq_drop_output(m_sequencer);
+
+    snd_seq_stop_queue(m_sequencer, m_queue, NULL);
+
+    // and release the notes that were playing
+    const int outputAmount = m_ports.size();
+    for (int output=0; output<outputAmount; output++)
+    {
+        for (int channel=0; channel<16; channel++)
+        {
+            snd_seq_event_t event;
+            snd_seq_ev_clear(&event);
+            snd_seq_ev_set_controller(&event, channel, 0x7B /* all notes off */, 0);
+            event.source.port = m_ports[output];
+            snd_seq_ev_set_subs(&event);
+            snd_seq_ev_set_direct(&event);
+            snd_seq_event_output(m_sequencer, &event);
+        }
+    }
+    snd_seq_drain_output(m_sequencer);
+}
+
+
+bool AlsaQueuePlayer::run(LiveTrackStreams& streams, const int songLengthInTicks, const bool loop)
+{
+    if (streams.getEventAmount() == 0 or m_ports.empty() or m_queue < 0)
+    {
+        std::cerr << "[AlsaQueuePlayer] nothing to play" << std::endl;
+        return false;
+    }
+
+    // events past the song length are not played, like with AriaSequenceTimer
+    const unsigned int songLength = (songLengthInTicks > 0 ? songLengthInTicks : 1);
+
+    snd_seq_start_queue(m_sequencer, m_queue, NULL);
+    snd_seq_drain_output(m_sequencer);
+
+    streams.rewind();
+
+    // queue tick at which the pass over the song being scheduled begins (it moves forward when looping)
+    unsigned int pass_start = 0;
+
+    // beginning of the passes that were scheduled but not entirely heard yet, to report the right tick
+    std::deque<unsigned int> passes;
+    passes.push_back(0);
+
+    bool all_scheduled = false;
+    unsigned int last_tick = 0;
+
+    // events to send when a track is replaced, see LiveTrackStreams::applyEdits
+    CompactMidiTrack chase;
+
+    while (mustContinue())
+    {
+        const unsigned int now = getQueueTick();
+        while (passes.size() > 1 and now >= passes[1]) passes.pop_front();
+        notifyTick(now - passes.front(), m_ppq * 1000.0 / getUsecPerBeat());
+
+        if (all_scheduled and now >= last_tick) break; // the end of the song was heard
+
+        // tracks edited while playing are heard from the next tick : what was scheduled from there on is
+        // taken back, and scheduled again with the new tracks
+        if (streams.hasPendingEdits())
+        {
+            const unsigned int cut = now + 1;
+            unschedule(cut);
+
+            pass_start = passes.front();
+            passes.resize(1);
+            streams.seek(cut - pass_start);
+
+            if (streams.applyEdits(chase))
+            {
+                const int chaseAmount = chase.getEventAmount();
+                for (int n=0; n<chaseAmount; n++)
+                {
+                    schedule(chase, chase.getEvent(n), chase.getEvent(n).getOutput(), cut);
+                }
+            }
+            all_scheduled = false;
+            last_tick = cut;
+        }
+
+        // keep the look-ahead window filled
+        const unsigned int horizon = now + getLookAheadTicks();
+        while (not all_scheduled)
+        {
+            if (not streams.hasNext() or (unsigned int)streams.getNextTick() >= songLength)
+            {
+                if (not loop)
+                {
+                    all_scheduled = true;
+                    break;
+                }
+
+                const unsigned int next_pass = pass_start + songLength;
+                if (next_pass > horizon) break;
+
+                // silence everything at the loop point, then play the song again
+                scheduleAllNotesOff(next_pass);
+                pass_start = next_pass;
+                passes.push_back(pass_start);
+                streams.rewind();
+                continue;
+            }
+
+            const unsigned int tick = pass_start + streams.getNextTick();
+            if (tick > horizon) break;
+
+            const CompactMidiTrack* track = NULL;
+            int output = 0;
+            const CompactMidiEvent* ev = streams.next(&track, &output);
+            schedule(*track, *ev, output, tick);
+            last_tick = tick;
+        }
+        snd_seq_drain_output(m_sequencer);
+
+        wxMilliSleep(FEED_INTERVAL_MS);
+    }
+
+    silence();
+    notifyTick(-1, 0.0);
+    return true;
+}
+
+
+bool AlsaQueuePlayer::mustContinue()
+{
+    return PlatformMidiManager::get()->seq_must_continue();
+}
+
+
+void AlsaQueuePlayer::notifyTick(const int tick, const double ticksPerMs)
+{
+    PlatformMidiManager::get()->seq_notify_current_tick(tick);
+    PlatformMidiManager::get()->seq_notify_accurate_current_tick(tick);
+
+    // the queue position was just read, so it is being heard now
+    PlaybackState& state = PlatformMidiManager::get()->getPlaybackState();
+    if (tick < 0) state.publishStopped();
+    else          state.publish(tick, PlaybackState::getTimeUs(), ticksPerMs);
+}
+
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestAlsaQueuePlayer
+{
+    using namespace AriaMaestosa;
+
+    class LoopbackPlayer : public AlsaQueuePlayer
+    {
+    public:
+        volatile bool m_stop;
+
+        LoopbackPlayer() { m_stop = false; }
+
+        virtual bool mustContinue() { return not m_stop; }
+        virtual void notifyTick(const int tick, const double ticksPerMs) { }
+    };
+
+    class FeederThread : public wxThread
+    {
+        LoopbackPlayer* m_player;
+        LiveTrackStreams* m_streams;
+        int m_length;
+
+    public:
+
+        FeederThread(LoopbackPlayer* player, LiveTrackStreams* streams, const int length) :
+            wxThread(wxTHREAD_JOINABLE)
+        {
+            m_player  = player;
+            m_streams = streams;
+            m_length  = length;
+        }
+
+        virtual ExitCode Entry()
+        {
+            m_player->run(*m_streams, m_length, false);
+            return 0;
+        }
+    };
+
+    double nowMs()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec*1000.0 + now.tv_nsec/1000000.0;
+    }
+
+    void addTempo(CompactMidiTrack& stream, const unsigned int tick, const int usecPerBeat)
+    {
+        const unsigned char data[3] = { (unsigned char)((usecPerBeat >> 16) & 0xFF),
+                                        (unsigned char)((usecPerBeat >> 8) & 0xFF),
+                                        (unsigned char)(usecPerBeat & 0xFF) };
+        stream.addMetaEvent(tick, 0x51, data, 3);
+    }
+
+    UNIT_TEST(TestScheduledOutputTiming)
+    {
+        const int PPQ   = 960;
+        const int NOTES = 64;
+        const int STEP  = PPQ/4; // sixteenth notes
+
+        snd_seq_t* loopback;
+        if (snd_seq_open(&loopback, DEFAULT_PORT.mb_str(), SND_SEQ_OPEN_INPUT, 0) < 0)
+        {
+            std::cout << "[AlsaQueuePlayer] no ALSA sequencer available, delivered timing not measured" << std::endl;
+            return;
+        }
+        snd_seq_set_client_name(loopback, "Aria Loopback");
+        const int inPort = snd_seq_create_simple_port(loopback, "Aria Loopback",
+                                                      SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
+                                                      SND_SEQ_PORT_TYPE_APPLICATION);
+        require_e(inPort, >=, 0, "the loopback port could be created");
+
+        LoopbackPlayer player;
+        require(player.open(PPQ, 120), "the queue could be allocated");
+        require(player.addOutput(snd_seq_client_id(loopback), inPort), "the loopback port could be connected");
+
+        // 120 bpm for the first half, 180 bpm for the second one
+        const int slowTempo = 500000;
+        const int fastTempo = 333333;
+
+        CompactMidiTrack stream;
+        std::vector<double> expectedMs;
+        addTempo(stream, 0, slowTempo);
+        for (int n=0; n<NOTES; n++)
+        {
+            const int tick = n*STEP;
+            if (n == NOTES/2) addTempo(stream, tick, fastTempo);
+            stream.addChannelEvent(tick, 0x90, 60, 100);
+
+            if (n <= NOTES/2) expectedMs.push_back(tick * (slowTempo/1000.0) / PPQ);
+            else              expectedMs.push_back(expectedMs[NOTES/2] + (n - NOTES/2)*STEP*(fastTempo/1000.0)/PPQ);
+        }
+
+        LiveTrackStreams streams;
+        streams.addTrack(stream, 0);
+
+        FeederThread feeder(&player, &streams, NOTES*STEP + 1);
+        require(feeder.Create() == wxTHREAD_NO_ERROR and feeder.Run() == wxTHREAD_NO_ERROR,
+                "the feeder thread could be started");
+
+        // receive the notes as they are delivered
+        std::vector<double> arrivalMs;
+        snd_seq_nonblock(loopback, 1);
+        const int fdCount = snd_seq_poll_descriptors_count(loopback, POLLIN);
+        std::vector<pollfd> fds(fdCount);
+        snd_seq_poll_descriptors(loopback, &fds[0], fdCount, POLLIN);
+
+        const double deadline = nowMs() + expectedMs[NOTES - 1] + 2000;
+        while ((int)arrivalMs.size() < NOTES and nowMs() < deadline)
+        {
+            poll(&fds[0], fdCount, 50);
+
+            snd_seq_event_t* ev;
+            while (snd_seq_event_input(loopback, &ev) >= 0)
+            {
+                if (ev->type == SND_SEQ_EVENT_NOTEON) arrivalMs.push_back(nowMs());
+            }
+        }
+
+        player.m_stop = true;
+        feeder.Wait();
+        snd_seq_close(loopback);
+
+        require_e((int)arrivalMs.size(), ==, NOTES, "all notes were delivered");
+
+        // the first note is the reference, what matters is how regular the others are
+        double maxError   = 0;
+        double totalError = 0;
+        for (int n=1; n<NOTES; n++)
+        {
+            const double error = fabs((arrivalMs[n] - arrivalMs[0]) - (expectedMs[n] - expectedMs[0]));
+            totalError += error;
+            if (error > maxError) maxError = error;
+        }
+
+        std::cout << "[AlsaQueuePlayer] " << NOTES << " notes delivered, timing error : "
+                  << (totalError / (NOTES - 1)) << " ms on average, " << maxError << " ms at most (sleep loop : "
+                  << AlsaQueuePlayer::FEED_INTERVAL_MS << " ms)" << std::endl;
+
+        require_e(maxError, <, 10.0, "notes are delivered on time, including across the tempo change");
+    }
+}
+
+#endif
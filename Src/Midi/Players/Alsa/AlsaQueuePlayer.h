@@ -0,0 +1,88 @@
+#ifndef _alsa_queue_player_
+#define _alsa_queue_player_
+
+#include "Utils.h"
+#include <alsa/asoundlib.h>
+#include <vector>
+
+namespace AriaMaestosa
+{
+    class CompactMidiEvent;
+    class CompactMidiTrack;
+    class LiveTrackStreams;
+    class MidiDevice;
+
+    /**
+      * @ingroup midi.players
+      *
+      * Plays a song by scheduling its events on an ALSA sequencer queue, with tick timestamps, instead of
+      * sending each one when a timer wakes up. The calling thread acts as feeder : it keeps the events of
+      * a short look-ahead window scheduled, and the sequencer delivers them on time. Tempo changes are
+      * scheduled as queue tempo events.
+      */
+    class AlsaQueuePlayer
+    {
+        snd_seq_t* m_sequencer;
+        int m_queue;
+        int m_ppq;
+
+        /** our port for each output of the song (see CompactMidiEvent::getOutput) */
+        std::vector<int> m_ports;
+
+        unsigned int getQueueTick();
+        unsigned int getUsecPerBeat();
+        unsigned int getLookAheadTicks();
+        void schedule(const CompactMidiTrack& track, const CompactMidiEvent& ev, const int output,
+                      const unsigned int tick);
+        void scheduleAllNotesOff(const unsigned int tick);
+        void unschedule(const unsigned int tick);
+        void silence();
+
+    public:
+        LEAK_CHECK(AlsaQueuePlayer);
+
+        /** how far ahead of the queue position events are scheduled */
+        static const int LOOK_AHEAD_MS = 200;
+
+        /** how often the feeder wakes up to schedule more events and report progression */
+        static const int FEED_INTERVAL_MS = 10;
+
+        AlsaQueuePlayer();
+        virtual ~AlsaQueuePlayer();
+
+        /**
+          * @brief opens a sequencer client of its own and allocates its queue
+          * @param ppq  ticks per quarter note of the song
+          * @param bpm  tempo until the first tempo event of the song
+          */
+        bool open(const int ppq, const int bpm);
+
+        /** @brief adds a port for the next output of the song, connected to the given sequencer address */
+        bool addOutput(const int client, const int port);
+
+        bool addOutput(MidiDevice* device);
+
+        int getOutputAmount() const { return m_ports.size(); }
+
+        /**
+          * @brief plays the tracks of the song; returns when the song is over or when 'mustContinue'
+          *        returns false. Tracks edited while the song plays replace the scheduled events from
+          *        the next tick on (see LiveTrackStreams::applyEdits)
+          * @param loop  whether to play again from the beginning after 'songLengthInTicks'
+          * @return false if there was nothing to play
+          */
+        bool run(LiveTrackStreams& streams, const int songLengthInTicks, const bool loop);
+
+        /** @brief polled by 'run' to know whether to continue; asks PlatformMidiManager by default */
+        virtual bool mustContinue();
+
+        /**
+          * @brief called by 'run' with the tick being heard and the current tempo, and with -1 once the song
+          *        is over; forwarded to PlatformMidiManager (and its PlaybackState) by default
+          */
+        virtual void notifyTick(const int tick, const double ticksPerMs);
+    };
+
+}
+
+#endif
@@ -18,6 +18,7 @@
 #include "AriaCore.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/CommonMidiUtils.h"
+#include "Midi/CompactMidiTrack.h"
 #include "Midi/Sequence.h"
 #include "IO/MidiToMemoryStream.h"
 #include "IO/IOUtils.h"
@@ -42,8 +43,7 @@ namespace AriaMaestosa
 
     class SequencerThread : public wxThread
     {
-        jdksmidi::MIDIMultiTrack* jdkmidiseq;
-        jdksmidi::MIDISequencer* jdksequencer;
+        LiveTrackStreams m_streams;
         int songLengthInTicks;
         bool selectionOnly;
         int m_start_tick;
@@ -53,31 +53,32 @@ namespace AriaMaestosa
 
         SequencerThread(const bool selectionOnly, Sequence* sequence)
         {
-                jdkmidiseq = NULL;
-                jdksequencer = NULL;
                 SequencerThread::selectionOnly = selectionOnly;
                 SequencerThread::sequence = sequence;
         }
         ~SequencerThread()
         {
             std::cout << "cleaning up sequencer" << std::endl;
-            if(jdksequencer != NULL) delete jdksequencer;
-            if(jdkmidiseq != NULL) delete jdkmidiseq;
         }
 
         void prepareSequencer()
         {
-            jdkmidiseq = new jdksmidi::MIDIMultiTrack();
+            CompactMidiSequence tracks;
             songLengthInTicks = -1;
             int trackAmount = -1;
             m_start_tick = 0;
-            makeJDKMidiSequence(sequence, *jdkmidiseq, selectionOnly, &songLengthInTicks,
-                                &m_start_tick, &trackAmount, true /* for playback */);
+            makeCompactMidiSequence(sequence, tracks, selectionOnly, &songLengthInTicks,
+                                    &m_start_tick, &trackAmount, true /* for playback */);
 
             //std::cout << "trackAmount=" << trackAmount << " start_tick=" << m_start_tick<<
             //        " songLengthInTicks=" << songLengthInTicks << std::endl;
 
-            jdksequencer = new jdksmidi::MIDISequencer(jdkmidiseq);
+            m_streams.set(tracks);
+
+            // edits are heard while the whole song plays (not when playing a selection, or recording)
+            LiveEditQueue& edits = PlatformMidiManager::get()->getLiveEdits();
+            const bool editable = not selectionOnly and not PlatformMidiManager::get()->isRecording();
+            m_streams.listen(&edits, edits.startPlayback(m_start_tick, songLengthInTicks, editable));
         }
 
         void go(int* startTick /* out */)
@@ -98,7 +99,7 @@ namespace AriaMaestosa
         ExitCode Entry()
         {
             AriaSequenceTimer timer(sequence);
-            timer.run(jdksequencer, songLengthInTicks);
+            timer.run(m_streams, songLengthInTicks);
 
             playing = false;
             cleanup_after_playback();
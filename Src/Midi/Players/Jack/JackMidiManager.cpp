@@ -6,6 +6,7 @@
 #include <memory>
 #include <exception>
 #include <cassert>
+#include <vector>
 #include <stdint.h>
 #include <pthread.h>
 #include <jack/jack.h>
@@ -13,12 +14,50 @@
 #include <wx/wx.h>
 #include <jdksmidi/utils.h>
 #include <jdksmidi/multitrack.h>
-#include <jdksmidi/sequencer.h>
 #include "Midi/CommonMidiUtils.h"
+#include "Midi/CompactMidiTrack.h"
 #include "Midi/Sequence.h"
 #include "Midi/Players/PlatformMidiManager.h"
 
 
+// the events of a song merged in playback order, along with the time of each event in milliseconds
+struct JackStream
+{
+	JackStream(jdksmidi::MIDIMultiTrack* tracks): next(0)
+	{
+		AriaMaestosa::CompactMidiSequence compact;
+		compact.set(*tracks, tracks->GetNumTracks());
+		compact.mergeTracks(events);
+
+		// like jdksmidi::MIDISequencer, assume 120 bpm until the first tempo event
+		const int clksPerBeat = tracks->GetClksPerBeat();
+		double msPerTick = 60000.0 / (120.0 * clksPerBeat);
+		double timeMs = 0.0;
+		unsigned int lastTick = 0;
+
+		const int amount = events.getEventAmount();
+		timesMs.reserve(amount);
+		for(int n = 0; n < amount; ++n)
+		{
+			const AriaMaestosa::CompactMidiEvent& ev = events.getEvent(n);
+			timeMs += (ev.m_tick - lastTick) * msPerTick;
+			lastTick = ev.m_tick;
+			timesMs.push_back(timeMs);
+
+			if(events.isTempo(ev))
+			{
+				msPerTick = 60000.0 / ((events.getTempo32(ev) / 32.0) * clksPerBeat);
+			}
+		}
+	}
+
+	AriaMaestosa::CompactMidiTrack events;
+	std::vector<double> timesMs;
+
+	// index of the next event to send
+	int next;
+};
+
 struct ScopedLocker
 {
 	~ScopedLocker()
@@ -50,10 +89,11 @@ public:
 		jack_client_close(m_jack);
 		pthread_cond_destroy(&m_finish);
 		pthread_mutex_destroy(&m_mutex);
-		delete m_sequencer;
+		delete m_stream;
 	}
 
-	PrivateJackMidiPlayer(): m_playing(false), m_frame(0), m_sequencer(0)
+	PrivateJackMidiPlayer(): m_playing(false), m_frame(0), m_stream(0), m_state(0), m_published(0),
+		m_ticks_per_ms(0.0)
 	{
 		pthread_mutexattr_t mattr;
 		pthread_mutexattr_init(&mattr);
@@ -100,14 +140,16 @@ public:
 		}
 	}
 
-	void play(jdksmidi::MIDIMultiTrack* tracks, uint64_t frame = 0)
+	// 'state' receives the position of the player during playback, or is null (e.g. for preview notes)
+	void play(jdksmidi::MIDIMultiTrack* tracks, AriaMaestosa::PlaybackState* state = 0, uint64_t frame = 0)
 	{
-		jdksmidi::MIDISequencer* tmp = new jdksmidi::MIDISequencer(tracks);
+		JackStream* tmp = new JackStream(tracks);
 		{
 			ScopedLocker lock(&m_mutex);
-			std::swap(tmp, m_sequencer);
+			std::swap(tmp, m_stream);
 			m_frame = frame;
 			m_playing = true;
+			m_state = state;
 		}
 		delete tmp;
 	}
@@ -137,8 +179,13 @@ public:
 	int getTick()
 	{
 		ScopedLocker lock(&m_mutex);
-		assert(m_sequencer != 0);
-		return m_sequencer->GetCurrentMIDIClockTime();
+		assert(m_stream != 0);
+		const int amount = m_stream->events.getEventAmount();
+		if(amount == 0)
+		{
+			return 0;
+		}
+		return m_stream->events.getEvent(std::min(m_stream->next, amount - 1)).m_tick;
 	}
 	
 	private:
@@ -156,50 +203,101 @@ public:
 				double bgn = self->m_frame * (1000.0 / srate);
 				double end = (self->m_frame + nFrame) * (1000.0 / srate);
 
-				self->m_sequencer->GoToTimeMs(bgn);
+				JackStream* stream = self->m_stream;
+				const int amount = stream->events.getEventAmount();
 
-				float t;
-				while (self->m_sequencer->GetNextEventTimeMs(&t) && t < end)
+				// events are read in place from the stream; skip those before the start position
+				while (stream->next < amount && stream->timesMs[stream->next] < bgn)
 				{
-					int trackId;
-					jdksmidi::MIDITimedBigMessage msg;
-					self->m_sequencer->GetNextEvent(&trackId, &msg);
+					++stream->next;
+				}
+
+				while (stream->next < amount && stream->timesMs[stream->next] < end)
+				{
+					const double t = stream->timesMs[stream->next];
+					const AriaMaestosa::CompactMidiEvent& msg = stream->events.getEvent(stream->next++);
 
-					if (not msg.IsMetaEvent())
+					if (not msg.hasPayload())
 					{
-						unsigned l = msg.GetLength();
+						int l = msg.getMessageLength();
+						if(l <= 0)
+						{
+							continue;
+						}
 						assert(l < 4);
 						uint8_t* ev = jack_midi_event_reserve(
 							buf, int(t * (srate / 1000.0)) - self->m_frame, l
 						);
-						ev[0] = msg.GetStatus();
+						ev[0] = msg.m_status;
 						if(l >= 2)
 						{
-							ev[1] = msg.GetByte1();
+							ev[1] = msg.m_data1;
 						}
 						if(l >= 3)
 						{
-							ev[2] = msg.GetByte2();
+							ev[2] = msg.m_data2;
 						}
 					}
 				}
 				self->m_frame += nFrame;
 
-				if(!self->m_sequencer->GetNextEventTimeMs(&t))
+				if(stream->next >= amount)
 				{
 					self->m_playing = false;
 					pthread_cond_signal(&self->m_finish);
 				}
 			}
 
+			// tell the GUI where playback is, so it doesn't need to take the mutex
+			if(self->m_playing && self->m_state != 0)
+			{
+				publishPosition(self, srate, nFrame);
+			}
+			else if(self->m_published != 0)
+			{
+				self->m_published->publishStopped();
+				self->m_published = 0;
+			}
+
 			return 0;
 		}
 
+		static void publishPosition(PrivateJackMidiPlayer* self, unsigned srate, jack_nframes_t nFrame)
+		{
+			JackStream* stream = self->m_stream;
+			const int amount = stream->events.getEventAmount();
+			if(stream->next == 0 || amount == 0)
+			{
+				return;
+			}
+
+			// anchor on the last event sent; its time is relative to the start of the period that was just filled
+			const int last = std::min(stream->next, amount) - 1;
+			const double lastMs = stream->timesMs[last];
+			const double periodStartMs = (self->m_frame - nFrame) * (1000.0 / srate);
+
+			if(stream->next < amount && stream->timesMs[stream->next] > lastMs)
+			{
+				self->m_ticks_per_ms = (stream->events.getEvent(stream->next).m_tick -
+				                        stream->events.getEvent(last).m_tick) /
+				                       (stream->timesMs[stream->next] - lastMs);
+			}
+
+			const long long anchorUs = AriaMaestosa::PlaybackState::getTimeUs() +
+			                           (long long)((lastMs - periodStartMs) * 1000.0);
+			self->m_state->publish(stream->events.getEvent(last).m_tick, anchorUs, self->m_ticks_per_ms);
+			self->m_published = self->m_state;
+		}
+
 		jack_client_t* m_jack;
 		jack_port_t* m_port;
 		bool m_playing;
 		uint64_t m_frame;
-		jdksmidi::MIDISequencer* m_sequencer;
+		JackStream* m_stream;
+		AriaMaestosa::PlaybackState* m_state;
+		// state the position was last published to, until it is told that playback stopped
+		AriaMaestosa::PlaybackState* m_published;
+		double m_ticks_per_ms;
 		pthread_mutex_t m_mutex;
 		pthread_cond_t m_finish;
 };
@@ -283,7 +381,7 @@ public:
 		int nTrack = -1;
 		tracks.reset(new jdksmidi::MIDIMultiTrack());
 		makeJDKMidiSequence(seq, *tracks, false, &len, startTick, &nTrack, true);
-		player->play(tracks.get());
+		player->play(tracks.get(), &m_playback_state);
 
         m_start_tick = *startTick;
 		return true;
@@ -297,7 +395,7 @@ public:
 		int nTrack = -1;
 		tracks.reset(new jdksmidi::MIDIMultiTrack());
 		makeJDKMidiSequence(seq, *tracks, true, &len, startTick, &nTrack, true);
-		player->play(tracks.get());
+		player->play(tracks.get(), &m_playback_state);
 
         m_start_tick = *startTick;
         
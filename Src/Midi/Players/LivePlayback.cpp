@@ -0,0 +1,839 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Midi/Players/LivePlayback.h"
+
+#include "Actions/AddNote.h"
+#include "Midi/CommonMidiUtils.h"
+#include "Midi/MeasureData.h"
+#include "Midi/Players/PlaybackState.h"
+#include "Midi/Track.h"
+#include "UnitTest.h"
+#include "UnitTestUtils.h"
+
+#include "jdksmidi/multitrack.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+using namespace AriaMaestosa;
+
+#if 0
+#pragma mark LiveEditQueue
+#endif
+
+LiveEditQueue::LiveEditQueue()
+{
+    m_head             = NULL;
+    m_generation       = 0;
+    m_start_tick       = 0;
+    m_song_length      = 0;
+    m_editable         = 0;
+    m_latency_count    = 0;
+    m_latency_total_us = 0;
+    m_latency_max_us   = 0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+LiveEditQueue::~LiveEditQueue()
+{
+    deleteAll(takeAll());
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditQueue::deleteAll(Replacement* list)
+{
+    while (list != NULL)
+    {
+        Replacement* next = list->m_next;
+        delete list;
+        list = next;
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+unsigned int LiveEditQueue::startPlayback(const int startTick, const int songLengthInTicks, const bool editable)
+{
+    // whatever was rebuilt for the previous song will never be played
+    deleteAll(takeAll());
+
+    m_start_tick  = startTick;
+    m_song_length = songLengthInTicks;
+    __atomic_store_n(&m_editable, (editable ? 1 : 0), __ATOMIC_RELEASE);
+
+    __atomic_store_n(&m_latency_count,    0, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_latency_total_us, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_latency_max_us,   0, __ATOMIC_RELAXED);
+
+    return __atomic_add_fetch(&m_generation, 1, __ATOMIC_ACQ_REL);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditQueue::post(Replacement* replacement)
+{
+    Replacement* head = __atomic_load_n(&m_head, __ATOMIC_RELAXED);
+    do
+    {
+        replacement->m_next = head;
+    }
+    while (not __atomic_compare_exchange_n(&m_head, &head, replacement, true /* weak */,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+LiveEditQueue::Replacement* LiveEditQueue::takeAll()
+{
+    Replacement* list = __atomic_exchange_n(&m_head, (Replacement*)NULL, __ATOMIC_ACQUIRE);
+
+    // the list has the latest replacement first, reverse it
+    Replacement* ordered = NULL;
+    while (list != NULL)
+    {
+        Replacement* next = list->m_next;
+        list->m_next = ordered;
+        ordered = list;
+        list = next;
+    }
+    return ordered;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditQueue::recordLatency(const long long us)
+{
+    // only the player writes, the GUI reads the statistics when playback is over
+    __atomic_add_fetch(&m_latency_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m_latency_total_us, us, __ATOMIC_RELAXED);
+    if (us > __atomic_load_n(&m_latency_max_us, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&m_latency_max_us, us, __ATOMIC_RELAXED);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditQueue::getLatency(/*out*/ int* count, /*out*/ double* meanMs, /*out*/ double* maxMs) const
+{
+    *count = __atomic_load_n(&m_latency_count, __ATOMIC_RELAXED);
+
+    const long long totalUs = __atomic_load_n(&m_latency_total_us, __ATOMIC_RELAXED);
+    *meanMs = (*count > 0 ? totalUs / 1000.0 / *count : 0.0);
+    *maxMs  = __atomic_load_n(&m_latency_max_us, __ATOMIC_RELAXED) / 1000.0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#pragma mark LiveTrackStreams
+#endif
+
+namespace AriaMaestosa
+{
+    /** @return the index of the first event of the track at or after the given tick */
+    int findFirstEventAt(const CompactMidiTrack& track, const unsigned int tick)
+    {
+        const std::vector<CompactMidiEvent>& events = track.getEvents();
+        int low  = 0;
+        int high = events.size();
+        while (low < high)
+        {
+            const int middle = (low + high) / 2;
+            if (events[middle].m_tick < tick) low = middle + 1;
+            else                              high = middle;
+        }
+        return low;
+    }
+
+    /** what the first events of a track leave behind on the channels it plays on */
+    struct ChannelState
+    {
+        /** for each (channel << 7 | note), how many times it was started and not ended */
+        std::map<int, int> m_notes;
+
+        /**
+          * for each (status << 8 | controller) of control change, program change and pitch bend events,
+          * the last (data1 | data2 << 8) sent
+          */
+        std::map<int, int> m_values;
+
+        void read(const CompactMidiTrack& track, const int eventAmount)
+        {
+            for (int n=0; n<eventAmount; n++)
+            {
+                const CompactMidiEvent& ev = track.getEvent(n);
+                if (ev.hasPayload()) continue;
+
+                const int note = (ev.getChannel() << 7) | ev.m_data1;
+                switch (ev.getType())
+                {
+                    case 0x90:
+                        if (ev.m_data2 > 0) m_notes[note]++;
+                        else                m_notes[note]--;
+                        break;
+                    case 0x80:
+                        m_notes[note]--;
+                        break;
+                    case 0xB0:
+                        m_values[(ev.m_status << 8) | ev.m_data1] = ev.m_data1 | (ev.m_data2 << 8);
+                        break;
+                    case 0xC0:
+                    case 0xE0:
+                        m_values[ev.m_status << 8] = ev.m_data1 | (ev.m_data2 << 8);
+                        break;
+                }
+            }
+        }
+
+        bool isSounding(const int note) const
+        {
+            std::map<int, int>::const_iterator it = m_notes.find(note);
+            return (it != m_notes.end() and it->second > 0);
+        }
+    };
+}
+
+LiveTrackStreams::LiveTrackStreams()
+{
+    m_edits      = NULL;
+    m_generation = 0;
+    clear();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::clear()
+{
+    m_tracks.clearAndDeleteAll();
+    m_outputs.clear();
+    m_positions.clear();
+    m_output_amount = 1;
+    rewind();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::set(CompactMidiSequence& tracks)
+{
+    clear();
+
+    const int trackAmount = tracks.getTrackAmount();
+    for (int n=0; n<trackAmount; n++)
+    {
+        CompactMidiTrack* track = new CompactMidiTrack();
+        tracks.swapTrack(n, *track);
+        m_tracks.push_back(track);
+        m_outputs.push_back(tracks.getTrackOutput(n));
+        m_positions.push_back(0);
+        m_output_amount = std::max(m_output_amount, tracks.getTrackOutput(n) + 1);
+    }
+    rewind();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::addTrack(CompactMidiTrack& events, const int output)
+{
+    CompactMidiTrack* track = new CompactMidiTrack();
+    track->swap(events);
+    m_tracks.push_back(track);
+    m_outputs.push_back(output);
+    m_positions.push_back(0);
+    m_output_amount = std::max(m_output_amount, output + 1);
+    rewind();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::listen(LiveEditQueue* edits, const unsigned int generation)
+{
+    m_edits      = edits;
+    m_generation = generation;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int LiveTrackStreams::getEventAmount() const
+{
+    int total = 0;
+    const int trackAmount = m_tracks.size();
+    for (int n=0; n<trackAmount; n++) total += m_tracks[n].getEventAmount();
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::findNextTrack()
+{
+    // same order as CompactMidiSequence::mergeTracks : the scan starts after the track the previous
+    // event came from, so that tracks take turns when their events happen at the same tick
+    const int trackAmount = m_tracks.size();
+    m_next_track = -1;
+    unsigned int min_tick = 0;
+    for (int j=0; j<trackAmount; j++)
+    {
+        const int n = (j + m_current_track + 1) % trackAmount;
+        if (m_positions[n] >= m_tracks[n].getEventAmount()) continue;
+
+        const unsigned int tick = m_tracks[n].getEvent(m_positions[n]).m_tick;
+        if (m_next_track == -1 or tick < min_tick)
+        {
+            m_next_track = n;
+            min_tick     = tick;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int LiveTrackStreams::getNextTick() const
+{
+    if (m_next_track == -1) return -1;
+    return m_tracks[m_next_track].getEvent(m_positions[m_next_track]).m_tick;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+const CompactMidiEvent* LiveTrackStreams::next(const CompactMidiTrack** track, int* output)
+{
+    if (m_next_track == -1) return NULL;
+
+    const int n = m_next_track;
+    const CompactMidiEvent* ev = &m_tracks[n].getEvent(m_positions[n]++);
+    if (track  != NULL) *track  = m_tracks.get(n);
+    if (output != NULL) *output = m_outputs[n];
+
+    m_current_track = n;
+    m_last_tick     = ev->m_tick;
+    findNextTrack();
+    return ev;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::rewind()
+{
+    std::fill(m_positions.begin(), m_positions.end(), 0);
+    m_current_track = 0;
+    m_last_tick     = -1;
+    findNextTrack();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::seek(const unsigned int tick)
+{
+    const int trackAmount = m_tracks.size();
+    for (int n=0; n<trackAmount; n++) m_positions[n] = findFirstEventAt(m_tracks[n], tick);
+
+    m_current_track = 0;
+    m_last_tick     = (int)tick - 1;
+    findNextTrack();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool LiveTrackStreams::applyEdits(/*out*/ CompactMidiTrack& chase)
+{
+    chase.clear();
+    if (m_edits == NULL or not m_edits->hasPending()) return false;
+
+    const unsigned int resumeTick = m_last_tick + 1;
+    const long long nowUs = PlaybackState::getTimeUs();
+
+    bool replaced = false;
+    LiveEditQueue::Replacement* list = m_edits->takeAll();
+    while (list != NULL)
+    {
+        LiveEditQueue::Replacement* replacement = list;
+        list = list->m_next;
+
+        const int track = replacement->m_track;
+        if (replacement->m_generation == m_generation and track >= 0 and track < (int)m_tracks.size())
+        {
+            replaceTrack(track, replacement->m_stream, replacement->m_output, resumeTick, chase);
+            m_edits->recordLatency(nowUs - replacement->m_edit_us);
+            replaced = true;
+        }
+
+        // along with the previous events of the track, now swapped into it
+        delete replacement;
+    }
+
+    if (replaced) findNextTrack();
+    return replaced;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveTrackStreams::replaceTrack(const int track, CompactMidiTrack& events, const int output,
+                                    const unsigned int resumeTick, CompactMidiTrack& chase)
+{
+    ChannelState before;
+    before.read(m_tracks[track], findFirstEventAt(m_tracks[track], resumeTick));
+
+    m_tracks[track].swap(events);
+
+    const int position = findFirstEventAt(m_tracks[track], resumeTick);
+    ChannelState after;
+    after.read(m_tracks[track], position);
+
+    m_positions[track] = position;
+
+    const int previousOutput = m_outputs[track];
+    m_outputs[track] = output;
+    m_output_amount = std::max(m_output_amount, output + 1);
+
+    // end the notes that the new events won't end
+    for (std::map<int, int>::const_iterator it = before.m_notes.begin(); it != before.m_notes.end(); it++)
+    {
+        if (it->second <= 0) continue;
+        if (output == previousOutput and after.isSounding(it->first)) continue;
+
+        chase.addChannelEvent(resumeTick, 0x80 | (it->first >> 7), it->first & 0x7F, 0, previousOutput);
+    }
+
+    // and leave the channels as if the new events had been played from the start
+    for (std::map<int, int>::const_iterator it = after.m_values.begin(); it != after.m_values.end(); it++)
+    {
+        if (output == previousOutput)
+        {
+            std::map<int, int>::const_iterator previous = before.m_values.find(it->first);
+            if (previous != before.m_values.end() and previous->second == it->second) continue;
+        }
+
+        chase.addChannelEvent(resumeTick, it->first >> 8, it->second & 0xFF, it->second >> 8, output);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#pragma mark LiveEditRebuilder
+#endif
+
+LiveEditRebuilder::LiveEditRebuilder(Sequence* sequence, LiveEditQueue* edits) : wxThread(wxTHREAD_JOINABLE),
+    m_has_work(m_mutex), m_idle(m_mutex)
+{
+    m_sequence   = sequence;
+    m_edits      = edits;
+    m_generation = edits->getGeneration();
+    m_song_length = edits->getSongLength();
+
+    MeasureData* md = sequence->getMeasureData();
+    m_first_measure = (edits->getStartTick() > 0 ? md->measureAtTick(edits->getStartTick()) : 0);
+
+    // channels and outputs are picked like makeCompactMidiSequence did when playback started
+    m_channels = getTrackChannels(sequence);
+
+    wxArrayString outputNames;
+    m_outputs = getTrackOutputs(sequence, outputNames);
+
+    const int trackAmount = sequence->getTrackAmount();
+    for (int n=0; n<trackAmount; n++) m_tracks.push_back(sequence->getTrack(n));
+
+    m_edit_us.assign(trackAmount, -1);
+    m_has_edits  = false;
+    m_edit_depth = 0;
+    m_building   = false;
+    m_quit       = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool LiveEditRebuilder::start()
+{
+    if (not m_edits->isEditable() or m_song_length < 1) return false;
+    if (Create() != wxTHREAD_NO_ERROR or Run() != wxTHREAD_NO_ERROR) return false;
+
+    m_sequence->setTrackEditListener(this);
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditRebuilder::stop()
+{
+    m_sequence->setTrackEditListener(NULL);
+    {
+        wxMutexLocker lock(m_mutex);
+        m_quit = true;
+        m_has_work.Signal();
+    }
+    Wait();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditRebuilder::onBeforeTrackEdit()
+{
+    wxMutexLocker lock(m_mutex);
+
+    // the thread must be done reading tracks before they are modified
+    while (m_building) m_idle.Wait();
+    m_edit_depth++;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditRebuilder::onTrackEdited(Track* track)
+{
+    const long long nowUs = PlaybackState::getTimeUs();
+
+    wxMutexLocker lock(m_mutex);
+    if (m_edit_depth > 0) m_edit_depth--;
+
+    const int trackAmount = m_tracks.size();
+    for (int n=0; n<trackAmount; n++)
+    {
+        if (track != NULL and m_tracks[n] != track) continue;
+
+        // when a track is edited again before it was rebuilt, the latency counts from the first edit
+        if (m_edit_us[n] < 0) m_edit_us[n] = nowUs;
+        m_has_edits = true;
+    }
+
+    if (m_has_edits and m_edit_depth == 0) m_has_work.Signal();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditRebuilder::rebuild(const int track, const long long editUs)
+{
+    LiveEditQueue::Replacement* replacement = new LiveEditQueue::Replacement();
+    replacement->m_generation = m_generation;
+    replacement->m_track      = track + 1; // MIDI track 0 holds the tempo events
+    replacement->m_output     = m_outputs[track];
+    replacement->m_edit_us    = editUs;
+    replacement->m_next       = NULL;
+
+    // the track may have been moved, or deleted, since playback started
+    int trackId = -1;
+    const int trackAmount = m_sequence->getTrackAmount();
+    for (int n=0; n<trackAmount; n++)
+    {
+        if (m_sequence->getTrack(n) == m_tracks[track]) trackId = n;
+    }
+
+    if (trackId != -1)
+    {
+        makeCompactMidiTrack(m_sequence, trackId, m_channels[track], m_first_measure, m_song_length,
+                             replacement->m_stream);
+    }
+    else
+    {
+        // a deleted track is silent, it only keeps the dummy end event (see makeCompactMidiTrack)
+        replacement->m_stream.addChannelEvent(m_song_length, 0xB0, 0, 127);
+    }
+
+    m_edits->post(replacement);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+wxThread::ExitCode LiveEditRebuilder::Entry()
+{
+    std::vector<long long> editUs;
+
+    m_mutex.Lock();
+    while (true)
+    {
+        while ((not m_has_edits or m_edit_depth > 0) and not m_quit) m_has_work.Wait();
+        if (m_quit) break;
+
+        // take all edits at once, tracks edited several times are only rebuilt once
+        editUs.swap(m_edit_us);
+        m_edit_us.assign(editUs.size(), -1);
+        m_has_edits = false;
+        m_building  = true;
+        m_mutex.Unlock();
+
+        const int trackAmount = editUs.size();
+        for (int n=0; n<trackAmount; n++)
+        {
+            if (editUs[n] >= 0) rebuild(n, editUs[n]);
+        }
+
+        m_mutex.Lock();
+        m_building = false;
+        m_idle.Broadcast();
+    }
+    m_mutex.Unlock();
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void LiveEditRebuilder::waitUntilPosted()
+{
+    wxMutexLocker lock(m_mutex);
+    while ((m_has_edits and not m_quit) or m_building) m_idle.Wait();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestLivePlayback
+{
+    using namespace AriaMaestosa;
+
+    /** @return the events of the first 'amount' note on events of a stream, as (tick, status, note) */
+    std::vector<int> readNotes(LiveTrackStreams& streams, const int amount)
+    {
+        std::vector<int> out;
+        while ((int)out.size() < amount*3 and streams.hasNext())
+        {
+            const CompactMidiEvent* ev = streams.next(NULL, NULL);
+            if (ev->getType() != 0x90) continue;
+            out.push_back(ev->m_tick);
+            out.push_back(ev->m_status);
+            out.push_back(ev->m_data1);
+        }
+        return out;
+    }
+
+    UNIT_TEST(TestSameOrderAsMergedTracks)
+    {
+        const int TRACKS = 5;
+
+        CompactMidiSequence sequence;
+        jdksmidi::MIDIMultiTrack jdkTracks(TRACKS);
+        sequence.set(jdkTracks, TRACKS);
+
+        // tracks have notes at the same ticks, to check that they take turns the same way
+        std::vector<CompactMidiTrack> tracks(TRACKS);
+        for (int n=0; n<TRACKS; n++)
+        {
+            for (int tick=0; tick<2000; tick += 60*(n % 3 + 1))
+            {
+                tracks[n].addChannelEvent(tick, 0x90 | n, 60 + n, 100);
+                tracks[n].addChannelEvent(tick + 30, 0x80 | n, 60 + n, 0);
+            }
+            sequence.swapTrack(n, tracks[n]);
+            sequence.setTrackOutput(n, n % 2);
+        }
+
+        CompactMidiTrack merged;
+        sequence.mergeTracks(merged);
+
+        LiveTrackStreams streams;
+        streams.set(sequence);
+        require_e(streams.getEventAmount(), ==, merged.getEventAmount(), "all events are played");
+        require_e(streams.getOutputAmount(), ==, merged.getOutputAmount(), "all outputs are played");
+
+        for (int n=0; n<merged.getEventAmount(); n++)
+        {
+            int output = -1;
+            const CompactMidiEvent* ev = streams.next(NULL, &output);
+            require(ev != NULL, "all events are played");
+            require_e(ev->m_tick,   ==, merged.getEvent(n).m_tick,   "events are played in the same order");
+            require_e(ev->m_status, ==, merged.getEvent(n).m_status, "events are played in the same order");
+            require_e(output,       ==, merged.getEvent(n).getOutput(), "events are played on their output");
+        }
+        require(not streams.hasNext(), "all events were played");
+    }
+
+    UNIT_TEST(TestReplaceTrackWhilePlaying)
+    {
+        LiveEditQueue edits;
+        const unsigned int generation = edits.startPlayback(0, 4000, true);
+
+        // track 0 : a long note and the instrument, track 1 : a note every 100 ticks
+        CompactMidiTrack conductor;
+        conductor.addChannelEvent(0, 0xC0 | 2, 10, 0);
+        conductor.addChannelEvent(0, 0x90 | 2, 40, 100);
+        conductor.addChannelEvent(3000, 0x80 | 2, 40, 0);
+        CompactMidiTrack pulse;
+        for (int tick=0; tick<4000; tick += 100) pulse.addChannelEvent(tick, 0x90 | 3, 70, 100);
+
+        LiveTrackStreams streams;
+        streams.addTrack(conductor, 0);
+        streams.addTrack(pulse, 0);
+        streams.listen(&edits, generation);
+
+        // play until tick 1000
+        while (streams.getNextTick() <= 1000) streams.next(NULL, NULL);
+
+        CompactMidiTrack chase;
+        require(not streams.applyEdits(chase), "nothing to replace until a track is posted");
+
+        // the long note is moved to another pitch, and the instrument changed
+        LiveEditQueue::Replacement* replacement = new LiveEditQueue::Replacement();
+        replacement->m_generation = generation;
+        replacement->m_track      = 0;
+        replacement->m_output     = 0;
+        replacement->m_edit_us    = PlaybackState::getTimeUs();
+        replacement->m_stream.addChannelEvent(0, 0xC0 | 2, 20, 0);
+        replacement->m_stream.addChannelEvent(0, 0x90 | 2, 45, 100);
+        replacement->m_stream.addChannelEvent(1500, 0x90 | 2, 50, 100);
+        replacement->m_stream.addChannelEvent(3000, 0x80 | 2, 45, 0);
+        edits.post(replacement);
+
+        // and a replacement left from a previous playback is ignored
+        LiveEditQueue::Replacement* stale = new LiveEditQueue::Replacement();
+        stale->m_generation = generation - 1;
+        stale->m_track      = 1;
+        stale->m_output     = 0;
+        stale->m_edit_us    = 0;
+        edits.post(stale);
+
+        require(streams.applyEdits(chase), "the posted track replaced the one being played");
+        require_e(chase.getEventAmount(), ==, 2, "the old note is ended and the new instrument is set");
+        require_e(chase.getEvent(0).getType(), ==, 0x80, "the note of the previous events is ended");
+        require_e(chase.getEvent(0).m_data1,   ==, 40,   "the note of the previous events is ended");
+        require_e(chase.getEvent(1).getType(), ==, 0xC0, "the instrument is set as the new events left it");
+        require_e(chase.getEvent(1).m_data1,   ==, 20,   "the instrument is set as the new events left it");
+
+        // playback goes on where it was, with the new events
+        const std::vector<int> notes = readNotes(streams, 3);
+        require_e(notes.size(), ==, 9u, "playback goes on");
+        require_e(notes[0], ==, 1100, "the other track is not disturbed");
+        require_e(notes[3], ==, 1200, "the other track is not disturbed");
+        require_e(notes[6], ==, 1300, "the other track is not disturbed");
+
+        while (streams.hasNext())
+        {
+            const CompactMidiEvent* ev = streams.next(NULL, NULL);
+            if (ev->m_tick == 1500 and ev->getChannel() == 2)
+            {
+                require_e((int)ev->m_data1, ==, 50, "the new events of the replaced track are played");
+            }
+        }
+
+        int count = 0;
+        double meanMs = 0, maxMs = 0;
+        edits.getLatency(&count, &meanMs, &maxMs);
+        require_e(count, ==, 1, "the latency of the edit was measured");
+    }
+
+    /** Stand-in for the sequencer thread : reads the events of the song and picks up the rebuilt tracks */
+    class PlayerThread : public wxThread
+    {
+        LiveTrackStreams* m_streams;
+
+    public:
+        volatile bool m_stop;
+        volatile int  m_replacements;
+
+        PlayerThread(LiveTrackStreams* streams) : wxThread(wxTHREAD_JOINABLE)
+        {
+            m_streams      = streams;
+            m_stop         = false;
+            m_replacements = 0;
+        }
+
+        virtual ExitCode Entry()
+        {
+            CompactMidiTrack chase;
+            while (not m_stop)
+            {
+                if (m_streams->applyEdits(chase)) m_replacements++;
+                wxMilliSleep(1);
+            }
+            return 0;
+        }
+    };
+
+    UNIT_TEST(TestEditToAudibleLatency)
+    {
+        const int TRACKS = 16;
+        const int EDITS  = 50;
+
+        Sequence* seq = new Sequence(NULL, NULL, NULL, NULL, false);
+        seq->setChannelManagementType(CHANNEL_MANUAL);
+        TestSequenceProvider provider(seq);
+        AriaMaestosa::setCurrentSequenceProvider(&provider);
+
+        {
+            ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+            tr->setMeasureAmount(200);
+        }
+
+        for (int t=0; t<TRACKS; t++)
+        {
+            Track* track = new Track(seq);
+            {
+                OwnerPtr<Sequence::Import> import(seq->startImport());
+                for (int n=0; n<2000; n++)
+                {
+                    track->addNote_import(40 + (n + t) % 40, n*240, n*240 + 200, 100, -1);
+                }
+            }
+            seq->addTrack(track);
+        }
+
+        LiveEditQueue edits;
+        CompactMidiSequence tracks;
+        int length = -1, start = -1, numTracks = -1;
+        require(makeCompactMidiSequence(seq, tracks, false, &length, &start, &numTracks, true),
+                "the song could be generated");
+
+        LiveTrackStreams streams;
+        streams.set(tracks);
+        streams.listen(&edits, edits.startPlayback(start, length, true));
+
+        PlayerThread player(&streams);
+        require(player.Create() == wxTHREAD_NO_ERROR and player.Run() == wxTHREAD_NO_ERROR,
+                "the player thread could be started");
+
+        LiveEditRebuilder rebuilder(seq, &edits);
+        require(rebuilder.start(), "a song played from the start can be edited live");
+
+        for (int n=0; n<EDITS; n++)
+        {
+            seq->getTrack(n % TRACKS)->action(new Action::AddNote(90, n*240 + 100, n*240 + 150, 80, -1));
+            wxMilliSleep(5);
+        }
+
+        // wait for the last edits to be heard
+        rebuilder.waitUntilPosted();
+        for (int n=0; n<1000 and edits.hasPending(); n++) wxMilliSleep(1);
+        rebuilder.stop();
+        player.m_stop = true;
+        player.Wait();
+
+        int count = 0;
+        double meanMs = 0, maxMs = 0;
+        edits.getLatency(&count, &meanMs, &maxMs);
+        require_e(count, >, 0, "edits were heard while playing");
+        require_e(count, <=, EDITS, "each track is replaced at most once per edit");
+
+        // the last version of each track is the one being played
+        CompactMidiSequence expected;
+        makeCompactMidiSequence(seq, expected, false, &length, &start, &numTracks, true);
+        for (int t=0; t<TRACKS; t++)
+        {
+            require_e(streams.getTrack(t + 1).getEventAmount(), ==, expected.getTrack(t + 1).getEventAmount(),
+                      "the edited tracks are played as they are after the edits");
+        }
+
+        std::cout << "[LivePlayback] " << count << " replacements for " << EDITS << " edits on " << TRACKS
+                  << " tracks of 2000 notes, edit-to-audible latency : " << meanMs << " ms on average, "
+                  << maxMs << " ms at most" << std::endl;
+
+        delete seq;
+    }
+}
@@ -0,0 +1,295 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __LIVE_PLAYBACK_H__
+#define __LIVE_PLAYBACK_H__
+
+#include "Midi/CompactMidiTrack.h"
+#include "Midi/Sequence.h"
+#include "ptr_vector.h"
+#include "Utils.h"
+
+#include <vector>
+#include <wx/thread.h>
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief carries the tracks rebuilt after an edit to the thread that plays the song
+      *
+      * Edits are made on the GUI thread, the track they modified is rebuilt on a worker thread (see
+      * LiveEditRebuilder), and the player picks it up between two events (see LiveTrackStreams::applyEdits).
+      * Rebuilt tracks are pushed on a lock-free list, and the player takes the whole list at once by
+      * swapping its head pointer with NULL, so the player never waits on the GUI or the worker.
+      *
+      * One instance lives as long as the PlatformMidiManager; each playback gets a generation number,
+      * so that tracks rebuilt for a song that was stopped are never played in the next one.
+      *
+      * @ingroup midi.players
+      */
+    class LiveEditQueue
+    {
+    public:
+
+        /** a track rebuilt after an edit */
+        struct Replacement
+        {
+            /** playback the track was built for, see startPlayback */
+            unsigned int     m_generation;
+
+            /** index of the track among the tracks being played (Aria track n is played as track n+1) */
+            int              m_track;
+
+            /** output the channel events of the track are routed to */
+            int              m_output;
+
+            /** when the edit was committed, see PlaybackState::getTimeUs */
+            long long        m_edit_us;
+
+            CompactMidiTrack m_stream;
+
+            Replacement*     m_next;
+        };
+
+    private:
+
+        Replacement* m_head;
+        unsigned int m_generation;
+
+        int m_start_tick;
+        int m_song_length;
+        int m_editable;
+
+        int       m_latency_count;
+        long long m_latency_total_us;
+        long long m_latency_max_us;
+
+        static void deleteAll(Replacement* list);
+
+    public:
+        LEAK_CHECK(LiveEditQueue);
+
+        LiveEditQueue();
+        ~LiveEditQueue();
+
+        /**
+          * @brief called by the player before it starts playing a song (before MainPane::enterPlayLoop)
+          * @param startTick          tick playback starts from, as given by makeCompactMidiSequence
+          * @param songLengthInTicks  as given by makeCompactMidiSequence
+          * @param editable           whether edits should be heard while playing (not when playing a selection)
+          * @return the generation of this playback, see LiveTrackStreams::listen
+          */
+        unsigned int startPlayback(const int startTick, const int songLengthInTicks, const bool editable);
+
+        unsigned int getGeneration() const { return __atomic_load_n(&m_generation, __ATOMIC_ACQUIRE); }
+        int          getStartTick()  const { return m_start_tick;  }
+        int          getSongLength() const { return m_song_length; }
+        bool         isEditable()    const { return __atomic_load_n(&m_editable, __ATOMIC_ACQUIRE) != 0; }
+
+        /** @brief may be called from any thread; the queue takes ownership of the replacement */
+        void post(Replacement* replacement);
+
+        /** @return whether replacements were posted and not taken yet */
+        bool hasPending() const { return __atomic_load_n(&m_head, __ATOMIC_ACQUIRE) != NULL; }
+
+        /**
+          * @brief takes all replacements posted so far, in the order they were posted (follow 'm_next');
+          *        the caller takes ownership of them
+          */
+        Replacement* takeAll();
+
+        /** @brief called by the player when it starts playing a replacement, 'us' after its edit */
+        void recordLatency(const long long us);
+
+        /** @brief edit-to-audible latency of the edits heard in the current playback */
+        void getLatency(/*out*/ int* count, /*out*/ double* meanMs, /*out*/ double* maxMs) const;
+    };
+
+    /**
+      * @brief the tracks of a song being played, read in time order by the player
+      *
+      * Events are read in the same order as CompactMidiSequence::mergeTracks would have merged them, but
+      * each track keeps its own events, so that a track can be replaced while the song plays (see
+      * applyEdits) without touching the others.
+      *
+      * Only note tracks are ever replaced: the first track, which holds the tempo and time signature
+      * events, is played as it was when playback started, so tempo edits are only heard once playback
+      * is restarted.
+      *
+      * Only to be used by the thread that plays the song (once playback started).
+      *
+      * @ingroup midi.players
+      */
+    class LiveTrackStreams
+    {
+        ptr_vector<CompactMidiTrack> m_tracks;
+        std::vector<int> m_outputs;
+        std::vector<int> m_positions;
+
+        /** track the previous event came from, where the search for the next one starts */
+        int m_current_track;
+
+        /** track the next event comes from, or -1 if all events were read */
+        int m_next_track;
+
+        /** tick of the previous event, -1 before the first one */
+        int m_last_tick;
+
+        int m_output_amount;
+
+        LiveEditQueue* m_edits;
+        unsigned int   m_generation;
+
+        void findNextTrack();
+        void replaceTrack(const int track, CompactMidiTrack& events, const int output,
+                          const unsigned int resumeTick, CompactMidiTrack& chase);
+
+    public:
+        LEAK_CHECK(LiveTrackStreams);
+
+        LiveTrackStreams();
+
+        /** @brief plays the tracks of 'tracks' (they are moved out of it, not copied) */
+        void set(CompactMidiSequence& tracks);
+
+        /** @brief adds a track to play (its events are moved out of 'events', not copied) */
+        void addTrack(CompactMidiTrack& events, const int output);
+
+        void clear();
+
+        /**
+          * @brief makes the tracks posted to 'edits' for the given playback replace the tracks being played
+          *        (see applyEdits)
+          */
+        void listen(LiveEditQueue* edits, const unsigned int generation);
+
+        int getTrackAmount() const { return m_tracks.size(); }
+        const CompactMidiTrack& getTrack(const int track) const { return m_tracks[track]; }
+
+        /** @return the total number of events of all tracks */
+        int getEventAmount() const;
+
+        /** @return 1 + the highest output a track is routed to */
+        int getOutputAmount() const { return m_output_amount; }
+
+        bool hasNext() const { return m_next_track != -1; }
+
+        /** @return whether tracks were posted for applyEdits to pick up */
+        bool hasPendingEdits() const { return m_edits != NULL and m_edits->hasPending(); }
+
+        /** @return the tick of the next event, or -1 if all events were read */
+        int getNextTick() const;
+
+        /**
+          * @brief reads the next event
+          * @param[out] track   if not NULL, receives the track the event belongs to (e.g. for the payload of
+          *                     meta events)
+          * @param[out] output  if not NULL, receives the output the event is routed to
+          * @return the event, or NULL if all events were read
+          */
+        const CompactMidiEvent* next(const CompactMidiTrack** track, int* output);
+
+        /** @brief goes back to the first event (e.g. when looping) */
+        void rewind();
+
+        /** @brief goes to the first event at or after the given tick */
+        void seek(const unsigned int tick);
+
+        /**
+          * @brief replaces the tracks that were rebuilt after an edit (see LiveEditQueue)
+          *
+          * Each new track resumes with its first event after the previous event read. Notes the previous
+          * events of the track left sounding, and that the new events won't end, are ended; the instrument,
+          * controllers and pitch bend are set as the new events left them. The events to send for that
+          * are given in 'chase', routed like the events of a playback stream (see CompactMidiEvent::getOutput).
+          *
+          * @return whether a track was replaced
+          */
+        bool applyEdits(/*out*/ CompactMidiTrack& chase);
+    };
+
+    /**
+      * @brief rebuilds the tracks modified by edits made while the song plays, and posts them to the
+      *        player (see LiveEditQueue)
+      *
+      * Listens to the edits of the sequence being played, and rebuilds the events of the tracks they
+      * modified on a thread of its own, so that editing stays as fast as when the song is not playing.
+      * The thread only reads tracks between edits (see ITrackEditListener::onBeforeTrackEdit).
+      *
+      * Channels and outputs are the ones tracks were given when playback started; tracks added while
+      * the song plays are not heard, edits can't make the song longer, and tempo edits are not heard
+      * (see LiveTrackStreams).
+      *
+      * @ingroup midi.players
+      */
+    class LiveEditRebuilder : public wxThread, public ITrackEditListener
+    {
+        Sequence*      m_sequence;
+        LiveEditQueue* m_edits;
+        unsigned int   m_generation;
+        int            m_first_measure;
+        int            m_song_length;
+
+        /** the tracks of the sequence when playback started, and how they are played */
+        std::vector<Track*> m_tracks;
+        std::vector<int>    m_channels;
+        std::vector<int>    m_outputs;
+
+        /** for each track, time of its oldest edit that was not rebuilt yet, or -1 */
+        std::vector<long long> m_edit_us;
+        bool m_has_edits;
+
+        wxMutex     m_mutex;
+        wxCondition m_has_work;
+        wxCondition m_idle;
+
+        /** number of edits being made (edits can be nested) */
+        int  m_edit_depth;
+
+        /** whether the thread is reading tracks */
+        bool m_building;
+        bool m_quit;
+
+        void rebuild(const int track, const long long editUs);
+
+    public:
+        LEAK_CHECK(LiveEditRebuilder);
+
+        LiveEditRebuilder(Sequence* sequence, LiveEditQueue* edits);
+
+        /**
+          * @brief starts listening to the edits of the sequence
+          * @return false if the song being played can't be edited live (e.g. when playing a selection)
+          */
+        bool start();
+
+        /** @brief stops listening, and waits for the thread to end */
+        void stop();
+
+        /** @brief waits until the tracks modified by the edits made so far were posted to the player */
+        void waitUntilPosted();
+
+        virtual void onBeforeTrackEdit();
+        virtual void onTrackEdited(Track* track);
+
+        virtual ExitCode Entry();
+    };
+
+}
+
+#endif
@@ -29,6 +29,7 @@
 #include "IO/MidiToMemoryStream.h"
 #include "IO/IOUtils.h"
 #include "Midi/CommonMidiUtils.h"
+#include "Midi/CompactMidiTrack.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Players/Mac/AudioUnitOutput.h"
 #include "Midi/Players/Mac/CoreMIDIOutput.h"
@@ -193,8 +194,7 @@ namespace AriaMaestosa
       */
     class SequencerThread : public wxThread
     {
-        jdksmidi::MIDIMultiTrack* jdkmidiseq;
-        jdksmidi::MIDISequencer* jdksequencer;
+        LiveTrackStreams m_streams;
         int songLengthInTicks;
         bool m_selection_only;
         int m_start_tick;
@@ -205,29 +205,30 @@ namespace AriaMaestosa
         SequencerThread(Sequence* seq, const bool selectionOnly)
         {
             m_sequence = seq;
-            jdkmidiseq = NULL;
-            jdksequencer = NULL;
             m_selection_only = selectionOnly;
         }
         ~SequencerThread()
         {
-            if (jdksequencer != NULL) delete jdksequencer;
-            if (jdkmidiseq != NULL) delete jdkmidiseq;
         }
         
         void prepareSequencer()
         {
-            jdkmidiseq = new jdksmidi::MIDIMultiTrack();
+            CompactMidiSequence tracks;
             songLengthInTicks = -1;
             int trackAmount = -1;
             m_start_tick = 0;
-            makeJDKMidiSequence(m_sequence, *jdkmidiseq, m_selection_only, &songLengthInTicks,
-                                &m_start_tick, &trackAmount, true /* for playback */);
+            makeCompactMidiSequence(m_sequence, tracks, m_selection_only, &songLengthInTicks,
+                                    &m_start_tick, &trackAmount, true /* for playback */);
             
             //std::cout << "trackAmount=" << trackAmount << " start_tick=" << m_start_tick<<
             //        " songLengthInTicks=" << songLengthInTicks << std::endl;
             
-            jdksequencer = new jdksmidi::MIDISequencer(jdkmidiseq);
+            m_streams.set(tracks);
+            
+            // edits are heard while the whole song plays (not when playing a selection, or recording)
+            LiveEditQueue& edits = PlatformMidiManager::get()->getLiveEdits();
+            const bool editable = not m_selection_only and not PlatformMidiManager::get()->isRecording();
+            m_streams.listen(&edits, edits.startPlayback(m_start_tick, songLengthInTicks, editable));
             
             g_current_tick = m_start_tick;
             g_current_accurate_tick = m_start_tick;
@@ -254,7 +255,7 @@ namespace AriaMaestosa
         ExitCode Entry()
         {
             AriaSequenceTimer timer(m_sequence);
-            timer.run(jdksequencer, songLengthInTicks);
+            timer.run(m_streams, songLengthInTicks);
             
             //must_stop = true;
             cleanup_after_playback();
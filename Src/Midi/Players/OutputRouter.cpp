@@ -0,0 +1,252 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Midi/Players/OutputRouter.h"
+
+#include "UnitTest.h"
+
+#include <iostream>
+#include <vector>
+#include <wx/stopwatch.h>
+#include <wx/utils.h>
+
+using namespace AriaMaestosa;
+
+#if 0
+#pragma mark OutputQueue
+#endif
+
+OutputQueue::OutputQueue(IOutputSink* sink) : wxThread(wxTHREAD_JOINABLE), m_sink(sink),
+    m_has_messages(m_mutex), m_sent_all(m_mutex)
+{
+    m_sending = false;
+    m_quit    = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool OutputQueue::start()
+{
+    return (Create() == wxTHREAD_NO_ERROR and Run() == wxTHREAD_NO_ERROR);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void OutputQueue::stop()
+{
+    {
+        wxMutexLocker lock(m_mutex);
+        m_quit = true;
+        m_has_messages.Signal();
+    }
+    Wait();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void OutputQueue::post(const RoutedMessage& message)
+{
+    wxMutexLocker lock(m_mutex);
+    m_pending.push_back(message);
+    m_has_messages.Signal();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void OutputQueue::waitUntilSent()
+{
+    wxMutexLocker lock(m_mutex);
+    while (not m_pending.empty() or m_sending) m_sent_all.Wait();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+wxThread::ExitCode OutputQueue::Entry()
+{
+    std::deque<RoutedMessage> sending;
+
+    m_mutex.Lock();
+    while (true)
+    {
+        while (m_pending.empty() and not m_quit) m_has_messages.Wait();
+        if (m_pending.empty()) break; // asked to quit, and everything was sent
+
+        // take everything that was posted at once, the sequencer can keep posting while the device works
+        sending.swap(m_pending);
+        m_sending = true;
+        m_mutex.Unlock();
+
+        const int amount = sending.size();
+        for (int n=0; n<amount; n++) m_sink->send(sending[n]);
+        sending.clear();
+
+        m_mutex.Lock();
+        m_sending = false;
+        if (m_pending.empty()) m_sent_all.Broadcast();
+    }
+    m_sent_all.Broadcast();
+    m_mutex.Unlock();
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+#if 0
+#pragma mark -
+#pragma mark OutputRouter
+#endif
+
+OutputRouter::~OutputRouter()
+{
+    clear();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool OutputRouter::addOutput(IOutputSink* sink)
+{
+    OutputQueue* output = new OutputQueue(sink);
+    if (not output->start())
+    {
+        std::cerr << "[OutputRouter] failed to start the thread of output " << m_outputs.size() << std::endl;
+        delete output;
+        return false;
+    }
+    m_outputs.push_back(output);
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void OutputRouter::post(const int output, const RoutedMessage& message)
+{
+    if (m_outputs.size() == 0) return;
+    if (output < 0 or output >= (int)m_outputs.size()) m_outputs[0].post(message);
+    else                                                m_outputs[output].post(message);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void OutputRouter::waitUntilSent()
+{
+    const int amount = m_outputs.size();
+    for (int n=0; n<amount; n++) m_outputs[n].waitUntilSent();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void OutputRouter::clear()
+{
+    const int amount = m_outputs.size();
+    for (int n=0; n<amount; n++) m_outputs[n].stop();
+    m_outputs.clearAndDeleteAll();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestOutputRouter
+{
+    using namespace AriaMaestosa;
+
+    /** What a loopback device received, kept outside of the sink since the router owns (and deletes) it */
+    struct LoopbackDevice
+    {
+        wxMutex m_mutex;
+        std::vector<RoutedMessage> m_received;
+
+        /** time at which the last message arrived, in ms since the beginning of the test */
+        long m_last_message_time;
+
+        LoopbackDevice() { m_last_message_time = -1; }
+    };
+
+    /** Stand-in for a real device, taking 'delay' ms to accept each message */
+    class LoopbackSink : public IOutputSink
+    {
+        LoopbackDevice* m_device;
+        wxStopWatch*    m_clock;
+        int             m_delay;
+
+    public:
+
+        LoopbackSink(LoopbackDevice* device, wxStopWatch* clock, const int delay)
+        {
+            m_device = device;
+            m_clock  = clock;
+            m_delay  = delay;
+        }
+
+        virtual void send(const RoutedMessage& message)
+        {
+            if (m_delay > 0) wxMilliSleep(m_delay);
+
+            wxMutexLocker lock(m_device->m_mutex);
+            m_device->m_received.push_back(message);
+            m_device->m_last_message_time = m_clock->Time();
+        }
+    };
+
+    UNIT_TEST(TestSlowOutputDoesNotStallOthers)
+    {
+        const int MESSAGES   = 50;
+        const int SLOW_DELAY = 5; // ms per message
+
+        LoopbackDevice fast, slow;
+        wxStopWatch clock;
+
+        OutputRouter router;
+        require(router.addOutput(new LoopbackSink(&fast, &clock, 0)), "the fast output could be opened");
+        require(router.addOutput(new LoopbackSink(&slow, &clock, SLOW_DELAY)), "the slow output could be opened");
+
+        // interleaved, like tracks routed to different devices
+        wxStopWatch postTime;
+        for (int n=0; n<MESSAGES; n++)
+        {
+            router.post(0, RoutedMessage::noteOn(n, 100, 0));
+            router.post(1, RoutedMessage::noteOn(n, 100, 1));
+        }
+        const long postMs = postTime.Time();
+
+        require_e(postMs, <, MESSAGES*SLOW_DELAY, "posting does not wait on the slow device");
+
+        router.waitUntilSent();
+
+        require_e(fast.m_received.size(), ==, (unsigned int)MESSAGES, "the fast device received everything");
+        require_e(slow.m_received.size(), ==, (unsigned int)MESSAGES, "the slow device received everything");
+        for (int n=0; n<MESSAGES; n++)
+        {
+            require_e((int)fast.m_received[n].m_data1, ==, n, "messages arrive in order");
+            require_e((int)slow.m_received[n].m_data1, ==, n, "messages arrive in order");
+            require_e(slow.m_received[n].getChannel(), ==, 1, "messages arrive on the device they were routed to");
+        }
+        require_e(fast.m_last_message_time, <, slow.m_last_message_time, "the fast device is done first");
+
+        // messages for an unknown output go to the default one; pitch bends survive the trip
+        router.post(7, RoutedMessage::pitchBend(-1234, 3));
+        router.waitUntilSent();
+        require_e(fast.m_received.size(), ==, (unsigned int)MESSAGES + 1, "unknown outputs fall back to output 0");
+        require_e(fast.m_received[MESSAGES].getBenderValue(), ==, -1234, "pitch bend values are kept");
+
+        std::cout << "[OutputRouter] " << MESSAGES*2 << " messages posted in " << postMs
+                  << " ms; fast device done after " << fast.m_last_message_time << " ms, slow device after "
+                  << slow.m_last_message_time << " ms" << std::endl;
+
+        router.clear();
+        require_e(router.getOutputAmount(), ==, 0, "outputs are closed");
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __OUTPUT_ROUTER_H__
+#define __OUTPUT_ROUTER_H__
+
+#include "Utils.h"
+#include "ptr_vector.h"
+
+#include <deque>
+#include <wx/thread.h>
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief a channel message (note on/off, control change, program change or pitch bend) on its
+      *        way to an output device
+      * @ingroup midi.players
+      */
+    struct RoutedMessage
+    {
+        unsigned char m_status;
+        unsigned char m_data1;
+        unsigned char m_data2;
+
+        RoutedMessage(const unsigned char status, const unsigned char data1, const unsigned char data2)
+        {
+            m_status = status;
+            m_data1  = data1;
+            m_data2  = data2;
+        }
+
+        int getType()    const { return m_status & 0xF0; }
+        int getChannel() const { return m_status & 0x0F; }
+
+        /** @return the signed 14 bit value of a pitch bend message */
+        int getBenderValue() const { return ((m_data2 << 7) | m_data1) - 8192; }
+
+        static RoutedMessage noteOn(const int note, const int volume, const int channel)
+        {
+            return RoutedMessage(0x90 | channel, note, volume);
+        }
+        static RoutedMessage noteOff(const int note, const int channel)
+        {
+            return RoutedMessage(0x80 | channel, note, 0);
+        }
+        static RoutedMessage controlChange(const int controller, const int value, const int channel)
+        {
+            return RoutedMessage(0xB0 | channel, controller, value);
+        }
+        static RoutedMessage programChange(const int instrument, const int channel)
+        {
+            return RoutedMessage(0xC0 | channel, instrument, 0);
+        }
+        static RoutedMessage pitchBend(const int value, const int channel)
+        {
+            const int bender = value + 8192;
+            return RoutedMessage(0xE0 | channel, bender & 0x7F, (bender >> 7) & 0x7F);
+        }
+    };
+
+    /**
+      * @brief where the messages of an output end up; each MIDI driver that supports several outputs
+      *        implements this for its devices (e.g. one ALSA sequencer port per device)
+      * @ingroup midi.players
+      */
+    class IOutputSink
+    {
+    public:
+        virtual ~IOutputSink() {}
+
+        /** @brief sends a message to the device; called from the thread of the output only */
+        virtual void send(const RoutedMessage& message) = 0;
+    };
+
+    /**
+      * @brief one output device during playback : a queue of messages, and the thread that sends them
+      *        to the sink of the device
+      *
+      * Posting a message never waits on the device, so that a slow device can't hold back the
+      * sequencer, nor the other devices.
+      * @ingroup midi.players
+      */
+    class OutputQueue : public wxThread
+    {
+        OwnerPtr<IOutputSink> m_sink;
+
+        std::deque<RoutedMessage> m_pending;
+        wxMutex     m_mutex;
+        wxCondition m_has_messages;
+        wxCondition m_sent_all;
+
+        /** whether the thread is sending a message it already took out of 'm_pending' */
+        bool m_sending;
+        bool m_quit;
+
+    public:
+        LEAK_CHECK(OutputQueue);
+
+        /** @param sink  the device of this output; the queue takes ownership of it */
+        OutputQueue(IOutputSink* sink);
+
+        /** @brief starts the thread of this output */
+        bool start();
+
+        /** @brief sends the messages still pending, then waits for the thread to end */
+        void stop();
+
+        /** @brief queues a message for the device; returns immediately */
+        void post(const RoutedMessage& message);
+
+        /** @brief waits until all messages posted so far were sent to the device */
+        void waitUntilSent();
+
+        virtual ExitCode Entry();
+    };
+
+    /**
+      * @brief dispatches the messages generated during playback to the output device of their track
+      *        (see Track::setOutputDevice); output 0 is the default device
+      * @ingroup midi.players
+      */
+    class OutputRouter
+    {
+        ptr_vector<OutputQueue> m_outputs;
+
+    public:
+        LEAK_CHECK(OutputRouter);
+
+        ~OutputRouter();
+
+        /**
+          * @brief adds an output, with its own queue and thread
+          * @param sink  the device of the new output; the router takes ownership of it
+          * @return false if its thread could not be started (the sink is then deleted)
+          */
+        bool addOutput(IOutputSink* sink);
+
+        int getOutputAmount() const { return m_outputs.size(); }
+
+        /** @brief queues a message for the given output (messages for an unknown output go to output 0) */
+        void post(const int output, const RoutedMessage& message);
+
+        /** @brief waits until all messages posted so far were sent to their device */
+        void waitUntilSent();
+
+        /** @brief sends the pending messages and closes all outputs */
+        void clear();
+    };
+
+}
+
+#endif
@@ -24,6 +24,8 @@
 #include <map>
 
 #include "Actions/EditAction.h"
+#include "Midi/Players/LivePlayback.h"
+#include "Midi/Players/PlaybackState.h"
 #include "ptr_vector.h"
 #include "Utils.h"
 
@@ -95,6 +97,12 @@ namespace AriaMaestosa
         
         wxMutex m_record_action_queue_lock;
         
+        /** Where playback is, see getPlaybackState */
+        PlaybackState m_playback_state;
+        
+        /** Tracks rebuilt after edits made while playing, see getLiveEdits */
+        LiveEditQueue m_live_edits;
+        
     public:
         
         DECLARE_MAGIC_NUMBER();
@@ -148,6 +156,23 @@ namespace AriaMaestosa
          */
         virtual int trackPlaybackProgression() = 0;
         
+        /**
+          * @brief  where playback is, published by the player without locks so that the GUI can draw
+          *         the playhead at display rate
+          * @note   players using the generic sequencer get this for free; native players may publish
+          *         nothing, in which case the GUI falls back to trackPlaybackProgression
+          */
+        PlaybackState& getPlaybackState() { return m_playback_state; }
+        
+        /**
+          * @brief  carries the tracks modified while the song plays to the player, so that edits are heard
+          *         without restarting playback
+          * @note   players using the generic sequencer (with LiveTrackStreams) get this for free; other
+          *         players don't call LiveEditQueue::startPlayback, and edits are then only heard the next
+          *         time the song is played
+          */
+        LiveEditQueue& getLiveEdits() { return m_live_edits; }
+        
         /** Get the current midi, as accurate as possible
           * (@c trackPlaybackProgression, by opposition, is really only meant to give feedback to the user and so
           *  can be content with only updating on every beat)
@@ -219,6 +244,14 @@ namespace AriaMaestosa
         virtual void seq_controlchange(const int controller, const int value, const int channel) { }
         virtual void seq_pitch_bend   (const int value, const int channel)                       { }
         
+        /**
+          * @brief called by the generic sequencer when the next events go to another output than the
+          *        previous ones (see Track::setOutputDevice). Output 0 is the default output, the others are
+          *        indices in the list given by makeCompactMidiSequence.
+          * @note  implementations that only have a single output can ignore this
+          */
+        virtual void seq_set_output(const int output) { }
+        
         /**
           * @brief called repeatedly by the generic sequencer to tell the midi player what is the current
           *        progression. the sequencer will call this with -1 as argument to indicate it exits.
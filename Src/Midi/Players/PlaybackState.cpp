@@ -0,0 +1,277 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Midi/Players/PlaybackState.h"
+
+#include "UnitTest.h"
+
+#include <iostream>
+#include <wx/thread.h>
+
+#if defined(__WXMSW__)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+using namespace AriaMaestosa;
+
+// The fields are read and written with relaxed atomic accesses, ordered by the fences around the
+// counter; this is what makes the torn reads the counter detects harmless
+
+PlaybackState::PlaybackState()
+{
+    m_sequence     = 0;
+    m_tick         = -1;
+    m_anchor_us    = 0;
+    m_ticks_per_ms = 0.0;
+    m_playing      = 0;
+
+    m_published_tick         = -1;
+    m_published_us           = 0;
+    m_published_ticks_per_ms = 0.0;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void PlaybackState::write(const int tick, const long long anchorUs, const double ticksPerMs, const bool playing)
+{
+    // only one thread writes, so the counter can be read plainly here
+    const unsigned int sequence = __atomic_load_n(&m_sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&m_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&m_tick,      tick,              __ATOMIC_RELAXED);
+    __atomic_store_n(&m_anchor_us, anchorUs,          __ATOMIC_RELAXED);
+    __atomic_store_n(&m_playing,   (playing ? 1 : 0), __ATOMIC_RELAXED);
+
+    double ticksPerMsCopy = ticksPerMs;
+    __atomic_store(&m_ticks_per_ms, &ticksPerMsCopy, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&m_sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void PlaybackState::publish(const int tick, const long long anchorUs, const double ticksPerMs)
+{
+    m_published_tick         = tick;
+    m_published_us           = anchorUs;
+    m_published_ticks_per_ms = ticksPerMs;
+
+    write(tick, anchorUs, ticksPerMs, true);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void PlaybackState::publishElapsed(const long long nowUs)
+{
+    if (m_published_tick == -1 or nowUs <= m_published_us) return;
+
+    // always extrapolated from the tick that was heard, so that rounding errors don't add up
+    const int tick = m_published_tick + (int)((nowUs - m_published_us) * m_published_ticks_per_ms / 1000.0);
+    write(tick, nowUs, m_published_ticks_per_ms, true);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void PlaybackState::publishStopped()
+{
+    m_published_tick = -1;
+    write(-1, getTimeUs(), 0.0, false);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+PlaybackState::Snapshot PlaybackState::read() const
+{
+    Snapshot out;
+    unsigned int before, after;
+    do
+    {
+        before = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+
+        out.m_tick      = __atomic_load_n(&m_tick,      __ATOMIC_RELAXED);
+        out.m_anchor_us = __atomic_load_n(&m_anchor_us, __ATOMIC_RELAXED);
+        out.m_playing   = (__atomic_load_n(&m_playing,  __ATOMIC_RELAXED) != 0);
+        __atomic_load(&m_ticks_per_ms, &out.m_ticks_per_ms, __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&m_sequence, __ATOMIC_RELAXED);
+    }
+    while ((before & 1) != 0 or before != after);
+
+    return out;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int PlaybackState::Snapshot::getTickAt(const long long timeUs) const
+{
+    if (not m_playing) return -1;
+
+    long long elapsedUs = timeUs - m_anchor_us;
+    if (elapsedUs < 0) elapsedUs = 0;
+    if (elapsedUs > MAX_EXTRAPOLATION_MS*1000LL) elapsedUs = MAX_EXTRAPOLATION_MS*1000LL;
+
+    return m_tick + (int)(elapsedUs * m_ticks_per_ms / 1000.0);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+long long PlaybackState::getTimeUs()
+{
+#if defined(__WXMSW__)
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (long long)(now.QuadPart * 1000000.0 / frequency.QuadPart);
+#elif defined(__APPLE__)
+    static mach_timebase_info_data_t timebase = { 0, 0 };
+    if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+    return (long long)(mach_absolute_time() * timebase.numer / timebase.denom / 1000);
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+#endif
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestPlaybackState
+{
+    using namespace AriaMaestosa;
+
+    /** Stand-in for the sequencer thread, publishing fields that can be checked against each other */
+    class PublisherThread : public wxThread
+    {
+        PlaybackState* m_state;
+        int            m_amount;
+
+    public:
+
+        PublisherThread(PlaybackState* state, const int amount) : wxThread(wxTHREAD_JOINABLE)
+        {
+            m_state  = state;
+            m_amount = amount;
+        }
+
+        virtual ExitCode Entry()
+        {
+            for (int n=1; n<=m_amount; n++)
+            {
+                m_state->publish(n, n*1000LL, n/4.0);
+            }
+            m_state->publishStopped();
+            return 0;
+        }
+    };
+
+    UNIT_TEST(TestConsistentSnapshots)
+    {
+        const int PUBLICATIONS = 2000000;
+
+        PlaybackState state;
+        require(not state.read().m_playing, "nothing is playing before the first publication");
+
+        PublisherThread publisher(&state, PUBLICATIONS);
+        require(publisher.Create() == wxTHREAD_NO_ERROR and publisher.Run() == wxTHREAD_NO_ERROR,
+                "the publisher thread could be started");
+
+        int  reads     = 0;
+        int  last_tick = 0;
+        long long startUs = PlaybackState::getTimeUs();
+        while (true)
+        {
+            const PlaybackState::Snapshot snapshot = state.read();
+            reads++;
+            if (not snapshot.m_playing)
+            {
+                if (last_tick > 0 or not publisher.IsRunning()) break; // the publisher is done
+                continue;
+            }
+
+            require_e(snapshot.m_anchor_us, ==, snapshot.m_tick*1000LL, "fields of a snapshot are never torn");
+            require_e(snapshot.m_ticks_per_ms, ==, snapshot.m_tick/4.0, "fields of a snapshot are never torn");
+            require_e(snapshot.m_tick, >=, last_tick, "publications are seen in order");
+            last_tick = snapshot.m_tick;
+        }
+        const long long elapsedUs = PlaybackState::getTimeUs() - startUs;
+        publisher.Wait();
+
+        require_e(state.read().getTickAt(PlaybackState::getTimeUs()), ==, -1, "a stopped player has no position");
+
+        std::cout << "[PlaybackState] " << reads << " reads while " << PUBLICATIONS << " publications were made, "
+                  << (reads > 0 ? elapsedUs*1000.0/reads : 0.0) << " ns per read" << std::endl;
+    }
+
+    UNIT_TEST(TestInterpolation)
+    {
+        PlaybackState state;
+
+        // 120 bpm at 960 ticks per beat
+        const double ticksPerMs = 120 * 960 / 60000.0;
+        state.publish(1000, 5000000LL, ticksPerMs);
+
+        const PlaybackState::Snapshot snapshot = state.read();
+        require(snapshot.m_playing, "publishing starts playback");
+        require_e(snapshot.getTickAt(5000000LL), ==, 1000, "the anchor tick is heard at the anchor time");
+        require_e(snapshot.getTickAt(4000000LL), ==, 1000, "the position never goes back before the anchor");
+        require_e(snapshot.getTickAt(5100000LL), ==, 1000 + 192, "the position moves at the tempo after the anchor");
+        require_e(snapshot.getTickAt(60000000LL), ==,
+                  1000 + (int)(PlaybackState::MAX_EXTRAPOLATION_MS*ticksPerMs),
+                  "the position stops moving when the player stops publishing");
+
+        state.publishStopped();
+        require(not state.read().m_playing, "the player stopped");
+    }
+
+    UNIT_TEST(TestLongGapBetweenEvents)
+    {
+        PlaybackState state;
+
+        // 120 bpm at 960 ticks per beat; a whole note (2 s) from tick 0, then the next event
+        const double ticksPerMs = 120 * 960 / 60000.0;
+        const long long startUs = 1000000LL;
+
+        state.publishElapsed(startUs);
+        require(not state.read().m_playing, "nothing is published before the first tick is heard");
+
+        state.publish(0, startUs, ticksPerMs);
+
+        // what the sequencer does every 10 ms while it waits for the next event
+        for (int ms=10; ms<2000; ms+=10)
+        {
+            state.publishElapsed(startUs + ms*1000LL);
+
+            // read 5 ms after the publication, like a frame drawn between two of them
+            const int tick     = state.read().getTickAt(startUs + (ms + 5)*1000LL);
+            const int expected = (int)((ms + 5)*ticksPerMs);
+            require(tick >= expected - 1 and tick <= expected, "the position keeps moving between events");
+        }
+
+        state.publish(3840, startUs + 2000000LL, ticksPerMs);
+        require_e(state.read().getTickAt(startUs + 2000000LL), ==, 3840, "the next event is heard on time");
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __PLAYBACK_STATE_H__
+#define __PLAYBACK_STATE_H__
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief where playback is : published by the thread that plays the song, read by the GUI to draw
+      *        the playhead
+      *
+      * This is a sequence lock. The writer makes the counter odd while it updates the fields, and even
+      * again when it is done; a reader retries when it saw an odd counter, or a different counter after
+      * reading the fields than before. Neither side ever waits on the other, so drawing the playhead can't
+      * hold back the player, and the player's locks are not needed to know where it is.
+      *
+      * There must be a single writer at a time (the sequencer thread, or the audio callback of the player).
+      *
+      * @ingroup midi.players
+      */
+    class PlaybackState
+    {
+        unsigned int m_sequence;
+
+        int          m_tick;
+        long long    m_anchor_us;
+        double       m_ticks_per_ms;
+        int          m_playing;
+
+        /** the last call to 'publish' (only used by the writer, see 'publishElapsed') */
+        int          m_published_tick;
+        long long    m_published_us;
+        double       m_published_ticks_per_ms;
+
+        void write(const int tick, const long long anchorUs, const double ticksPerMs, const bool playing);
+
+    public:
+
+        /** a consistent copy of the state, as read by the GUI */
+        struct Snapshot
+        {
+            /** tick being heard at 'm_anchor_us', relative to the tick playback started from */
+            int       m_tick;
+
+            /** time at which 'm_tick' was heard, see PlaybackState::getTimeUs */
+            long long m_anchor_us;
+
+            /** tempo at the anchor, used to extrapolate the tick being heard after it */
+            double    m_ticks_per_ms;
+
+            /** false before the player first published its position, and after it stopped */
+            bool      m_playing;
+
+            /**
+              * @return the tick being heard at the given time, extrapolated from the anchor at the current
+              *         tempo (no further than MAX_EXTRAPOLATION_MS, in case the player stalls)
+              */
+            int getTickAt(const long long timeUs) const;
+        };
+
+        /** how long past its last publication the position of the player is trusted to keep moving */
+        static const int MAX_EXTRAPOLATION_MS = 500;
+
+        PlaybackState();
+
+        /**
+          * @brief called by the player when a tick is heard
+          * @param tick        tick being heard, relative to the tick playback started from
+          * @param anchorUs    time at which it is heard (see getTimeUs)
+          * @param ticksPerMs  current tempo
+          */
+        void publish(const int tick, const long long anchorUs, const double ticksPerMs);
+
+        /**
+          * @brief called by the player between two ticks it hears (e.g. during a long note), so that the
+          *        position is not extrapolated past MAX_EXTRAPOLATION_MS
+          * @param nowUs  current time (see getTimeUs); the tick heard then is extrapolated from the last
+          *               call to 'publish', at its tempo. Does nothing before the first call to 'publish'.
+          */
+        void publishElapsed(const long long nowUs);
+
+        /** @brief called by the player when it stops playing the song */
+        void publishStopped();
+
+        /** @brief may be called from any thread, never blocks */
+        Snapshot read() const;
+
+        /** @return the time of a monotonic clock, in microseconds, shared by the players and the GUI */
+        static long long getTimeUs();
+    };
+
+}
+
+#endif
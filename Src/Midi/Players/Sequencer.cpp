@@ -19,14 +19,11 @@
 #include "GUI/MainFrame.h"
 #include "Midi/Players/Sequencer.h"
 #include "Midi/CommonMidiUtils.h"
+#include "Midi/CompactMidiTrack.h"
 #include "Midi/Sequence.h"
+#include "Midi/Players/LivePlayback.h"
 #include "Midi/Players/PlatformMidiManager.h"
-
-#include "jdksmidi/world.h"
-#include "jdksmidi/multitrack.h"
-#include "jdksmidi/sequencer.h"
-#include "jdksmidi/driver.h"
-#include "jdksmidi/process.h"
+#include "Profiler.h"
 
 // FIXME: the build system should check for them.
 #ifdef __WXMSW__
@@ -169,8 +166,53 @@ public:
     }
 };
 
-void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int songLengthInTicks)
+/** Tells the GUI that playback stopped, whichever way AriaSequenceTimer::run returns */
+class PublishStoppedOnExit
 {
+public:
+    
+    ~PublishStoppedOnExit()
+    {
+        PlatformMidiManager::get()->getPlaybackState().publishStopped();
+    }
+};
+
+/** Sends a channel event to the given output (switching the current output of the player if needed) */
+void sendChannelEvent(const CompactMidiEvent& ev, const int output, int& current_output)
+{
+    const int channel = ev.getChannel();
+    
+    if (output != current_output)
+    {
+        current_output = output;
+        PlatformMidiManager::get()->seq_set_output(current_output);
+    }
+    
+    switch (ev.getType())
+    {
+        case 0x90: // note on
+            PlatformMidiManager::get()->seq_note_on(ev.m_data1 /* note */, ev.m_data2 /* volume */, channel);
+            break;
+        case 0x80: // note off
+            PlatformMidiManager::get()->seq_note_off(ev.m_data1 /* note */, channel);
+            break;
+        case 0xB0: // control change
+            PlatformMidiManager::get()->seq_controlchange(ev.m_data1 /* controller */, ev.m_data2 /* value */,
+                                                          channel);
+            break;
+        case 0xE0: // pitch bend
+            PlatformMidiManager::get()->seq_pitch_bend(ev.getBenderValue(), channel);
+            break;
+        case 0xC0: // program change
+            PlatformMidiManager::get()->seq_prog_change(ev.m_data1 /* instrument */, channel);
+            break;
+    }
+}
+
+void AriaSequenceTimer::run(LiveTrackStreams& streams, const int songLengthInTicks)
+{
+    PROFILE_ZONE("AriaSequenceTimer::run");
+    
     // Added because I suspect invalid reentrency is the cause of bug #113
     ReentrencyGuard guard;
     if (not guard.ok())
@@ -181,10 +223,18 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
         return;
     }
     //std::cout << "  * AriaSequenceTimer::run" << std::endl;
+    
+    PublishStoppedOnExit publishStopped;
+    PlaybackState& state = PlatformMidiManager::get()->getPlaybackState();
 
     //std::cout << "trying to play " << seq->suggestFileName().mb_str() << std::endl;
 
-    jdksequencer->GoToTimeMs( 0 );
+    // events to send when a track is replaced, see LiveTrackStreams::applyEdits
+    CompactMidiTrack chase;
+
+    // events are sent to the output of their track
+    int current_output = 0;
+    PlatformMidiManager::get()->seq_set_output(current_output);
 
     int bpm = m_seq->getTempo();
     const int beatlen = m_seq->ticksPerQuarterNote();
@@ -195,18 +245,15 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
 
     float next_event_time = 0;
 
-    jdksmidi::MIDITimedBigMessage ev;
-    int ev_track;
-
-    jdksmidi::MIDIClockTime tick;
-    if (not jdksequencer->GetNextEventTime(&tick))
+    long tick;
+    if (not streams.hasNext())
     {
         std::cerr << "[AriaSequenceTimer] failed to get first event time, returning (did you try to play en empty sequence?)" << std::endl;
         cleanup_sequencer();
         return;
     }
     
-    //jdksequencer->ResetAllTracks();
+    tick = streams.getNextTick();
     
     long previous_tick = tick;
     
@@ -215,6 +262,9 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
     timer = new BasicTimer();
     timer->reset_and_start();
     
+    // when the timer started, on the clock shared with the GUI
+    long long start_us = PlaybackState::getTimeUs();
+    
     long total_millis = 0;
     long last_millis = 0;
     
@@ -225,10 +275,31 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
     
     while (PlatformMidiManager::get()->seq_must_continue() or PlatformMidiManager::get()->isRecording())
     {
+        // tracks edited since the previous events were sent replace the ones being played
+        if (streams.applyEdits(chase))
+        {
+            const int chaseAmount = chase.getEventAmount();
+            for (int n=0; n<chaseAmount; n++)
+            {
+                sendChannelEvent(chase.getEvent(n), chase.getEvent(n).getOutput(), current_output);
+            }
+            
+            // the next event may now be another one, from the new events
+            if (streams.hasNext() and streams.getNextTick() != tick)
+            {
+                next_event_time += (streams.getNextTick() - tick) / ticks_per_millis;
+                tick = streams.getNextTick();
+            }
+        }
+        
         // process all events that need to be done by the current tick
         while (next_event_time <= total_millis)
         {
-            if (not jdksequencer->GetNextEvent( &ev_track, &ev ))
+            // events are read in place, there is nothing to copy
+            const CompactMidiTrack* track = NULL;
+            int output = 0;
+            const CompactMidiEvent* ev = streams.next(&track, &output);
+            if (ev == NULL)
             {
                 if (not PlatformMidiManager::get()->isRecording() and not m_seq->isLoopEnabled())
                 {
@@ -255,46 +326,30 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
                         
                         if ((int)tick >= next_metronome_beat and next_metronome_beat != played_metronome_tick)
                         {
+                            // the metronome plays on the default output
+                            if (current_output != 0)
+                            {
+                                current_output = 0;
+                                PlatformMidiManager::get()->seq_set_output(current_output);
+                            }
                             PlatformMidiManager::get()->seq_note_on(metronomeInstrument, metronomeVolume, 9);
                             played_metronome_tick = next_metronome_beat;
                         }
                     }
                 }
             }
-            const int channel = ev.GetChannel();
-
-            if (ev.IsNoteOn())
-            {
-                const int note = ev.GetNote();
-                const int volume = ev.GetVelocity();
-                PlatformMidiManager::get()->seq_note_on(note, volume, channel);
-            }
-            else if (ev.IsNoteOff())
-            {
-                const int note = ev.GetNote();
-                PlatformMidiManager::get()->seq_note_off(note, channel);
-            }
-            else if (ev.IsControlChange())
-            {
-                const int controllerID = ev.GetController();
-                const int value = ev.GetControllerValue();
-                PlatformMidiManager::get()->seq_controlchange(controllerID, value, channel);
-            }
-            else if (ev.IsPitchBend())
+            else if (ev->hasPayload())
             {
-                const int pitchBendVal = ev.GetBenderValue();
-                PlatformMidiManager::get()->seq_pitch_bend(pitchBendVal, channel);
-            }
-            else if (ev.IsProgramChange())
-            {
-                const int instrument = ev.GetPGValue();
-                PlatformMidiManager::get()->seq_prog_change(instrument, channel);
+                if (track->isTempo(*ev))
+                {
+                    //std::cout << "tempo event" << std::endl;
+                    const int event_bpm = track->getTempo32(*ev)/32;
+                    ticks_per_millis = (double)event_bpm * (double)beatlen / (double)60000.0;
+                }
             }
-            else if (ev.IsTempo())
+            else
             {
-                //std::cout << "tempo event" << std::endl;
-                const int event_bpm = ev.GetTempo32()/32;
-                ticks_per_millis = (double)event_bpm * (double)beatlen / (double)60000.0;
+                sendChannelEvent(*ev, output, current_output);
             }
             /*
             else if ( ev.IsPolyPressure() )
@@ -319,7 +374,11 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
 
             previous_tick = tick;
 
-            if (not jdksequencer->GetNextEventTime(&tick))
+            if (streams.hasNext())
+            {
+                tick = streams.getNextTick();
+            }
+            else
             {
                 // if recording, continue as long as user doesn't press stop.
                 // if looping, continue until the loop point, wherever it may be
@@ -345,21 +404,22 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
                     tick = 0;
                     previous_tick = 0;
                     
-                    jdksequencer->GoToTimeMs( 0 );
-                    if (not jdksequencer->GetNextEventTime(&tick))
+                    streams.rewind();
+                    if (not streams.hasNext())
                     {
                         std::cerr << "[AriaSequenceTimer] failed to get first event time, returning (did you try to play en empty sequence?)" << std::endl;
                         cleanup_sequencer();
                         return;
                     }
                     
-                    //jdksequencer->ResetAllTracks();
+                    tick = streams.getNextTick();
                     
                     previous_tick = tick;
                     
                     next_event_time = tick / ticks_per_millis;
                     
                     timer->reset();
+                    start_us = PlaybackState::getTimeUs();
                     
                     total_millis = 0;
                     last_millis = 0;
@@ -369,11 +429,16 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
                     
                     next_beat = 0;
                     
-                    // all notes off on all channels
-                    for (int n = 0; n < 16; n++)
+                    // all notes off on all channels of all outputs
+                    for (int output = 0; output < streams.getOutputAmount(); output++)
                     {
-                        PlatformMidiManager::get()->seq_controlchange(0x7B /* all notes off */, 0, n);
+                        PlatformMidiManager::get()->seq_set_output(output);
+                        for (int n = 0; n < 16; n++)
+                        {
+                            PlatformMidiManager::get()->seq_controlchange(0x7B /* all notes off */, 0, n);
+                        }
                     }
+                    current_output = streams.getOutputAmount() - 1;
                 }
                 else
                 {
@@ -388,6 +453,9 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
             }
 
             PlatformMidiManager::get()->seq_notify_current_tick(previous_tick);
+            
+            // 'next_event_time' is still the time of the event at 'previous_tick' here
+            state.publish(previous_tick, start_us + (long long)(next_event_time*1000.0), ticks_per_millis);
 
             //std::cout << "next_event_time was " << next_event_time << " adding " <<
             //((tick - previous_tick) / ticks_per_millis) << " tick=" << tick <<
@@ -417,6 +485,9 @@ void AriaSequenceTimer::run(jdksmidi::MIDISequencer* jdksequencer, const int son
         // FIXME; this will not play well with tempo changes
         PlatformMidiManager::get()->seq_notify_accurate_current_tick(total_millis*ticks_per_millis);
         
+        // keep the playhead moving while no event is played (see PlaybackState::MAX_EXTRAPOLATION_MS)
+        state.publishElapsed(start_us + (long long)total_millis*1000LL);
+        
         if (PlatformMidiManager::get()->isRecording())
         {
             const int extend_tick = total_millis*ticks_per_millis;
@@ -17,12 +17,11 @@
 #ifndef __ARIA_SEQUENCER_H__
 #define __ARIA_SEQUENCER_H__
 
-namespace jdksmidi{ class MIDISequencer; }
-
 namespace AriaMaestosa
 {
 
     class Sequence;
+    class LiveTrackStreams;
 
     class AriaSequenceTimer
     {
@@ -31,7 +30,11 @@ namespace AriaMaestosa
     public:
 
         AriaSequenceTimer(Sequence* seq);
-        void run(jdksmidi::MIDISequencer* jdksequencer, const int songLengthInTicks);
+        /**
+          * @brief plays the tracks of the song through the current PlatformMidiManager; tracks edited
+          *        while the song plays are picked up as they come (see LiveTrackStreams::applyEdits)
+          */
+        void run(LiveTrackStreams& streams, const int songLengthInTicks);
     };
 
 }
@@ -37,7 +37,9 @@ const int CURRENT_FILE_VERSION = 4;
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/Track.h"
 #include "GUI/GraphicalTrack.h"
+#include "MemoryUsage.h"
 #include "PreferencesData.h"
+#include "Profiler.h"
 #include "Utils.h"
 
 #include <wx/intl.h>
@@ -62,10 +64,12 @@ Sequence::Sequence(IPlaybackModeListener* playbackListener, IActionStackListener
     m_playback_listener         = playbackListener;
     m_action_stack_listener     = actionStackListener;
     m_seq_data_listener         = sequenceDataListener;
+    m_track_edit_listener       = NULL;
     m_play_with_metronome       = false;
     m_playback_start_tick       = 0;
     m_default_key_type          = KEY_TYPE_C;
     m_default_key_symbol_amount = 0;
+    m_events_revision           = 0;
     
     m_sequence_filename     = new Model<wxString>( _("Untitled") );
     channelManagement = CHANNEL_AUTO;
@@ -298,6 +302,7 @@ void Sequence::addTempoEvent_import( ControllerEvent* evt )
 void Sequence::sortTempoEvents()
 {
     m_tempo_events.insertionSort();
+    eventsChanged();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -305,6 +310,7 @@ void Sequence::sortTempoEvents()
 void Sequence::sortTextEvents()
 {
     m_text_events.insertionSort();
+    eventsChanged();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -365,6 +371,7 @@ ControllerEvent* Sequence::getTempoEventAt(int tick)
 wxString Sequence::addTextEvent(TextEvent* evt)
 {
     wxString previousValue;
+    eventsChanged();
 
     // don't bother checking order if we're importing, we know its in time order and all
     // FIXME - what about 'addControlEvent_import' ??
@@ -468,9 +475,14 @@ void Sequence::updateTrackPlayingStatus()
 
 void Sequence::action( Action::MultiTrackAction* actionObj)
 {
+    PROFILE_ZONE("Sequence::action");
+    
+    beforeTrackEdit();
     addToUndoStack( actionObj );
     actionObj->setParentSequence(this, new SequenceVisitor(this));
     actionObj->perform();
+    eventsChanged();
+    trackEdited(NULL);
     
     if (m_action_stack_listener != NULL) m_action_stack_listener->onActionStackChanged();
     
@@ -516,8 +528,15 @@ void Sequence::undo()
         return;
     }
     
+    // only the track of a single-track action was modified
+    Action::SingleTrackAction* trackAction = dynamic_cast<Action::SingleTrackAction*>(lastAction);
+    Track* editedTrack = (trackAction != NULL ? trackAction->getParentTrack() : NULL);
+    
+    beforeTrackEdit();
     lastAction->undo();
     undoStack.erase( undoStack.size() - 1 );
+    eventsChanged();
+    trackEdited(editedTrack);
 
     if (m_seq_data_listener != NULL) m_seq_data_listener->onSequenceDataChanged();
     
@@ -544,6 +563,38 @@ void Sequence::clearUndoStack()
     if (m_action_stack_listener != NULL) m_action_stack_listener->onActionStackChanged();
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+void Sequence::getMemoryUsage(MemoryUsage& usage) const
+{
+    const int trackAmount = tracks.size();
+    for (int n=0; n<trackAmount; n++)
+    {
+        tracks.getConst(n)->getMemoryUsage(usage);
+    }
+    
+    const int tempoAmount = m_tempo_events.size();
+    usage.add(MemoryUsage::CONTROLLER_EVENTS,
+              (long long)tempoAmount*(sizeof(ControllerEvent) + sizeof(ControllerEvent*)), tempoAmount);
+    
+    const int textAmount = m_text_events.size();
+    for (int n=0; n<textAmount; n++)
+    {
+        const TextEvent* evt = m_text_events.getConst(n);
+        usage.add(MemoryUsage::TEXT_EVENTS, sizeof(TextEvent) + sizeof(TextEvent*) +
+                  MemoryUsage::getStringBytes(evt->getTextValue()), 1);
+        usage.addTexture(evt->getText().getTextureBytes());
+    }
+    
+    const int actionAmount = undoStack.size();
+    for (int n=0; n<actionAmount; n++)
+    {
+        usage.add(MemoryUsage::UNDO_STACK, undoStack.getConst(n)->getMemoryUsage(), 1);
+    }
+    
+    usage.add(MemoryUsage::OTHER, sizeof(Sequence));
+}
+
 
 // ----------------------------------------------------------------------------------------------------------
 // ----------------------------------------------- Tracks ---------------------------------------------------
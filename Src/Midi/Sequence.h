@@ -41,6 +41,7 @@ namespace AriaMaestosa
 
     class ControllerEvent;
     class MeasureBar;
+    class MemoryUsage;
     class IMeasureDataListener;
 
     const int DEFAULT_SONG_LENGTH = 12;
@@ -86,6 +87,22 @@ namespace AriaMaestosa
         virtual void onTrackAdded(Track* t) = 0;
         virtual void onTrackRemoved(Track* t) = 0;
     };
+    
+    /**
+      * @brief Interface for listeners that are to be notified of edits to the events of tracks as they are
+      *        committed (see Track::action, Sequence::action and Sequence::undo), e.g. to replay them live
+      */
+    class ITrackEditListener
+    {
+    public:
+        virtual ~ITrackEditListener() {}
+        
+        /** called before an edit modifies tracks; tracks must not be read from other threads until it's done */
+        virtual void onBeforeTrackEdit() = 0;
+        
+        /** @param track  the track that was edited, or NULL if the edit may have modified any track */
+        virtual void onTrackEdited(Track* track) = 0;
+    };
 
     class SequenceVisitor;
     
@@ -130,6 +147,8 @@ namespace AriaMaestosa
         
         ISequenceDataListener* m_seq_data_listener;
         
+        ITrackEditListener* m_track_edit_listener;
+        
         /** Whether a metronome should be heard during playback */
         bool m_play_with_metronome;
         
@@ -171,6 +190,9 @@ namespace AriaMaestosa
         
         int m_default_key_symbol_amount;
         
+        /** incremented whenever notes or events may have changed, see 'getEventsRevision' */
+        int m_events_revision;
+        
         
      public:
         
@@ -190,6 +212,7 @@ namespace AriaMaestosa
             ~Import()
             {
                 m_parent->m_importing = false;
+                m_parent->eventsChanged();
             }
             
             /**
@@ -203,7 +226,7 @@ namespace AriaMaestosa
             }
         };
 
-        LEAK_CHECK();
+        LEAK_CHECK(Sequence);
 
         /**
           * @brief Sequence constructor
@@ -216,6 +239,9 @@ namespace AriaMaestosa
         
         void addTrackSetListener(ITrackSetListener* l) { m_listeners.push_back(l); }
         
+        /** @param l  listener to notify of edits, or NULL to stop notifying */
+        void setTrackEditListener(ITrackEditListener* l) { m_track_edit_listener = l; }
+        
         /**
          * @brief perform an action that affects multiple tracks
          *
@@ -230,6 +256,21 @@ namespace AriaMaestosa
         /** @brief you do not need to call this yourself, Track::action and Sequence::action do. */
         void addToUndoStack( Action::EditAction* action );
         
+        /** @brief you do not need to call these yourself, Track::action and Sequence::action do. */
+        void beforeTrackEdit()
+        {
+            if (m_track_edit_listener != NULL) m_track_edit_listener->onBeforeTrackEdit();
+        }
+        void trackEdited(Track* track)
+        {
+            // views compare the notes revision of each track to know which ones to repaint; NULL means
+            // the action may have edited any track
+            if (track != NULL) track->notesChanged();
+            else for (int n=0; n<tracks.size(); n++) tracks[n].notesChanged();
+            
+            if (m_track_edit_listener != NULL) m_track_edit_listener->onTrackEdited(track);
+        }
+        
         Action::EditAction* getLatestAction()
         {
             if (undoStack.size() == 0) return NULL;
@@ -251,6 +292,15 @@ namespace AriaMaestosa
             return undoStack.size() > 0;
         }
 
+        /** @return the number of actions kept in the undo stack */
+        int getUndoStackSize() const { return undoStack.size(); }
+        
+        /**
+          * @brief adds the memory used by this sequence (tracks, events and undo stack, not its
+          *        graphics; see GraphicalSequence::getMemoryUsage)
+          */
+        void getMemoryUsage(MemoryUsage& usage) const;
+
         wxString suggestFileName() const;
         wxString suggestTitle() const;
         
@@ -325,6 +375,19 @@ namespace AriaMaestosa
         
         void addTextEvent_import(const int x, const wxString& value, const int controller);
         
+        /**
+          * @return a number that changes whenever notes or events of this sequence may have changed
+          *         (edit actions, undo, import, direct insertion). Views that cache data derived from
+          *         events compare it to know when to rebuild.
+          */
+        int  getEventsRevision() const { return m_events_revision; }
+        
+        /**
+          * @brief bumps the events revision, see 'getEventsRevision'; may be called by the per-track
+          *        tasks of an action running in parallel (see Parallel::forEach)
+          */
+        void eventsChanged() { __atomic_add_fetch(&m_events_revision, 1, __ATOMIC_RELAXED); }
+        
         int                    getTempoEventAmount() const { return m_tempo_events.size();  }
         const ControllerEvent* getTempoEvent(int id) const { return m_tempo_events.getConst(id); }
         void eraseTempoEvent(int id) { m_tempo_events.erase(id); }
@@ -337,6 +400,7 @@ namespace AriaMaestosa
         
         int                    getTextEventAmount() const { return m_text_events.size();  }
         const TextEvent*       getTextEvent(int id) const { return m_text_events.getConst(id); }
+        TextEvent*             getTextEvent(int id)       { return m_text_events.get(id);      }
         void eraseTextEvent(int id) { m_text_events.erase(id); }
         void setTextEventValue(int id, wxString& newValue) { m_text_events[id].setText(newValue); }
         void setTextEventTick (int id, int newTick)  { m_text_events[id].setTick(newTick);  }
@@ -479,7 +543,7 @@ namespace AriaMaestosa
             return new SequenceVisitor(m_sequence);
         }
         
-        LEAK_CHECK();
+        LEAK_CHECK(SequenceVisitor);
     };
 
 }
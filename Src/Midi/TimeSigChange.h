@@ -36,7 +36,7 @@ namespace AriaMaestosa
         int m_tick_cache;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(TimeSigChange);
         
         /**
           * @param tick  The cached tick value only, will be overwritten
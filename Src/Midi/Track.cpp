@@ -33,8 +33,12 @@
 #include "Midi/ControllerEvent.h"
 #include "Midi/DrumChoice.h"
 #include "Midi/MeasureData.h"
+#include "Midi/NoteKernels.h"
+#include "MemoryUsage.h"
 #include "PreferencesData.h"
+#include "Profiler.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "jdksmidi/world.h"
@@ -57,6 +61,8 @@ Track::Track(Sequence* sequence)
 #endif
 
     m_magnetic_grid = new MagneticGrid();
+    m_note_index    = new NoteIndex(this);
+    m_notes_revision = 0;
     
     m_volume = 100;
     m_muted = false;
@@ -84,6 +90,7 @@ Track::Track(Sequence* sequence)
     }
 
     m_listener = NULL;
+    m_graphics = NULL;
 
     // init key data
     setKey(sequence->getDefaultKeySymbolAmount(),
@@ -148,27 +155,18 @@ Track::~Track()
 
 void Track::action( Action::SingleTrackAction* actionObj)
 {
+    PROFILE_ZONE("Track::action");
+    
+    m_sequence->beforeTrackEdit();
     actionObj->setParentTrack(this, new TrackVisitor(this));
     m_sequence->addToUndoStack( actionObj );
     actionObj->perform();
+    m_sequence->eventsChanged();
+    m_sequence->trackEdited(this);
     
     ASSERT(m_sequence->invariant());
 }
 
-// ----------------------------------------------------------------------------------------------------------
-
-GraphicalTrack* Track::getGraphics()
-{
-    return getMainFrame()->getCurrentGraphicalSequence()->getGraphicsFor(this);
-}
-
-// ----------------------------------------------------------------------------------------------------------
-
-const GraphicalTrack* Track::getGraphics() const
-{
-    return getMainFrame()->getCurrentGraphicalSequence()->getGraphicsFor(this);
-}
-
 
 // =======================================================================================================
 // ======================================= Add/Remove Notes ==============================================
@@ -179,6 +177,52 @@ const GraphicalTrack* Track::getGraphics() const
 #pragma mark Add/Remove Notes
 #endif
 
+/**
+  * @return the index of 'note' in 'notes', that are in order of start tick (or of end tick if 'byEnd'),
+  *         or -1 if it is not there. Notes marked to be removed (NULL) are skipped.
+  */
+template<VECTOR_TYPE type>
+static int findNoteInOrder(const ptr_vector<Note, type>& notes, const Note* note, const bool byEnd)
+{
+    const std::vector<Note*>& contents = notes.contentsVector;
+    const int count = contents.size();
+    const int key = (byEnd ? note->getEndTick() : note->getTick());
+
+    // binary search for the first note at 'key'
+    int from = 0;
+    int to   = count;
+    while (from < to)
+    {
+        const int middle = from + (to - from)/2;
+        int probe = middle;
+        while (probe < to and contents[probe] == NULL) probe++;
+        if (probe == to)
+        {
+            to = middle;
+            continue;
+        }
+
+        const int probeKey = (byEnd ? contents[probe]->getEndTick() : contents[probe]->getTick());
+        if (probeKey < key) from = probe + 1;
+        else                to   = probe;
+    }
+
+    for (int n=from; n<count; n++)
+    {
+        if (contents[n] == note) return n;
+        if (contents[n] != NULL and (byEnd ? contents[n]->getEndTick() : contents[n]->getTick()) != key) break;
+    }
+
+    // not where it should be : the notes are not in order (e.g. an action is moving them)
+    for (int n=0; n<count; n++)
+    {
+        if (contents[n] == note) return n;
+    }
+    return -1;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 
 bool Track::addNote(Note* note, bool check_for_overlapping_notes)
 {
@@ -187,6 +231,8 @@ bool Track::addNote(Note* note, bool check_for_overlapping_notes)
     {
         m_notes.push_back(note);
         m_note_off.push_back(note); // dont forget to reorder note off vector after importing
+        if (note->isSelected()) m_selected_notes.insert(note);
+        notesChanged();
         return true;
     }
 
@@ -248,7 +294,9 @@ bool Track::addNote(Note* note, bool check_for_overlapping_notes)
         m_note_off.push_back(note);
     }
 
+    if (note->isSelected()) m_selected_notes.insert(note);
 
+    notesChanged();
     return true;
 
 }
@@ -260,6 +308,7 @@ void Track::addControlEvent( ControllerEvent* evt, wxFloat64* previousValue )
     ptr_vector<ControllerEvent>* vector;
 
     if (previousValue != NULL) *previousValue = -1;
+    m_sequence->eventsChanged();
 
     // tempo events
     if (evt->getController() == PSEUDO_CONTROLLER_TEMPO) vector = &m_sequence->m_tempo_events;
@@ -336,19 +385,15 @@ void Track::setNoteEnd_import(const int tick, const int noteID)
 
 void Track::removeNote(const int id)
 {
+    Note* note = m_notes.get(id);
 
     // also delete corresponding note off event
-    const int namount = m_note_off.size();
-    for (int i=0; i<namount; i++)
-    {
-        if (&m_note_off[i] == &m_notes[id])
-        {
-            m_note_off.remove(i);
-            break;
-        }
-    }
+    const int noteOffID = findNoteInOrder(m_note_off, note, true /* by end */);
+    if (noteOffID != -1) m_note_off.remove(noteOffID);
 
+    m_selected_notes.erase(note);
     m_notes.erase(id);
+    notesChanged();
 
 }
 
@@ -360,21 +405,21 @@ void Track::markNoteToBeRemoved(const int id)
     ASSERT_E(id,<,m_notes.size());
 
     // also delete corresponding note off event
-    const int namount = m_note_off.size();
     Note* note = m_notes.get(id);
 
-    for (int i=0; i<namount; i++)
+    const int noteOffID = findNoteInOrder(m_note_off, note, true /* by end */);
+    if (noteOffID != -1)
     {
-        if (m_note_off.get(i) == note)
-        {
-            m_note_off.markToBeRemoved(i);
-            break;
-        }
+        m_note_off.markToBeRemoved(noteOffID);
+    }
 #ifdef _MORE_DEBUG_CHECKS
-        if (i+1 == namount) std::cout << "WARNING could not find note off event corresponding to note on event" << std::endl;
-#endif
+    else
+    {
+        std::cout << "WARNING could not find note off event corresponding to note on event" << std::endl;
     }
+#endif
 
+    m_selected_notes.erase(note);
     m_notes.markToBeRemoved(id);
 }
 
@@ -387,6 +432,7 @@ void Track::removeMarkedNotes()
 
     m_notes.removeMarked();
     m_note_off.removeMarked();
+    notesChanged();
 
 #ifdef _MORE_DEBUG_CHECKS
     if (m_notes.size() != m_note_off.size())
@@ -407,6 +453,7 @@ int getNoteTick(Note* note)
 void Track::reorderNoteVector()
 {
     m_notes.insertionSort(getNoteTick);
+    notesChanged();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -423,9 +470,18 @@ void Track::reorderNoteOffVector()
 
 // ----------------------------------------------------------------------------------------------------------
 
+void Track::notesChanged()
+{
+    m_note_index->invalidate();
+    m_notes_revision++;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 void Track::reorderControlVector()
 {
     m_control_events.insertionSort();
+    m_sequence->eventsChanged();
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -519,6 +575,25 @@ int Track::getNoteAmount() const
 
 // ----------------------------------------------------------------------------------------------------------
 
+void Track::getMemoryUsage(MemoryUsage& usage) const
+{
+    // each note is referenced from both 'm_notes' and 'm_note_off'
+    const int noteAmount = m_notes.size();
+    usage.add(MemoryUsage::NOTES, (long long)noteAmount*(sizeof(Note) + 2*sizeof(Note*)), noteAmount);
+    
+    // the selection is part of the notes; each node of the set holds a pointer, plus three pointers and a color
+    usage.add(MemoryUsage::NOTES, (long long)m_selected_notes.size()*(5*sizeof(void*)));
+    
+    const int eventAmount = m_control_events.size();
+    usage.add(MemoryUsage::CONTROLLER_EVENTS, (long long)eventAmount*(sizeof(ControllerEvent) + sizeof(ControllerEvent*)),
+              eventAmount);
+    
+    usage.add(MemoryUsage::ANALYSERS, m_note_index->getMemoryBytes());
+    usage.add(MemoryUsage::OTHER, sizeof(Track) + MemoryUsage::getStringBytes(m_track_name->getValue()));
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
 int Track::getNoteVolume(const int id) const
 {
     ASSERT_E(id,>=,0);
@@ -666,12 +741,11 @@ int Track::getFirstNoteTick(bool selectionOnly) const
 
     if (not selectionOnly) return m_notes[0].getTick();
 
-    const int noteAmount = m_notes.size();
     int tick = -1;
 
-    for (int n=0; n<noteAmount; n++)
+    for (std::set<Note*>::const_iterator it = m_selected_notes.begin(); it != m_selected_notes.end(); it++)
     {
-        if ( m_notes[n].isSelected() ) return m_notes[n].getTick();
+        if (tick == -1 or (*it)->getTick() < tick) tick = (*it)->getTick();
     }//next
 
     return tick;
@@ -682,12 +756,66 @@ int Track::getFirstNoteTick(bool selectionOnly) const
 
 int Track::getFirstSelectedNote() const
 {
-    const int count = m_notes.size();
+    if (m_selected_notes.empty()) return -1;
+
+    // find a selected note that starts first...
+    const Note* first = NULL;
+    for (std::set<Note*>::const_iterator it = m_selected_notes.begin(); it != m_selected_notes.end(); it++)
+    {
+        if (first == NULL or (*it)->getTick() < first->getTick()) first = *it;
+    }
+
+    // ...then the first one among the selected notes that start at the same time
+    int id = findNoteInOrder(m_notes, first, false /* by start */);
+    ASSERT_E(id,>=,0);
+    for (int n=id-1; n>=0 and m_notes[n].getTick() == first->getTick(); n--)
+    {
+        if (m_notes[n].isSelected()) id = n;
+    }
+    return id;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Track::setNoteSelected(Note* note, const bool selected)
+{
+    ASSERT(note != NULL);
+
+    note->setSelected(selected);
+    if (selected) m_selected_notes.insert(note);
+    else          m_selected_notes.erase(note);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Track::getSelectedNoteIDs(std::vector<int>& ids) const
+{
+    ids.clear();
+    ids.reserve(m_selected_notes.size());
+
+    for (std::set<Note*>::const_iterator it = m_selected_notes.begin(); it != m_selected_notes.end(); it++)
+    {
+        const int id = findNoteInOrder(m_notes, *it, false /* by start */);
+        ASSERT_E(id,>=,0);
+        ids.push_back(id);
+    }
+
+    std::sort(ids.begin(), ids.end());
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Track::getSelectedNotes(std::vector<Note*>& notes) const
+{
+    std::vector<int> ids;
+    getSelectedNoteIDs(ids);
+
+    const int count = ids.size();
+    notes.resize(count);
     for (int n=0; n<count; n++)
     {
-        if (m_notes[n].isSelected()) return n;
+        notes[n] = m_notes.contentsVector[ids[n]];
     }
-    return -1;
 }
 
 // ----------------------------------------------------------------------------------------------------------
@@ -711,13 +839,28 @@ void Track::selectNote(const int id, const bool selected, bool ignoreModifiers)
         {
          */
 
-            if (ignoreModifiers)
+            if (ignoreModifiers and selected)
             {
                 const int count = m_notes.size();
                 for (int n=0; n<count; n++)
                 {
-                    m_notes[n].setSelected(selected);
+                    m_notes[n].setSelected(true);
+                }//next
+
+                // inserting in address order lets the set append each note in constant time
+                std::vector<Note*> notes(m_notes.contentsVector);
+                std::sort(notes.begin(), notes.end());
+                m_selected_notes.clear();
+                m_selected_notes.insert(notes.begin(), notes.end());
+            }
+            else if (ignoreModifiers)
+            {
+                // only the selected notes need to be visited
+                for (std::set<Note*>::iterator it = m_selected_notes.begin(); it != m_selected_notes.end(); it++)
+                {
+                    (*it)->setSelected(false);
                 }//next
+                m_selected_notes.clear();
             }//end if
 
         /*
@@ -733,15 +876,15 @@ void Track::selectNote(const int id, const bool selected, bool ignoreModifiers)
         // if we ignore +/- key modifiers, just set the value right away
         if (ignoreModifiers)
         {
-            m_notes[id].setSelected(selected);
+            setNoteSelected(m_notes.get(id), selected);
         }
         else
         {
             // otherwise, check key modifiers and set value accordingly
             if (selected)
             {
-                if      (Display::isSelectMorePressed()) m_notes[id].setSelected(true);
-                else if (Display::isSelectLessPressed()) m_notes[id].setSelected(not selected);
+                if      (Display::isSelectMorePressed()) setNoteSelected(m_notes.get(id), true);
+                else if (Display::isSelectLessPressed()) setNoteSelected(m_notes.get(id), not selected);
             }
         }//end if
 
@@ -771,6 +914,18 @@ void Track::updateNotesForGuitarEditor()
 // ----------------------------------------------------------------------------------------------------------
 
 int Track::snapMidiTickToGrid(int tick, bool isNoteStart, bool is_ceil)
+{
+    int origin_tick;
+    float ticklen;
+    getMagneticGridStep(tick, isNoteStart, &origin_tick, &ticklen);
+
+    NoteKernels::snapToGrid(&tick, 1, origin_tick, ticklen, is_ceil);
+    return tick;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void Track::getMagneticGridStep(const int tick, const bool isNoteStart, int* origin, float* stepLength)
 {
     int origin_tick = 0;
     MeasureData* md = m_sequence->getMeasureData();
@@ -804,12 +959,8 @@ int Track::snapMidiTickToGrid(int tick, bool isNoteStart, bool is_ceil)
         ticklen = (float)(m_sequence->ticksPerQuarterNote()*4 / divider);
     }
 
-    if (is_ceil)
-    {
-        return origin_tick + (int)(ceil((float)(tick - origin_tick)/ticklen)*ticklen);
-    }
-
-    return origin_tick + (int)(round((float)(tick - origin_tick)/ticklen)*ticklen);
+    *origin     = origin_tick;
+    *stepLength = ticklen;
 }
 
 // -------------------------------------------------------------------------------------------------------
@@ -828,11 +979,15 @@ void Track::copy()
     Clipboard::clear();
     Clipboard::setBeatLength(m_sequence->ticksPerQuarterNote());
 
+    std::vector<int> selection;
+    getSelectedNoteIDs(selection);
+
     int tickOfFirstSelectedNote=-1;
     // place all selected notes into clipboard
-    for (int n=0; n<m_notes.size(); n++)
+    const int selectedAmount = selection.size();
+    for (int i=0; i<selectedAmount; i++)
     {
-        if (!m_notes[n].isSelected()) continue;
+        const int n = selection[i];
 
         Note* tmp=new Note(m_notes[n]);
         Clipboard::add(tmp);
@@ -1364,6 +1519,8 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
                          bool selectionOnly,
                          int& startTick)
 {
+    PROFILE_ZONE("Track::addMidiEvents");
+    
     const bool DEBUG_NOTE_ORDER = false;
     
     // ignore track if it has been muted
@@ -1390,8 +1547,8 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
     // when previewing selected notes (start by finding the note that plays first, to start playing at
     // the right place and note from the beginning)
     int firstNoteStartTick = -1;
-    int selectedNoteAmount = 0;
 
+#ifdef _MORE_DEBUG_CHECKS
     for (int n=0; n<m_notes.size(); n++)
     {
         if (m_notes[n].getLength() <= 1)
@@ -1399,24 +1556,32 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
             fprintf(stderr, "EMPTY NOTE\n");
         }
     }
+#endif
+
+    // IDs of the selected notes in 'm_notes' and in 'm_note_off', in increasing order
+    std::vector<int> selectedNoteOn;
+    std::vector<int> selectedNoteOff;
 
     if (selectionOnly)
     {
-        const int noteAmount = m_notes.size();
-        for (int n=0; n<noteAmount; n++)
+        getSelectedNoteIDs(selectedNoteOn);
+
+        const int selectedNoteAmount = selectedNoteOn.size();
+        if (selectedNoteAmount == 0)  return -1; // error, no note was found.
+
+        selectedNoteOff.reserve(selectedNoteAmount);
+        for (int n=0; n<selectedNoteAmount; n++)
         {
-            if (m_notes[n].isSelected())
+            Note* note = m_notes.get(selectedNoteOn[n]);
+            if (note->getTick() < firstNoteStartTick or firstNoteStartTick==-1)
             {
-                if (m_notes[n].getTick() < firstNoteStartTick or firstNoteStartTick==-1)
-                {
-                    firstNoteStartTick = m_notes[n].getTick();
-                }
-                selectedNoteAmount++;
+                firstNoteStartTick = note->getTick();
             }
+            selectedNoteOff.push_back( findNoteInOrder(m_note_off, note, true /* by end */) );
         }
+        std::sort(selectedNoteOff.begin(), selectedNoteOff.end());
 
         if (firstNoteStartTick == -1) return -1; // error, no note was found.
-        if (selectedNoteAmount == 0)  return -1; // error, no note was found.
 
     }
     else
@@ -1566,6 +1731,10 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
     int note_off_id    = 0;
     int control_evt_id = 0;
 
+    // when only playing the selection, position in 'selectedNoteOn' and 'selectedNoteOff'
+    int selected_on_id  = 0;
+    int selected_off_id = 0;
+
     const int noteOnAmount     = m_notes.size();
     const int noteOffAmount    = m_note_off.size();
     const int controllerAmount = m_control_events.size();
@@ -1589,14 +1758,16 @@ int Track::addMidiEvents(jdksmidi::MIDITrack* midiTrack,
         // if we only want to play what's selected, skip unselected notes
         if (selectionOnly)
         {
-            while (note_on_id < noteOnAmount   and not m_notes[note_on_id].isSelected())
+            while (selected_on_id < (int)selectedNoteOn.size() and selectedNoteOn[selected_on_id] < note_on_id)
             {
-                note_on_id++;
+                selected_on_id++;
             }
-            while (note_off_id < noteOffAmount and not m_note_off[note_off_id].isSelected())
+            while (selected_off_id < (int)selectedNoteOff.size() and selectedNoteOff[selected_off_id] < note_off_id)
             {
-                note_off_id++;
+                selected_off_id++;
             }
+            note_on_id  = (selected_on_id  < (int)selectedNoteOn.size()  ? selectedNoteOn[selected_on_id]   : noteOnAmount);
+            note_off_id = (selected_off_id < (int)selectedNoteOff.size() ? selectedNoteOff[selected_off_id] : noteOffAmount);
         }
 
         bool have_tick_on = (note_on_id < noteOnAmount);
@@ -1917,6 +2088,13 @@ void Track::saveToFile(wxFileOutputStream& fileout)
             break;
     }
 
+    if (not m_output_device.IsEmpty())
+    {
+        wxString output = m_output_device;
+        output.Replace("\"", "&quot;");
+        writeData(wxT("  <output device=\"") + output + wxT("\" />\n"), fileout);
+    }
+
     getGraphics()->saveToFile(fileout);
 
     // notes
@@ -1946,6 +2124,8 @@ bool Track::readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq)
 
     m_notes.clearAndDeleteAll();
     m_note_off.clearWithoutDeleting(); // have already been deleted by previous command
+    m_selected_notes.clear();
+    notesChanged();
     m_control_events.clearAndDeleteAll();
 
     // parse XML file
@@ -2060,6 +2240,18 @@ bool Track::readFromFile(irr::io::IrrXMLReader* xml, GraphicalSequence* gseq)
                         std::cerr << "Missing info from file: instrument ID" << std::endl;
                     }
                 }
+                else if (strcmp("output", xml->getNodeName()) == 0)
+                {
+                    const char* device = xml->getAttributeValue("device");
+                    if (device != NULL)
+                    {
+                        m_output_device = fromCString((char*)device);
+                    }
+                    else
+                    {
+                        std::cerr << "Missing info from file: output device" << std::endl;
+                    }
+                }
                 else if (strcmp("magneticgrid", xml->getNodeName()) == 0)
                 {
                     if (not m_magnetic_grid->readFromFile(xml)) return false;
@@ -32,14 +32,18 @@ namespace jdksmidi { class MIDITrack; }
 #include "Midi/InstrumentChoice.h"
 #include "Midi/MagneticGrid.h"
 #include "Midi/Note.h"
+#include "Midi/NoteIndex.h"
 
 #include "ptr_vector.h"
 
+#include <set>
+
 namespace AriaMaestosa
 {
     
     class Sequence; // forward
     class GraphicalTrack;
+    class MemoryUsage;
     class MainFrame;
     class ControllerEvent;
     class FullTrackUndo;
@@ -93,7 +97,7 @@ namespace AriaMaestosa
         virtual void onNotationTypeChange() = 0;
         virtual void onKeyChange(const int symbolAmount, const KeyType symbol) = 0;
 
-        LEAK_CHECK();
+        LEAK_CHECK(ITrackListener);
     };
     
     /**
@@ -118,6 +122,9 @@ namespace AriaMaestosa
         /** Only used if in manual channel management mode */
         int m_channel;
         
+        /** Output device the track is played on (see getOutputDevice), empty for the default output */
+        wxString m_output_device;
+        
         OwnerPtr<InstrumentChoice> m_instrument;
         OwnerPtr<DrumChoice> m_drum_kit;
         
@@ -147,6 +154,19 @@ namespace AriaMaestosa
 
         OwnerPtr<MagneticGrid> m_magnetic_grid;
         
+        /** Spatial index over 'm_notes', for hit-testing and rectangle selection */
+        OwnerPtr<NoteIndex> m_note_index;
+        
+        /**
+          * The selected notes of 'm_notes', so that working on the selection doesn't need to go through
+          * all notes. Kept in sync when notes are selected through this class, and when they are added or
+          * removed (see 'setNoteSelected').
+          */
+        std::set<Note*> m_selected_notes;
+        
+        /** incremented whenever notes are added, removed or reordered, see 'getNotesRevision' */
+        int m_notes_revision;
+        
         OwnerPtr< Model<wxString> > m_track_name;
         
         /**
@@ -171,6 +191,9 @@ namespace AriaMaestosa
         bool m_editor_mode[NOTATION_TYPE_COUNT];
 
         ITrackListener* m_listener;
+        
+        /** The view of this track, set by the GraphicalSequence that created it (NULL if there is none) */
+        GraphicalTrack* m_graphics;
     
         IInstrumentChoiceListener* m_next_instrument_listener;
         IDrumChoiceListener* m_next_drumkit_listener;
@@ -216,14 +239,14 @@ namespace AriaMaestosa
             ptr_vector<Note, REF>&       getNoteOffVector()      { return m_track->m_note_off;       }
             ptr_vector<ControllerEvent>& getControlEventVector() { return m_track->m_control_events; }
             
-            LEAK_CHECK();
+            LEAK_CHECK(TrackVisitor);
         };
         
 #ifdef _MORE_DEBUG_CHECKS
         int m_track_unique_ID;
 #endif
         
-        LEAK_CHECK();
+        LEAK_CHECK(Track);
         
         Track(Sequence* sequence);
         ~Track();
@@ -237,6 +260,12 @@ namespace AriaMaestosa
             m_listener = listener;
         }
         
+        /**
+          * @brief Called by the GraphicalSequence when it creates (or destroys) the view of this track
+          * @note  Does not take ownership of the view
+          */
+        void setGraphics(GraphicalTrack* graphics) { m_graphics = graphics; }
+        
         void setInstrumentListener(IInstrumentChoiceListener* l) { m_next_instrument_listener = l; }
         void setDrumListener      (IDrumChoiceListener* l)       { m_next_drumkit_listener    = l; }
         
@@ -280,6 +309,27 @@ namespace AriaMaestosa
         void setName(wxString name);
         
         void selectNote(const int id, const bool selected, bool ignoreModifiers=false);
+        
+        /**
+          * @brief selects or deselects a note of this track
+          *
+          * Notes that are part of a track must be selected through the track (and not through
+          * Note::setSelected), so that the track knows what is selected. A note that is already
+          * selected when it is added to the track is added to the selection.
+          */
+        void setNoteSelected(Note* note, const bool selected);
+        
+        /** @return the number of selected notes */
+        int getSelectedNoteAmount() const { return m_selected_notes.size(); }
+        
+        /**
+          * @brief the IDs of the selected notes, in increasing order
+          * @param[out] ids  receives the IDs; it is cleared first
+          */
+        void getSelectedNoteIDs(std::vector<int>& ids) const;
+        
+        /** @brief same as above, but gives the notes themselves (in the order of their IDs) */
+        void getSelectedNotes(std::vector<Note*>& notes) const;
 
         const wxString    getName     () const { return m_track_name->getValue(); }
         Model<wxString>*  getNameModel()       { return m_track_name;             }
@@ -298,6 +348,14 @@ namespace AriaMaestosa
           */
         int snapMidiTickToGrid(int absolute_x, bool isNoteStart, bool ceil=false);
         
+        /**
+          * @brief the magnetic grid around a tick, as used by 'snapMidiTickToGrid' (and NoteKernels::snapToGrid)
+          * @param[out] origin      tick the grid starts from (the start of the measure if measures don't all
+          *                         have the same length, 0 otherwise)
+          * @param[out] stepLength  distance between two lines of the grid, in ticks
+          */
+        void getMagneticGridStep(const int tick, const bool isNoteStart, int* origin, float* stepLength);
+        
         MagneticGrid* getMagneticGrid() { return m_magnetic_grid; }
         
         /** 
@@ -342,6 +400,21 @@ namespace AriaMaestosa
         /** use only if other getters can't provide what you want! (FIXME) */
         Note* getNote                 (const int id);
         
+        /** @return the (tick x pitch) index over the notes of this track, see NoteIndex */
+        NoteIndex& getNoteIndex() { return *m_note_index; }
+        
+        /** @brief adds the memory used by the notes and events of this track (see MemoryUsage) */
+        void getMemoryUsage(MemoryUsage& usage) const;
+        
+        /**
+          * @return a counter that changes whenever notes are added, removed or reordered in this track,
+          *         and after every action (or undo) that edited it (see Sequence::trackEdited).
+          */
+        int getNotesRevision() const { return m_notes_revision; }
+        
+        /** Called whenever notes are added, removed, reordered or edited; drops what was derived from them */
+        void notesChanged();
+        
         /**
          * Returns the first note in the given range, or -1 if there is none
          */
@@ -357,8 +430,9 @@ namespace AriaMaestosa
         void markNoteToBeRemoved(const int id);
         void removeMarkedNotes();
         
-        GraphicalTrack* getGraphics();
-        const GraphicalTrack* getGraphics() const;
+        /** @return the view of this track, or NULL if no view was created for it */
+        GraphicalTrack* getGraphics()             { return m_graphics; }
+        const GraphicalTrack* getGraphics() const { return m_graphics; }
 
         /** 
          * @param id ID of the note to get the string of
@@ -483,6 +557,17 @@ namespace AriaMaestosa
         /** @pre only used in manual channel mode */
         int getChannel();
         
+        /**
+          * @return the MIDI output this track is played on, as listed by PlatformMidiManager::getOutputChoices,
+          *         or an empty string for the default output (the one selected in the 'Output' menu)
+          * @note  channels are picked separately for each output, so a song may use more than 16 channels
+          *        as long as no output gets more than 16 of them
+          */
+        const wxString& getOutputDevice() const { return m_output_device; }
+        
+        /** @brief set the MIDI output this track is played on (see getOutputDevice) */
+        void setOutputDevice(const wxString& output) { m_output_device = output; }
+        
         /**
           * @brief set the MIDI instrument used by this track
           */
@@ -0,0 +1,384 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Parallel.h"
+
+#include "Profiler.h"
+#include "Utils.h"
+#include "ptr_vector.h"
+
+#include <algorithm>
+#include <vector>
+#include <wx/thread.h>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    namespace Parallel
+    {
+        /** how long idle workers sleep before checking whether wx asks them to end (milliseconds) */
+        const int IDLE_TIMEOUT_MS = 200;
+        
+        /** 0 for one thread per CPU, see setWorkerLimit */
+        int g_worker_limit = 0;
+        
+        /** The items [m_from .. m_to-1] that a thread still has to process */
+        class WorkRange
+        {
+            wxCriticalSection m_lock;
+            int m_from;
+            int m_to;
+            
+        public:
+            
+            WorkRange()
+            {
+                m_from = 0;
+                m_to   = 0;
+            }
+            
+            void set(const int from, const int to)
+            {
+                wxCriticalSectionLocker lock(m_lock);
+                m_from = from;
+                m_to   = to;
+            }
+            
+            /** @brief takes the first item of the range, for the thread the range belongs to */
+            bool takeFront(int* id)
+            {
+                wxCriticalSectionLocker lock(m_lock);
+                if (m_from >= m_to) return false;
+                *id = m_from++;
+                return true;
+            }
+            
+            /** @brief takes the last half of the range, for another thread that ran out of items */
+            bool stealBack(int* from, int* to)
+            {
+                wxCriticalSectionLocker lock(m_lock);
+                const int remaining = m_to - m_from;
+                if (remaining <= 0) return false;
+                
+                *to  = m_to;
+                m_to -= (remaining + 1)/2;
+                *from = m_to;
+                return true;
+            }
+        };
+        
+        class WorkerThread;
+        
+        /**
+          * Threads kept between calls to 'forEach'. Thread 0 is the thread calling 'forEach', the
+          * workers are numbered from 1; each thread works on the range with the same index.
+          */
+        class TaskPool
+        {
+            /** held for the whole duration of a 'forEach', so that only one runs at a time */
+            wxMutex m_submit_lock;
+            
+            /** guards the fields below, and is the mutex of the conditions */
+            wxMutex     m_mutex;
+            wxCondition m_wake;
+            wxCondition m_done;
+            
+            /** incremented each time a task is handed to the workers */
+            unsigned int m_generation;
+            
+            /** threads (including thread 0) working on the current task */
+            int m_participants;
+            
+            /** workers that were woken for the current task and did not leave it yet */
+            int m_busy;
+            
+            bool m_quit;
+            
+            IParallelTask* m_task;
+            
+            std::vector<WorkerThread*> m_threads;
+            ptr_vector<WorkRange>      m_ranges;
+            
+            /** @brief starts workers until there are 'amount' of them (or one fails to start) */
+            void startWorkers(const int amount);
+            
+        public:
+            
+            TaskPool();
+            ~TaskPool();
+            
+            /** @return false if the pool is busy, then the caller processes the items itself */
+            bool run(const int count, IParallelTask* task);
+            
+            /**
+              * @brief called by workers, waits until there is a task they take part in
+              * @param generation  the last task the worker saw, updated
+              * @return false if the worker must end
+              */
+            bool waitForTask(const int thread, unsigned int* generation, wxThread* worker);
+            
+            /** @brief processes items until none are left in any range */
+            void work(const int thread);
+            
+            /** @brief called by workers once they are done with the current task */
+            void leaveTask();
+        };
+        
+        class WorkerThread : public wxThread
+        {
+            TaskPool* m_pool;
+            int       m_index;
+            
+        public:
+            
+            WorkerThread(TaskPool* pool, const int index) : wxThread(wxTHREAD_JOINABLE)
+            {
+                m_pool  = pool;
+                m_index = index;
+            }
+            
+            virtual ExitCode Entry()
+            {
+                Profiler::setThreadName("Parallel worker");
+                
+                unsigned int generation = 0;
+                while (m_pool->waitForTask(m_index, &generation, this))
+                {
+                    m_pool->work(m_index);
+                    m_pool->leaveTask();
+                }
+                return 0;
+            }
+        };
+        
+        TaskPool* g_pool = NULL;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+Parallel::TaskPool::TaskPool() : m_wake(m_mutex), m_done(m_mutex)
+{
+    m_generation   = 0;
+    m_participants = 0;
+    m_busy         = 0;
+    m_quit         = false;
+    m_task         = NULL;
+    
+    // range of the calling thread
+    m_ranges.push_back(new WorkRange());
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+Parallel::TaskPool::~TaskPool()
+{
+    {
+        wxMutexLocker lock(m_mutex);
+        m_quit = true;
+        m_wake.Broadcast();
+    }
+    
+    const int threadAmount = m_threads.size();
+    for (int n=0; n<threadAmount; n++)
+    {
+        m_threads[n]->Wait();
+        delete m_threads[n];
+    }
+    m_ranges.clearAndDeleteAll();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void Parallel::TaskPool::startWorkers(const int amount)
+{
+    while ((int)m_threads.size() < amount)
+    {
+        // the range must exist before the worker that uses it starts
+        m_ranges.push_back(new WorkRange());
+        
+        WorkerThread* thread = new WorkerThread(this, m_threads.size() + 1);
+        if (thread->Create() != wxTHREAD_NO_ERROR or thread->Run() != wxTHREAD_NO_ERROR)
+        {
+            // not fatal, the threads that did start (at least the calling one) will pick up the work
+            std::cerr << "[Parallel] WARNING: failed to start worker thread" << std::endl;
+            delete thread;
+            m_ranges.erase(m_ranges.size() - 1);
+            return;
+        }
+        m_threads.push_back(thread);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+bool Parallel::TaskPool::run(const int count, IParallelTask* task)
+{
+    if (m_submit_lock.TryLock() != wxMUTEX_NO_ERROR) return false;
+    
+    int participants = std::min(getWorkerCount(), count);
+    startWorkers(participants - 1);
+    participants = std::min(participants, (int)m_threads.size() + 1);
+    
+    // give each thread an equal part of the items
+    for (int n=0; n<participants; n++)
+    {
+        m_ranges[n].set((int)((long long)count*n/participants), (int)((long long)count*(n + 1)/participants));
+    }
+    
+    {
+        wxMutexLocker lock(m_mutex);
+        m_task         = task;
+        m_participants = participants;
+        m_busy         = participants - 1;
+        m_generation++;
+        if (m_busy > 0) m_wake.Broadcast();
+    }
+    
+    work(0);
+    
+    {
+        // workers may still be processing the items they took
+        wxMutexLocker lock(m_mutex);
+        while (m_busy > 0) m_done.Wait();
+        m_task = NULL;
+    }
+    
+    m_submit_lock.Unlock();
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+bool Parallel::TaskPool::waitForTask(const int thread, unsigned int* generation, wxThread* worker)
+{
+    wxMutexLocker lock(m_mutex);
+    while (true)
+    {
+        if (m_quit) return false;
+        
+        if (m_generation != *generation)
+        {
+            *generation = m_generation;
+            if (thread < m_participants) return true;
+        }
+        
+        // wake up from time to time in case wx asks the thread to end (e.g. when exiting without 'stopWorkers')
+        m_wake.WaitTimeout(IDLE_TIMEOUT_MS);
+        if (worker->TestDestroy()) return false;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void Parallel::TaskPool::work(const int thread)
+{
+    IParallelTask* task = m_task;
+    WorkRange& own = m_ranges[thread];
+    
+    while (true)
+    {
+        int id;
+        while (own.takeFront(&id))
+        {
+            task->run(id);
+        }
+        
+        // out of items, steal from the others
+        bool stole = false;
+        for (int n=1; n<m_participants and not stole; n++)
+        {
+            int from, to;
+            if (m_ranges[(thread + n) % m_participants].stealBack(&from, &to))
+            {
+                own.set(from, to);
+                stole = true;
+            }
+        }
+        if (not stole) return;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void Parallel::TaskPool::leaveTask()
+{
+    wxMutexLocker lock(m_mutex);
+    m_busy--;
+    if (m_busy == 0) m_done.Signal();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------
+
+int Parallel::getWorkerCount()
+{
+    int count = wxThread::GetCPUCount();
+    if (count < 1) count = 1;
+    
+    const int limit = __atomic_load_n(&g_worker_limit, __ATOMIC_RELAXED);
+    if (limit > 0 and limit < count) count = limit;
+    return count;
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void Parallel::setWorkerLimit(const int limit)
+{
+    ASSERT_E(limit,>=,0);
+    __atomic_store_n(&g_worker_limit, limit, __ATOMIC_RELAXED);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void Parallel::forEach(const int count, IParallelTask* task)
+{
+    if (count <= 0) return;
+    
+    if (count > 1 and getWorkerCount() > 1)
+    {
+        TaskPool* pool = __atomic_load_n(&g_pool, __ATOMIC_ACQUIRE);
+        if (pool == NULL)
+        {
+            // the pool starts no thread before its first task, so the one that loses the race is simply deleted
+            TaskPool* created = new TaskPool();
+            if (__atomic_compare_exchange_n(&g_pool, &pool, created, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                pool = created;
+            }
+            else
+            {
+                delete created;
+            }
+        }
+        
+        if (pool->run(count, task)) return;
+    }
+    
+    for (int n=0; n<count; n++)
+    {
+        task->run(n);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+void Parallel::stopWorkers()
+{
+    TaskPool* pool = __atomic_exchange_n(&g_pool, (TaskPool*)NULL, __ATOMIC_ACQ_REL);
+    delete pool;
+}
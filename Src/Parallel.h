@@ -0,0 +1,76 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief a unit of work that can be executed for many independent items at once
+      *
+      * Implementations must not touch any GUI object, and must only write to data that
+      * belongs to the item they were given (e.g. the notes of one track, or the slot of a
+      * vector that was sized before the call).
+      */
+    class IParallelTask
+    {
+    public:
+        virtual ~IParallelTask() {}
+        
+        /** @param id  ID of the item to process, in range [0 .. count-1] */
+        virtual void run(const int id) = 0;
+    };
+    
+    /**
+      * Items are run by a pool of worker threads, started the first time they are needed and kept
+      * for the following calls. Each thread is given a range of items, takes them from the front of
+      * its range, and when it has none left, steals half of what remains at the back of the range
+      * of another thread.
+      */
+    namespace Parallel
+    {
+        /** @return the number of threads (including the calling thread) used by 'forEach' */
+        int getWorkerCount();
+        
+        /**
+          * @brief limits the number of threads (including the calling thread) used by 'forEach',
+          *        e.g. to compare with a serial run
+          * @param limit  at least 1, or 0 to use one thread per CPU (the default)
+          */
+        void setWorkerLimit(const int limit);
+        
+        /**
+          * @brief runs 'task' on every ID in range [0 .. count-1], spreading the items over worker threads
+          *
+          * The calling thread takes part in the work and this call only returns once all items
+          * were processed. Items may be processed in any order. When the pool is already busy (e.g.
+          * 'forEach' called from a task, or from two threads at once), the items are processed
+          * by the calling thread, in increasing order.
+          */
+        void forEach(const int count, IParallelTask* task);
+        
+        /**
+          * @brief stops the worker threads and waits for them to end; to be called before exiting,
+          *        never while 'forEach' runs. A later call to 'forEach' starts new threads.
+          */
+        void stopWorkers();
+    }
+    
+}
+
+#endif
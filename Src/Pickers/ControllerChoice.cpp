@@ -185,7 +185,7 @@ using namespace AriaMaestosa;
 
 // -----------------------------------------------------------------------------------------------------------
 
-ControllerChoice::ControllerChoice() : wxMenu(), m_controller_label(new Model<wxString>(wxT("")), true)
+ControllerChoice::ControllerChoice() : wxEvtHandler(), m_controller_label(new Model<wxString>(wxT("")), true)
 {
     LabelSingleton* label_renderer = LabelSingleton::getInstance();
     if (label_renderer->getStringAmount() == 0)
@@ -214,45 +214,61 @@ ControllerChoice::ControllerChoice() : wxMenu(), m_controller_label(new Model<wx
     m_controller_id = 7;
     m_controller_label.setMaxWidth(75, true);
     m_controller_label.getModel()->setValue(g_controller_names[m_controller_id]);
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+ControllerChoice::~ControllerChoice()
+{
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+wxMenu* ControllerChoice::getMenu()
+{
+    if (m_menu.raw_ptr != NULL) return m_menu;
+    
+    m_menu = new wxMenu();
+    wxMenu* menu = m_menu;
     
-    Append( 7 ,  g_controller_names[7  ] ); // Volume // fine:39
-    Append( 10 , g_controller_names[10 ] ); // Pan // fine:42
-    Append( 1 ,  g_controller_names[1  ] ); // Modulation // fine:33
-    Append( 91 , g_controller_names[91 ] ); // Reverb
-    Append( 64 , g_controller_names[64 ] ); // Sustain
+    menu->Append( 7 ,  g_controller_names[7  ] ); // Volume // fine:39
+    menu->Append( 10 , g_controller_names[10 ] ); // Pan // fine:42
+    menu->Append( 1 ,  g_controller_names[1  ] ); // Modulation // fine:33
+    menu->Append( 91 , g_controller_names[91 ] ); // Reverb
+    menu->Append( 64 , g_controller_names[64 ] ); // Sustain
 
-    Append( PSEUDO_CONTROLLER_INSTRUMENT_CHANGE, wxT("Instrument") );
+    menu->Append( PSEUDO_CONTROLLER_INSTRUMENT_CHANGE, wxT("Instrument") );
     
     // In the midi specs, pitch bend is not a controller. However, i found it just made sense to place it
     // among controllers, so i assigned it arbitrary ID 200.
-    Append( PSEUDO_CONTROLLER_PITCH_BEND , wxT("Pitch Bend") );
-    Append( PSEUDO_CONTROLLER_TEMPO , wxT("Tempo (global)") );
-    Append( PSEUDO_CONTROLLER_LYRICS , wxT("Lyrics (global)") );
+    menu->Append( PSEUDO_CONTROLLER_PITCH_BEND , wxT("Pitch Bend") );
+    menu->Append( PSEUDO_CONTROLLER_TEMPO , wxT("Tempo (global)") );
+    menu->Append( PSEUDO_CONTROLLER_LYRICS , wxT("Lyrics (global)") );
     
-    AppendSeparator();
+    menu->AppendSeparator();
 
-    Append( 0  , g_controller_names[0  ] ); // Bank select
-    Append( 2  , g_controller_names[2  ] ); // Breath
-    Append( 4  , g_controller_names[4  ] ); // Foot
-    Append( 8  , g_controller_names[8  ] ); // Balance
-    Append( 11 , g_controller_names[11 ] ); // Expression
-    Append( 92 , g_controller_names[92 ] ); // Tremolo
-    Append( 93 , g_controller_names[93 ] ); // Chorus
-    Append( 94 , g_controller_names[94 ] ); // Celeste
-    Append( 95 , g_controller_names[95 ] ); // Phaser
+    menu->Append( 0  , g_controller_names[0  ] ); // Bank select
+    menu->Append( 2  , g_controller_names[2  ] ); // Breath
+    menu->Append( 4  , g_controller_names[4  ] ); // Foot
+    menu->Append( 8  , g_controller_names[8  ] ); // Balance
+    menu->Append( 11 , g_controller_names[11 ] ); // Expression
+    menu->Append( 92 , g_controller_names[92 ] ); // Tremolo
+    menu->Append( 93 , g_controller_names[93 ] ); // Chorus
+    menu->Append( 94 , g_controller_names[94 ] ); // Celeste
+    menu->Append( 95 , g_controller_names[95 ] ); // Phaser
 
 
-    Append( 70 , g_controller_names[70 ] ); // Timber Variation
-    Append( 71 , g_controller_names[71 ] ); // Timber/Harmonic
-    Append( 72 , g_controller_names[72 ] ); // Release Time
-    Append( 73 , g_controller_names[73 ] ); // Attack Time
-    Append( 74 , g_controller_names[74 ] ); // Brightness
-    Append( 75 , g_controller_names[75 ] ); // Decay Time
+    menu->Append( 70 , g_controller_names[70 ] ); // Timber Variation
+    menu->Append( 71 , g_controller_names[71 ] ); // Timber/Harmonic
+    menu->Append( 72 , g_controller_names[72 ] ); // Release Time
+    menu->Append( 73 , g_controller_names[73 ] ); // Attack Time
+    menu->Append( 74 , g_controller_names[74 ] ); // Brightness
+    menu->Append( 75 , g_controller_names[75 ] ); // Decay Time
 
-    AppendSeparator();
+    menu->AppendSeparator();
 
     wxMenu* misc_menu = new wxMenu();
-    Append(wxID_ANY,wxT("Misc"), misc_menu);
+    menu->Append(wxID_ANY,wxT("Misc"), misc_menu);
 
     misc_menu->Append( 66 , g_controller_names[66 ] ); // Sostenuto
     misc_menu->Append( 67 , g_controller_names[67 ] ); // Soft Pedal
@@ -288,16 +304,12 @@ ControllerChoice::ControllerChoice() : wxMenu(), m_controller_label(new Model<wx
     misc_menu->Append( 83 , g_controller_names[83 ] ); // General Purpose 8
      */
 
-    Connect(0,204, wxEVT_COMMAND_MENU_SELECTED,
-            wxCommandEventHandler(ControllerChoice::menuSelected));
+    menu->Connect(0,204, wxEVT_COMMAND_MENU_SELECTED,
+                  wxCommandEventHandler(ControllerChoice::menuSelected), NULL, this);
     misc_menu->Connect(0,204, wxEVT_COMMAND_MENU_SELECTED,
                        wxCommandEventHandler(ControllerChoice::menuSelected), NULL, this);
-}
-
-// -----------------------------------------------------------------------------------------------------------
-
-ControllerChoice::~ControllerChoice()
-{
+    
+    return menu;
 }
 
 // -----------------------------------------------------------------------------------------------------------
@@ -338,7 +350,7 @@ void ControllerChoice::updateLabel()
     ASSERT_E(m_controller_id,>=,0);
 
     Display::render();
-    getMainFrame()->getMainPane()->SetFocus();
+    if (getMainFrame() != NULL) getMainFrame()->getMainPane()->SetFocus();
 }
 
 // -----------------------------------------------------------------------------------------------------------
@@ -32,20 +32,26 @@ namespace AriaMaestosa
       * @ingroup pickers
       * @brief the menu where you can choose a midi controller
       */
-    class ControllerChoice : public wxMenu
+    class ControllerChoice : public wxEvtHandler
     {
         int m_controller_id;
         AriaRenderString m_controller_label;
         
+        /** the popup menu itself, only built the first time it is shown (see 'getMenu') */
+        OwnerPtr<wxMenu> m_menu;
+        
         void updateLabel();
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(ControllerChoice);
         
         ControllerChoice();
         ~ControllerChoice();
         
         int  getControllerID() const { return m_controller_id; }
+        
+        /** @return the menu listing the controllers, built on first call */
+        wxMenu* getMenu();
             
         void setControllerID(int id);
         
@@ -38,7 +38,7 @@ namespace AriaMaestosa
         DrumChoice* m_model;
                 
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(DrumPicker);
         
         DrumPicker();
         ~DrumPicker();
@@ -57,7 +57,7 @@ namespace AriaMaestosa
         
     public:
         
-        LEAK_CHECK();
+        LEAK_CHECK(InstrumentPicker);
         
         InstrumentPicker();
         ~InstrumentPicker();
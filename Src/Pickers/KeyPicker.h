@@ -77,7 +77,7 @@ namespace AriaMaestosa
         wxString buildKeyLabel(const wxString& majorKey, const wxString& minorKey);
         
 public:
-        LEAK_CHECK();
+        LEAK_CHECK(KeyPicker);
 
         KeyPicker();
         ~KeyPicker();
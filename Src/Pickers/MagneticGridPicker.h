@@ -59,7 +59,7 @@ namespace AriaMaestosa
         void resetChecks();
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(MagneticGridPicker);
         
         MagneticGridPicker(GraphicalTrack* parent, MagneticGrid* model);
         ~MagneticGridPicker();
@@ -39,7 +39,7 @@ namespace AriaMaestosa
         
     public:
         
-        LEAK_CHECK();
+        LEAK_CHECK(NotePickerWidget);
         
         NotePickerWidget(wxWindow* parent, bool withCheckbox);
         void enterDefaultValue(int pitchID);
@@ -52,7 +52,7 @@ namespace AriaMaestosa
         GraphicalSequence* m_gseq;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(TimeSigPicker);
         
         TimeSigPicker();
         
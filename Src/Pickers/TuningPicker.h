@@ -38,7 +38,7 @@ namespace AriaMaestosa
         Track* m_parent;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(TuningPicker);
         
         TuningPicker();
         ~TuningPicker();
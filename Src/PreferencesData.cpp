@@ -284,6 +284,11 @@ void PreferencesData::fillSettingsVector()
                                      _("Automatically launch FluidSynth if needed"),
                                      SETTING_BOOL, SETTING_CATEGORY_AUDIO, wxT("1") );
     m_settings.push_back(launchFluidSynth);
+    
+    Setting* scheduledOutput = new Setting(fromCString(SETTING_ID_ALSA_SCHEDULED_OUTPUT),
+                                     _("Schedule playback on the ALSA sequencer queue (more accurate timing)"),
+                                     SETTING_BOOL, SETTING_CATEGORY_AUDIO, wxT("1") );
+    m_settings.push_back(scheduledOutput);
 #endif
 
 #ifndef __WXMAC__
@@ -304,6 +309,12 @@ void PreferencesData::fillSettingsVector()
                                      SETTING_BOOL, SETTING_CATEGORY_UI, wxT("0") );
     m_settings.push_back(loadLastSession); 
     
+    //I18N: In preferences; a warning is shown when the songs that are open use more memory than this
+    Setting* memoryBudget = new Setting(fromCString(SETTING_ID_MEMORY_BUDGET),
+                                     _("Warn when open songs use more memory than (MB, 0 = never)"),
+                                     SETTING_INT, SETTING_CATEGORY_UI, wxT("0") );
+    m_settings.push_back(memoryBudget);
+    
     
     Setting* lastSessionFiles = new Setting(fromCString(SETTING_ID_LAST_SESSION_FILES),
                                      wxT("Last session files"),
@@ -74,6 +74,7 @@ static const wxString SYSTEM_BANK = _("System soundbank");
     EXTERN const char* SETTING_ID_PLAY_DURING_EDIT DEFAULT("playDuringEdit");
     EXTERN const char* SETTING_ID_LANGUAGE         DEFAULT("lang");
     EXTERN const char* SETTING_ID_LAUNCH_FLUIDSYNTH  DEFAULT("launchFluidSynth");
+    EXTERN const char* SETTING_ID_ALSA_SCHEDULED_OUTPUT  DEFAULT("alsaScheduledOutput");
     
 #ifndef __WXMAC__
     EXTERN const char* SETTING_ID_SINGLE_INSTANCE_APPLICATION  DEFAULT("singleInstanceApplication");
@@ -105,6 +106,8 @@ static const wxString SYSTEM_BANK = _("System soundbank");
     
     EXTERN const char* SETTING_ID_CHECK_NEW_VERSION DEFAULT("checkForNewVersion");
     
+    EXTERN const char* SETTING_ID_MEMORY_BUDGET    DEFAULT("memoryBudget");
+    
     EXTERN const char* SETTING_ID_REMEMBER_WINDOW_POS DEFAULT("rememberWindowLocation");
     EXTERN const char* SETTING_ID_WINDOW_X DEFAULT("window_x");
     EXTERN const char* SETTING_ID_WINDOW_Y DEFAULT("window_y");
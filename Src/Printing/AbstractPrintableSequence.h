@@ -128,7 +128,7 @@ namespace AriaMaestosa
         /** @return whether 'calculteLayout' was called on this object */
         bool isLayoutCalculated() const { return m_layout_calculated; }
         
-        LEAK_CHECK()
+        LEAK_CHECK(AbstractPrintableSequence);
         
     };
     
@@ -29,6 +29,7 @@
 #include <wx/printdlg.h>
 #include <wx/graphics.h>
 #include <wx/dcprint.h>
+#include <wx/stopwatch.h>
 
 using namespace AriaMaestosa;
 
@@ -195,6 +196,19 @@ wxPrinterError AriaPrintable::print()
 
 // -------------------------------------------------------------------------------------------------------------
 
+int AriaPrintable::exportToFile(const wxString& filePath)
+{
+    ASSERT( MAGIC_NUMBER_OK() );
+    
+    ASSERT(m_seq->isLayoutCalculated());
+    ASSERT(m_printer_manager != NULL);
+    
+    m_printer_manager->setPageCount(m_seq->getPageAmount());
+    return m_printer_manager->exportToFile(filePath);
+}
+
+// -------------------------------------------------------------------------------------------------------------
+
 AriaPrintable* AriaPrintable::getCurrentPrintable()
 {
     ASSERT(m_current_printable != NULL);
@@ -213,6 +227,10 @@ void AriaPrintable::printPage(const int pageNum, wxDC& dc, wxGraphicsContext* gc
     
     ASSERT( m_seq != NULL );
     
+#ifdef ARIA_PROFILER
+    wxStopWatch stopwatch;
+#endif
+    
     const int h = y1 - y0;
 
     //LayoutPage& page = m_seq->getPage(pageNum-1);
@@ -333,8 +351,8 @@ void AriaPrintable::printPage(const int pageNum, wxDC& dc, wxGraphicsContext* gc
     dc.SetFont( m_normal_font );
     m_seq->printLinesInArea(dc, gc, pageNum-1, notation_area_y0, notation_area_h, h, x0, x1);
     
-#if wxCHECK_VERSION(2,9,1) && wxUSE_GRAPHICS_CONTEXT
-    delete gc;
+#ifdef ARIA_PROFILER
+    std::cout << "[AriaPrintable] Rendering page " << pageNum << " took " << stopwatch.Time() << " ms" << std::endl;
 #endif
 }
     
@@ -89,7 +89,7 @@ namespace AriaMaestosa
         
     public:
         
-        LEAK_CHECK();
+        LEAK_CHECK(AriaPrintable);
         
         /**
          * Construct this object BEFORE calling 'calculateLayout' in the prntable sequence, since the printable
@@ -129,6 +129,14 @@ namespace AriaMaestosa
           */ 
         wxPrinterError print();
         
+        /**
+          * @brief Render the sequence to a PDF, SVG or PNG file, without any dialog or window
+          * @pre  the 'calculateLayout' method of the printable sequence has been called
+          * @return the number of pages written, or -1 if an error occurred
+          * @see wxEasyPrintWrapper::exportToFile
+          */
+        int exportToFile(const wxString& filePath);
+        
         /** 
           * @return the number of units used horizontally in the coordinate system set-up for
           * the kind of paper that is selected.
@@ -0,0 +1,175 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "Printing/NotationExport.h"
+
+#include "AriaCore.h"
+#include "GUI/GraphicalSequence.h"
+#include "GUI/GraphicalTrack.h"
+#include "IO/AriaFileWriter.h"
+#include "IO/IOUtils.h"
+#include "IO/MidiFileReader.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "Printing/AriaPrintable.h"
+#include "Printing/KeyrollPrintableSequence.h"
+#include "Printing/SymbolPrinter/SymbolPrintableSequence.h"
+
+#include <iostream>
+#include <set>
+#include <vector>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    /** keyroll defaults, matching the initial values of the keyroll printing options dialog */
+    const float KEYROLL_EXPORT_CM_PER_BEAT      = 0.7f;
+    const float KEYROLL_EXPORT_VERTICAL_MARGIN  = 0.0f;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool AriaMaestosa::exportNotation(const wxString& songPath, const wxString& outputPath)
+{
+    wxStopWatch totalTime;
+    
+    // ---- load the song, without any window attached to it
+    OwnerPtr<GraphicalSequence> gseq( new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false)) );
+    Sequence* seq = gseq->getModel();
+    seq->setFilepath(songPath);
+    
+    bool loaded = false;
+    if (wxFileName(songPath).GetExt().Lower() == wxT("aria"))
+    {
+        loaded = loadAriaFile(gseq, songPath);
+    }
+    else
+    {
+        std::set<wxString> warnings;
+        loaded = loadMidiFile(gseq, songPath, warnings);
+    }
+    
+    if (not loaded)
+    {
+        std::cerr << "[exportNotation] ERROR: cannot load " << songPath.mb_str() << std::endl;
+        return false;
+    }
+    seq->setSequenceFilename( extractTitle(songPath) );
+    
+    // ---- pick what to print
+    std::vector< std::pair<GraphicalTrack*, NotationType> > symbolTracks;
+    std::vector< std::pair<GraphicalTrack*, NotationType> > keyrollTracks;
+    
+    const int trackAmount = seq->getTrackAmount();
+    for (int n=0; n<trackAmount; n++)
+    {
+        Track* track = seq->getTrack(n);
+        if (track->isMuted()) continue;
+        
+        GraphicalTrack* gtrack = gseq->getGraphicsFor(track);
+        ASSERT(gtrack != NULL);
+        
+        if (track->isNotationTypeEnabled(SCORE))
+        {
+            symbolTracks.push_back( std::pair<GraphicalTrack*, NotationType>(gtrack, SCORE) );
+        }
+        if (track->isNotationTypeEnabled(GUITAR))
+        {
+            symbolTracks.push_back( std::pair<GraphicalTrack*, NotationType>(gtrack, GUITAR) );
+        }
+        if (track->isNotationTypeEnabled(KEYBOARD))
+        {
+            keyrollTracks.push_back( std::pair<GraphicalTrack*, NotationType>(gtrack, KEYBOARD) );
+        }
+    }
+    
+    const bool useSymbolPrinter = not symbolTracks.empty();
+    const std::vector< std::pair<GraphicalTrack*, NotationType> >& whatToPrint =
+            (useSymbolPrinter ? symbolTracks : keyrollTracks);
+    
+    if (whatToPrint.empty())
+    {
+        std::cerr << "[exportNotation] ERROR: " << songPath.mb_str() << " has no printable track" << std::endl;
+        return false;
+    }
+    
+    // ---- calculate layout
+    bool success = false;
+    OwnerPtr<AriaPrintable> printable( new AriaPrintable(AbstractPrintableSequence::getTitle(seq), &success) );
+    if (not success)
+    {
+        std::cerr << "[exportNotation] ERROR: page setup failed" << std::endl;
+        return false;
+    }
+    
+    OwnerPtr<AbstractPrintableSequence> printableSeq;
+    if (useSymbolPrinter)
+    {
+        printableSeq = new SymbolPrintableSequence(seq);
+    }
+    else
+    {
+        std::vector<wxColor> colors(whatToPrint.size(), wxColour(150,150,150));
+        printableSeq = new KeyrollPrintableSequence(seq, KEYROLL_EXPORT_CM_PER_BEAT, KEYROLL_EXPORT_VERTICAL_MARGIN,
+                                                    false /* compact */, colors);
+    }
+    
+    printable->setSequence(printableSeq);
+    printable->hideEmptyTracks(true);
+    printable->showTrackNames(whatToPrint.size() > 1);
+    
+    for (unsigned int n=0; n<whatToPrint.size(); n++)
+    {
+        if (not printableSeq->addTrack( whatToPrint[n].first, whatToPrint[n].second ))
+        {
+            std::cerr << "[exportNotation] WARNING: track '" << whatToPrint[n].first->getTrack()->getName().mb_str()
+                      << "' cannot be printed, skipping it" << std::endl;
+        }
+    }
+    
+    if (printableSeq->getTrackAmount() == 0)
+    {
+        std::cerr << "[exportNotation] ERROR: " << songPath.mb_str() << " has no printable track" << std::endl;
+        return false;
+    }
+    
+    wxStopWatch layoutTime;
+    printableSeq->calculateLayout();
+    const long layoutMs = layoutTime.Time();
+    
+    // ---- render pages
+    wxStopWatch renderTime;
+    const int pages = printable->exportToFile(outputPath);
+    const long renderMs = renderTime.Time();
+    
+    if (pages < 0)
+    {
+        std::cerr << "[exportNotation] ERROR: cannot write " << outputPath.mb_str() << std::endl;
+        return false;
+    }
+    
+    const long totalMs = totalTime.Time();
+    std::cout << "[exportNotation] " << songPath.mb_str() << " -> " << outputPath.mb_str() << " : "
+              << pages << " pages, layout " << layoutMs << " ms, render " << renderMs << " ms, total "
+              << totalMs << " ms, " << (totalMs > 0 ? pages*1000.0f/totalMs : 0.0f) << " pages/s" << std::endl;
+    
+    return true;
+}
+
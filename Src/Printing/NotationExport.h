@@ -0,0 +1,43 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+ 
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef __NOTATION_EXPORT_H__
+#define __NOTATION_EXPORT_H__
+
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+    
+    /**
+      * @brief load a song and render its printed notation to a file, without any dialog or window
+      *
+      * Tracks that have the score or tablature view enabled are laid out with the symbol printer;
+      * if the song has none, tracks with the keyboard view enabled are printed as a keyroll, using
+      * the same defaults as the keyroll printing options dialog. Muted tracks are skipped.
+      * Page count and timings are printed to standard output.
+      *
+      * @param songPath    path of the .aria or .mid file to load
+      * @param outputPath  file to write; its extension selects the format (see AriaPrintable::exportToFile)
+      * @return whether the export succeeded
+      * @ingroup printing
+      */
+    bool exportNotation(const wxString& songPath, const wxString& outputPath);
+    
+}
+
+#endif
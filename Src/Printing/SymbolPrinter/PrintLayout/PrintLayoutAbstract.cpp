@@ -30,10 +30,14 @@
 #include "Printing/SymbolPrinter/SymbolPrintableSequence.h"
 
 #include "AriaCore.h"
+#include "Parallel.h"
 
 #include <iostream>
 #include <cmath>
 #include <map>
+#include <vector>
+
+#include <wx/stopwatch.h>
 
 #define BE_VERBOSE 0
 
@@ -61,7 +65,25 @@ namespace AriaMaestosa
     /** Whether to show a line ehader (clef+key, tab tuning, etc...) on every line */
     const bool HEADER_ON_EVERY_LINE = false;
     
+    /**
+      * Whether to look for measures that repeat earlier ones (see PrintLayoutMeasure::findSimilarMeasures).
+      * Off until the layout prints repetitions, since nothing reads the result before that.
+      */
+    const bool DETECT_REPEATED_MEASURES = false;
+    
     int repetitionMinimalLength = 2;
+    
+    /**
+      * prints the time elapsed since the stopwatch was last started, and restarts it
+      * (only in profiler builds, see ARIA_PROFILER)
+      */
+    void printStageTime(const char* stage, wxStopWatch& stopwatch)
+    {
+#ifdef ARIA_PROFILER
+        std::cout << "[PrintLayoutAbstract] " << stage << " took " << stopwatch.Time() << " ms" << std::endl;
+        stopwatch.Start();
+#endif
+    }
         
     // -------------------------------------------------------------------------------------------
     
@@ -136,7 +158,10 @@ void PrintLayoutAbstract::calculateLayoutElements (ptr_vector<GraphicalTrack, RE
     std::vector<LayoutElement> layoutElements;
     
     // search for repeated m_measures if necessary
-    //if (checkRepetitions_bool) findSimilarMeasures();
+    if (DETECT_REPEATED_MEASURES) findSimilarMeasures();
+    
+    
+    wxStopWatch stopwatch;
     
     const int trackAmount = tracks.size();
     for (int i=0; i<trackAmount; i++)
@@ -145,39 +170,37 @@ void PrintLayoutAbstract::calculateLayoutElements (ptr_vector<GraphicalTrack, RE
         ASSERT( editorPrintable != NULL );
         editorPrintable->earlySetup( i, tracks.get(i) );
     }
+    printStageTime("earlySetup (analysers, silences)", stopwatch);
     
     createLayoutElements(layoutElements);
+    printStageTime("createLayoutElements", stopwatch);
+    
     calculateRelativeLengths(layoutElements);
+    printStageTime("calculateRelativeLengths", stopwatch);
     
     // this will also move the layoutElements to their corresponding LayoutLine object
     layInLinesAndPages(layoutElements, layoutPages);
+    printStageTime("layInLinesAndPages", stopwatch);
 }
 
 // -----------------------------------------------------------------------------------------------------
-#if 0
+
 void PrintLayoutAbstract::findSimilarMeasures()
 {
+    std::cout << "\n====\nfindSimilarMeasures\n====\n";
+    
     const Sequence* seq = m_sequence->getSequence();
     const int measureAmount = seq->getMeasureData()->getMeasureAmount();
-
-    for (int measure=0; measure<measureAmount; measure++)
-    {
-        // check current measure against all previous m_measures to see if it is not a repetition
-        for (int checkMeasure=0; checkMeasure<measure; checkMeasure++)
-        {
-            ASSERT_E(measure,<,(int)m_measures.size());
-            ASSERT_E(checkMeasure,<,(int)m_measures.size());
-            const bool isSameAs = m_measures[measure].calculateIfMeasureIsSameAs(m_measures[checkMeasure]);
-            //std::cout << "measure " << (measure+1) << " is same as " << (checkMeasure+1) << " ? " << isSameAs << std::endl;
-            
-            if (!isSameAs) continue;
-            m_measures[measure].firstSimilarMeasure = checkMeasure;
-            m_measures[checkMeasure].similarMeasuresFoundLater.push_back(measure);
-            break;
-        }//next
-    }//next
-}
+    
+#ifdef ARIA_PROFILER
+    wxStopWatch stopwatch;
+    const int repetitions = PrintLayoutMeasure::findSimilarMeasures(m_measures, measureAmount);
+    std::cout << "    " << repetitions << " repeated measure(s) found among " << measureAmount
+              << " measure(s) in " << stopwatch.Time() << " ms" << std::endl;
+#else
+    PrintLayoutMeasure::findSimilarMeasures(m_measures, measureAmount);
 #endif
+}
     
 // -----------------------------------------------------------------------------------------------------
         
@@ -301,44 +324,36 @@ void PrintLayoutAbstract::createLayoutElements(std::vector<LayoutElement>& layou
 
 // -----------------------------------------------------------------------------------------------------
     
-void PrintLayoutAbstract::calculateRelativeLengths(std::vector<LayoutElement>& layoutElements)
+namespace AriaMaestosa
 {
-    std::cout << "\n====\ncalculateRelativeLengths\n====\n";
-
-    // calculate approximative width of each element
-    const int layoutElementsAmount = layoutElements.size();
-    for (int n=0; n<layoutElementsAmount; n++)
+    /**
+      * Collects the symbols of all printed tracks within one measure, and calculates their
+      * relative placement. Each measure has its own RelativePlacementManager, and editor
+      * printables only read their (previously analysed) track data at this point, so measures
+      * can be processed concurrently.
+      */
+    class MeasurePlacementTask : public IParallelTask
     {
-        if ((n & 3) == 0) // only update progress one element out of 4
+        SymbolPrintableSequence* m_sequence;
+        ptr_vector<PrintLayoutMeasure>& m_measures;
+        const std::vector<int>& m_measure_ids;
+        
+    public:
+        
+        MeasurePlacementTask(SymbolPrintableSequence* sequence, ptr_vector<PrintLayoutMeasure>& measures,
+                             const std::vector<int>& measureIDs) :
+            m_measures(measures), m_measure_ids(measureIDs)
         {
-            WaitWindow::setProgress( 35 + n*25/layoutElementsAmount );
+            m_sequence = sequence;
         }
         
-#if BE_VERBOSE
-        std::cout << "= layout element " << n << " =\n";
-#endif
-        
-        //layoutElements[n].width_in_print_units = LAYOUT_ELEMENT_MIN_WIDTH;
-
-        if (layoutElements[n].getType() == SINGLE_MEASURE or layoutElements[n].getType() == EMPTY_MEASURE)
-        {     
-            layoutElements[n].width_in_print_units = LAYOUT_ELEMENT_MIN_WIDTH;
-            
-            // determine a list of all ticks on which a note starts.
-            // then we can determine where within this measure should this note be drawn
-            
-            std::vector<int> all_ticks_vector;
-            
-            // Ask all editors to add their symbols to the list
-            PrintLayoutMeasure& meas = m_measures[layoutElements[n].m_measure];
+        virtual void run(const int id)
+        {
+            PrintLayoutMeasure& meas = m_measures[m_measure_ids[id]];
             RelativePlacementManager& ticks_relative_position = meas.getTicksPlacementManager();
             
+            // Ask all editors to add their symbols to the list
             const int trackAmount = meas.getTrackRefAmount();
-            
-#if BE_VERBOSE
-            std::cout << "  -> collecting ticks from " << trackAmount << " tracks\n";
-#endif
-            
             for (int i=0; i<trackAmount; i++)
             {
                 MeasureTrackReference& track_ref = meas.getWritableTrackRef(i);
@@ -349,34 +364,55 @@ void PrintLayoutAbstract::calculateRelativeLengths(std::vector<LayoutElement>& l
             }
             
             ticks_relative_position.calculateRelativePlacement();
-            
-            /*
-            layoutElements[n].width_in_units = ticks_relative_position.getUnitCount();
-            if (layoutElements[n].width_in_units < MIN_UNIT_WIDTH)
-            {
-                layoutElements[n].width_in_units = MIN_UNIT_WIDTH;
-            }*/
-            
-            layoutElements[n].width_in_print_units = ticks_relative_position.getWidth();
-
-            if (layoutElements[n].width_in_print_units < LAYOUT_ELEMENT_MIN_WIDTH)
-            {
-                layoutElements[n].width_in_print_units = LAYOUT_ELEMENT_MIN_WIDTH;
-            }
-            
-#if BE_VERBOSE
-            std::cout << "  -> Layout element " << n << " is " << layoutElements[n].width_in_print_units
-                      << " unit(s) wide" << std::endl;
-#endif
         }
-        /*
-        else if (layoutElements[n].getType() == REPEATED_RIFF)
+    };
+}
+
+void PrintLayoutAbstract::calculateRelativeLengths(std::vector<LayoutElement>& layoutElements)
+{
+    std::cout << "\n====\ncalculateRelativeLengths\n====\n";
+
+    WaitWindow::setProgress( 35 );
+    
+    // determine which elements are measures that need their notes placed
+    std::vector<int> elements;
+    std::vector<int> measureIDs;
+    
+    const int layoutElementsAmount = layoutElements.size();
+    for (int n=0; n<layoutElementsAmount; n++)
+    {
+        if (layoutElements[n].getType() == SINGLE_MEASURE or layoutElements[n].getType() == EMPTY_MEASURE)
         {
-            layoutElements[n].width_in_print_units = LAYOUT_ELEMENT_MIN_WIDTH;
-        }*/
+            elements.push_back(n);
+            measureIDs.push_back(layoutElements[n].m_measure);
+        }
+    }
+    
+    // determine a list of all ticks on which a note starts, for each measure; then we can
+    // determine where within this measure should this note be drawn
+    MeasurePlacementTask task(m_sequence, m_measures, measureIDs);
+    Parallel::forEach(measureIDs.size(), &task);
+    
+    WaitWindow::setProgress( 60 );
+    
+    // calculate approximative width of each element
+    const int measureElementsAmount = elements.size();
+    for (int i=0; i<measureElementsAmount; i++)
+    {
+        LayoutElement& element = layoutElements[elements[i]];
+        
+        element.width_in_print_units = m_measures[element.m_measure].getTicksPlacementManager().getWidth();
 
-        //std::cout << "$$ setting charwidth for element " << n << " : " << layoutElements[n].width_in_units << std::endl;
-    } // end for elements
+        if (element.width_in_print_units < LAYOUT_ELEMENT_MIN_WIDTH)
+        {
+            element.width_in_print_units = LAYOUT_ELEMENT_MIN_WIDTH;
+        }
+        
+#if BE_VERBOSE
+        std::cout << "  -> Layout element " << elements[i] << " is " << element.width_in_print_units
+                  << " unit(s) wide" << std::endl;
+#endif
+    }
 }
 
 // -----------------------------------------------------------------------------------------------------
@@ -599,9 +635,17 @@ void PrintLayoutAbstract::addLayoutInformation(ptr_vector<GraphicalTrack, REF>&
 {    
     ASSERT( MAGIC_NUMBER_OK_FOR(tracks) );
 
+    wxStopWatch stopwatch;
+    
     generateMeasures(tracks);
+    printStageTime("generateMeasures", stopwatch);
     
     calculateLayoutElements(tracks, layoutPages);
+    
+#ifdef ARIA_PROFILER
+    std::cout << "[PrintLayoutAbstract] Total layout time : " << stopwatch.Time() << " ms ("
+              << Parallel::getWorkerCount() << " worker thread(s))" << std::endl;
+#endif
 }
 
 // -----------------------------------------------------------------------------------------------------
@@ -73,8 +73,13 @@ namespace AriaMaestosa
           */
         void createLayoutElements(std::vector<LayoutElement>& layoutElements);
         
-        /** fills fields containing info about similar measures withing the PrintLayoutMeasure objects */
-        //void findSimilarMeasures();
+        /**
+          * @brief fills fields containing info about similar measures within the PrintLayoutMeasure objects
+          *
+          * Measures are bucketed by fingerprint hash, so each measure is only compared with the
+          * earlier measures that have the same hash (linear expected time in the number of measures)
+          */
+        void findSimilarMeasures();
         
         /** utility method invoked by 'layInLinesAndPages' when a line is complete */
         void terminateLine(LayoutLine* line, ptr_vector<LayoutPage>& layoutPages, const int maxLevelHeight,
@@ -15,6 +15,7 @@
  */
 
 #include "AriaCore.h"
+#include "GUI/GraphicalSequence.h"
 #include "GUI/GraphicalTrack.h"
 #include "Midi/MeasureData.h"
 #include "Midi/Sequence.h"
@@ -22,6 +23,9 @@
 #include "PrintLayoutMeasure.h"
 
 #include "Printing/SymbolPrinter/PrintLayout/PrintLayoutAbstract.h"
+#include "UnitTest.h"
+
+#include <algorithm>
 
 namespace AriaMaestosa
 {
@@ -38,11 +42,13 @@ PrintLayoutMeasure::PrintLayoutMeasure(const int measID, Sequence* seq) :
     m_ticks_placement_manager(measID == -1 ? 0 : seq->getMeasureData()->lastTickInMeasure( measID ))
 {
     m_sequence = seq;
-    //firstSimilarMeasure  = -1;
-    //cutApart             = false;
     m_measure_id         = measID;
     m_contains_something = false;
     
+    m_fingerprint_hash       = 0;
+    m_fingerprint_note_count = 0;
+    m_first_similar_measure  = -1;
+    
     if (measID != -1)
     {
         m_first_tick = seq->getMeasureData()->firstTickInMeasure( measID );
@@ -51,109 +57,153 @@ PrintLayoutMeasure::PrintLayoutMeasure(const int measID, Sequence* seq) :
 }
 
 // -------------------------------------------------------------------------------------------
-#if 0
-bool PrintLayoutMeasure::calculateIfMeasureIsSameAs(PrintLayoutMeasure& checkMeasure)
+
+namespace AriaMaestosa
+{
+    /** (relative tick, length, pitch) description of a note, used to build measure fingerprints */
+    struct NoteFingerprint
+    {
+        int m_relative_tick;
+        int m_length;
+        int m_pitch;
+        
+        bool operator<(const NoteFingerprint& other) const
+        {
+            if (m_relative_tick != other.m_relative_tick) return m_relative_tick < other.m_relative_tick;
+            if (m_pitch         != other.m_pitch)         return m_pitch         < other.m_pitch;
+            return m_length < other.m_length;
+        }
+    };
+}
+
+void PrintLayoutMeasure::calculateFingerprint()
 {
+    m_fingerprint.clear();
+    m_fingerprint_note_count = 0;
     
-    const int trackRefAmount = m_track_refs.size();
-    int total_note_amount = 0;
+    std::vector<NoteFingerprint> notes;
     
+    const int trackRefAmount = m_track_refs.size();
     for (int tref=0; tref<trackRefAmount; tref++)
     {
-        const int my_first_note  = m_track_refs[tref].getFirstNote();
-        const int my_last_note   = m_track_refs[tref].getLastNote();
-        const int his_first_note = checkMeasure.m_track_refs[tref].getFirstNote();
-        const int his_last_note  = checkMeasure.m_track_refs[tref].getLastNote();
+        notes.clear();
         
-        ASSERT( m_track_refs.size() == checkMeasure.m_track_refs.size() );
-        ASSERT_E( tref,<,(int)m_track_refs.size() );
-        ASSERT( m_track_refs[tref].getTrack() == checkMeasure.m_track_refs[tref].getTrack() );
-        Track* track = m_track_refs[tref].getTrack();
+        const int firstNote = m_track_refs[tref].getFirstNote();
+        const int lastNote  = m_track_refs[tref].getLastNote();
         
-        // if these 2 measures don't even have the same number of notes, they're definitely not the same
-        if ( (his_last_note - his_first_note + 1) != (my_last_note - my_first_note + 1) )
+        if (firstNote != -1 and lastNote != -1)
         {
-            return false;
+            const Track* track = m_track_refs[tref].getConstTrack()->getTrack();
+            
+            for (int n=firstNote; n<=lastNote; n++)
+            {
+                const int start_tick = track->getNoteStartInMidiTicks(n);
+                const int end_tick   = track->getNoteEndInMidiTicks(n);
+                
+                if (end_tick - start_tick <= 0) continue; // malformed notes are skipped when printing too
+                if (start_tick < m_first_tick or start_tick >= m_last_tick) continue;
+                
+                NoteFingerprint f;
+                f.m_relative_tick = start_tick - m_first_tick;
+                f.m_length        = end_tick - start_tick;
+                f.m_pitch         = track->getNotePitchID(n);
+                notes.push_back(f);
+            }
+            
+            // notes that start at the same tick (e.g. chords) may be stored in any order
+            std::sort(notes.begin(), notes.end());
         }
         
-        
-        const int noteAmount = (his_last_note - his_first_note);
-        total_note_amount += noteAmount;
-        
-        // don't count empty measures as repetitions 
-        if (noteAmount<1)
+        // the note count also acts as a separator between tracks
+        const int count = notes.size();
+        m_fingerprint.push_back(count);
+        for (int n=0; n<count; n++)
         {
-            // when comparing a multiple-track line, don't stop on empty measures, for other tracks may not be empty
-            // for multi-track lines, variable 'total_note_amount' will be checked at the end to verify measure is not empty
-            if (trackRefAmount>1) continue;
-            return false;
+            m_fingerprint.push_back(notes[n].m_relative_tick);
+            m_fingerprint.push_back(notes[n].m_length);
+            m_fingerprint.push_back(notes[n].m_pitch);
         }
-        
-        /*
-         if we get till there, the 2 measures have the same amount of notes.
-         to know whether they are truly identitcal, we need to compare note by note
-         we will match each notes from the first measure to the identical one in the second.
-         If ever one note failes to be matched, then the 2 measures are different.
-         */
-        int noteMatched_this[noteAmount];
-        int noteMatched_other[noteAmount];
-        for (int n=0; n<noteAmount; n++)
+        m_fingerprint_note_count += count;
+    }
+    
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    const int size = m_fingerprint.size();
+    for (int n=0; n<size; n++)
+    {
+        const unsigned int value = (unsigned int)m_fingerprint[n];
+        for (int byte=0; byte<4; byte++)
         {
-            noteMatched_this[n] = false;
-            noteMatched_other[n] = false;
+            hash ^= (value >> (byte*8)) & 0xFF;
+            hash *= 16777619u;
         }
+    }
+    m_fingerprint_hash = hash;
+}
+
+// -------------------------------------------------------------------------------------------
+
+bool PrintLayoutMeasure::calculateIfMeasureIsSameAs(const PrintLayoutMeasure& checkMeasure) const
+{
+    ASSERT( m_track_refs.size() == checkMeasure.m_track_refs.size() );
+    
+    // don't count empty measures as repetitions
+    if (m_fingerprint_note_count == 0 or checkMeasure.m_fingerprint_note_count == 0) return false;
+    
+    if (m_fingerprint_hash != checkMeasure.m_fingerprint_hash) return false;
+    
+    // same hash; compare the full fingerprints to rule out collisions
+    return m_fingerprint == checkMeasure.m_fingerprint;
+}
+
+// -------------------------------------------------------------------------------------------
+
+int PrintLayoutMeasure::findSimilarMeasures(ptr_vector<PrintLayoutMeasure>& measures, const int measureAmount)
+{
+    ASSERT_E(measureAmount,<=,measures.size());
+    
+    // use a power of two bucket count, at least twice the amount of measures, to keep chains short
+    unsigned int bucketCount = 16;
+    while (bucketCount < (unsigned int)measureAmount*2) bucketCount *= 2;
+    const unsigned int bucketMask = bucketCount - 1;
+    
+    // each bucket contains the IDs of measures with a matching hash, in measure order; only the first
+    // measure of each group of identical measures is kept there, since later ones refer to it anyway
+    std::vector< std::vector<int> > buckets(bucketCount);
+    
+    int repetitions = 0;
+    
+    for (int measure=0; measure<measureAmount; measure++)
+    {
+        PrintLayoutMeasure& current = measures[measure];
+        current.calculateFingerprint();
+        
+        if (current.isEmpty()) continue;
+        
+        std::vector<int>& bucket = buckets[current.getFingerprintHash() & bucketMask];
         
-        for (int checkNote_this=0; checkNote_this<=noteAmount; checkNote_this++)
+        // check current measure against previous measures with the same hash to see if it is not a repetition
+        bool found = false;
+        const int candidateAmount = bucket.size();
+        for (int c=0; c<candidateAmount; c++)
         {
-            for (int checkNote_other=0; checkNote_other<=noteAmount; checkNote_other++)
-            {
-                if (noteMatched_other[checkNote_other]) continue; // this note was already matched
-                
-                // check start tick matches
-                if (track->getNoteStartInMidiTicks(his_first_note + checkNote_other) - checkMeasure.getFirstTick() !=
-                   track->getNoteStartInMidiTicks(my_first_note + checkNote_this) - getFirstTick())
-                {
-                    // they dont match, check the next one
-                    continue;
-                }
-                
-                // check end tick matches
-                if (track->getNoteEndInMidiTicks(his_first_note + checkNote_other) - checkMeasure.getFirstTick() !=
-                   track->getNoteEndInMidiTicks(my_first_note + checkNote_this) - getFirstTick())
-                {
-                    // they dont match, check the next one
-                    continue;
-                }
-                
-                // check pitch matches
-                if (track->getNotePitchID(his_first_note + checkNote_other) !=
-                   track->getNotePitchID(my_first_note + checkNote_this))
-                {
-                    // they dont match, check the next one
-                    continue;
-                }
-                
-                noteMatched_this[checkNote_this] = true;
-                noteMatched_other[checkNote_other] = true;
-                
-                
-            }//next note
+            const int checkMeasure = bucket[c];
+            ASSERT_E(checkMeasure,<,measure);
             
-            // we couldn't find a note in the other measure that matches this one
-            if (noteMatched_this[checkNote_this] == false)
-            {
-                // std::cout << "  not the same cause couldn't find a note in the other measure that matches this one\n";
-                return false;
-            }
+            if (not current.calculateIfMeasureIsSameAs(measures[checkMeasure])) continue;
             
-        }//next note
+            current.setFirstSimilarMeasure(checkMeasure);
+            measures[checkMeasure].addSimilarMeasureFoundLater(measure);
+            repetitions++;
+            found = true;
+            break;
+        }//next
         
-    } // next track reference
+        if (not found) bucket.push_back(measure);
+    }//next
     
-    if (total_note_amount == 0) return false; // don't count empty measures as repeitions
-    return true;
+    return repetitions;
 }
-#endif
 
 // -------------------------------------------------------------------------------------------
     
@@ -390,3 +440,62 @@ bool PrintLayoutMeasure::findConsecutiveRepetition(ptr_vector<PrintLayoutMeasure
 }
 #endif
     
+
+// -------------------------------------------------------------------------------------------
+// -------------------------------------------------------------------------------------------
+
+namespace TestPrintLayoutMeasure
+{
+    using namespace AriaMaestosa;
+    
+    UNIT_TEST(TestFindSimilarMeasures)
+    {
+        OwnerPtr<GraphicalSequence> gseq( new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false)) );
+        Sequence* seq = gseq->getModel();
+        const int beat = seq->ticksPerQuarterNote();
+        const int measureLength = seq->getMeasureData()->measureLengthInTicks(0);
+        
+        // each measure holds a note then a chord; measure 1 is the same as measure 0, measure 2 too but
+        // with its chord stored high to low, measure 3 has its first note one tick later and measure 4
+        // one semitone lower
+        const int MEASURE_AMOUNT = 5;
+        const int firstNoteDelay[MEASURE_AMOUNT] = { 0,  0,  0,  1,  0  };
+        const int firstNotePitch[MEASURE_AMOUNT] = { 60, 60, 60, 60, 61 };
+        
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int m=0; m<MEASURE_AMOUNT; m++)
+            {
+                const int tick = m*measureLength;
+                t->addNote_import(firstNotePitch[m], tick + firstNoteDelay[m], tick + beat, 80, -1);
+                
+                const bool reversed = (m == 2);
+                t->addNote_import(reversed ? 65 : 72, tick + beat, tick + beat*2, 80, -1);
+                t->addNote_import(68,                 tick + beat, tick + beat*2, 80, -1);
+                t->addNote_import(reversed ? 72 : 65, tick + beat, tick + beat*2, 80, -1);
+            }
+        }
+        seq->addTrack(t);
+        require_e(t->getNotePitchID(1), !=, t->getNotePitchID(9), "the chords of measures 0 and 2 are stored in different orders");
+        
+        GraphicalTrack* gtrack = gseq->getGraphicsFor(t);
+        
+        ptr_vector<PrintLayoutMeasure> measures;
+        for (int m=0; m<MEASURE_AMOUNT; m++) measures.push_back( new PrintLayoutMeasure(m, seq) );
+        
+        int note = 0;
+        for (int m=0; m<MEASURE_AMOUNT; m++) note = measures[m].addTrackReference(note, gtrack);
+        
+        const int repetitions = PrintLayoutMeasure::findSimilarMeasures(measures, MEASURE_AMOUNT);
+        
+        require_e(measures[1].getFirstSimilarMeasure(), ==, 0,  "identical measures match");
+        require_e(measures[2].getFirstSimilarMeasure(), ==, 0,  "chords stored in a different order match");
+        require_e(measures[3].getFirstSimilarMeasure(), ==, -1, "a note one tick later does not match");
+        require_e(measures[4].getFirstSimilarMeasure(), ==, -1, "a note one semitone lower does not match");
+        require(not measures[3].calculateIfMeasureIsSameAs(measures[4]), "measures that differ from the first one differently don't match");
+        
+        require_e(repetitions, ==, 2, "only the identical measures are counted as repetitions");
+        require_e((int)measures[0].getSimilarMeasuresFoundLater().size(), ==, 2, "the first measure knows of its repetitions");
+    }
+}
@@ -22,6 +22,8 @@
 #include "Printing/SymbolPrinter/PrintLayout/RelativePlacementManager.h"
 #include "ptr_vector.h"
 
+#include <vector>
+
 namespace AriaMaestosa
 {
     class PrintLayoutMeasure;
@@ -82,6 +84,25 @@ namespace AriaMaestosa
         
         Sequence* m_sequence;
         
+        /**
+          * Canonical description of the contents of this measure, across all track references :
+          * for each track, the amount of notes followed by a sorted (relative tick, length, pitch)
+          * triplet for each note. Two measures with the same fingerprint print the same way.
+          */
+        std::vector<int> m_fingerprint;
+        
+        /** Hash of 'm_fingerprint', used to bucket measures when looking for repetitions */
+        unsigned int m_fingerprint_hash;
+        
+        /** Amount of notes that start in this measure, over all track references */
+        int m_fingerprint_note_count;
+        
+        /** ID of the first earlier measure that has the same contents as this one, or -1 if none */
+        int m_first_similar_measure;
+        
+        /** IDs of the later measures that were found to be repetitions of this one */
+        std::vector<int> m_similar_measures_found_later;
+        
     public:
         
         PrintLayoutMeasure(const int measID, Sequence* seq);
@@ -95,6 +116,44 @@ namespace AriaMaestosa
           */
         int  addTrackReference(const int firstNote, GraphicalTrack* track);
         
+        /**
+          * @brief Computes the fingerprint of this measure from its track references.
+          * @pre   All track references must have been added
+          */
+        void calculateFingerprint();
+        
+        /** @return the hash of the fingerprint (@see calculateFingerprint) */
+        unsigned int getFingerprintHash() const { return m_fingerprint_hash; }
+        
+        /**
+          * @return whether this measure contains the same notes (relative to the start of the measure)
+          *         as the given measure. Empty measures are never considered to be the same.
+          * @pre    'calculateFingerprint' must have been called on both measures
+          */
+        bool calculateIfMeasureIsSameAs(const PrintLayoutMeasure& checkMeasure) const;
+        
+        /** @return the ID of the first earlier measure that is identical to this one, or -1 if none */
+        int  getFirstSimilarMeasure() const { return m_first_similar_measure; }
+        
+        /** @return the IDs of all later measures that are identical to this one */
+        const std::vector<int>& getSimilarMeasuresFoundLater() const { return m_similar_measures_found_later; }
+        
+        /** @brief record that measure 'laterMeasure' is a repetition of this one */
+        void addSimilarMeasureFoundLater(const int laterMeasure)
+        {
+            m_similar_measures_found_later.push_back(laterMeasure);
+        }
+        
+        void setFirstSimilarMeasure(const int measure) { m_first_similar_measure = measure; }
+        
+        /**
+          * @brief Links each of the first 'measureAmount' measures that repeats an earlier one to the first
+          *        measure it repeats (see getFirstSimilarMeasure and getSimilarMeasuresFoundLater)
+          * @pre   All track references must have been added
+          * @return the amount of measures that repeat an earlier one
+          */
+        static int findSimilarMeasures(ptr_vector<PrintLayoutMeasure>& measures, const int measureAmount);
+        
         int  getFirstTick     () const { return m_first_tick;             }
         int  getLastTick      () const { return m_last_tick;              }
 
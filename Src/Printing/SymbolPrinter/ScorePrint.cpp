@@ -103,7 +103,7 @@ namespace AriaMaestosa
     class ScoreData : public LineTrackRef::EditorData
     {
     public:            
-        LEAK_CHECK();
+        LEAK_CHECK(ScoreData);
         
         virtual ~ScoreData() {}
         
@@ -138,7 +138,7 @@ namespace AriaMaestosa
         int m_track_id;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(PrintXConverter);
         
         PrintXConverter(ScorePrintable* parent, LayoutLine* line, const int trackID)
         {
@@ -438,14 +438,10 @@ namespace AriaMaestosa
                   << measureFromTick << ", to " << measureToTick << "\n{\n";
 #endif
         
-        GraphicalTrack* gtrack = trackRef.getTrack();
-        ScoreEditor* scoreEditor = gtrack->getScoreEditor();
-        
-        ASSERT(gtrack->getTrack() == m_track);
+        ASSERT(trackRef.getTrack()->getTrack() == m_track);
         
-        ScoreMidiConverter* converter = scoreEditor->getScoreMidiConverter();
-        converter->updateConversionData();
-        converter->resetAccidentalsForNewRender();
+        // Note : measures are processed concurrently, so this method may only read the analysers
+        // built in 'earlySetup' (the score converter was already prepared there)
         
         // ---- notes
         for (int clef=0; clef<2; clef++)
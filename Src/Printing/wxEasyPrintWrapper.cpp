@@ -9,6 +9,8 @@
 #include <wx/graphics.h>
 #include <wx/dcprint.h>
 #include <wx/dcmemory.h>
+#include <wx/filename.h>
+#include <wx/image.h>
 
 #ifdef __WXMAC__
 
@@ -26,6 +28,22 @@ using namespace AriaMaestosa;
 #include <wx/dcgraph.h>
 #endif
 
+#if defined(USE_CAIRO) && wxCHECK_VERSION(2,9,1) && wxUSE_GRAPHICS_CONTEXT
+#define EXPORT_VECTOR_FILES 1
+#include <cairo.h>
+#include <cairo-pdf.h>
+#include <cairo-svg.h>
+#endif
+
+namespace AriaMaestosa
+{
+    /** number of typographic points in one millimeter, the unit of PDF and SVG surfaces */
+    const double POINTS_PER_MM = 72.0 / 25.4;
+    
+    /** resolution used when exporting pages as bitmaps */
+    const double EXPORT_BITMAP_DPI = 150.0;
+}
+
 
 #if 0
 #pragma mark -
@@ -342,8 +360,10 @@ bool wxEasyPrintWrapper::OnPrintPage(int pageNum)
     {
         gc = wxGraphicsContext::Create( dynamic_cast<wxMemoryDC&>(dc) );
     }
-    wxGCDC* gcdc = new wxGCDC(gc);
-    m_print_callback->printPage(pageNum, *gcdc, gc, x0, y0, x1, y1);
+    
+    // the wxGCDC takes ownership of the graphics context
+    wxGCDC gcdc(gc);
+    m_print_callback->printPage(pageNum, gcdc, gc, x0, y0, x1, y1);
 #else
     m_print_callback->printPage(pageNum, dc, NULL, x0, y0, x1, y1);
 #endif
@@ -359,5 +379,156 @@ void wxEasyPrintWrapper::OnEndPrinting()
 }
 
 // -----------------------------------------------------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------
+#if 0
+#pragma mark -
+#pragma mark wxEasyPrintWrapper : file export
+#endif
+
+// -----------------------------------------------------------------------------------------------------
+
+int wxEasyPrintWrapper::exportToFile(const wxString& filePath)
+{
+    ASSERT(m_unit_width  > 0);
+    ASSERT(m_unit_height > 0);
+    ASSERT(m_page_amount > 0);
+    
+    wxFileName fileName(filePath);
+    const wxString format = fileName.GetExt().Lower();
+    
+    // ---- paper size and margins, in millimeters, with orientation taken into account
+    const wxSize paperSize = m_page_setup.GetPaperSize();
+    const int large_side = std::max(paperSize.GetWidth(), paperSize.GetHeight());
+    const int small_side = std::min(paperSize.GetWidth(), paperSize.GetHeight());
+    
+    const int paper_width  = (m_orient == wxPORTRAIT ? small_side : large_side);
+    const int paper_height = (m_orient == wxPORTRAIT ? large_side : small_side);
+    
+    // 'updateCoordinateSystem' keeps the same aspect ratio on both axes, so one scale factor
+    // is enough to map print units onto the area between margins
+    const double mm_per_unit = double(paper_width - m_left_margin - m_right_margin) / m_unit_width;
+    
+    const int x0 = 0;
+    const int y0 = 0;
+    const int x1 = x0 + (int)m_unit_width;
+    const int y1 = y0 + (int)m_unit_height;
+    
+    int pagesWritten = 0;
+    
+#ifdef EXPORT_VECTOR_FILES
+    // a PDF surface holds all pages, so it lives across iterations
+    cairo_surface_t* pdfSurface = NULL;
+#endif
+    
+    for (int pageNum = 1; pageNum <= m_page_amount; pageNum++)
+    {
+        // multi-page formats go to a single file, others get one file per page
+        wxFileName pageFile = fileName;
+        if (format != wxT("pdf") and m_page_amount > 1)
+        {
+            pageFile.SetName( fileName.GetName() + wxString::Format(wxT("-%i"), pageNum) );
+        }
+        
+#ifdef EXPORT_VECTOR_FILES
+        if (format == wxT("pdf") or format == wxT("svg"))
+        {
+            cairo_surface_t* surface = NULL;
+            
+            const double width_pt  = paper_width*POINTS_PER_MM;
+            const double height_pt = paper_height*POINTS_PER_MM;
+            
+            if (format == wxT("pdf"))
+            {
+                if (pageNum == 1)
+                {
+                    pdfSurface = cairo_pdf_surface_create(pageFile.GetFullPath().utf8_str(), width_pt, height_pt);
+                }
+                surface = pdfSurface;
+            }
+            else
+            {
+                surface = cairo_svg_surface_create(pageFile.GetFullPath().utf8_str(), width_pt, height_pt);
+            }
+            
+            if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+            {
+                std::cerr << "[wxEasyPrintWrapper] ERROR: cannot create " << pageFile.GetFullPath().mb_str()
+                          << " : " << cairo_status_to_string(cairo_surface_status(surface)) << std::endl;
+                cairo_surface_destroy(surface);
+                return -1;
+            }
+            
+            cairo_t* cr = cairo_create(surface);
+            cairo_translate(cr, m_left_margin*POINTS_PER_MM, m_top_margin*POINTS_PER_MM);
+            cairo_scale(cr, mm_per_unit*POINTS_PER_MM, mm_per_unit*POINTS_PER_MM);
+            
+            {
+                // the wxGCDC takes ownership of the graphics context, which in turn releases 'cr'
+                wxGraphicsContext* gc = wxGraphicsRenderer::GetCairoRenderer()->CreateContextFromNativeContext(cr);
+                wxGCDC gcdc(gc);
+                m_print_callback->printPage(pageNum, gcdc, gc, x0, y0, x1, y1);
+            }
+            
+            cairo_surface_show_page(surface);
+            
+            if (format == wxT("svg") or pageNum == m_page_amount)
+            {
+                cairo_surface_finish(surface);
+                cairo_surface_destroy(surface);
+                pdfSurface = NULL;
+            }
+            
+            pagesWritten++;
+            continue;
+        }
+#endif
+        
+        if (format != wxT("png"))
+        {
+            std::cerr << "[wxEasyPrintWrapper] ERROR: unsupported export format '" << format.mb_str() << "'" << std::endl;
+            return -1;
+        }
+        
+        // ---- bitmap export, available with every build
+        const double pixels_per_mm = EXPORT_BITMAP_DPI / 25.4;
+        const double scale = mm_per_unit*pixels_per_mm;
+        
+        wxBitmap bitmap((int)(paper_width*pixels_per_mm), (int)(paper_height*pixels_per_mm));
+        wxMemoryDC memDC(bitmap);
+        memDC.SetBackground(*wxWHITE_BRUSH);
+        memDC.Clear();
+        
+#if wxCHECK_VERSION(2,9,1) && wxUSE_GRAPHICS_CONTEXT
+        {
+            wxGraphicsContext* gc = wxGraphicsContext::Create(memDC);
+            gc->Translate(m_left_margin*pixels_per_mm, m_top_margin*pixels_per_mm);
+            gc->Scale(scale, scale);
+            
+            // the wxGCDC takes ownership of the graphics context
+            wxGCDC gcdc(gc);
+            m_print_callback->printPage(pageNum, gcdc, gc, x0, y0, x1, y1);
+        }
+#else
+        memDC.SetDeviceOrigin(m_left_margin*pixels_per_mm, m_top_margin*pixels_per_mm);
+        memDC.SetUserScale(scale, scale);
+        m_print_callback->printPage(pageNum, memDC, NULL, x0, y0, x1, y1);
+#endif
+        
+        memDC.SelectObject(wxNullBitmap);
+        
+        if (wxImage::FindHandler(wxBITMAP_TYPE_PNG) == NULL) wxImage::AddHandler(new wxPNGHandler());
+        
+        if (not bitmap.SaveFile(pageFile.GetFullPath(), wxBITMAP_TYPE_PNG))
+        {
+            std::cerr << "[wxEasyPrintWrapper] ERROR: cannot write " << pageFile.GetFullPath().mb_str() << std::endl;
+            return -1;
+        }
+        pagesWritten++;
+    }
+    
+    return pagesWritten;
+}
 
+// -----------------------------------------------------------------------------------------------------
 
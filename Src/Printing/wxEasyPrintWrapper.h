@@ -102,7 +102,7 @@ namespace AriaMaestosa
         
     public:
         
-        LEAK_CHECK();
+        LEAK_CHECK(wxEasyPrintWrapper);
         
 
         /** 
@@ -163,6 +163,18 @@ namespace AriaMaestosa
           */
         void setPageCount(const int pageCount);
         
+        /**
+          * Render all pages straight to a file, without showing any dialog or window.
+          * The format is picked from the extension of 'filePath' : ".pdf" produces a single
+          * multi-page file, ".svg" and ".png" produce one file per page (the page number is
+          * appended to the file name when there is more than one page).
+          * PDF and SVG output are vector and require a build with cairo (USE_CAIRO).
+          *
+          * @pre   'setPageCount' must have been called
+          * @return the number of pages written, or -1 if an error occurred
+          */
+        int exportToFile(const wxString& filePath);
+        
         // ---- callbacks from wxPrintout
         virtual void OnBeginPrinting();
         virtual bool OnBeginDocument(int startPage, int endPage);
@@ -0,0 +1,337 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Profiler.h"
+
+#include "Midi/Players/PlaybackState.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <wx/thread.h>
+
+using namespace AriaMaestosa;
+
+namespace AriaMaestosa
+{
+    namespace Profiler
+    {
+        struct Event
+        {
+            Zone*     m_zone;
+            long long m_start_us;
+            long long m_duration_us;
+        };
+
+        /**
+          * The events of one thread. Only that thread writes; 'writeTrace' may read at any time, so the
+          * buffer works like PlaybackState : 'm_claimed' is raised before a slot is overwritten and
+          * 'm_written' once it was, and a reader discards the slots that were claimed while it copied them.
+          */
+        struct ThreadBuffer
+        {
+            Event        m_events[EVENTS_PER_THREAD];
+            unsigned int m_claimed;
+            unsigned int m_written;
+
+            int          m_id;
+            const char*  m_name;
+
+            ThreadBuffer* m_next;
+        };
+
+        /** all zones ever entered, and all threads that ever entered one (never deleted) */
+        Zone*         g_zones      = NULL;
+        ThreadBuffer* g_threads    = NULL;
+        int           g_thread_ids = 0;
+
+        __thread ThreadBuffer* t_buffer = NULL;
+
+        ThreadBuffer* getThreadBuffer()
+        {
+            if (t_buffer != NULL) return t_buffer;
+
+            ThreadBuffer* buffer = new ThreadBuffer();
+            buffer->m_claimed = 0;
+            buffer->m_written = 0;
+            buffer->m_id      = __atomic_add_fetch(&g_thread_ids, 1, __ATOMIC_RELAXED);
+            buffer->m_name    = NULL;
+
+            buffer->m_next = __atomic_load_n(&g_threads, __ATOMIC_RELAXED);
+            while (not __atomic_compare_exchange_n(&g_threads, &buffer->m_next, buffer, true,
+                                                   __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            {
+            }
+
+            t_buffer = buffer;
+            return buffer;
+        }
+
+        void record(Zone* zone, const long long startUs, const long long durationUs)
+        {
+            ThreadBuffer* buffer = getThreadBuffer();
+            const unsigned int index = buffer->m_written;
+            Event& slot = buffer->m_events[index % EVENTS_PER_THREAD];
+
+            __atomic_store_n(&buffer->m_claimed, index + 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+
+            __atomic_store_n(&slot.m_zone,        zone,       __ATOMIC_RELAXED);
+            __atomic_store_n(&slot.m_start_us,    startUs,    __ATOMIC_RELAXED);
+            __atomic_store_n(&slot.m_duration_us, durationUs, __ATOMIC_RELAXED);
+
+            __atomic_store_n(&buffer->m_written, index + 1, __ATOMIC_RELEASE);
+        }
+
+        /** @brief copies the events of a thread that were not overwritten while they were copied */
+        void copyEvents(ThreadBuffer* buffer, std::vector<Event>& out)
+        {
+            const unsigned int end   = __atomic_load_n(&buffer->m_written, __ATOMIC_ACQUIRE);
+            const unsigned int begin = (end > (unsigned int)EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0);
+
+            std::vector<Event> copy(end - begin);
+            for (unsigned int n=begin; n<end; n++)
+            {
+                const Event& slot = buffer->m_events[n % EVENTS_PER_THREAD];
+                copy[n - begin].m_zone        = __atomic_load_n(&slot.m_zone,        __ATOMIC_RELAXED);
+                copy[n - begin].m_start_us    = __atomic_load_n(&slot.m_start_us,    __ATOMIC_RELAXED);
+                copy[n - begin].m_duration_us = __atomic_load_n(&slot.m_duration_us, __ATOMIC_RELAXED);
+            }
+
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            const unsigned int claimed = __atomic_load_n(&buffer->m_claimed, __ATOMIC_RELAXED);
+            const unsigned int valid   = (claimed > (unsigned int)EVENTS_PER_THREAD ? claimed - EVENTS_PER_THREAD : 0);
+
+            for (unsigned int n=std::max(begin, valid); n<end; n++)
+            {
+                out.push_back(copy[n - begin]);
+            }
+        }
+
+        void writeString(std::ostream& out, const char* string)
+        {
+            out << '"';
+            for (const char* c = string; *c != '\0'; c++)
+            {
+                if (*c == '"' or *c == '\\') out << '\\';
+                out << *c;
+            }
+            out << '"';
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+Profiler::Zone::Zone(const char* name)
+{
+    m_name     = name;
+    m_count    = 0;
+    m_total_us = 0;
+    m_max_us   = 0;
+
+    m_next = __atomic_load_n(&g_zones, __ATOMIC_RELAXED);
+    while (not __atomic_compare_exchange_n(&g_zones, &m_next, this, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Profiler::Zone::add(const long long durationUs)
+{
+    __atomic_add_fetch(&m_count,    1,          __ATOMIC_RELAXED);
+    __atomic_add_fetch(&m_total_us, durationUs, __ATOMIC_RELAXED);
+
+    long long max = __atomic_load_n(&m_max_us, __ATOMIC_RELAXED);
+    while (durationUs > max and
+           not __atomic_compare_exchange_n(&m_max_us, &max, durationUs, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+Profiler::ScopedZone::ScopedZone(Zone* zone)
+{
+    m_zone     = zone;
+    m_start_us = PlaybackState::getTimeUs();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+Profiler::ScopedZone::~ScopedZone()
+{
+    const long long durationUs = PlaybackState::getTimeUs() - m_start_us;
+    m_zone->add(durationUs);
+    record(m_zone, m_start_us, durationUs);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Profiler::getZones(std::vector<ZoneStats>& out)
+{
+    out.clear();
+    for (Zone* zone = __atomic_load_n(&g_zones, __ATOMIC_ACQUIRE); zone != NULL; zone = zone->m_next)
+    {
+        ZoneStats stats;
+        stats.m_name     = zone->m_name;
+        stats.m_count    = __atomic_load_n(&zone->m_count,    __ATOMIC_RELAXED);
+        stats.m_total_us = __atomic_load_n(&zone->m_total_us, __ATOMIC_RELAXED);
+        stats.m_max_us   = __atomic_load_n(&zone->m_max_us,   __ATOMIC_RELAXED);
+        if (stats.m_count > 0) out.push_back(stats);
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void Profiler::setThreadName(const char* name)
+{
+    __atomic_store_n(&getThreadBuffer()->m_name, name, __ATOMIC_RELEASE);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int Profiler::writeTrace(std::ostream& out)
+{
+    int written = 0;
+    std::vector<Event> events;
+
+    out << "{\"traceEvents\":[\n";
+    for (ThreadBuffer* buffer = __atomic_load_n(&g_threads, __ATOMIC_ACQUIRE); buffer != NULL;
+         buffer = buffer->m_next)
+    {
+        const char* name = __atomic_load_n(&buffer->m_name, __ATOMIC_ACQUIRE);
+        if (name != NULL)
+        {
+            out << (written > 0 ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->m_id << ",\"args\":{\"name\":";
+            writeString(out, name);
+            out << "}}";
+        }
+
+        events.clear();
+        copyEvents(buffer, events);
+        for (unsigned int n=0; n<events.size(); n++)
+        {
+            out << (written > 0 or name != NULL ? ",\n" : "") << "{\"name\":";
+            writeString(out, events[n].m_zone->m_name);
+            out << ",\"cat\":\"aria\",\"ph\":\"X\",\"ts\":" << events[n].m_start_us
+                << ",\"dur\":" << events[n].m_duration_us << ",\"pid\":1,\"tid\":" << buffer->m_id << "}";
+            written++;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return written;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool Profiler::writeTrace(const char* path)
+{
+    std::ofstream file(path);
+    if (not file.is_open()) return false;
+
+    const int written = writeTrace(file);
+    std::cout << "[Profiler] " << written << " events written to " << path << std::endl;
+    return file.good();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+#if _MORE_DEBUG_CHECKS // so that utility classes are not compiled in when unit tests are disabled
+namespace TestProfiler
+{
+    using namespace AriaMaestosa;
+
+    Profiler::Zone g_outer_zone("TestProfiler outer");
+    Profiler::Zone g_inner_zone("TestProfiler \"inner\"");
+
+    /** Enters the test zones from a thread of its own */
+    class ZoneThread : public wxThread
+    {
+        int m_amount;
+
+    public:
+
+        ZoneThread(const int amount) : wxThread(wxTHREAD_JOINABLE)
+        {
+            m_amount = amount;
+        }
+
+        virtual ExitCode Entry()
+        {
+            Profiler::setThreadName("TestProfiler worker");
+            for (int n=0; n<m_amount; n++)
+            {
+                Profiler::ScopedZone outer(&g_outer_zone);
+                Profiler::ScopedZone inner(&g_inner_zone);
+            }
+            return 0;
+        }
+    };
+
+    UNIT_TEST(TestZonesFromSeveralThreads)
+    {
+        const int PER_THREAD = Profiler::EVENTS_PER_THREAD;
+
+        ZoneThread first(PER_THREAD), second(PER_THREAD);
+        require(first.Create()  == wxTHREAD_NO_ERROR and first.Run()  == wxTHREAD_NO_ERROR, "thread started");
+        require(second.Create() == wxTHREAD_NO_ERROR and second.Run() == wxTHREAD_NO_ERROR, "thread started");
+
+        // read traces while the threads record, the way a user dumping a trace during playback would
+        std::ostringstream during;
+        Profiler::writeTrace(during);
+
+        const long long startUs = PlaybackState::getTimeUs();
+        for (int n=0; n<PER_THREAD; n++)
+        {
+            Profiler::ScopedZone outer(&g_outer_zone);
+        }
+        const long long elapsedUs = PlaybackState::getTimeUs() - startUs;
+
+        first.Wait();
+        second.Wait();
+
+        std::vector<Profiler::ZoneStats> zones;
+        Profiler::getZones(zones);
+        int outer = -1, inner = -1;
+        for (unsigned int n=0; n<zones.size(); n++)
+        {
+            if (zones[n].m_name == g_outer_zone.m_name) outer = zones[n].m_count;
+            if (zones[n].m_name == g_inner_zone.m_name) inner = zones[n].m_count;
+        }
+        require_e(outer, ==, PER_THREAD*3, "every call of the outer zone is counted");
+        require_e(inner, ==, PER_THREAD*2, "every call of the inner zone is counted");
+
+        std::ostringstream trace;
+        const int written = Profiler::writeTrace(trace);
+        const std::string json = trace.str();
+        require_e(written, >=, PER_THREAD*3, "each thread keeps its most recent events");
+        require(json.find("{\"traceEvents\":[") == 0, "the trace is a Trace Event JSON object");
+        require(json.find("\"TestProfiler \\\"inner\\\"\"") != std::string::npos, "zone names are escaped");
+        require(json.find("\"args\":{\"name\":\"TestProfiler worker\"}") != std::string::npos,
+                "named threads are named in the trace");
+
+        std::cout << "[Profiler] " << written << " events in the trace, "
+                  << elapsedUs*1000.0/PER_THREAD << " ns per zone" << std::endl;
+    }
+}
+#endif
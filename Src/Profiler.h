@@ -0,0 +1,117 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <ostream>
+#include <vector>
+
+namespace AriaMaestosa
+{
+
+    /**
+      * @brief measures where time goes, zone by zone
+      *
+      * A zone is a scope marked with PROFILE_ZONE; each time it is left, its duration is added to the
+      * statistics of the zone, and recorded as an event in a buffer that belongs to the calling thread
+      * (so that recording never takes a lock nor waits on another thread). When a buffer is full, its
+      * oldest events are overwritten; the statistics keep counting.
+      *
+      * Zones are only compiled in when building with ARIA_PROFILER defined ('scons profiler=1');
+      * otherwise PROFILE_ZONE expands to nothing.
+      */
+    namespace Profiler
+    {
+        /** number of events each thread keeps for 'writeTrace' */
+        const int EVENTS_PER_THREAD = 65536;
+
+        /** @brief a profiled scope (one per PROFILE_ZONE), with the statistics of all the times it was left */
+        class Zone
+        {
+        public:
+            const char* m_name;
+
+            int       m_count;
+            long long m_total_us;
+            long long m_max_us;
+
+            /** next zone in the list of all zones, see 'getZones' */
+            Zone* m_next;
+
+            Zone(const char* name);
+
+            /** @brief adds one call, may be called from any thread */
+            void add(const long long durationUs);
+        };
+
+        /** @brief measures the time spent between its construction and its destruction in the given zone */
+        class ScopedZone
+        {
+            Zone*     m_zone;
+            long long m_start_us;
+
+        public:
+
+            ScopedZone(Zone* zone);
+            ~ScopedZone();
+        };
+
+        /** @brief the statistics of a zone at one point in time */
+        struct ZoneStats
+        {
+            const char* m_name;
+            int         m_count;
+            long long   m_total_us;
+            long long   m_max_us;
+        };
+
+        /** @brief the statistics of every zone entered at least once so far, in no particular order */
+        void getZones(std::vector<ZoneStats>& out);
+
+        /** @brief names the calling thread in traces (threads are otherwise numbered in the order they were seen) */
+        void setThreadName(const char* name);
+
+        /**
+          * @brief writes the events recorded so far in the Trace Event format, that chrome://tracing
+          *        and Perfetto can load
+          * @return the number of events written
+          */
+        int writeTrace(std::ostream& out);
+
+        /** @brief same as above, to a file; @return false if the file could not be written */
+        bool writeTrace(const char* path);
+    }
+
+}
+
+#ifdef ARIA_PROFILER
+
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+
+/** @brief profiles the rest of the enclosing scope under the given name (a string literal) */
+#define PROFILE_ZONE(name) \
+    static ::AriaMaestosa::Profiler::Zone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__)(name); \
+    ::AriaMaestosa::Profiler::ScopedZone PROFILE_ZONE_CONCAT(profile_scope_, __LINE__)(&PROFILE_ZONE_CONCAT(profile_zone_, __LINE__))
+
+#else
+
+#define PROFILE_ZONE(name)
+
+#endif
+
+#endif
@@ -38,7 +38,7 @@ namespace AriaMaestosa
         bool    m_delete_image;
         
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(AbstractDrawable);
 
         AbstractDrawable(Image* image=NULL);
         AbstractDrawable(wxString imagePath);
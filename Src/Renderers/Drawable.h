@@ -21,3 +21,7 @@
 #ifdef RENDERER_OPENGL
 #include "Renderers/GLDrawable.h"
 #endif
+
+#ifdef RENDERER_HEADLESS
+#include "Renderers/HeadlessDrawable.h"
+#endif
@@ -30,7 +30,7 @@ class Image
 {
     GLuint* ID;
 public:
-    LEAK_CHECK();
+    LEAK_CHECK(Image);
     
     int width, height;
     
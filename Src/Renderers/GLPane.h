@@ -39,7 +39,7 @@ namespace AriaMaestosa
     {
         wxGLContext* m_context;
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(GLPane);
 
         GLPane(wxWindow* parent, int* args);
         ~GLPane();
@@ -349,6 +349,116 @@ void endScissors()
     glDisable(GL_SCISSOR_TEST);
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+/*
+ * Layers are drawn straight into the frame, then copied from the back buffer into a texture (so
+ * no framebuffer object extension is needed). OpenGL 1.1 textures must have power-of-two sizes,
+ * so the layer only fills the bottom-left part of its texture, like GLImage does.
+ */
+struct LayerContents
+{
+    GLuint m_texture;
+    
+    /** the part of the texture covered by the layer */
+    float m_tex_coord_x, m_tex_coord_y;
+};
+
+static int nextPowerOfTwo(const int size)
+{
+    int out = 1;
+    while (out < size) out *= 2;
+    return out;
+}
+
+Layer::Layer()
+{
+    m_contents = NULL;
+    m_x        = 0;
+    m_y        = 0;
+    m_width    = 0;
+    m_height   = 0;
+}
+
+Layer::~Layer()
+{
+    invalidate();
+}
+
+void Layer::invalidate()
+{
+    if (m_contents != NULL)
+    {
+        glDeleteTextures(1, &m_contents->m_texture);
+        delete m_contents;
+        m_contents = NULL;
+    }
+}
+
+bool drawLayer(Layer& layer, const int x, const int y, const int width, const int height)
+{
+    if (layer.m_contents == NULL) return false;
+    if (layer.m_x != x or layer.m_y != y or layer.m_width != width or layer.m_height != height)
+    {
+        layer.invalidate();
+        return false;
+    }
+    
+    images();
+    glColor4f(1, 1, 1, 1);
+    glBindTexture(GL_TEXTURE_2D, layer.m_contents->m_texture);
+    
+    // the texture was read bottom-up from the back buffer
+    glBegin(GL_QUADS);
+    const float tx = layer.m_contents->m_tex_coord_x;
+    const float ty = layer.m_contents->m_tex_coord_y;
+    glTexCoord2f(0,  ty); glVertex2f(x*10.0,           y*10.0);
+    glTexCoord2f(tx, ty); glVertex2f((x + width)*10.0, y*10.0);
+    glTexCoord2f(tx, 0 ); glVertex2f((x + width)*10.0, (y + height)*10.0);
+    glTexCoord2f(0,  0 ); glVertex2f(x*10.0,           (y + height)*10.0);
+    glEnd();
+    
+    return true;
+}
+
+void beginLayer(Layer& layer, const int x, const int y, const int width, const int height)
+{
+    layer.invalidate();
+    layer.m_x      = x;
+    layer.m_y      = y;
+    layer.m_width  = width;
+    layer.m_height = height;
+}
+
+void endLayer(Layer& layer)
+{
+    ASSERT(layer.m_contents == NULL);
+    if (layer.m_width <= 0 or layer.m_height <= 0) return;
+    
+    layer.m_contents = new LayerContents();
+    glGenTextures(1, &layer.m_contents->m_texture);
+    glBindTexture(GL_TEXTURE_2D, layer.m_contents->m_texture);
+    
+    const int textureWidth  = nextPowerOfTwo(layer.m_width);
+    const int textureHeight = nextPowerOfTwo(layer.m_height);
+    layer.m_contents->m_tex_coord_x = (float)layer.m_width/(float)textureWidth;
+    layer.m_contents->m_tex_coord_y = (float)layer.m_height/(float)textureHeight;
+    
+    // allocate the texture without initializing it, then copy the frame into its bottom-left corner
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureWidth, textureHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    
+    // like glScissor, glCopyTexSubImage2D uses bottom-left based window coordinates
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                        layer.m_x, Display::getHeight() - layer.m_y - layer.m_height,
+                        layer.m_width, layer.m_height);
+    
+    // the texture is drawn pixel for pixel
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+}
+
 }
 
 DEFINE_SINGLETON( AriaRender::NumberRendererSingleton );
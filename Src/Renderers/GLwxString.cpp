@@ -399,6 +399,14 @@ void wxGLString::setMaxWidth(const int w, const bool warp /*false: truncate. tru
     }
 }
 
+void wxGLString::releaseTexture()
+{
+    if (m_image.raw_ptr == NULL or not m_image.owner) return;
+
+    m_image = NULL;
+    m_consolidated = false;
+}
+
 wxGLString::~wxGLString()
 {
 }
@@ -520,6 +528,7 @@ void wxGLNumberRenderer::renderNumber(const char* s, int x, int y)
 wxGLStringArray::wxGLStringArray()
 {
     img = NULL;
+    m_texture_bytes = 0;
     consolidated = false;
 }
 wxGLStringArray::wxGLStringArray(const wxString strings_arg[], int amount)
@@ -545,6 +554,7 @@ void wxGLStringArray::bind()
 void wxGLStringArray::addStrings(const wxString strings_arg[], int amount)
 {
     img = NULL;
+    m_texture_bytes = 0;
     consolidated = false;
 
     for (int n=0; n<amount; n++)
@@ -562,6 +572,19 @@ void wxGLStringArray::setFont(wxFont font)
     m_font = font;
 }
 
+void wxGLStringArray::releaseTexture()
+{
+    const int amount = strings.size();
+    for (int n=0; n<amount; n++)
+    {
+        strings[n].setImage(NULL, true);
+    }
+
+    img = NULL;
+    m_texture_bytes = 0;
+    consolidated = false;
+}
+
 void wxGLStringArray::consolidate(wxDC* dc)
 {
     int x=0, y=0;
@@ -630,6 +653,7 @@ void wxGLStringArray::consolidate(wxDC* dc)
     }
 
     img = new TextTexture(bmp);
+    m_texture_bytes = power_of_2_w*power_of_2_h*4;
 
     for (int n=0; n<amount; n++)
     {
@@ -41,7 +41,7 @@ namespace AriaMaestosa
         TextTexture(wxBitmap& bmp);
         void load(wxImage* img);
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(TextTexture);
 
         ~TextTexture();
     };
@@ -82,7 +82,7 @@ namespace AriaMaestosa
         void move(int x, int y);
     public:
 
-        LEAK_CHECK();
+        LEAK_CHECK(TextGLDrawable);
 
         virtual ~TextGLDrawable() {}
 
@@ -179,6 +179,15 @@ namespace AriaMaestosa
         void render(const int x, const int y);
 
         virtual void onModelChanged(wxString newval) { m_consolidated = false; }
+
+        /** @return the bytes of the texture owned by this string (none if it renders from an array) */
+        int getTextureBytes() const { return (m_image.raw_ptr != NULL and m_image.owner ? texw*texh*4 : 0); }
+
+        /**
+          * @brief frees the texture of this string; it is created again the next time the string is bound.
+          *        Strings of a wxGLStringArray share the texture of the array, see wxGLStringArray::releaseTexture.
+          */
+        void releaseTexture();
     };
 
     typedef wxGLString AriaRenderString;
@@ -255,6 +264,7 @@ namespace AriaMaestosa
     {
         ptr_vector<wxGLString, HOLD> strings;
         OwnerPtr<TextTexture> img;
+        int m_texture_bytes;
         wxFont m_font;
         bool consolidated;
     public:
@@ -289,7 +299,13 @@ namespace AriaMaestosa
          The wxDC argument is only used to calculate text extents and will not be rendered on.  */
         void consolidate(wxDC* dc);
 
-        LEAK_CHECK();
+        /** @return the bytes of the texture shared by the strings of this array */
+        int getTextureBytes() const { return m_texture_bytes; }
+
+        /** @brief frees the texture of this array; it is created again the next time the array is bound */
+        void releaseTexture();
+
+        LEAK_CHECK(wxGLStringArray);
     };
 
     typedef wxGLStringArray AriaRenderArray;
@@ -0,0 +1,46 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#include "Renderers/Drawable.h"
+#include "Renderers/HeadlessRenderer.h"
+#include "Renderers/ImageBase.h"
+
+using namespace AriaMaestosa;
+
+// -------------------------------------------------------------------------------------------------------
+
+void Drawable::render()
+{
+    // like the OpenGL backend, a scaled or rotated image counts as a single draw call
+    int w = (int)(m_image->width  * m_x_scale);
+    int h = (int)(m_image->height * m_y_scale);
+    if (m_angle == 90 or m_angle == 270)
+    {
+        const int tmp = w;
+        w = h;
+        h = tmp;
+    }
+
+    const int x = m_x - m_hotspot_x;
+    const int y = m_y - m_hotspot_y;
+    AriaRender::recordCommand(AriaRender::COMMAND_IMAGE, x, y, x + w, y + h);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+#endif
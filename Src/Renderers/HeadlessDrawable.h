@@ -0,0 +1,44 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#ifndef __HEADLESS_DRAWABLE_H__
+#define __HEADLESS_DRAWABLE_H__
+
+#include "Renderers/AbstractDrawable.h"
+
+namespace AriaMaestosa
+{
+
+    /**
+     * @brief   headless render backend : records one draw call per rendered image
+     * @ingroup renderers
+     */
+    class Drawable : public AbstractDrawable
+    {
+    public:
+
+        Drawable(Image* image=NULL) : AbstractDrawable(image) {}
+        Drawable(wxString imagePath) : AbstractDrawable(imagePath) {}
+
+        virtual void render();
+    };
+
+}
+
+#endif
+#endif
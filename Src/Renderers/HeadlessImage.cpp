@@ -0,0 +1,66 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#include "Renderers/ImageBase.h"
+#include "Utils.h"
+
+#include <iostream>
+#include <wx/image.h>
+
+using namespace AriaMaestosa;
+
+// -------------------------------------------------------------------------------------------------------
+
+Image::Image()
+{
+    width  = 0;
+    height = 0;
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+Image::Image(wxString path)
+{
+    load(path);
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+Image::~Image()
+{
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+void Image::load(wxString path)
+{
+    // wxImage does not need a display connection, unlike wxBitmap
+    wxImage image;
+    path = getResourcePrefix() + path;
+    if (not image.LoadFile(path))
+    {
+        fprintf(stderr, "Failed to load %s\n", (const char*)path.mb_str());
+        exit(1);
+    }
+    width  = image.GetWidth();
+    height = image.GetHeight();
+}
+
+// -------------------------------------------------------------------------------------------------------
+
+#endif
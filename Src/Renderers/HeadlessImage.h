@@ -0,0 +1,51 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#ifndef __HEADLESS_IMAGE_H__
+#define __HEADLESS_IMAGE_H__
+
+#include "Utils.h"
+#include <wx/string.h>
+
+namespace AriaMaestosa
+{
+
+    /**
+     * @brief   headless render backend : image
+     *
+     * Only the size of the image is kept; nothing is ever rasterized.
+     * @ingroup renderers
+     */
+    class Image
+    {
+    public:
+        LEAK_CHECK(Image);
+
+        int width, height;
+
+        Image();
+        Image(wxString path);
+        ~Image();
+
+        void load(wxString path);
+    };
+
+}
+
+#endif
+#endif
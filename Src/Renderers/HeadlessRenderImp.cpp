@@ -0,0 +1,496 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#include "Utils.h"
+#include "AriaCore.h"
+
+#include "Editors/ControllerEditor.h"
+#include "Editors/KeyboardEditor.h"
+#include "Editors/ScoreEditor.h"
+#include "GUI/GraphicalSequence.h"
+#include "GUI/GraphicalTrack.h"
+#include "GUI/ImageProvider.h"
+#include "GUI/MainPane.h"
+#include "GUI/MeasureBar.h"
+#include "MemoryUsage.h"
+#include "Midi/MeasureData.h"
+#include "Midi/Sequence.h"
+#include "Midi/Track.h"
+#include "PreferencesData.h"
+#include "Renderers/Drawable.h"
+#include "Renderers/HeadlessRenderer.h"
+#include "Renderers/RenderAPI.h"
+#include "UnitTest.h"
+
+#include <algorithm>
+#include <iostream>
+#include <wx/image.h>
+#include <wx/stopwatch.h>
+
+namespace AriaMaestosa
+{
+namespace AriaRender
+{
+
+/*
+ * The headless backend draws nothing : each call is recorded in a command list with its bounding box
+ * and color, which is enough to count draw calls and check what lands where.
+ */
+
+std::vector<Command> commands;
+int draw_calls_by_type[COMMAND_TYPE_COUNT] = { 0 };
+
+unsigned char rc = 255;
+unsigned char gc = 255;
+unsigned char bc = 255;
+unsigned char ac = 255;
+int lineWidth_i = 1;
+int pointSize_i = 1;
+
+bool scissors_enabled = false;
+int scissor_x1 = 0, scissor_y1 = 0, scissor_x2 = 0, scissor_y2 = 0;
+
+int viewport_width  = 1024;
+int viewport_height = 768;
+
+const std::vector<Command>& getCommands()
+{
+    return commands;
+}
+
+void clearCommands()
+{
+    commands.clear();
+    for (int n=0; n<COMMAND_TYPE_COUNT; n++) draw_calls_by_type[n] = 0;
+}
+
+int getDrawCallCount()
+{
+    return commands.size();
+}
+
+int getDrawCallCount(const CommandType type)
+{
+    return draw_calls_by_type[type];
+}
+
+void setViewportSize(const int width, const int height)
+{
+    viewport_width  = width;
+    viewport_height = height;
+}
+
+int getViewportWidth()
+{
+    return viewport_width;
+}
+
+int getViewportHeight()
+{
+    return viewport_height;
+}
+
+void recordCommand(const CommandType type, const int x1, const int y1, const int x2, const int y2)
+{
+    Command command;
+    command.m_type = type;
+    command.m_x1   = std::min(x1, x2);
+    command.m_y1   = std::min(y1, y2);
+    command.m_x2   = std::max(x1, x2);
+    command.m_y2   = std::max(y1, y2);
+    command.m_r    = rc;
+    command.m_g    = gc;
+    command.m_b    = bc;
+    command.m_a    = ac;
+    command.m_clipped = scissors_enabled and (command.m_x2 < scissor_x1 or command.m_x1 > scissor_x2 or
+                                              command.m_y2 < scissor_y1 or command.m_y1 > scissor_y2);
+    commands.push_back(command);
+    draw_calls_by_type[type]++;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void primitives()
+{
+}
+
+void images()
+{
+    setImageState(STATE_NORMAL);
+}
+
+void setImageState(const ImageState imgst)
+{
+}
+
+void renderNumber(const int number, const int x, const int y)
+{
+    renderNumber( to_wxString(number).mb_str(), x, y );
+}
+
+void renderNumber(const float number, const int x, const int y)
+{
+    renderNumber( to_wxString(number).mb_str(), x, y );
+}
+
+void renderNumber(const char* number, const int x, const int y)
+{
+    int w, h;
+    HeadlessString::getTextExtents(wxString(number, wxConvUTF8), getNumberFont(), &w, &h);
+    recordCommand(COMMAND_TEXT, x, y - h, x + w, y);
+}
+
+void renderString(const wxString& string, const int x, const int y, const int maxWidth)
+{
+    Model<wxString> model(string);
+    HeadlessString headlessString(&model, false);
+    headlessString.setFont(getNoteNamesFont());
+    headlessString.setMaxWidth(maxWidth, false);
+    headlessString.bind();
+    headlessString.render(x, y);
+}
+
+void color(const float r, const float g, const float b)
+{
+    rc = (unsigned char)(r*255);
+    gc = (unsigned char)(g*255);
+    bc = (unsigned char)(b*255);
+    ac = 255;
+}
+
+void color(const float r, const float g, const float b, const float a)
+{
+    rc = (unsigned char)(r*255);
+    gc = (unsigned char)(g*255);
+    bc = (unsigned char)(b*255);
+    ac = (unsigned char)(a*255);
+}
+
+void line(const int x1, const int y1, const int x2, const int y2)
+{
+    recordCommand(COMMAND_LINE, x1, y1, x2, y2);
+}
+
+void lineWidth(const int n)
+{
+    lineWidth_i = n;
+}
+
+void lineSmooth(const bool enabled)
+{
+}
+
+void point(const int x, const int y)
+{
+    recordCommand(COMMAND_POINT, x - pointSize_i/2, y - pointSize_i/2, x + pointSize_i/2, y + pointSize_i/2);
+}
+
+void pointSize(const int n)
+{
+    pointSize_i = n;
+}
+
+void rect(const int x1, const int y1, const int x2, const int y2)
+{
+    recordCommand(COMMAND_RECT, x1, y1, x2, y2);
+}
+
+void bordered_rect_no_start(const int x1, const int y1, const int x2, const int y2)
+{
+    recordCommand(COMMAND_BORDERED_RECT, x1, y1 - 1, x2 + 1, y2 + 1);
+}
+
+void bordered_rect(const int x1, const int y1, const int x2, const int y2)
+{
+    recordCommand(COMMAND_BORDERED_RECT, x1, y1 - 1, x2 + 1, y2 + 1);
+}
+
+void hollow_rect(const int x1, const int y1, const int x2, const int y2)
+{
+    recordCommand(COMMAND_HOLLOW_RECT, x1, y1, x2, y2);
+}
+
+void select_rect(const int x1, const int y1, const int x2, const int y2)
+{
+    recordCommand(COMMAND_SELECT_RECT, x1, y1, x2, y2);
+}
+
+void triangle(const int x1, const int y1, const int x2, const int y2, const int x3, const int y3)
+{
+    recordCommand(COMMAND_TRIANGLE, std::min(x1, std::min(x2, x3)), std::min(y1, std::min(y2, y3)),
+                                    std::max(x1, std::max(x2, x3)), std::max(y1, std::max(y2, y3)));
+}
+
+void arc(int center_x, int center_y, int radius_x, int radius_y, bool show_above)
+{
+    recordCommand(COMMAND_ARC, center_x - radius_x, (show_above ? center_y - radius_y : center_y),
+                               center_x + radius_x, (show_above ? center_y : center_y + radius_y));
+}
+
+void quad(const int x1, const int y1,
+          const int x2, const int y2,
+          const int x3, const int y3,
+          const int x4, const int y4)
+{
+    recordCommand(COMMAND_QUAD, std::min(std::min(x1, x2), std::min(x3, x4)),
+                                std::min(std::min(y1, y2), std::min(y3, y4)),
+                                std::max(std::max(x1, x2), std::max(x3, x4)),
+                                std::max(std::max(y1, y2), std::max(y3, y4)));
+}
+
+void beginScissors(const int x, const int y, const int width, const int height)
+{
+    scissors_enabled = true;
+    scissor_x1 = x;
+    scissor_y1 = y;
+    scissor_x2 = x + width;
+    scissor_y2 = y + height;
+}
+
+void endScissors()
+{
+    scissors_enabled = false;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+/*
+ * Layers only remember that they were drawn; drawing a cached layer counts as a single image draw,
+ * like with the other backends.
+ */
+struct LayerContents
+{
+};
+
+Layer::Layer()
+{
+    m_contents = NULL;
+    m_x        = 0;
+    m_y        = 0;
+    m_width    = 0;
+    m_height   = 0;
+}
+
+Layer::~Layer()
+{
+    invalidate();
+}
+
+void Layer::invalidate()
+{
+    delete m_contents;
+    m_contents = NULL;
+}
+
+bool drawLayer(Layer& layer, const int x, const int y, const int width, const int height)
+{
+    if (layer.m_contents == NULL) return false;
+    if (layer.m_x != x or layer.m_y != y or layer.m_width != width or layer.m_height != height)
+    {
+        layer.invalidate();
+        return false;
+    }
+
+    recordCommand(COMMAND_LAYER, x, y, x + width, y + height);
+    return true;
+}
+
+void beginLayer(Layer& layer, const int x, const int y, const int width, const int height)
+{
+    layer.invalidate();
+    layer.m_x      = x;
+    layer.m_y      = y;
+    layer.m_width  = width;
+    layer.m_height = height;
+    if (width <= 0 or height <= 0) return;
+
+    layer.m_contents = new LayerContents();
+}
+
+void endLayer(Layer& layer)
+{
+    // what was drawn in the layer was recorded directly in the frame
+}
+
+}
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------------------------
+
+namespace TestHeadlessRenderer
+{
+    using namespace AriaMaestosa;
+
+    UNIT_TEST(TestEditorFrameTimeAndDrawCalls)
+    {
+        const int FRAMES         = 100;
+        const int MEASURE_AMOUNT = 64;
+
+        wxInitAllImageHandlers();
+        if (not ImageProvider::imagesLoaded()) ImageProvider::loadImages();
+
+        AriaRender::setViewportSize(1024, 768);
+
+        OwnerPtr<GraphicalSequence> gseq( new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false)) );
+        Sequence* seq = gseq->getModel();
+        const int beat = seq->ticksPerQuarterNote();
+
+        {
+            ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+            tr->setMeasureAmount(MEASURE_AMOUNT);
+        }
+
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<MEASURE_AMOUNT*8; n++)
+            {
+                // eighth notes climbing through two octaves, over a modulation ramp
+                t->addNote_import(48 + n % 24, n*beat/2, (n + 1)*beat/2, 80, -1);
+                t->addControlEvent_import(n*beat/2, n % 128, 1 /* modulation */);
+            }
+        }
+        seq->addTrack(t);
+
+        t->setNotationType(SCORE, true);
+        t->setNotationType(KEYBOARD, true);
+        t->setNotationType(CONTROLLER, true);
+
+        GraphicalTrack* gtrack = gseq->getGraphicsFor(t);
+        require(gtrack != NULL, "a view was created for the track");
+
+        gtrack->getControllerEditor()->setController(1 /* modulation */);
+        gtrack->setHeight(600);
+        gtrack->layout(MEASURE_BAR_Y + gseq->getMeasureBar()->getMeasureBarHeight());
+
+        Editor* editors[] = { gtrack->getKeyboardEditor(), gtrack->getScoreEditor(),
+                              gtrack->getControllerEditor(), NULL };
+        const char* names[] = { "KeyboardEditor", "ScoreEditor", "ControllerEditor", "MeasureBar" };
+
+        for (int e=0; e<4; e++)
+        {
+            int firstFrameCalls = 0;
+
+            wxStopWatch frameTime;
+            for (int frame=0; frame<FRAMES; frame++)
+            {
+                AriaRender::clearCommands();
+
+                if (editors[e] != NULL) editors[e]->render();
+                else                    gseq->getMeasureBar()->render(MEASURE_BAR_Y);
+
+                if (frame == 0) firstFrameCalls = AriaRender::getDrawCallCount();
+            }
+            const long totalMs = frameTime.Time();
+
+            const int drawCalls = AriaRender::getDrawCallCount();
+            require_e(drawCalls, >, 0, "rendering is recorded");
+            require_e(drawCalls, <=, firstFrameCalls, "frames after the first one do not draw more");
+
+            std::cout << "[HeadlessRenderer] " << names[e] << " : " << (totalMs / (float)FRAMES)
+                      << " ms per frame, " << drawCalls << " draw calls (" << firstFrameCalls
+                      << " on the first frame, " << AriaRender::getDrawCallCount(AriaRender::COMMAND_LAYER)
+                      << " cached layers)" << std::endl;
+        }
+    }
+
+    UNIT_TEST(TestHibernatedSequenceRendersAsBefore)
+    {
+        const int MEASURE_AMOUNT = 32;
+
+        wxInitAllImageHandlers();
+        if (not ImageProvider::imagesLoaded()) ImageProvider::loadImages();
+
+        AriaRender::setViewportSize(1024, 768);
+
+        OwnerPtr<GraphicalSequence> gseq( new GraphicalSequence(new Sequence(NULL, NULL, NULL, NULL, false)) );
+        Sequence* seq = gseq->getModel();
+        const int beat = seq->ticksPerQuarterNote();
+
+        {
+            ScopedMeasureTransaction tr(seq->getMeasureData()->startTransaction());
+            tr->setMeasureAmount(MEASURE_AMOUNT);
+        }
+
+        Track* t = new Track(seq);
+        {
+            OwnerPtr<Sequence::Import> import(seq->startImport());
+            for (int n=0; n<MEASURE_AMOUNT*8; n++)
+            {
+                t->addNote_import(48 + n % 24, n*beat/2, (n + 1)*beat/2, 80, -1);
+                t->addControlEvent_import(n*beat/2, n % 128, 1 /* modulation */);
+            }
+        }
+        seq->addTrack(t);
+
+        t->setNotationType(SCORE, true);
+        t->setNotationType(KEYBOARD, true);
+        t->setNotationType(CONTROLLER, true);
+
+        GraphicalTrack* gtrack = gseq->getGraphicsFor(t);
+        gtrack->getControllerEditor()->setController(1 /* modulation */);
+        gtrack->setHeight(600);
+        gtrack->layout(MEASURE_BAR_Y + gseq->getMeasureBar()->getMeasureBarHeight());
+
+        Editor* editors[] = { gtrack->getKeyboardEditor(), gtrack->getScoreEditor(), gtrack->getControllerEditor() };
+        int drawCalls[3];
+
+        for (int e=0; e<3; e++)
+        {
+            AriaRender::clearCommands();
+            editors[e]->render();
+            drawCalls[e] = AriaRender::getDrawCallCount();
+        }
+
+        MemoryUsage awake;
+        gseq->getMemoryUsage(awake);
+
+        gseq->hibernate();
+        require(gseq->isHibernating(), "the sequence knows it is hibernating");
+
+        MemoryUsage asleep;
+        gseq->getMemoryUsage(asleep);
+        require_e(asleep.getBytes(MemoryUsage::RENDER_CACHES), <, awake.getBytes(MemoryUsage::RENDER_CACHES),
+                  "render caches are freed");
+        require_e(asleep.getBytes(MemoryUsage::ANALYSERS), <, awake.getBytes(MemoryUsage::ANALYSERS),
+                  "analysers are freed");
+        require_e(asleep.getBytes(MemoryUsage::NOTES), ==, awake.getBytes(MemoryUsage::NOTES), "the model is kept");
+        require_e(t->getNoteAmount(), ==, MEASURE_AMOUNT*8, "the model is kept");
+
+        // what was freed is rebuilt by the next render, which draws everything again
+        gseq->wake();
+        for (int e=0; e<3; e++)
+        {
+            AriaRender::clearCommands();
+            editors[e]->render();
+            require_e(AriaRender::getDrawCallCount(), ==, drawCalls[e], "editors render as before hibernating");
+        }
+
+        MemoryUsage woken;
+        gseq->getMemoryUsage(woken);
+        require_e(woken.getBytes(MemoryUsage::RENDER_CACHES), ==, awake.getBytes(MemoryUsage::RENDER_CACHES),
+                  "render caches are rebuilt");
+
+        std::cout << "[HeadlessRenderer] hibernating a sequence of " << t->getNoteAmount() << " notes frees "
+                  << (awake.getTotalBytes() - asleep.getTotalBytes()) << " of "
+                  << awake.getTotalBytes() << " bytes" << std::endl;
+    }
+}
+
+#endif
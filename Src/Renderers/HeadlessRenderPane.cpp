@@ -0,0 +1,103 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#include "Utils.h"
+
+#include "Renderers/HeadlessRenderPane.h"
+#include "Renderers/HeadlessRenderer.h"
+#include "AriaCore.h"
+
+#include <wx/wx.h>
+
+#include "GUI/MainFrame.h"
+
+using namespace AriaMaestosa;
+
+// ----------------------------------------------------------------------------------------------------------
+
+HeadlessRenderPane::HeadlessRenderPane(wxWindow* parent, int* args) :
+    wxPanel(parent, wxID_ANY,  wxDefaultPosition, wxDefaultSize, wxWANTS_CHARS)
+{
+#if wxCHECK_VERSION(2,9,1)
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
+#else
+    SetBackgroundStyle(wxBG_STYLE_CUSTOM);
+#endif
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+HeadlessRenderPane::~HeadlessRenderPane()
+{
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void HeadlessRenderPane::resized(wxSizeEvent& evt)
+{
+    evt.Skip();
+    if (getMainFrame()->getSequenceAmount()>0) DisplayFrame::updateVerticalScrollbar();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int HeadlessRenderPane::getWidth()
+{
+    if (Display::isVisible()) return GetSize().x;
+    else return AriaRender::getViewportWidth();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+int HeadlessRenderPane::getHeight()
+{
+    if (Display::isVisible()) return GetSize().y;
+    else return AriaRender::getViewportHeight();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+bool HeadlessRenderPane::prepareFrame()
+{
+    if (!GetParent()->IsShown()) return false;
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void HeadlessRenderPane::beginFrame()
+{
+    AriaRender::clearCommands();
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+void HeadlessRenderPane::endFrame()
+{
+    if (Display::renderDC == NULL) return;
+
+    Display::renderDC -> SetBackground( *wxBLACK_BRUSH );
+    Display::renderDC -> Clear();
+    Display::renderDC -> SetTextForeground( *wxWHITE );
+    Display::renderDC -> DrawText( wxString::Format(wxT("%i draw calls"), AriaRender::getDrawCallCount()),
+                                   10, 10 );
+}
+
+// ----------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#ifndef __HEADLESS_RENDERER_H__
+#define __HEADLESS_RENDERER_H__
+
+#include "Renderers/RenderAPI.h"
+
+#include <vector>
+
+namespace AriaMaestosa
+{
+    namespace AriaRender
+    {
+        /**
+          * @brief kinds of commands recorded by the headless render backend
+          * @ingroup renderers
+          */
+        enum CommandType
+        {
+            COMMAND_LINE,
+            COMMAND_POINT,
+            COMMAND_RECT,
+            COMMAND_HOLLOW_RECT,
+            COMMAND_SELECT_RECT,
+            COMMAND_BORDERED_RECT,
+            COMMAND_TRIANGLE,
+            COMMAND_ARC,
+            COMMAND_QUAD,
+            COMMAND_IMAGE,
+            COMMAND_TEXT,
+            COMMAND_LAYER,
+
+            COMMAND_TYPE_COUNT
+        };
+
+        /**
+          * @brief one draw call, as recorded by the headless render backend
+          *
+          * Coordinates hold the bounding box of what was drawn. Commands drawn entirely outside of the
+          * current scissor rectangle are still recorded, with 'm_clipped' set.
+          * @ingroup renderers
+          */
+        struct Command
+        {
+            CommandType m_type;
+            int m_x1, m_y1, m_x2, m_y2;
+            unsigned char m_r, m_g, m_b, m_a;
+            bool m_clipped;
+        };
+
+        /** @brief the commands recorded since the last call to 'clearCommands' (or since the frame began) */
+        const std::vector<Command>& getCommands();
+
+        /** @brief forget all recorded commands; called by the render pane at the beginning of each frame */
+        void clearCommands();
+
+        /** @return the number of draw calls recorded since the last call to 'clearCommands' */
+        int getDrawCallCount();
+
+        /** @return the number of draw calls of the given kind recorded since the last 'clearCommands' */
+        int getDrawCallCount(const CommandType type);
+
+        /**
+          * @brief set the size of the viewport used when there is no main pane (in unit tests and
+          *        benchmarks); Display::getWidth and Display::getHeight then return these values
+          */
+        void setViewportSize(const int width, const int height);
+
+        int getViewportWidth();
+        int getViewportHeight();
+
+        /** @brief record a draw call with the current color; for use by the headless backend classes */
+        void recordCommand(const CommandType type, const int x1, const int y1, const int x2, const int y2);
+    }
+}
+
+#endif
+#endif
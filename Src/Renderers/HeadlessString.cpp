@@ -0,0 +1,190 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef RENDERER_HEADLESS
+
+#include "Renderers/HeadlessString.h"
+#include "Renderers/HeadlessRenderer.h"
+
+#include <algorithm>
+#include <wx/settings.h>
+#include <wx/tokenzr.h>
+
+namespace AriaMaestosa
+{
+
+#if 0
+#pragma mark -
+#pragma mark HeadlessString
+#endif
+
+    HeadlessString::HeadlessString(Model<wxString>* model, bool own)
+    {
+        m_model = model;
+        m_consolidated = false;
+        m_max_width = -1;
+        m_warp = false;
+        m_w = -1;
+        m_h = -1;
+
+        if (not own) m_model.owner = false;
+
+        model->setListener(this);
+    }
+
+    HeadlessString::~HeadlessString()
+    {
+    }
+
+    void HeadlessString::getTextExtents(const wxString& text, const wxFont& font, int* w, int* h)
+    {
+        const int pointSize = (font.IsOk() ? font.GetPointSize() :
+                               wxSystemSettings::GetFont(wxSYS_SYSTEM_FONT).GetPointSize());
+
+        // typical proportions of a proportional font : characters average 0.6em wide, lines are 1.3em high
+        *w = (int)(text.size() * pointSize * 0.6f + 0.5f);
+        *h = (int)(pointSize * 1.3f + 0.5f);
+    }
+
+    void HeadlessString::setMaxWidth(const int w, const bool warp)
+    {
+        m_max_width = w;
+        m_warp = warp;
+    }
+
+    void HeadlessString::setFont(const wxFont& font)
+    {
+        m_font = font;
+        m_consolidated = false;
+    }
+
+    void HeadlessString::bind()
+    {
+        if (not m_consolidated)
+        {
+            getTextExtents(m_model->getValue(), m_font, &m_w, &m_h);
+            m_consolidated = true;
+        }
+    }
+
+    int HeadlessString::getWidth()
+    {
+        ASSERT_E(m_w, >=, 0);
+        ASSERT_E(m_w, <, 90000);
+        return m_w;
+    }
+
+    int HeadlessString::getHeight()
+    {
+        ASSERT_E(m_h, >=, 0);
+        ASSERT_E(m_h, <, 90000);
+        return m_h;
+    }
+
+    void HeadlessString::render(const int x, const int y)
+    {
+        if (not m_consolidated) bind();
+
+        if (m_max_width != -1 and m_w > m_max_width and m_warp)
+        {
+            // one line per word, like the wxWidgets backend does
+            wxString multiline = m_model->getValue();
+            multiline.Replace(wxT(" "),wxT("\n"));
+            multiline.Replace(wxT("/"),wxT("/\n"));
+
+            int my_y = y - m_h;
+            wxStringTokenizer tkz(multiline, wxT("\n"));
+            while ( tkz.HasMoreTokens() )
+            {
+                int w, h;
+                getTextExtents(tkz.GetNextToken(), m_font, &w, &h);
+                AriaRender::recordCommand(AriaRender::COMMAND_TEXT, x, my_y, x + w, my_y + h);
+                my_y += m_h;
+            }
+        }
+        else
+        {
+            const int w = (m_max_width != -1 ? std::min(m_w, m_max_width) : m_w);
+            AriaRender::recordCommand(AriaRender::COMMAND_TEXT, x, y - m_h, x + w, y);
+        }
+    }
+
+#if 0
+#pragma mark -
+#pragma mark HeadlessStringArray
+#endif
+
+    HeadlessStringArray::HeadlessStringArray()
+    {
+        m_consolidated = false;
+    }
+
+    HeadlessStringArray::HeadlessStringArray(const wxString strings_arg[], int amount)
+    {
+        m_consolidated = false;
+        addStrings(strings_arg, amount);
+    }
+
+    HeadlessStringArray::~HeadlessStringArray()
+    {
+    }
+
+    HeadlessString& HeadlessStringArray::get(const int id)
+    {
+        return m_strings[id];
+    }
+
+    void HeadlessStringArray::addStrings(const wxString strings_arg[], int amount)
+    {
+        for (int n=0; n<amount; n++)
+        {
+            m_strings.push_back( new HeadlessString( new Model<wxString>(strings_arg[n]), true ) );
+        }
+        m_consolidated = false;
+    }
+
+    void HeadlessStringArray::addString(const wxString& newstring)
+    {
+        m_strings.push_back( new HeadlessString( new Model<wxString>(newstring), true ) );
+        m_consolidated = false;
+    }
+
+    void HeadlessStringArray::bind()
+    {
+        if (not m_consolidated)
+        {
+            if (not m_font.IsOk()) return;
+
+            const int amount = m_strings.size();
+            for (int n=0; n<amount; n++)
+            {
+                m_strings[n].setFont(m_font);
+                m_strings[n].bind();
+            }
+
+            m_consolidated = true;
+        }
+    }
+
+    void HeadlessStringArray::setFont(const wxFont& font)
+    {
+        m_font = font;
+        m_consolidated = false;
+    }
+
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License along
+ with this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __HEADLESS_STRING_H__
+#define __HEADLESS_STRING_H__
+
+#ifdef RENDERER_HEADLESS
+
+#include <wx/font.h>
+#include <wx/string.h>
+
+class wxDC;
+
+#include "ptr_vector.h"
+#include "Utils.h"
+
+namespace AriaMaestosa
+{
+
+    class HeadlessStringArray;
+
+    /**
+     * @brief   headless render backend : text renderer
+     *
+     * Text is not rasterized; its size is estimated from the point size of the font, so that layout
+     * does not depend on a display connection.
+     * @ingroup renderers
+     */
+    class HeadlessString : public IModelListener<wxString>
+    {
+    protected:
+        wxFont m_font;
+
+        int m_w, m_h;
+        friend class HeadlessStringArray;
+
+        bool m_consolidated;
+
+        int m_max_width;
+
+        bool m_warp;
+
+        OwnerPtr< Model<wxString> > m_model;
+
+    public:
+
+        HeadlessString(Model<wxString>* model, bool own);
+
+        ~HeadlessString();
+
+        void bind();
+
+        void setMaxWidth(const int w, const bool warp=false);
+
+        /** set how to draw string for next consolidate() - has no immediate effect,
+         you need to call consolidate() to get results  */
+        void setFont(const wxFont& font);
+
+        void consolidate(wxDC* dc) { m_consolidated = false; bind(); }
+
+        void render(const int x, const int y);
+
+        Model<wxString>*       getModel()       { return m_model; }
+        const Model<wxString>* getModel() const { return m_model; }
+        int getWidth();
+        int getHeight();
+
+        void scale(float f) {}
+        void rotate(int angle) {}
+
+        virtual void onModelChanged(wxString newval) { m_consolidated = false; }
+
+        /** @brief estimate the size the given text would take with the given font */
+        static void getTextExtents(const wxString& text, const wxFont& font, int* w, int* h);
+
+        /** @return the bytes of the texture of this string (there is none when rendering headless) */
+        int getTextureBytes() const { return 0; }
+
+        /** @brief frees the texture of this string until it is drawn again (nothing to free here) */
+        void releaseTexture() {}
+    };
+
+    typedef HeadlessString AriaRenderString;
+
+    /**
+     * @brief   headless render backend : text array renderer
+     * @ingroup renderers
+     */
+    class HeadlessStringArray
+    {
+        ptr_vector<HeadlessString, HOLD> m_strings;
+        wxFont m_font;
+        bool m_consolidated;
+
+    public:
+
+        HeadlessStringArray();
+        HeadlessStringArray(const wxString strings_arg[], int amount);
+        ~HeadlessStringArray();
+
+        HeadlessString& get(const int id);
+
+        void bind();
+        void addStrings(const wxString strings_arg[], int amount);
+        void addString(const wxString& string);
+        int getStringAmount() const { return m_strings.size(); }
+
+        void setFont(const wxFont& font);
+
+        void consolidate(wxDC* dc){}
+
+        int getTextureBytes() const { return 0; }
+
+        void releaseTexture() {}
+    };
+
+    typedef HeadlessStringArray AriaRenderArray;
+
+}
+
+#endif
+#endif
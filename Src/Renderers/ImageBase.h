@@ -18,6 +18,8 @@
     #include "Renderers/GLImage.h"
 #elif defined(RENDERER_WXWIDGETS)
     #include "Renderers/wxImage.h"
+#elif defined(RENDERER_HEADLESS)
+    #include "Renderers/HeadlessImage.h"
 #else
     #error No renderer defined!
 #endif
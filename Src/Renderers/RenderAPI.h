@@ -24,6 +24,8 @@
 #include "Renderers/GLwxString.h"
 #elif defined(RENDERER_WXWIDGETS)
 #include "Renderers/wxDCString.h"
+#elif defined(RENDERER_HEADLESS)
+#include "Renderers/HeadlessString.h"
 #else
 #error No renderer defined!
 #endif
@@ -175,6 +177,56 @@ namespace AriaMaestosa
                   const int x2, const int y2,
                   const int x3, const int y3,
                   const int x4, const int y4);
+        
+        /** @brief backend-specific storage of a Layer (an OpenGL texture, or a wxBitmap) */
+        struct LayerContents;
+        
+        /**
+          * @brief cached rendering of a rectangular area of the frame
+          *
+          * What is drawn between 'beginLayer' and 'endLayer' ends up in the frame as usual, and is
+          * also kept in the layer, so that 'drawLayer' can then reproduce it in a single image draw.
+          * It is used for parts of the display that rarely change, like editor backgrounds.
+          */
+        class Layer
+        {
+            Layer(const Layer&);
+            Layer& operator=(const Layer&);
+            
+        public:
+            
+            /** for use by the renderer only */
+            LayerContents* m_contents;
+            int m_x, m_y, m_width, m_height;
+            
+            Layer();
+            ~Layer();
+            
+            /** @brief discard the cached rendering; the next 'drawLayer' call will fail */
+            void invalidate();
+            
+            /** @return an estimate of the memory held by the cached rendering (4 bytes per pixel) */
+            long long getCachedBytes() const
+            {
+                return (m_contents == NULL ? 0 : (long long)m_width*m_height*4);
+            }
+        };
+        
+        /**
+          * @brief draw the cached contents of a layer
+          * @return false (and draws nothing) if the layer holds no contents for the given rectangle, in
+          *         which case the caller draws it again between 'beginLayer' and 'endLayer'
+          */
+        bool drawLayer(Layer& layer, const int x, const int y, const int width, const int height);
+        
+        /**
+          * @brief start caching drawing performed within the given rectangle into a layer.
+          * Layers cannot be nested.
+          */
+        void beginLayer(Layer& layer, const int x, const int y, const int width, const int height);
+        
+        /** @brief end drawing started by 'beginLayer'; the layer can now be drawn with 'drawLayer' */
+        void endLayer(Layer& layer);
     }
 }
 #endif
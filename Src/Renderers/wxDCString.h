@@ -66,6 +66,12 @@ namespace AriaMaestosa
         void rotate(int angle);
         
         virtual void onModelChanged(wxString newval) { m_consolidated = false; }
+
+        /** @return the bytes of the texture of this string (strings are drawn directly, there is none) */
+        int getTextureBytes() const { return 0; }
+
+        /** @brief frees the texture of this string until it is drawn again (nothing to free here) */
+        void releaseTexture() {}
     };
     
     typedef wxDCString AriaRenderString;
@@ -120,6 +126,10 @@ namespace AriaMaestosa
         void setFont(const wxFont& font);
         
         void consolidate(wxDC* dc){}
+
+        int getTextureBytes() const { return 0; }
+
+        void releaseTexture() {}
     };
     
     typedef wxDCStringArray AriaRenderArray;
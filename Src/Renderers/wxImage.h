@@ -39,7 +39,7 @@ namespace AriaMaestosa
         wxImage* states[AriaRender::STATE_AMOUNT];
         wxBitmap* states_bmp[AriaRender::STATE_AMOUNT];
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(Image);
         
         int width, height;
         
@@ -304,6 +304,98 @@ void endScissors()
     Display::renderDC -> DestroyClippingRegion();
 }
 
+// ----------------------------------------------------------------------------------------------------------
+
+/*
+ * Layers are drawn into a bitmap (by temporarily redirecting 'Display::renderDC' to a memory DC),
+ * which is then blitted into the frame.
+ */
+struct LayerContents
+{
+    wxBitmap m_bitmap;
+};
+
+/** the DC that was current before 'beginLayer', and the memory DC that replaces it until 'endLayer' */
+wxDC*       dc_before_layer = NULL;
+wxMemoryDC* layer_dc        = NULL;
+
+Layer::Layer()
+{
+    m_contents = NULL;
+    m_x        = 0;
+    m_y        = 0;
+    m_width    = 0;
+    m_height   = 0;
+}
+
+Layer::~Layer()
+{
+    invalidate();
+}
+
+void Layer::invalidate()
+{
+    delete m_contents;
+    m_contents = NULL;
+}
+
+bool drawLayer(Layer& layer, const int x, const int y, const int width, const int height)
+{
+    if (layer.m_contents == NULL) return false;
+    if (layer.m_x != x or layer.m_y != y or layer.m_width != width or layer.m_height != height)
+    {
+        layer.invalidate();
+        return false;
+    }
+    
+    Display::renderDC -> DrawBitmap( layer.m_contents->m_bitmap, x, y, false );
+    return true;
+}
+
+void beginLayer(Layer& layer, const int x, const int y, const int width, const int height)
+{
+    ASSERT(layer_dc == NULL); // layers cannot be nested
+    
+    layer.invalidate();
+    layer.m_x      = x;
+    layer.m_y      = y;
+    layer.m_width  = width;
+    layer.m_height = height;
+    if (width <= 0 or height <= 0) return;
+    
+    layer.m_contents = new LayerContents();
+    layer.m_contents->m_bitmap.Create(width, height);
+    
+    layer_dc = new wxMemoryDC(layer.m_contents->m_bitmap);
+    layer_dc -> SetDeviceOrigin(-x, -y);
+    layer_dc -> SetFont( Display::renderDC->GetFont() );
+    
+    dc_before_layer   = Display::renderDC;
+    Display::renderDC = layer_dc;
+    
+    updatePen();
+    updateBrush();
+    updateFontColor();
+}
+
+void endLayer(Layer& layer)
+{
+    if (layer_dc == NULL) return; // empty layer
+    
+    Display::renderDC = dc_before_layer;
+    dc_before_layer   = NULL;
+    
+    layer_dc -> SelectObject(wxNullBitmap);
+    delete layer_dc;
+    layer_dc = NULL;
+    
+    updatePen();
+    updateBrush();
+    updateFontColor();
+    
+    drawLayer(layer, layer.m_x, layer.m_y, layer.m_width, layer.m_height);
+}
+
 }
 }
 #endif
@@ -37,7 +37,7 @@ namespace AriaMaestosa
     {
 
     public:
-        LEAK_CHECK();
+        LEAK_CHECK(wxRenderPane);
 
         wxRenderPane(wxWindow* parent, int* args);
         ~wxRenderPane();
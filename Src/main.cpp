@@ -22,16 +22,22 @@
 #include <wx/ipc.h>      // IPC support
 #include <wx/filename.h>
 #include <wx/tokenzr.h>
+#include <wx/timer.h>
+#include <wx/display.h>
 
 #include "GUI/MainFrame.h"
 #include "GUI/MainPane.h"
 #include "Midi/Players/PlatformMidiManager.h"
 #include "Midi/KeyPresets.h"
+#include "Parallel.h"
 #include "PreferencesData.h"
+#include "Printing/NotationExport.h"
+#include "Profiler.h"
 #include "languages.h"
 #include "UnitTest.h"
 #include "Utils.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "main.h"
@@ -43,6 +49,10 @@ static const wxString IPC_START = wxT("StartOther");
 static const wxString IPC_APP_PORT = wxT("4242");
 static const wxString CONNECTION_FILE_SEPARATOR = wxT("|");
 static const wxString RELOAD_PARAM = wxT("--reload");
+static const wxString EXPORT_PARAM = wxT("--export");
+
+/** refresh rate assumed when the display does not report one */
+static const int DEFAULT_REFRESH_RATE = 60;
 
 using namespace AriaMaestosa;
 
@@ -135,20 +145,53 @@ public:
 
 
 
+//----------------------------------------------------------------------------
+//! Render loop timer, paces playback rendering at the refresh rate of the display
+class RenderLoopTimer : public wxTimer
+{
+public:
+    
+    void Notify()
+    {
+        wxGetApp().frame->getMainPane()->playbackRenderLoop();
+    }
+};
+
+
+
 // ------------------------------------------------------------------------------------------------------
 // ------------------------------------------------------------------------------------------------------
 
+int wxWidgetApp::getFrameInterval()
+{
+    int refreshRate = 0;
+    
+#if wxUSE_DISPLAY
+    const int displayID = wxDisplay::GetFromWindow(frame);
+    if (displayID != wxNOT_FOUND)
+    {
+        refreshRate = wxDisplay(displayID).GetCurrentMode().refresh;
+    }
+#endif
+    
+    if (refreshRate <= 0) refreshRate = DEFAULT_REFRESH_RATE;
+    return std::max(1, 1000 / refreshRate);
+}
+
+// ------------------------------------------------------------------------------------------------------
+
 void wxWidgetApp::activateRenderLoop(bool on)
 {
     if (on and not m_render_loop_on)
     {
-        Connect( wxID_ANY, wxEVT_IDLE, wxIdleEventHandler(wxWidgetApp::onIdle) );
+        if (m_render_loop_timer == NULL) m_render_loop_timer = new RenderLoopTimer();
+        m_render_loop_timer->Start(getFrameInterval());
         m_render_loop_on = true;
     }
 
     else if (not on and m_render_loop_on)
     {
-        Disconnect( wxEVT_IDLE, wxIdleEventHandler(wxWidgetApp::onIdle) );
+        m_render_loop_timer->Stop();
         m_render_loop_on = false;
     }
 }
@@ -157,12 +200,7 @@ void wxWidgetApp::activateRenderLoop(bool on)
 
 void wxWidgetApp::onIdle(wxIdleEvent& evt)
 {
-    if (m_render_loop_on)
-    {
-        frame->getMainPane()->playbackRenderLoop();
-        evt.RequestMore();
-    }
-    
+    // while recording, the render loop timer keeps idle events coming after each frame
     PlatformMidiManager* pmm = PlatformMidiManager::get();
     if (pmm->isRecording())
     {
@@ -195,6 +233,10 @@ bool wxWidgetApp::OnInit()
     m_render_loop_on = false;
     appName = GetAppName();
     
+#ifdef ARIA_PROFILER
+    Profiler::setThreadName("GUI");
+#endif
+    
     for (int n=0; n<argc; n++)
     {
         if (wxString(argv[n]) == wxT("--utest"))
@@ -207,6 +249,22 @@ bool wxWidgetApp::OnInit()
             UnitTestCase::showMenu();
             exit(0);
         }
+        else if (wxString(argv[n]) == EXPORT_PARAM)
+        {
+            if (n + 2 >= argc)
+            {
+                std::cerr << "Usage : " << wxString(argv[0]).mb_str() << " --export <pdf|svg|png> <files...>" << std::endl;
+                exit(1);
+            }
+            
+            okToLog = false;
+            Core::setPlayDuringEdit(PLAY_NEVER);
+            prefs = PreferencesData::getInstance();
+            prefs->init();
+            
+            const bool success = exportNotationFromCommandLine(wxString(argv[n+1]), n+2);
+            exit(success ? 0 : 1);
+        }
         else if (wxString(argv[n]) == wxT("--verbose"))
         {
             wxLog::SetLogLevel(wxLOG_Info);
@@ -302,6 +360,10 @@ int wxWidgetApp::OnExit()
     wxDELETE(m_single_instance_checker);
     delete m_IPC_server;
 #endif
+    
+    wxDELETE(m_render_loop_timer);
+    
+    Parallel::stopWorkers();
 
 #ifdef _MORE_DEBUG_CHECKS
     MemoryLeaks::checkForLeaks();
@@ -390,6 +452,26 @@ bool wxWidgetApp::handleSingleInstance()
 }
 
 
+bool wxWidgetApp::exportNotationFromCommandLine(const wxString& format, const int firstFileArg)
+{
+    bool success = true;
+    
+    for (int n=firstFileArg; n<argc; n++)
+    {
+        wxFileName outputPath( cleanPath(wxString(argv[n])) );
+        const wxString songPath = outputPath.GetFullPath();
+        outputPath.SetExt(format);
+        
+        if (not exportNotation(songPath, outputPath.GetFullPath()))
+        {
+            success = false;
+        }
+    }
+    
+    return success;
+}
+
+
 /** Removes heading and trailing quotes */
 wxString wxWidgetApp::cleanPath(const wxString& input)
 {
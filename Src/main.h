@@ -26,6 +26,7 @@ class wxIdleEvent;
 class wxActivateEvent;
 class wxSingleInstanceChecker;
 class AppIPCServer;
+class RenderLoopTimer;
 
 namespace AriaMaestosa
 {
@@ -49,7 +50,7 @@ namespace AriaMaestosa
         bool m_render_loop_on;
         
         
-        wxWidgetApp() { frame = NULL; }
+        wxWidgetApp() { frame = NULL; m_render_loop_timer = NULL; }
         
         
         /** implement callback from wxApp */
@@ -61,10 +62,13 @@ namespace AriaMaestosa
         /** implement callback from wxApp */
         void MacOpenFile(const wxString &fileName);
         
-        /** call to activate or deactivate the render loop (which is based on idle events) */
+        /**
+          * call to activate or deactivate the render loop (which is driven by a timer running at
+          * the refresh rate of the display showing the main frame)
+          */
         void activateRenderLoop(bool on);
         
-        /** callback : called on idle */
+        /** callback : called on idle, processes incoming recorded events */
         void onIdle(wxIdleEvent& evt);
         
         /** callback : called when app is activated */
@@ -86,9 +90,20 @@ namespace AriaMaestosa
 
         wxSingleInstanceChecker* m_single_instance_checker;
         AppIPCServer* m_IPC_server;
+        RenderLoopTimer* m_render_loop_timer;
+        
+        /** @return the time between two frames of the render loop, in milliseconds */
+        int getFrameInterval();
         
         bool handleSingleInstance();
         
+        /**
+          * Headless notation export, for '--export <pdf|svg|png> <files...>' : renders the printed
+          * notation of each given song next to it, with the given extension.
+          * @return whether all files were exported successfully
+          */
+        bool exportNotationFromCommandLine(const wxString& format, const int firstFileArg);
+        
     };
     
 }
@@ -22,6 +22,7 @@
 #ifndef _ptr_vector_
 #define _ptr_vector_
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 
@@ -368,18 +369,9 @@ namespace AriaMaestosa
             ASSERT( MAGIC_NUMBER_OK() );
             ASSERT( not m_performing_deletion );
 
-            int vectorSize = contentsVector.size();
-            for (int n=0; n<vectorSize; n++)
-            {
-                
-                if ( contentsVector[n] == 0 )
-                {
-                    contentsVector.erase(contentsVector.begin()+n);
-                    vectorSize = contentsVector.size();
-                    n -= 2;
-                    if (n < -1) n=-1;
-                }
-            }//next
+            // a single pass, whatever the number of marked objects
+            contentsVector.erase(std::remove(contentsVector.begin(), contentsVector.end(), (TYPE*)0),
+                                 contentsVector.end());
             
         }
         // ------------------------------------------------------------------------
@@ -263,7 +263,8 @@ public:
     const MIDIMultiTrack *multitrack;
     int num_tracks;
 
-    MIDISequencerTrackState *track_state[64];
+    // the states of all tracks, allocated as one contiguous block of num_tracks objects
+    MIDISequencerTrackState *track_state;
     MIDIMultiTrackIterator iterator;
     MIDIClockTime cur_clock;
     float cur_time_ms;
@@ -338,7 +339,9 @@ protected:
     int tempo_scale;
 
     int num_tracks;
-    MIDISequencerTrackProcessor *track_processors[64];
+
+    // the processors of all tracks, allocated as one contiguous array of num_tracks objects
+    MIDISequencerTrackProcessor *track_processors;
 
     MIDISequencerState state;
 } ;
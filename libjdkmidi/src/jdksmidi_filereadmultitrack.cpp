@@ -86,6 +86,13 @@ void MIDIFileReadMultiTrack::mf_header (int the_format_, int ntrks_, int divisio
     the_format = the_format_;
     num_tracks = ntrks_;
     division = division_;
+
+    // make room for all tracks of the file, the multitrack may have been created with fewer
+    if ( num_tracks > multitrack->GetNumTracks() )
+    {
+        multitrack->ClearAndResize ( num_tracks );
+    }
+
     multitrack->SetClksPerBeat ( division );
 }
 
@@ -29,6 +29,8 @@
 #include "jdksmidi/world.h"
 #include "jdksmidi/sequencer.h"
 
+#include <new>
+
 namespace jdksmidi
 {
 
@@ -470,6 +472,58 @@ bool MIDISequencerTrackState::Process ( MIDITimedBigMessage *msg )
 
 ////////////////////////////////////////////////////////////////////////////
 
+// track states take constructor arguments, so they can't come from new[]; they are constructed in place
+// in a single block instead, to keep the per-track data of big songs together in memory
+
+static MIDISequencerTrackState *CreateTrackStates (
+    int num_tracks,
+    const MIDISequencer *s,
+    MIDISequencerGUIEventNotifier *n
+)
+{
+    MIDISequencerTrackState *states = static_cast<MIDISequencerTrackState *> (
+        ::operator new ( ( num_tracks > 0 ? num_tracks : 1 ) * sizeof ( MIDISequencerTrackState ) ) );
+
+    for ( int i = 0; i < num_tracks; ++i )
+    {
+        new ( &states[i] ) MIDISequencerTrackState ( s, i, n );
+    }
+
+    return states;
+}
+
+static MIDISequencerTrackState *CopyTrackStates (
+    int num_tracks,
+    const MIDISequencerTrackState *src
+)
+{
+    MIDISequencerTrackState *states = static_cast<MIDISequencerTrackState *> (
+        ::operator new ( ( num_tracks > 0 ? num_tracks : 1 ) * sizeof ( MIDISequencerTrackState ) ) );
+
+    for ( int i = 0; i < num_tracks; ++i )
+    {
+        new ( &states[i] ) MIDISequencerTrackState ( src[i] );
+    }
+
+    return states;
+}
+
+static void DestroyTrackStates (
+    int num_tracks,
+    MIDISequencerTrackState *states
+)
+{
+    if ( states == 0 )
+        return;
+
+    for ( int i = 0; i < num_tracks; ++i )
+    {
+        states[i].~MIDISequencerTrackState();
+    }
+
+    ::operator delete ( states );
+}
+
 MIDISequencerState::MIDISequencerState (
     const MIDISequencer *s,
     const MIDIMultiTrack * m,
@@ -486,10 +540,7 @@ MIDISequencerState::MIDISequencerState (
     cur_measure ( 0 ),
     next_beat_time ( 0 )
 {
-    for ( int i = 0; i < num_tracks; ++i )
-    {
-        track_state[i] = new MIDISequencerTrackState ( s, i, notifier );
-    }
+    track_state = CreateTrackStates ( num_tracks, s, notifier );
 }
 
 MIDISequencerState::MIDISequencerState ( const MIDISequencerState &s )
@@ -504,37 +555,33 @@ MIDISequencerState::MIDISequencerState ( const MIDISequencerState &s )
     cur_measure ( s.cur_measure ),
     next_beat_time ( s.next_beat_time )
 {
-    for ( int i = 0; i < num_tracks; ++i )
-    {
-        track_state[i] = new MIDISequencerTrackState ( *s.track_state[i] );
-    }
+    track_state = CopyTrackStates ( num_tracks, s.track_state );
 }
 
 
 MIDISequencerState::~MIDISequencerState()
 {
-    for ( int i = 0; i < num_tracks; ++i )
-    {
-        jdks_safe_delete_object( track_state[i] );
-    }
+    DestroyTrackStates ( num_tracks, track_state );
+    track_state = 0;
 }
 
 const MIDISequencerState & MIDISequencerState::operator = ( const MIDISequencerState & s )
 {
+    if ( this == &s )
+        return *this;
+
     if ( num_tracks != s.num_tracks )
     {
-        {
-            for ( int i = 0; i < num_tracks; ++i )
-            {
-                jdks_safe_delete_object( track_state[i] );
-            }
-        }
+        DestroyTrackStates ( num_tracks, track_state );
         num_tracks = s.num_tracks;
+        track_state = CopyTrackStates ( num_tracks, s.track_state );
+    }
+
+    else
+    {
+        for ( int i = 0; i < num_tracks; ++i )
         {
-            for ( int i = 0; i < num_tracks; ++i )
-            {
-                track_state[i] = new MIDISequencerTrackState ( *s.track_state[i] );
-            }
+            track_state[i] = s.track_state[i];
         }
     }
 
@@ -561,33 +608,27 @@ MIDISequencer::MIDISequencer (
     num_tracks ( m->GetNumTracks() ),
     state ( this, m, n ) // TO DO: fix this hack
 {
-    for ( int i = 0; i < num_tracks; ++i )
-    {
-        track_processors[i] = new MIDISequencerTrackProcessor;
-    }
+    track_processors = new MIDISequencerTrackProcessor [ num_tracks > 0 ? num_tracks : 1 ];
 }
 
 
 MIDISequencer::~MIDISequencer()
 {
-    for ( int i = 0; i < num_tracks; ++i )
-    {
-        jdks_safe_delete_object( track_processors[i] );
-    }
+    jdks_safe_delete_array( track_processors );
 }
 
 void MIDISequencer::ResetTrack ( int trk )
 {
-    state.track_state[trk]->Reset();
-    track_processors[trk]->Reset();
+    state.track_state[trk].Reset();
+    track_processors[trk].Reset();
 }
 
 void MIDISequencer::ResetAllTracks()
 {
     for ( int i = 0; i < num_tracks; ++i )
     {
-        state.track_state[i]->Reset();
-        track_processors[i]->Reset();
+        state.track_state[i].Reset();
+        track_processors[i].Reset();
     }
 }
 
@@ -634,27 +675,27 @@ double MIDISequencer::GetCurrentTempoScale() const
 
 double MIDISequencer::GetCurrentTempo() const
 {
-    return state.track_state[0]->tempobpm;
+    return state.track_state[0].tempobpm;
 }
 
 MIDISequencerTrackState * MIDISequencer::GetTrackState ( int trk )
 {
-    return state.track_state[trk];
+    return &state.track_state[trk];
 }
 
 const MIDISequencerTrackState * MIDISequencer::GetTrackState ( int trk ) const
 {
-    return state.track_state[ trk ];
+    return &state.track_state[ trk ];
 }
 
 MIDISequencerTrackProcessor * MIDISequencer::GetTrackProcessor ( int trk )
 {
-    return track_processors[trk];
+    return &track_processors[trk];
 }
 
 const MIDISequencerTrackProcessor * MIDISequencer::GetTrackProcessor ( int trk ) const
 {
-    return track_processors[ trk ];
+    return &track_processors[ trk ];
 }
 
 bool MIDISequencer::GetSoloMode() const
@@ -676,12 +717,12 @@ void MIDISequencer::SetSoloMode ( bool m, int trk )
     {
         if ( i == trk )
         {
-            track_processors[i]->solo = true;
+            track_processors[i].solo = true;
         }
 
         else
         {
-            track_processors[i]->solo = false;
+            track_processors[i].solo = false;
         }
     }
 }
@@ -691,7 +732,7 @@ void MIDISequencer::GoToZero()
     // go to time zero
     for ( int i = 0; i < num_tracks; ++i )
     {
-        state.track_state[i]->GoToZero();
+        state.track_state[i].GoToZero();
     }
 
     state.iterator.GoToTime ( 0 );
@@ -700,7 +741,7 @@ void MIDISequencer::GoToZero()
 // state.next_beat_time = state.multitrack->GetClksPerBeat();
     state.next_beat_time =
         state.multitrack->GetClksPerBeat()
-        * 4 / ( state.track_state[0]->timesig_denominator );
+        * 4 / ( state.track_state[0].timesig_denominator );
     // examine all the events at this specific time
     // and update the track states to reflect this time
     ScanEventsAtThisTime();
@@ -722,7 +763,7 @@ bool MIDISequencer::GoToTime ( MIDIClockTime time_clk )
         // start from zero if desired time is before where we are
         for ( int i = 0; i < state.num_tracks; ++i )
         {
-            state.track_state[i]->GoToZero();
+            state.track_state[i].GoToZero();
         }
 
         state.iterator.GoToTime ( 0 );
@@ -731,7 +772,7 @@ bool MIDISequencer::GoToTime ( MIDIClockTime time_clk )
 //  state.next_beat_time = state.multitrack->GetClksPerBeat();
         state.next_beat_time =
             state.multitrack->GetClksPerBeat()
-            * 4 / ( state.track_state[0]->timesig_denominator );
+            * 4 / ( state.track_state[0].timesig_denominator );
         state.cur_beat = 0;
         state.cur_measure = 0;
     }
@@ -780,7 +821,7 @@ bool MIDISequencer::GoToTimeMs ( float time_ms )
         // start from zero if desired time is before where we are
         for ( int i = 0; i < state.num_tracks; ++i )
         {
-            state.track_state[i]->GoToZero();
+            state.track_state[i].GoToZero();
         }
 
         state.iterator.GoToTime ( 0 );
@@ -789,7 +830,7 @@ bool MIDISequencer::GoToTimeMs ( float time_ms )
 //  state.next_beat_time = state.multitrack->GetClksPerBeat();
         state.next_beat_time =
             state.multitrack->GetClksPerBeat()
-            * 4 / ( state.track_state[0]->timesig_denominator );
+            * 4 / ( state.track_state[0].timesig_denominator );
         state.cur_beat = 0;
         state.cur_measure = 0;
     }
@@ -837,7 +878,7 @@ bool MIDISequencer::GoToMeasure ( int measure, int beat )
     {
         for ( int i = 0; i < state.num_tracks; ++i )
         {
-            state.track_state[i]->GoToZero();
+            state.track_state[i].GoToZero();
         }
 
         state.iterator.GoToTime ( 0 );
@@ -848,7 +889,7 @@ bool MIDISequencer::GoToMeasure ( int measure, int beat )
 //  state.next_beat_time = state.multitrack->GetClksPerBeat();
         state.next_beat_time =
             state.multitrack->GetClksPerBeat()
-            * 4 / ( state.track_state[0]->timesig_denominator );
+            * 4 / ( state.track_state[0].timesig_denominator );
     }
 
     MIDIClockTime t = 0;
@@ -895,7 +936,7 @@ bool MIDISequencer::GetNextEventTimeMs ( double *t )
         // calculate delta time from last event time
         double delta_clocks = ( double ) ( ct - state.cur_clock );
         // calculate tempo in milliseconds per clock
-        double clocks_per_sec = ( ( state.track_state[0]->tempobpm *
+        double clocks_per_sec = ( ( state.track_state[0].tempobpm *
                                     ( ( ( double ) tempo_scale ) * 0.01 )
                                     * ( 1. / 60. ) ) * state.multitrack->GetClksPerBeat() );
 
@@ -976,7 +1017,7 @@ bool MIDISequencer::GetNextEvent ( int *tracknum, MIDITimedBigMessage *msg )
             int new_measure = state.cur_measure;
             // do we need to update the measure number?
 
-            if ( new_beat >= state.track_state[0]->timesig_numerator )
+            if ( new_beat >= state.track_state[0].timesig_numerator )
             {
                 // yup
                 new_beat = 0;
@@ -991,7 +1032,7 @@ bool MIDISequencer::GetNextEvent ( int *tracknum, MIDITimedBigMessage *msg )
             // denom=0  (1)  ---> 4/1 midi file beats per symbolic beat
             state.next_beat_time +=
                 state.multitrack->GetClksPerBeat()
-                * 4 / ( state.track_state[0]->timesig_denominator );
+                * 4 / ( state.track_state[0].timesig_denominator );
             state.cur_beat = new_beat;
             state.cur_measure = new_measure;
 
@@ -1022,7 +1063,7 @@ bool MIDISequencer::GetNextEvent ( int *tracknum, MIDITimedBigMessage *msg )
             }
 
             // give the beat marker event to the conductor track to process
-            state.track_state[*tracknum]->Process ( msg );
+            state.track_state[*tracknum].Process ( msg );
             return true;
         }
 
@@ -1043,7 +1084,7 @@ bool MIDISequencer::GetNextEvent ( int *tracknum, MIDITimedBigMessage *msg )
                     // yes, only allow this message thru if
                     // the track is either track 0
                     // or it is explicitly solod.
-                    if ( trk == 0 || track_processors[trk]->solo )
+                    if ( trk == 0 || track_processors[trk].solo )
                     {
                         allow_msg = true;
                     }
@@ -1055,8 +1096,8 @@ bool MIDISequencer::GetNextEvent ( int *tracknum, MIDITimedBigMessage *msg )
                 }
 
                 if ( ! ( allow_msg
-                         && track_processors[trk]->Process ( msg )
-                         && state.track_state[trk]->Process ( msg ) )
+                         && track_processors[trk].Process ( msg )
+                         && state.track_state[trk].Process ( msg ) )
                    )
                 {
                     // the message is not allowed to come out!